@@ -0,0 +1,141 @@
+#include "ADCWindowTable.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+void ADCWindowTable::Clear(){
+  ChannelKeys.clear();
+  Offsets.assign(1,0);
+  WindowStart.clear();
+  WindowEnd.clear();
+}
+
+bool ADCWindowTable::Load(const std::string &window_db){
+  this->Clear();
+  std::ifstream myfile(window_db.c_str());
+  if (!myfile.is_open()) return false;
+
+  //Gather the windows by channel, keeping the order of the file within a channel
+  std::map<unsigned long, std::vector<std::pair<int,int>>> chanwindowmap;
+  std::string fileline;
+  while (getline(myfile,fileline)){
+    if (fileline.find("#") != std::string::npos) continue;
+    std::vector<std::string> dataline;
+    std::stringstream linestream(fileline);
+    std::string field;
+    while (getline(linestream,field,',')) if (!field.empty()) dataline.push_back(field);
+    if (dataline.empty()) continue;
+    unsigned long chanvalue = std::stoul(dataline.at(0));
+    int windowminvalue = std::stoi(dataline.at(1));
+    int windowmaxvalue = std::stoi(dataline.at(2));
+    chanwindowmap[chanvalue].emplace_back(windowminvalue,windowmaxvalue);
+  }
+
+  ChannelKeys.reserve(chanwindowmap.size());
+  Offsets.reserve(chanwindowmap.size()+1);
+  for (const auto &apair : chanwindowmap){
+    ChannelKeys.push_back(apair.first);
+    for (const std::pair<int,int> &awindow : apair.second){
+      WindowStart.push_back(awindow.first);
+      WindowEnd.push_back(awindow.second);
+    }
+    Offsets.push_back(WindowStart.size());
+  }
+  return true;
+}
+
+int ADCWindowTable::ChannelIndex(unsigned long channel_key) const {
+  std::vector<unsigned long>::const_iterator it = std::lower_bound(ChannelKeys.begin(),ChannelKeys.end(),channel_key);
+  if (it == ChannelKeys.end() || *it != channel_key) return -1;
+  return static_cast<int>(it-ChannelKeys.begin());
+}
+
+void ADCWindowIntegrator::Integrate(const uint16_t *raw, const double *calibrated, size_t nsamples,
+    const int *starts, const int *ends, size_t nwindows, std::vector<ADCWindowIntegral> &integrals){
+  integrals.resize(nwindows);
+  if (nwindows == 0) return;
+
+  for (size_t w = 0; w < nwindows; w++){
+    if (starts[w] < 0 || ends[w] < starts[w] || static_cast<size_t>(ends[w]) >= nsamples){
+      throw std::out_of_range("ADCWindowIntegrator: window ["+std::to_string(starts[w])+","+std::to_string(ends[w])
+          +"] does not fit a waveform of "+std::to_string(nsamples)+" samples");
+    }
+  }
+
+  Order.resize(nwindows);
+  for (size_t w = 0; w < nwindows; w++) Order[w] = w;
+  if (!std::is_sorted(starts,starts+nwindows)){
+    std::sort(Order.begin(),Order.end(),[starts](size_t a, size_t b){ return starts[a] < starts[b]; });
+  }
+  for (size_t w = 0; w < nwindows; w++){
+    integrals[w].PeakSample = starts[w];
+    integrals[w].MaxADC = raw[starts[w]];
+  }
+
+  //Walk through the samples covered by any window, skipping the gaps between windows,
+  //in segments over which the set of windows holding the samples does not change.  The
+  //prefix sums have one entry per segment boundary; Lo/Hi are the entries at the
+  //start and the end of each window.
+  RawPrefix.resize(2*nwindows+1);
+  ChargePrefix.resize(2*nwindows+1);
+  Lo.resize(nwindows);
+  Hi.resize(nwindows);
+  RawPrefix[0] = 0;
+  ChargePrefix[0] = 0.;
+  Active.clear();
+  size_t count = 0;
+  size_t next = 0;
+  int p = starts[Order[0]];
+  while (true){
+    if (Active.empty()){
+      if (next == nwindows) break;
+      p = std::max(p,starts[Order[next]]);
+    }
+    while (next < nwindows && starts[Order[next]] == p){
+      Lo[Order[next]] = count;
+      Active.push_back(Order[next++]);
+    }
+    int stop = ends[Active[0]];
+    for (size_t a = 1; a < Active.size(); a++) stop = std::min(stop,ends[Active[a]]);
+    if (next < nwindows) stop = std::min(stop,starts[Order[next]]-1);
+
+    unsigned long raw_sum = 0;
+    double charge_sum = 0.;
+    uint16_t max_sample = raw[p];
+    int peak = p;
+    for (int q = p; q <= stop; q++){
+      raw_sum += raw[q];
+      charge_sum += calibrated[q];
+      if (max_sample < raw[q]){
+        max_sample = raw[q];
+        peak = q;
+      }
+    }
+    RawPrefix[count+1] = RawPrefix[count]+raw_sum;
+    ChargePrefix[count+1] = ChargePrefix[count]+charge_sum;
+    count++;
+
+    for (size_t a = 0; a < Active.size(); ){
+      ADCWindowIntegral &integral = integrals[Active[a]];
+      if (integral.MaxADC < max_sample){
+        integral.MaxADC = max_sample;
+        integral.PeakSample = peak;
+      }
+      if (ends[Active[a]] == stop){
+        Hi[Active[a]] = count;
+        Active[a] = Active.back();
+        Active.pop_back();
+      }
+      else a++;
+    }
+    p = stop+1;
+  }
+
+  for (size_t w = 0; w < nwindows; w++){
+    integrals[w].RawArea = RawPrefix[Hi[w]]-RawPrefix[Lo[w]];
+    integrals[w].Charge = ChargePrefix[Hi[w]]-ChargePrefix[Lo[w]];
+  }
+}
@@ -0,0 +1,105 @@
+#ifndef ADCWINDOWTABLE_H
+#define ADCWINDOWTABLE_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+* \class ADCWindowTable
+*
+* Per-channel integration windows of an ADC window DB file (lines of
+* "channel_key,window_start,window_end", in samples, both ends included; lines holding
+* a '#' are skipped), as used for the fixed_windows pulse finding and the LED
+* waveforms.  The file is read once, and the windows are kept in flat arrays: the
+* channels get a dense index (their rank in channel key order), and the windows of
+* channel index i are entries [Offset(i), Offset(i+1)) of the window arrays, in file order.
+*/
+
+class ADCWindowTable {
+
+ public:
+
+  ADCWindowTable() : Offsets(1,0) {}
+
+  /// Read a window DB file, replacing the current table.  Returns false if the file
+  /// could not be opened, leaving the table empty.
+  bool Load(const std::string &window_db);
+  void Clear();
+
+  /// Dense index of a channel key, or -1 if the channel has no windows
+  int ChannelIndex(unsigned long channel_key) const;
+
+  size_t NumChannels() const { return ChannelKeys.size(); }
+  size_t NumWindows() const { return WindowStart.size(); }
+  size_t NumWindows(int channel_index) const { return Offsets[channel_index+1]-Offsets[channel_index]; }
+  unsigned long ChannelKey(int channel_index) const { return ChannelKeys[channel_index]; }
+
+  /// Windows of a channel index: start and end samples of NumWindows(channel_index) windows
+  const int* WindowStarts(int channel_index) const { return WindowStart.data()+Offsets[channel_index]; }
+  const int* WindowEnds(int channel_index) const { return WindowEnd.data()+Offsets[channel_index]; }
+
+ private:
+
+  std::vector<unsigned long> ChannelKeys;  // sorted
+  std::vector<uint32_t> Offsets;           // NumChannels()+1 entries
+  std::vector<int> WindowStart;
+  std::vector<int> WindowEnd;
+
+};
+
+/// Raw area, peak and charge of one integration window
+struct ADCWindowIntegral {
+  size_t PeakSample;       // first sample with the highest raw ADC value
+  unsigned short MaxADC;
+  unsigned long RawArea;   // ADC * samples
+  double Charge;           // calibrated sum, V * samples
+};
+
+/**
+* \class ADCWindowIntegrator
+*
+* Integrates a set of windows of a raw and a calibrated waveform in one pass over the
+* samples covered by any window (gaps between windows are skipped).  The pass runs in
+* segments over which the set of windows holding the samples does not change, and
+* keeps prefix sums of both waveforms at the segment boundaries and the peak of every
+* window.  Areas and charges are then differences of two prefix sums, however many
+* windows there are and however much they overlap.  The scratch buffers are kept
+* between calls, so an integrator should be reused for the waveforms of a channel (it
+* is not thread safe; use one per thread).
+*/
+
+class ADCWindowIntegrator {
+
+ public:
+
+  ADCWindowIntegrator(){}
+
+  /// Integrate the nwindows windows [starts[i], ends[i]] of the nsamples samples of raw
+  /// and calibrated.  Throws std::out_of_range if a window does not lie within the
+  /// waveform or ends before it starts.
+  void Integrate(const uint16_t *raw, const double *calibrated, size_t nsamples,
+      const int *starts, const int *ends, size_t nwindows, std::vector<ADCWindowIntegral> &integrals);
+  /// As above, for the Samples() of a raw and a calibrated waveform (or WaveformView),
+  /// which must have the same size
+  template<typename RawSamples, typename CalibratedSamples>
+  void Integrate(const RawSamples &raw, const CalibratedSamples &calibrated,
+      const int *starts, const int *ends, size_t nwindows, std::vector<ADCWindowIntegral> &integrals){
+    if (nwindows > 0 && raw.size() != calibrated.size()) throw std::out_of_range("ADCWindowIntegrator: raw and calibrated waveform sizes differ");
+    Integrate(raw.data(), calibrated.data(), raw.size(), starts, ends, nwindows, integrals);
+  }
+
+ private:
+
+  std::vector<unsigned long> RawPrefix;
+  std::vector<double> ChargePrefix;
+  std::vector<size_t> Order;    // windows by start sample
+  std::vector<size_t> Active;   // windows holding the current sample
+  std::vector<size_t> Lo;       // prefix entry before the first sample of each window
+  std::vector<size_t> Hi;       // prefix entry after the last sample of each window
+
+};
+
+#endif
@@ -3,6 +3,8 @@
 
 #include "TObject.h"
 
+#include <atomic>
+
 class ANNIERecoObjectTable{
 
  public:
@@ -39,12 +41,13 @@ class ANNIERecoObjectTable{
   ANNIERecoObjectTable();
   ~ANNIERecoObjectTable();
 
-  Int_t numDigits;
-  Int_t numClusters;
-  Int_t numClusterDigits;
-  Int_t numVertices;
-  Int_t numRings;
-  Int_t numEvents;
+  // atomic, as reconstruction objects may be made on several threads at once
+  std::atomic<Int_t> numDigits;          //!
+  std::atomic<Int_t> numClusters;        //!
+  std::atomic<Int_t> numClusterDigits;   //!
+  std::atomic<Int_t> numVertices;        //!
+  std::atomic<Int_t> numRings;           //!
+  std::atomic<Int_t> numEvents;          //!
 
 };
 
@@ -9,10 +9,11 @@
 double FindPulseMax(std::vector<double> *theWav, double &themax, int &maxbin, double &themin, int &minbin);
 std::string GetStdoutFromCommand(std::string command);
 
-// Computes the sample mean and sample variance for a std::vector of numerical
-// values. Based on http://tinyurl.com/mean-var-onl-alg.
-template<typename ElementType> void ComputeMeanAndVariance(
-  const std::vector<ElementType>& data, double& mean, double& var,
+// Computes the sample mean and sample variance for a std::vector (or any container
+// with size() and at(), such as WaveformView samples) of numerical values. Based on
+// http://tinyurl.com/mean-var-onl-alg.
+template<typename Container> void ComputeMeanAndVariance(
+  const Container& data, double& mean, double& var,
   size_t sample_cutoff = std::numeric_limits<size_t>::max(), size_t sample_start=0)
 {
   if ( data.empty() || sample_cutoff == 0 || (data.size()-sample_start) <= 0) {
@@ -31,7 +32,7 @@ template<typename ElementType> void ComputeMeanAndVariance(
   mean = 0.;
 
   for (int lcount=sample_start; lcount<data.size(); ++lcount) {
-    const ElementType x = data.at(lcount);
+    const auto x = data.at(lcount);
     ++num_samples;
     double delta = x - mean;
     mean += delta / num_samples;
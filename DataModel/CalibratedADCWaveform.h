@@ -10,9 +10,9 @@ template <typename T> class CalibratedADCWaveform : public Waveform<T> {
 
     CalibratedADCWaveform() : Waveform<T>(), fBaseline(0.),
       fSigmaBaseline(0.) {}
-    CalibratedADCWaveform(const double& tc, const std::vector<T>& samples,
+    CalibratedADCWaveform(const double& tc, std::vector<T> samples,
       double baseline, double sigma_bl)
-      : Waveform<T>(tc, samples), fBaseline(baseline),
+      : Waveform<T>(tc, std::move(samples)), fBaseline(baseline),
       fSigmaBaseline(sigma_bl) {}
 
     inline double GetBaseline() const { return fBaseline; }
@@ -0,0 +1,55 @@
+/* vim:set noexpandtab tabstop=4 wrap */
+#ifndef CARDCHANNELKEY_H
+#define CARDCHANNELKEY_H
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+#include <unordered_map>
+
+// Packed integer keys for electronics space.  They replace the heap-allocated
+// std::vector<int>{CardID,ChannelID} and std::vector<int>{Crate,Slot,Channel} keys
+// used in the decoder and event building maps.  Keys sort in the same order as the
+// vectors they replace, so iterating a std::map keyed by them is unchanged.
+//
+// CardChannelKey:      bits 31-8 CardID (Crate*1000+Slot), bits 7-0 ADC channel
+// CrateSlotChannelKey: bits 31-16 crate, bits 15-8 slot, bits 7-0 channel
+typedef uint32_t CardChannelKey;
+typedef uint32_t CrateSlotChannelKey;
+
+// Key type version of the tank wave maps shared through the CStore
+// (InProgressTankEvents, FinishedPMTWaves, FIFOPMTWaves, TimestampsFromTheFuture).
+// Published by PMTDataDecoder as "TankWaveKeyVersion".
+//  1: keyed by std::vector<int>{CardID,ChannelID} (no "TankWaveKeyVersion" entry)
+//  2: keyed by CardChannelKey
+const int TANK_WAVE_KEY_VERSION = 2;
+
+inline CardChannelKey MakeCardChannelKey(int CardID, int ChannelID){
+	return ((uint32_t)CardID << 8) | ((uint32_t)ChannelID & 0xff);
+}
+inline int CardIDFromKey(CardChannelKey key){ return (int)(key >> 8); }
+inline int ChannelIDFromKey(CardChannelKey key){ return (int)(key & 0xff); }
+
+inline CrateSlotChannelKey MakeCrateSlotChannelKey(int Crate, int Slot, int Channel){
+	return ((uint32_t)Crate << 16) | (((uint32_t)Slot & 0xff) << 8) | ((uint32_t)Channel & 0xff);
+}
+inline CrateSlotChannelKey MakeCrateSlotChannelKey(const std::vector<int> &CrateSlotChannel){
+	return MakeCrateSlotChannelKey(CrateSlotChannel.at(0),CrateSlotChannel.at(1),CrateSlotChannel.at(2));
+}
+inline std::vector<int> CrateSlotChannelFromKey(CrateSlotChannelKey key){
+	return std::vector<int>{(int)(key >> 16), (int)((key >> 8) & 0xff), (int)(key & 0xff)};
+}
+
+// Converts a crate space map as published by LoadGeometry (key {crate,slot,channel})
+// into a lookup table keyed by CrateSlotChannelKey
+template<typename T>
+std::unordered_map<CrateSlotChannelKey,T> PackCrateSpaceMap(const std::map<std::vector<int>,T> &CrateSpaceMap){
+	std::unordered_map<CrateSlotChannelKey,T> packed;
+	packed.reserve(CrateSpaceMap.size());
+	for (typename std::map<std::vector<int>,T>::const_iterator it = CrateSpaceMap.begin(); it != CrateSpaceMap.end(); ++it){
+		packed.emplace(MakeCrateSlotChannelKey(it->first),it->second);
+	}
+	return packed;
+}
+
+#endif
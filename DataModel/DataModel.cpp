@@ -1,6 +1,6 @@
 #include "DataModel.h"
 
-DataModel::DataModel(){}
+DataModel::DataModel():Profiler(0){}
 
 /*
 TTree* DataModel::GetTTree(std::string name){
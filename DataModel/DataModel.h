@@ -17,6 +17,7 @@
 #include "BeamStatusClass.h"
 #include "BeamStatus.h"
 #include "ChannelKey.h"
+#include "CardChannelKey.h"
 #include "Detector.h"
 #include "Direction.h"
 #include "Geometry.h"
@@ -38,6 +39,7 @@
 #include "LAPPDPulse.h"
 #include "CardData.h"
 #include "TriggerData.h"
+#include "ToolProfiler.h"
 
 #include <zmq.hpp>
 
@@ -72,6 +74,8 @@ class DataModel {
 
   zmq::context_t* context; ///< ZMQ contex used for producing zmq sockets for inter thread,  process, or computer communication
 
+  ToolProfiler* Profiler; ///< Per tool timing and memory profiler, made by the first tool initialised when ToolProfiling is on in the ToolChainConfig, otherwise null
+
 
  private:
 
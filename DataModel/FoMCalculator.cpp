@@ -1,5 +1,7 @@
 #include "FoMCalculator.h"
 
+#include <algorithm>
+
 //Constructor
 FoMCalculator::FoMCalculator() {
   fVtxGeo = 0;
@@ -303,27 +305,199 @@ void FoMCalculator::PointVertexChi2(double vtxX, double vtxY, double vtxZ,
   return;
 }
 
-void FoMCalculator::ExtendedVertexChi2(double vtxX, double vtxY, double vtxZ, double dirX, double dirY, double dirZ, double coneAngle, double vtxTime, double& fom)
+void FoMCalculator::ExtendedVertexChi2(double vtxX, double vtxY, double vtxZ, double dirX, double dirY, double dirZ, double coneAngle, double vtxTime, double& fom, double* gradient)
 {  
-  // figure of merit
-  // ===============
-  double vtxFOM = -9999.;
-  double timeFOM = -9999.;
-  double coneFOM = -9999.;
+  // This is CalcExtendedResiduals, TimePropertiesLnL and ConePropertiesFoM in a single
+  // pass over the digit arrays of fVtxGeo, which are only read.  The digits are taken in
+  // blocks: the geometry of a block is calculated first, in a loop that vectorises, then
+  // the likelihood and cone charge of its digits are added up.
+  const VertexGeometry* vtxgeo = this->fVtxGeo;
+  const int nDigits = vtxgeo->fNDigits;
+  const bool* isFiltered = vtxgeo->fIsFiltered;
+  const int* digitType = vtxgeo->fDigitType;
+  const double* digitX = vtxgeo->fDigitX;
+  const double* digitY = vtxgeo->fDigitY;
+  const double* digitZ = vtxgeo->fDigitZ;
+  const double* digitT = vtxgeo->fDigitT;
+  const double* digitQ = vtxgeo->fDigitQ;
+  const double* deltaSigma = vtxgeo->fDeltaSigma;
+
+  // extended residuals
+  double thetadeg = Parameters::CherenkovAngle(); // degrees
+  double theta = thetadeg*(TMath::Pi()/180.0); // degrees->radians
+  double sintheta = sin(theta);
+  double costheta = cos(theta);
+  double cottheta = costheta/sintheta;
+  double fC = Parameters::SpeedOfLight();
+  double fVmu = fC;
+  double fN = Parameters::Index0();
+  double vphoton = fC/fN;
+  double invSintheta = 1.0/sintheta;
+  double invVmu = 1.0/fVmu;
+  double invVphoton = 1.0/vphoton;
+  bool hasDirection = ( dirX*dirX + dirY*dirY + dirZ*dirZ>0.0 );
+
+  // time likelihood: the hit time resolution is scaled by detector type, and the
+  // normalisation of each resolution is only recalculated when the resolution changes
+  double sigmaScale[2];
+  sigmaScale[RecoDigit::PMT8inch] = 1.5;
+  sigmaScale[RecoDigit::lappd_v0] = 1.2;
+  double Pnoise = 1e-8;  //FIXME; Need implementation of noise model
+  double lastSigma = -1.0;
+  double realNorm = 0.0;      // (1-Pnoise)*A
+  double logNorm = 0.0;       // log((1-Pnoise)*A)
+  double noiseRatio = 0.0;    // Pnoise/((1-Pnoise)*A)
+  double chi2 = 0.0;
+  double ndof = 0.0;
+
+  // cone charge: cone edge (low side) and (high side) [muons: 3.0, electrons: 7.0]
+  double coneEdgeLow = 21.0;
+  double coneEdgeHigh = 3.0;
+  double coneCharge = 0.0;
+  double allCharge = 0.0;
+  double degrees = 180.0/TMath::Pi();
+
+  // derivatives of chi2 and coneCharge with respect to (x,y,z,px,py,pz,t)
+  double dChi2[7] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  double dConeCharge[7] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+  const int kBlock = 64;
+  double blockDs[kBlock];
+  double blockCos[kBlock];
+  double blockDelta[kBlock];
+
+  for( int first=0; first<nDigits; first+=kBlock ){
+    const int nBlock = std::min(kBlock, nDigits-first);
+
+    // geometry and extended residuals (as CalcExtendedResiduals)
+    for( int i=0; i<nBlock; i++ ){
+      int idigit = first+i;
+      double dx = digitX[idigit]-vtxX;
+      double dy = digitY[idigit]-vtxY;
+      double dz = digitZ[idigit]-vtxZ;
+      double ds = sqrt(dx*dx+dy*dy+dz*dz);
+      double cosphi = hasDirection ? (dx*dirX+dy*dirY+dz*dirZ)/ds : 1.0;
+      double sin2phi = 1.0-cosphi*cosphi;
+      double sinphi = sqrt( sin2phi>0.0 ? sin2phi : 0.0 );
+      double LtrackCone = ds*(sintheta*cosphi-costheta*sinphi)*invSintheta;
+      double LphotonCone = ds*sinphi*invSintheta;
+      bool insideCone = ( cosphi>costheta );
+      double Ltrack = insideCone ? LtrackCone : 0.0;
+      double Lphoton = insideCone ? LphotonCone : ds;
+      blockDs[i] = ds;
+      blockCos[i] = cosphi;
+      blockDelta[i] = digitT[idigit] - Ltrack*invVmu - Lphoton*invVphoton;
+    }
 
-  // calculate residuals
-  // ===================
-  this->fVtxGeo->CalcExtendedResiduals(vtxX,vtxY,vtxZ,0.0,dirX,dirY,dirZ);
-  
-  // calculate figure of merit
-  // =========================
+    for( int i=0; i<nBlock; i++ ){
+      int idigit = first+i;
+      int type = digitType[idigit];
+
+      // time likelihood (as TimePropertiesLnL):
+      //   -2*log(P), P = (1-Pnoise)*A*exp(-x) + Pnoise, x = residual^2/(2*sigma^2)
+      // written as log((1-Pnoise)*A) - x + log(1+y), y = noiseRatio*exp(x), so that
+      // log(1+y) is a short series while the hit is well above the noise
+      double sigma = deltaSigma[idigit];
+      if( type==RecoDigit::PMT8inch || type==RecoDigit::lappd_v0 ) sigma *= sigmaScale[type];
+      if( sigma!=lastSigma ){
+        double A = 1.0 / ( 2.0*sigma*sqrt(0.5*TMath::Pi()) ); //normalisation constant
+        realNorm = (1.0-Pnoise)*A;
+        logNorm = log(realNorm);
+        noiseRatio = Pnoise/realNorm;
+        lastSigma = sigma;
+      }
+      double residual = blockDelta[i] - vtxTime;
+      double x = (residual*residual)/(2.0*sigma*sigma);
+      double expx = exp(-x);
+      double realFraction = 0.0;  // (1-Pnoise)*A*exp(-x)/P
+      if( expx>1e4*noiseRatio ){
+        double y = noiseRatio/expx;
+        chi2 += -2.0*( logNorm - x + y*(1.0 - y*(0.5 - y*(1.0/3.0 - 0.25*y))) );
+        realFraction = 1.0/(1.0+y);
+      }
+      else{
+        double P = realNorm*expx + Pnoise;
+        chi2 += -2.0*log(P);
+        realFraction = realNorm*expx/P;
+      }
+      ndof += 1.0;
+
+      // cone charge (as ConePropertiesFoM)
+      bool inCharge = ( isFiltered[idigit] && type==RecoDigit::PMT8inch );
+      double cosphi = blockCos[i];
+      double digitCharge = digitQ[idigit];
+      double deltaAngle = 0.0;
+      double coneEdge = 0.0;
+      double u = 0.0;
+      if( inCharge ){
+        deltaAngle = ( hasDirection ? acos(cosphi)*degrees : 0.0 ) - coneAngle;
+        bool insideEdge = ( deltaAngle<=0.0 );
+        coneEdge = insideEdge ? coneEdgeLow : coneEdgeHigh;
+        u = 1.0 + (deltaAngle*deltaAngle)/(coneEdge*coneEdge);
+        double coneWeight = insideEdge ? 0.75 + 0.25/u : 0.00 + 1.00/u;
+        coneCharge += digitCharge*coneWeight;
+        allCharge += digitCharge;
+      }
 
-  this->ConePropertiesFoM(coneAngle,coneFOM);
-  this->TimePropertiesLnL(vtxTime, timeFOM);
+      if( gradient ){
+        // d(delta)/d(ds) and d(delta)/d(cosphi); the 1/sinphi terms are dropped on the
+        // track direction itself, where d(cosphi) vanishes as well
+        double ds = blockDs[i];
+        double sin2phi = 1.0-cosphi*cosphi;
+        double sinphi = sqrt( sin2phi>0.0 ? sin2phi : 0.0 );
+        double invSinphi = ( sinphi>1e-12 ) ? 1.0/sinphi : 0.0;
+        bool insideCone = ( cosphi>costheta );
+        double dDeltaDs = insideCone ? -(cosphi-cottheta*sinphi)/fVmu - sinphi/(sintheta*vphoton) : -1.0/vphoton;
+        double dDeltaDcos = insideCone ? -ds*(1.0+cottheta*cosphi*invSinphi)/fVmu + ds*cosphi*invSinphi/(sintheta*vphoton) : 0.0;
+        // d(ds)/d(vtx) = -p, d(cosphi)/d(vtx) = (cosphi*p - dir)/ds, d(cosphi)/d(dir) = p
+        double p[3] = { (digitX[idigit]-vtxX)/ds, (digitY[idigit]-vtxY)/ds, (digitZ[idigit]-vtxZ)/ds };
+        double dir[3] = { dirX, dirY, dirZ };
+        double dCosDv[3] = {0.0, 0.0, 0.0};
+        double dCosDdir[3] = {0.0, 0.0, 0.0};
+        if( hasDirection ){
+          for( int k=0; k<3; k++ ){
+            dCosDv[k] = (cosphi*p[k]-dir[k])/ds;
+            dCosDdir[k] = p[k];
+          }
+        }
+        // d(-2*log(P))/d(residual)
+        double dChi2Dres = 2.0*realFraction*residual/(sigma*sigma);
+        for( int k=0; k<3; k++ ){
+          dChi2[k] += dChi2Dres*( -dDeltaDs*p[k] + dDeltaDcos*dCosDv[k] );
+          dChi2[3+k] += dChi2Dres*dDeltaDcos*dCosDdir[k];
+        }
+        dChi2[6] += -dChi2Dres;
+        if( inCharge ){
+          // d(cone weight)/d(deltaAngle), then d(deltaAngle)/d(cosphi) = -degrees/sinphi
+          double dConeWeight = -( deltaAngle<=0.0 ? 0.25 : 1.0 )*(2.0*deltaAngle/(coneEdge*coneEdge))/(u*u);
+          double dChargeDcos = -digitCharge*dConeWeight*degrees*invSinphi;
+          for( int k=0; k<3; k++ ){
+            dConeCharge[k] += dChargeDcos*dCosDv[k];
+            dConeCharge[3+k] += dChargeDcos*dCosDdir[k];
+          }
+        }
+      }
+    }
+  }
+
+  // figures of merit
+  // ================
+  double timeFOM = -9999.;
+  double coneFOM = -9999.;
+  double dTimeFOM[7] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  double dConeFOM[7] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  if( ndof>0.0 ){
+    timeFOM = fBaseFOM - 5.0*chi2/ndof;
+    for( int k=0; k<7; k++ ) dTimeFOM[k] = -5.0*dChi2[k]/ndof;
+  }
+  if( allCharge>0.0 ){
+    coneFOM = fBaseFOM*coneCharge/allCharge;
+    for( int k=0; k<7; k++ ) dConeFOM[k] = fBaseFOM*dConeCharge[k]/allCharge;
+  }
   
   double fTimeFitWeight = this->fTimeFitWeight;
   double fConeFitWeight = this->fConeFitWeight;
-  vtxFOM = (fTimeFitWeight*timeFOM+fConeFitWeight*coneFOM)/(fTimeFitWeight+fConeFitWeight);
+  double vtxFOM = (fTimeFitWeight*timeFOM+fConeFitWeight*coneFOM)/(fTimeFitWeight+fConeFitWeight);
 
   // calculate overall figure of merit
   // =================================
@@ -332,6 +506,13 @@ void FoMCalculator::ExtendedVertexChi2(double vtxX, double vtxY, double vtxZ, do
   // truncate
   if( fom<-9999. ) fom = -9999.;
 
+  if( gradient ){
+    for( int k=0; k<7; k++ ){
+      gradient[k] = ( vtxFOM<-9999. ) ? 0.0
+                  : (fTimeFitWeight*dTimeFOM[k]+fConeFitWeight*dConeFOM[k])/(fTimeFitWeight+fConeFitWeight);
+    }
+  }
+
   return;
 }
 
@@ -55,9 +55,12 @@ public:
   void PointVertexChi2(double vtxX, double vtxY, double vtxZ,
 	                                    double dirX, double dirY, double dirZ, 
 	                                    double coneAngle, double vtxTime, double& fom);
+  // Extended residuals, time likelihood and cone charge in one pass over the digits.
+  // If gradient is given, it is filled with d(fom)/d(vtxX,vtxY,vtxZ,dirX,dirY,dirZ,vtxTime).
   void ExtendedVertexChi2(double vtxX, double vtxY, double vtxZ, 
 	                                    double dirX, double dirY, double dirZ, 
-	                                    double coneAngle, double vtxTime, double& fom);
+	                                    double coneAngle, double vtxTime, double& fom,
+	                                    double* gradient = 0);
 //  void ConePropertiesLnL(double coneParam0, double coneParam1, double coneParam2, double& coneAngle, double& coneFOM);
 //  void CorrectedVertexChi2(double vtxX, double vtxY, double vtxZ, 
 //	                                    double dirX, double dirY, double dirZ, 
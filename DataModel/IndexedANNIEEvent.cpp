@@ -0,0 +1,126 @@
+#include "IndexedANNIEEvent.h"
+
+#include <stdint.h>
+#include <map>
+
+#include <boost/serialization/map.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include "ADCPulse.h"
+#include "BeamStatus.h"
+#include "Hit.h"
+#include "PsecData.h"
+#include "TimeClass.h"
+#include "TriggerClass.h"
+#include "Waveform.h"
+#include "WaveformBlock.h"
+
+typedef bool (*ANNIEEventKeyWriter)(BoostStore&, const std::string&, IndexedEventWriter&);
+typedef bool (*ANNIEEventKeyReader)(const IndexedEventFile&, size_t, const std::string&, BoostStore&);
+
+struct ANNIEEventKeyCodec {
+  ANNIEEventKeyWriter Write;
+  ANNIEEventKeyReader Read;
+};
+
+template<typename T> static bool WriteValue(BoostStore &store, const std::string &key, IndexedEventWriter &writer){
+  T value;
+  if(!store.Get(key,value)) return false;
+  writer.Set(key,value);
+  return true;
+}
+
+template<typename T> static bool ReadValue(const IndexedEventFile &file, size_t entry, const std::string &key, BoostStore &store){
+  T value;
+  if(!file.Get(entry,key,value)) return false;
+  store.Set(key,value);
+  return true;
+}
+
+template<typename T> static bool WritePointer(BoostStore &store, const std::string &key, IndexedEventWriter &writer){
+  T *value = nullptr;
+  if(!store.Get(key,value) || value==nullptr) return false;
+  writer.Set(key,*value);
+  return true;
+}
+
+template<typename T> static bool ReadPointer(const IndexedEventFile &file, size_t entry, const std::string &key, BoostStore &store){
+  T *value = new T;
+  if(!file.Get(entry,key,*value)){
+    delete value;
+    return false;
+  }
+  store.Set(key,value,true);
+  return true;
+}
+
+template<typename T> static ANNIEEventKeyCodec ValueCodec(){ return ANNIEEventKeyCodec{&WriteValue<T>, &ReadValue<T>}; }
+template<typename T> static ANNIEEventKeyCodec PointerCodec(){ return ANNIEEventKeyCodec{&WritePointer<T>, &ReadPointer<T>}; }
+
+// The ANNIEEvent keys and the types the ANNIEEventBuilder sets them with
+static const std::map<std::string,ANNIEEventKeyCodec>& KeyCodecs(){
+  typedef std::map<unsigned long,std::vector<Hit>> HitMap;
+  static const std::map<std::string,ANNIEEventKeyCodec> codecs = {
+    // run and event information
+    {"EventNumber", ValueCodec<uint32_t>()},
+    {"RunNumber", ValueCodec<int>()},
+    {"SubrunNumber", ValueCodec<int>()},
+    {"PartNumber", ValueCodec<int>()},
+    {"RunType", ValueCodec<int>()},
+    {"RunStartTime", ValueCodec<uint64_t>()},
+    {"DataStreams", ValueCodec<std::map<std::string,bool>>()},
+    // trigger
+    {"CTCTimestamp", ValueCodec<uint64_t>()},
+    {"TriggerWord", ValueCodec<uint32_t>()},
+    {"TriggerExtended", ValueCodec<int>()},
+    {"TriggerData", ValueCodec<TriggerClass>()},
+    {"BeamStatus", ValueCodec<BeamStatus>()},
+    // tank PMTs
+    {"EventTimeTank", ValueCodec<uint64_t>()},
+    {"RawADCData", ValueCodec<std::map<unsigned long,std::vector<Waveform<uint16_t>>>>()},
+    {"RawADCAuxData", ValueCodec<std::map<unsigned long,std::vector<Waveform<uint16_t>>>>()},
+    {"RawADCDataBlock", ValueCodec<WaveformBlock<uint16_t>>()},
+    {"RawADCAuxDataBlock", ValueCodec<WaveformBlock<uint16_t>>()},
+    {"Hits", PointerCodec<HitMap>()},
+    {"AuxHits", PointerCodec<HitMap>()},
+    {"RecoADCData", ValueCodec<std::map<unsigned long,std::vector<std::vector<ADCPulse>>>>()},
+    {"RecoAuxADCData", ValueCodec<std::map<unsigned long,std::vector<std::vector<ADCPulse>>>>()},
+    {"RawAcqSize", ValueCodec<std::map<unsigned long,std::vector<int>>>()},
+    // MRD
+    {"TDCData", PointerCodec<HitMap>()},
+    {"EventTimeMRD", ValueCodec<TimeClass>()},
+    {"MRDTriggerType", ValueCodec<std::string>()},
+    {"MRDLoopbackTDC", ValueCodec<std::map<std::string,int>>()},
+    // LAPPD
+    {"LAPPDData", ValueCodec<PsecData>()},
+    {"EventTimeLAPPD", ValueCodec<uint64_t>()},
+    {"LAPPDOffset", ValueCodec<uint64_t>()}
+  };
+  return codecs;
+}
+
+const std::vector<std::string>& IndexedANNIEEventKeys(){
+  static const std::vector<std::string> keys = [](){
+    std::vector<std::string> names;
+    for(const std::pair<const std::string,ANNIEEventKeyCodec> &codec : KeyCodecs()) names.push_back(codec.first);
+    return names;
+  }();
+  return keys;
+}
+
+bool IsIndexedANNIEEventKey(const std::string &key){
+  return KeyCodecs().count(key) > 0;
+}
+
+bool WriteANNIEEventKey(BoostStore &store, const std::string &key, IndexedEventWriter &writer){
+  std::map<std::string,ANNIEEventKeyCodec>::const_iterator it = KeyCodecs().find(key);
+  if(it == KeyCodecs().end() || !store.Has(key)) return false;
+  return it->second.Write(store,key,writer);
+}
+
+bool ReadANNIEEventKey(const IndexedEventFile &file, size_t entry, const std::string &key, BoostStore &store){
+  std::map<std::string,ANNIEEventKeyCodec>::const_iterator it = KeyCodecs().find(key);
+  if(it == KeyCodecs().end()) return false;
+  return it->second.Read(file,entry,key,store);
+}
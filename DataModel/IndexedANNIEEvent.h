@@ -0,0 +1,33 @@
+#ifndef INDEXEDANNIEEVENT_H
+#define INDEXEDANNIEEVENT_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "BoostStore.h"
+#include "IndexedEventFile.h"
+
+/**
+* Copying of ANNIEEvent entries between a BoostStore and an indexed event file (see
+* IndexedEventFile.h).  A BoostStore only learns the type of a value when it is read, so
+* the type of every key has to be known here.  These are the keys the ANNIEEventBuilder
+* writes into ProcessedData files, listed by IndexedANNIEEventKeys(); other keys are not
+* copied.  A key written by another tool is added by adding its type to the table in
+* IndexedANNIEEvent.cpp.
+*/
+
+/// The ANNIEEvent keys that can be copied
+const std::vector<std::string>& IndexedANNIEEventKeys();
+bool IsIndexedANNIEEventKey(const std::string &key);
+
+/// Serialise a key of an ANNIEEvent entry into the current entry of writer.  Returns
+/// false if the key is not known or the store does not hold it.
+bool WriteANNIEEventKey(BoostStore &store, const std::string &key, IndexedEventWriter &writer);
+
+/// Deserialise a key of an entry of file and Set it in an ANNIEEvent store, the way the
+/// ANNIEEventBuilder sets it: Hits, AuxHits and TDCData as pointers owned by the store,
+/// everything else by value.  Returns false if the key is not known or not in the entry.
+bool ReadANNIEEventKey(const IndexedEventFile &file, size_t entry, const std::string &key, BoostStore &store);
+
+#endif
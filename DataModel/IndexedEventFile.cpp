@@ -0,0 +1,225 @@
+#include "IndexedEventFile.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char INDEXED_EVENT_MAGIC[8] = {'A','N','N','I','E','I','D','X'};
+static const uint32_t INDEXED_EVENT_VERSION = 1;
+static const size_t INDEXED_EVENT_HEADER_SIZE = 16;
+static const size_t INDEXED_EVENT_TRAILER_SIZE = 16;
+
+template<typename T> static void WriteRaw(std::ofstream &out, T value){
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Reads a T at pos of the mapping, advancing pos; false if it would read past end
+template<typename T> static bool ReadRaw(const char *data, size_t end, size_t &pos, T &value){
+  if(end < pos || end-pos < sizeof(T)) return false;
+  std::memcpy(&value, data+pos, sizeof(T));
+  pos += sizeof(T);
+  return true;
+}
+
+IndexedEventWriter::IndexedEventWriter() : Offset(0), EntryFirstRecord(1,0) {}
+
+IndexedEventWriter::~IndexedEventWriter(){
+  Close();
+}
+
+bool IndexedEventWriter::Open(const std::string &filename){
+  Close();
+  Out.open(filename, std::ios::binary | std::ios::trunc);
+  if(!Out.is_open()) return false;
+  Out.write(INDEXED_EVENT_MAGIC, sizeof(INDEXED_EVENT_MAGIC));
+  WriteRaw<uint32_t>(Out, INDEXED_EVENT_VERSION);
+  WriteRaw<uint32_t>(Out, 0);
+  Offset = INDEXED_EVENT_HEADER_SIZE;
+  return true;
+}
+
+void IndexedEventWriter::SetBytes(const std::string &key, const char *data, size_t size){
+  if(!Out.is_open()) return;
+  std::map<std::string,uint32_t>::iterator it = KeyNumbers.find(key);
+  if(it == KeyNumbers.end()){
+    it = KeyNumbers.emplace(key, KeyNames.size()).first;
+    KeyNames.push_back(key);
+  }
+  // a key set again in the same entry points its record at the new value, so the index
+  // holds each key of an entry once; the bytes of the old value stay unused in the file
+  ValueRecord *record = nullptr;
+  for(size_t i_record=EntryFirstRecord.back(); i_record<Records.size(); ++i_record){
+    if(Records[i_record].Key == it->second) record = &Records[i_record];
+  }
+  if(record == nullptr){
+    Records.emplace_back();
+    record = &Records.back();
+    record->Key = it->second;
+  }
+  record->Offset = Offset;
+  record->Size = size;
+  Out.write(data, size);
+  Offset += size;
+}
+
+void IndexedEventWriter::WriteEntry(){
+  EntryFirstRecord.push_back(Records.size());
+}
+
+bool IndexedEventWriter::Close(){
+  if(!Out.is_open()) return true;
+  if(Records.size() > EntryFirstRecord.back()) WriteEntry();
+
+  const uint64_t index_offset = Offset;
+  WriteRaw<uint32_t>(Out, KeyNames.size());
+  for(const std::string &name : KeyNames){
+    WriteRaw<uint32_t>(Out, name.size());
+    Out.write(name.data(), name.size());
+  }
+  WriteRaw<uint64_t>(Out, EntryFirstRecord.size()-1);
+  for(uint64_t first : EntryFirstRecord) WriteRaw<uint64_t>(Out, first);
+  WriteRaw<uint64_t>(Out, Records.size());
+  for(const ValueRecord &record : Records){
+    WriteRaw<uint32_t>(Out, record.Key);
+    WriteRaw<uint32_t>(Out, 0);
+    WriteRaw<uint64_t>(Out, record.Offset);
+    WriteRaw<uint64_t>(Out, record.Size);
+  }
+  WriteRaw<uint64_t>(Out, index_offset);
+  Out.write(INDEXED_EVENT_MAGIC, sizeof(INDEXED_EVENT_MAGIC));
+
+  bool ok = Out.good();
+  Out.close();
+  Offset = 0;
+  KeyNumbers.clear();
+  KeyNames.clear();
+  Records.clear();
+  EntryFirstRecord.assign(1,0);
+  return ok;
+}
+
+IndexedEventFile::IndexedEventFile() : Data(nullptr), Size(0) {}
+
+IndexedEventFile::~IndexedEventFile(){
+  Close();
+}
+
+bool IndexedEventFile::Open(const std::string &filename){
+  Close();
+  int fd = open(filename.c_str(), O_RDONLY);
+  if(fd < 0) return false;
+  struct stat info;
+  if(fstat(fd, &info) != 0 || (size_t)info.st_size < INDEXED_EVENT_HEADER_SIZE+INDEXED_EVENT_TRAILER_SIZE){
+    close(fd);
+    return false;
+  }
+  void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);   // the mapping keeps the file open
+  if(mapping == MAP_FAILED) return false;
+  Data = static_cast<const char*>(mapping);
+  Size = info.st_size;
+  Name = filename;
+  // values are read in no particular order, so don't read ahead of them
+  madvise(mapping, Size, MADV_RANDOM);
+
+  if(!ReadIndex()){
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void IndexedEventFile::Close(){
+  if(Data != nullptr) munmap(const_cast<char*>(Data), Size);
+  Data = nullptr;
+  Size = 0;
+  Name.clear();
+  KeyNumbers.clear();
+  KeyNames.clear();
+  Records.clear();
+  EntryFirstRecord.clear();
+}
+
+bool IndexedEventFile::ReadIndex(){
+  if(std::memcmp(Data, INDEXED_EVENT_MAGIC, sizeof(INDEXED_EVENT_MAGIC)) != 0) return false;
+  if(std::memcmp(Data+Size-sizeof(INDEXED_EVENT_MAGIC), INDEXED_EVENT_MAGIC, sizeof(INDEXED_EVENT_MAGIC)) != 0) return false;
+  size_t pos = sizeof(INDEXED_EVENT_MAGIC);
+  uint32_t version = 0;
+  ReadRaw(Data, Size, pos, version);
+  if(version != INDEXED_EVENT_VERSION) return false;
+
+  const size_t index_end = Size-INDEXED_EVENT_TRAILER_SIZE;
+  uint64_t index_offset = 0;
+  pos = index_end;
+  ReadRaw(Data, Size, pos, index_offset);
+  if(index_offset < INDEXED_EVENT_HEADER_SIZE || index_offset > index_end) return false;
+
+  pos = index_offset;
+  uint32_t num_keys = 0;
+  if(!ReadRaw(Data, index_end, pos, num_keys)) return false;
+  for(uint32_t i_key=0; i_key<num_keys; ++i_key){
+    uint32_t length = 0;
+    if(!ReadRaw(Data, index_end, pos, length) || index_end-pos < length) return false;
+    KeyNames.emplace_back(Data+pos, length);
+    KeyNumbers.emplace(KeyNames.back(), i_key);
+    pos += length;
+  }
+
+  uint64_t num_entries = 0;
+  if(!ReadRaw(Data, index_end, pos, num_entries) || (index_end-pos)/sizeof(uint64_t) < num_entries+1) return false;
+  EntryFirstRecord.resize(num_entries+1);
+  for(uint64_t &first : EntryFirstRecord) ReadRaw(Data, index_end, pos, first);
+
+  uint64_t num_records = 0;
+  if(!ReadRaw(Data, index_end, pos, num_records) || (index_end-pos)/24 < num_records) return false;
+  Records.resize(num_records);
+  for(ValueRecord &record : Records){
+    uint32_t padding = 0;
+    ReadRaw(Data, index_end, pos, record.Key);
+    ReadRaw(Data, index_end, pos, padding);
+    ReadRaw(Data, index_end, pos, record.Offset);
+    ReadRaw(Data, index_end, pos, record.Size);
+    if(record.Key >= num_keys || record.Offset > index_offset || record.Size > index_offset-record.Offset) return false;
+  }
+  for(size_t i_entry=0; i_entry<num_entries; ++i_entry){
+    if(EntryFirstRecord[i_entry] > EntryFirstRecord[i_entry+1]) return false;
+  }
+  if(EntryFirstRecord.back() != num_records) return false;
+  return true;
+}
+
+const IndexedEventFile::ValueRecord* IndexedEventFile::FindRecord(size_t entry, const std::string &key) const {
+  if(entry >= NumEntries()) return nullptr;
+  std::map<std::string,uint32_t>::const_iterator it = KeyNumbers.find(key);
+  if(it == KeyNumbers.end()) return nullptr;
+  // an entry has a few dozen values at most, each key once
+  for(uint64_t i_record=EntryFirstRecord[entry]; i_record<EntryFirstRecord[entry+1]; ++i_record){
+    if(Records[i_record].Key == it->second) return &Records[i_record];
+  }
+  return nullptr;
+}
+
+std::vector<std::string> IndexedEventFile::EntryKeys(size_t entry) const {
+  std::vector<std::string> keys;
+  if(entry >= NumEntries()) return keys;
+  for(uint64_t i_record=EntryFirstRecord[entry]; i_record<EntryFirstRecord[entry+1]; ++i_record){
+    keys.push_back(KeyNames[Records[i_record].Key]);
+  }
+  return keys;
+}
+
+bool IndexedEventFile::Has(size_t entry, const std::string &key) const {
+  return FindRecord(entry, key) != nullptr;
+}
+
+const char* IndexedEventFile::GetBytes(size_t entry, const std::string &key, size_t &size) const {
+  const ValueRecord *record = FindRecord(entry, key);
+  if(record == nullptr){
+    size = 0;
+    return nullptr;
+  }
+  size = record->Size;
+  return Data+record->Offset;
+}
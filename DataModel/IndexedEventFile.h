@@ -0,0 +1,166 @@
+#ifndef INDEXEDEVENTFILE_H
+#define INDEXEDEVENTFILE_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+
+/**
+* Indexed event files hold entries of named values (like the entries of a multi-event
+* BoostStore), but every value is serialised on its own, and an index of all values is
+* kept at the end of the file.  Any value of any entry can therefore be read without
+* reading or decoding anything else.
+*
+* File layout (integers in the byte order of the machine that wrote the file):
+*   header   "ANNIEIDX", uint32 format version, uint32 0
+*   values   the values as boost binary archives without archive header, entry by entry
+*   index    uint32 number of keys, then per key a uint32 length and the name
+*            uint64 number of entries, then per entry the uint64 number of its first
+*            value record, and one more for the end of the last entry
+*            uint64 number of value records, then per record a uint32 key number,
+*            uint32 0, uint64 file offset and uint64 size of the value
+*   trailer  uint64 file offset of the index, "ANNIEIDX"
+*/
+
+/**
+* \class IndexedEventWriter
+*
+* Writes an indexed event file.  The values of an entry are Set() one at a time and
+* written to the file straight away; WriteEntry() closes the entry.  Close() writes the
+* index.  A file that is not closed has no index and can't be read.
+*/
+
+class IndexedEventWriter {
+
+ public:
+
+  IndexedEventWriter();
+  ~IndexedEventWriter();   ///< Closes the file
+
+  /// Start a new file, closing the current one.  Returns false if it can't be created.
+  bool Open(const std::string &filename);
+  bool IsOpen() const { return Out.is_open(); }
+
+  /// Add a value to the current entry.  A key set twice in an entry keeps only the last value.
+  template<typename T> void Set(const std::string &key, const T &value){
+    std::ostringstream stream;
+    {
+      boost::archive::binary_oarchive oa(stream, boost::archive::no_header);
+      oa << value;
+    }
+    const std::string bytes = stream.str();
+    SetBytes(key, bytes.data(), bytes.size());
+  }
+  void SetBytes(const std::string &key, const char *data, size_t size);
+
+  void WriteEntry();        ///< Close the current entry (an entry may have no values)
+  bool Close();             ///< Close an entry that still has values, write the index and close the file
+  size_t NumEntries() const { return EntryFirstRecord.size()-1; }
+
+ private:
+
+  struct ValueRecord {
+    uint32_t Key;
+    uint64_t Offset;
+    uint64_t Size;
+  };
+
+  std::ofstream Out;
+  uint64_t Offset;                               // file offset of the next value
+  std::map<std::string,uint32_t> KeyNumbers;
+  std::vector<std::string> KeyNames;
+  std::vector<ValueRecord> Records;
+  std::vector<uint64_t> EntryFirstRecord;        // entries+1 elements
+
+};
+
+/**
+* \class IndexedEventFile
+*
+* Reads an indexed event file.  The file is memory-mapped and only its index is read by
+* Open(), so opening is cheap however large the file is.  Get() deserialises a single
+* value of a single entry, in any order of entries and keys; the pages of the other
+* values are never touched.  A file may be read from several threads at once.
+*/
+
+class IndexedEventFile {
+
+ public:
+
+  IndexedEventFile();
+  ~IndexedEventFile();   ///< Unmaps the file
+
+  /// Map a file and read its index.  Returns false, leaving no file open, if the file
+  /// can't be opened or is not a complete indexed event file.
+  bool Open(const std::string &filename);
+  void Close();
+  bool IsOpen() const { return Data!=nullptr; }
+  const std::string& FileName() const { return Name; }
+
+  size_t NumEntries() const { return EntryFirstRecord.empty() ? 0 : EntryFirstRecord.size()-1; }
+  const std::vector<std::string>& Keys() const { return KeyNames; }   ///< All keys used in the file
+  std::vector<std::string> EntryKeys(size_t entry) const;             ///< Keys of one entry, in the order they were first set
+  bool Has(size_t entry, const std::string &key) const;
+
+  /// Serialised bytes of a value; nullptr if the entry does not hold the key
+  const char* GetBytes(size_t entry, const std::string &key, size_t &size) const;
+
+  /// Deserialise a value.  Returns false if the entry does not hold the key or the value
+  /// can't be deserialised as a T.
+  template<typename T> bool Get(size_t entry, const std::string &key, T &out) const {
+    size_t size = 0;
+    const char *bytes = GetBytes(entry, key, size);
+    if(bytes==nullptr) return false;
+    try {
+      MemoryBuffer buffer(bytes, size);
+      boost::archive::binary_iarchive ia(buffer, boost::archive::no_header);
+      ia >> out;
+    } catch(std::exception &e){
+      return false;
+    }
+    return true;
+  }
+
+ private:
+
+  /// Read-only streambuf over a value of the mapping
+  class MemoryBuffer : public std::streambuf {
+   public:
+    MemoryBuffer(const char *data, size_t size){
+      char *begin = const_cast<char*>(data);
+      setg(begin, begin, begin+size);
+    }
+  };
+
+  struct ValueRecord {
+    uint32_t Key;
+    uint64_t Offset;
+    uint64_t Size;
+  };
+
+  bool ReadIndex();
+  const ValueRecord* FindRecord(size_t entry, const std::string &key) const;
+
+  IndexedEventFile(const IndexedEventFile&) = delete;
+  IndexedEventFile& operator=(const IndexedEventFile&) = delete;
+
+  std::string Name;
+  const char *Data;
+  size_t Size;
+  std::map<std::string,uint32_t> KeyNumbers;
+  std::vector<std::string> KeyNames;
+  std::vector<ValueRecord> Records;
+  std::vector<uint64_t> EntryFirstRecord;
+
+};
+
+#endif
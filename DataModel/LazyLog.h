@@ -0,0 +1,20 @@
+#ifndef LAZYLOG_H
+#define LAZYLOG_H
+
+/**
+* LOG_LAZY(message, level, verbosity)
+*
+* Same as Log(message, level, verbosity) from within a Tool, except that the message
+* expression is only evaluated if the level passes the verbosity.  Use it for Log calls in
+* per-entry and per-waveform code, where building the std::string (to_string and
+* concatenation, or just copying a long literal) costs more than the check:
+*
+*   LOG_LAZY("PMTDataDecoder Tool: Bank size is "+to_string(bank.size()),v_debug,verbosity);
+*
+* The level and verbosity are evaluated twice, so they should not have side effects.
+*/
+
+#define LOG_LAZY(message,level,verbosity) \
+  do { if((level)<=(verbosity)) Log((message),(level),(verbosity)); } while(0)
+
+#endif
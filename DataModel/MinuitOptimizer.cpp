@@ -18,25 +18,23 @@
 #include <cassert>
 using namespace std;
 
-static MinuitOptimizer* fgMinuitOptimizer = 0;
-static FoMCalculator* fgFoMCalculator = 0;
-static void vertex_time_lnl(int&, double*, double& f, double* par, int)
+void MinuitOptimizer::vertex_time_lnl(double* par, double& f)
 {  
 
   bool printDebugMessages = 0;
   
   double vtxTime = par[0]; // nanoseconds
   double fom = -9999.;
-  fgMinuitOptimizer->time_fit_itr();  
-  fgFoMCalculator->TimePropertiesLnL(vtxTime, fom);
+  this->time_fit_itr();  
+  fFoMCalculator->TimePropertiesLnL(vtxTime, fom);
   f = -fom; // note: need to maximize this fom
   if( printDebugMessages ){
-    std::cout << "  [vertex_time_lnl] [" << fgMinuitOptimizer->time_fit_iterations() << "] vtime=" << vtxTime << " fom=" << fom << std::endl;
+    std::cout << "  [vertex_time_lnl] [" << this->time_fit_iterations() << "] vtime=" << vtxTime << " fom=" << fom << std::endl;
   }
   return;
 }
 
-static void point_position_chi2(int&, double*, double& f, double* par, int)
+void MinuitOptimizer::point_position_chi2(double* par, double& f)
 {
   bool printDebugMessages = 0;
 
@@ -46,26 +44,26 @@ static void point_position_chi2(int&, double*, double& f, double* par, int)
   double vtxTime = par[3]; //ns, added by JW
 
   double fom = -9999.;
-  fgMinuitOptimizer->point_position_itr();
-  fgFoMCalculator->PointPositionChi2(vtxX,vtxY,vtxZ,vtxTime,fom);
+  this->point_position_itr();
+  fFoMCalculator->PointPositionChi2(vtxX,vtxY,vtxZ,vtxTime,fom);
 
 
   f = -fom; // note: need to maximize this fom
 
   if( printDebugMessages ){
-    std::cout << " [point_position_chi2] [" << fgMinuitOptimizer->point_position_iterations() << "] (x,y,z)=(" << vtxX << "," << vtxY << "," << vtxZ << ") vtime=" << vtxTime << " fom=" << fom << std::endl;
+    std::cout << " [point_position_chi2] [" << this->point_position_iterations() << "] (x,y,z)=(" << vtxX << "," << vtxY << "," << vtxZ << ") vtime=" << vtxTime << " fom=" << fom << std::endl;
   }
 
   return;
 }
 
-static void point_direction_chi2(int&, double*, double& f, double* par, int)
+void MinuitOptimizer::point_direction_chi2(double* par, double& f)
 {
   bool printDebugMessages = 0;
   
-  double vtxX = fgMinuitOptimizer->fVtxX;
-  double vtxY = fgMinuitOptimizer->fVtxY;
-  double vtxZ = fgMinuitOptimizer->fVtxZ;
+  double vtxX = this->fVtxX;
+  double vtxY = this->fVtxY;
+  double vtxZ = this->fVtxZ;
   
   double dirX = 0.0;
   double dirY = 0.0;
@@ -80,24 +78,24 @@ static void point_direction_chi2(int&, double*, double& f, double* par, int)
 
   double fom = -9999.;
 
-  double coneAngle = fgMinuitOptimizer->fConeAngle; //Cherenkov cone angle
+  double coneAngle = this->fConeAngle; //Cherenkov cone angle
 
-  fgMinuitOptimizer->point_direction_itr();
-  fgFoMCalculator->PointDirectionChi2(vtxX,vtxY,vtxZ,
+  this->point_direction_itr();
+  fFoMCalculator->PointDirectionChi2(vtxX,vtxY,vtxZ,
                                      dirX,dirY,dirZ,
                                      coneAngle, fom);
   f = -fom; // note: need to maximize this fom
 
   if( printDebugMessages ){
-    std::cout << " [point_direction_chi2] [" << fgMinuitOptimizer->point_direction_iterations() 
-    	<< "] (px,py,pz)=(" << fgMinuitOptimizer->fDirX << "," << fgMinuitOptimizer->fDirY << "," 
-    	<< fgMinuitOptimizer->fDirZ << ") fom=" << fom << std::endl;
+    std::cout << " [point_direction_chi2] [" << this->point_direction_iterations() 
+    	<< "] (px,py,pz)=(" << this->fDirX << "," << this->fDirY << "," 
+    	<< this->fDirZ << ") fom=" << fom << std::endl;
   }
 
   return; 
 }
 
-static void point_vertex_chi2(int&, double*, double& f, double* par, int)
+void MinuitOptimizer::point_vertex_chi2(double* par, double& f)
 {
   bool printDebugMessages = 0;
   
@@ -114,21 +112,21 @@ static void point_vertex_chi2(int&, double*, double& f, double* par, int)
   
   double fom = -9999.;
  
-  double coneAngle = fgMinuitOptimizer->fConeAngle; //Cherenkov cone angle
+  double coneAngle = this->fConeAngle; //Cherenkov cone angle
 
-  fgMinuitOptimizer->point_vertex_itr();
-  fgFoMCalculator->PointVertexChi2(vtxX,vtxY,vtxZ,dirX,dirY,dirZ,coneAngle, vtxTime,fom);
+  this->point_vertex_itr();
+  fFoMCalculator->PointVertexChi2(vtxX,vtxY,vtxZ,dirX,dirY,dirZ,coneAngle, vtxTime,fom);
   f = -fom; // note: need to maximize this fom
 
   if( printDebugMessages ){
-    std::cout << " [point_vertex_chi2] [" << fgMinuitOptimizer->point_vertex_iterations() 
+    std::cout << " [point_vertex_chi2] [" << this->point_vertex_iterations() 
     	<< "] (x,y,z)=(" << vtxX << "," << vtxY << "," << vtxZ << ") (px,py,pz)=(" 
     	<< dirX << "," << dirY << "," << dirZ << ") vtime=" << vtxTime << " fom=" << fom << std::endl;
   }
   return;
 }
 
-static void extended_vertex_chi2(int&, double*, double& f, double* par, int)
+void MinuitOptimizer::extended_vertex_chi2(double* par, double& f, double* grad)
 {
   bool printDebugMessages = 0;
   
@@ -144,20 +142,37 @@ static void extended_vertex_chi2(int&, double*, double& f, double* par, int)
   double dirY = sin(dirTheta)*sin(dirPhi);
   double dirZ = cos(dirTheta);
 
-  double coneAngle = fgMinuitOptimizer->fConeAngle; //Cherenkov cone angle
+  double coneAngle = this->fConeAngle; //Cherenkov cone angle
 
   double fom = -9999.;
 
-  fgMinuitOptimizer->extended_vertex_itr();
-  
-  fgFoMCalculator->ExtendedVertexChi2(vtxX,vtxY,vtxZ,
-                                     dirX,dirY,dirZ, 
-                                     coneAngle, vtxTime,fom);
+  this->extended_vertex_itr();
+  
+  if( grad ){
+    // d(fom)/d(x,y,z,px,py,pz,t), then the chain rule to (x,y,z,theta,phi,t)
+    double dfom[7];
+    fFoMCalculator->ExtendedVertexChi2(vtxX,vtxY,vtxZ,
+                                       dirX,dirY,dirZ, 
+                                       coneAngle, vtxTime,fom,dfom);
+    double dDirdTheta[3] = { cos(dirTheta)*cos(dirPhi), cos(dirTheta)*sin(dirPhi), -sin(dirTheta) };
+    double dDirdPhi[3] = { -sin(dirTheta)*sin(dirPhi), sin(dirTheta)*cos(dirPhi), 0.0 };
+    grad[0] = -dfom[0];
+    grad[1] = -dfom[1];
+    grad[2] = -dfom[2];
+    grad[3] = -(dfom[3]*dDirdTheta[0] + dfom[4]*dDirdTheta[1] + dfom[5]*dDirdTheta[2]);
+    grad[4] = -(dfom[3]*dDirdPhi[0] + dfom[4]*dDirdPhi[1] + dfom[5]*dDirdPhi[2]);
+    grad[5] = -dfom[6];
+  }
+  else{
+    fFoMCalculator->ExtendedVertexChi2(vtxX,vtxY,vtxZ,
+                                       dirX,dirY,dirZ, 
+                                       coneAngle, vtxTime,fom);
+  }
 
   f = -fom; // note: need to maximize this fom
 
   if( printDebugMessages ){
-    std::cout << " [extended_vertex_chi2] [" << fgMinuitOptimizer->extended_vertex_iterations() 
+    std::cout << " [extended_vertex_chi2] [" << this->extended_vertex_iterations() 
     	<< "] (x,y,z)=(" << vtxX << "," << vtxY << "," << vtxZ << ") (px,py,pz)=(" << dirX << "," 
     	<< dirY << "," << dirZ << ") vtime=" << vtxTime << " fom=" << fom << std::endl;  
   }
@@ -167,8 +182,7 @@ static void extended_vertex_chi2(int&, double*, double& f, double* par, int)
 
 //Constructor
 MinuitOptimizer::MinuitOptimizer() {
-  fgMinuitOptimizer = this;
-  fgFoMCalculator = new FoMCalculator();
+  fFoMCalculator = new FoMCalculator();
   fSeedVtx = 0;
   fFittedVtx = new RecoVertex();
   fVtxX = -9999.;
@@ -188,6 +202,7 @@ MinuitOptimizer::MinuitOptimizer() {
   fPass = 0;
   fItr = 0;
   fPrintLevel = -1;
+  fUseAnalyticGradient = false;
 
   fFixTimeParam0 = 0.20;  // scattering parameter (not currently used)
   
@@ -215,25 +230,7 @@ MinuitOptimizer::MinuitOptimizer() {
   // default Mean time calculator type
   this->SetMeanTimeCalculatorType(0);
   
-  fMinuitPointPosition = new TMinuit();
-  fMinuitPointPosition->SetPrintLevel(-1);
-  fMinuitPointPosition->SetMaxIterations(5000);
-
-  fMinuitPointDirection = new TMinuit();
-  fMinuitPointDirection->SetPrintLevel(-1);
-  fMinuitPointDirection->SetMaxIterations(5000);
-
-  fMinuitPointVertex = new TMinuit();
-  fMinuitPointVertex->SetPrintLevel(-1);
-  fMinuitPointVertex->SetMaxIterations(5000);
-
-  fMinuitExtendedVertex = new TMinuit();
-  fMinuitExtendedVertex->SetPrintLevel(-1);
-  fMinuitExtendedVertex->SetMaxIterations(5000); 
-  
-  fMinuitTimeFit = new TMinuit();
-  fMinuitTimeFit->SetPrintLevel(-1);
-  fMinuitTimeFit->SetMaxIterations(5000);   
+  fFitBackend = new MinuitFitBackend();
 
   //fMinuitCorrectedVertex = new TMinuit();
   //fMinuitCorrectedVertex->SetPrintLevel(-1);
@@ -247,12 +244,8 @@ MinuitOptimizer::MinuitOptimizer() {
 //Destructor
 MinuitOptimizer::~MinuitOptimizer() {
 	fSeedVtx = 0;
-    delete fgFoMCalculator; fgFoMCalculator = 0;
-	delete fMinuitTimeFit; fMinuitTimeFit = 0;
-	delete fMinuitPointPosition; fMinuitPointPosition = 0;
-	delete fMinuitPointDirection; fMinuitPointDirection = 0;
-	delete fMinuitPointVertex; fMinuitPointVertex = 0;
-	delete fMinuitExtendedVertex; fMinuitExtendedVertex = 0;
+    delete fFoMCalculator; fFoMCalculator = 0;
+	delete fFitBackend; fFitBackend = 0;
 	delete fFittedVtx; fFittedVtx = 0;
 	//delete fMinuitCorrectedVertex; fMinuitCorrectedVertex = 0;
 	//delete fMinuitConeFit; fMinuitConeFit = 0;
@@ -265,15 +258,20 @@ void MinuitOptimizer::SetFitterTimeRange(double tmin, double tmax) {
 }
 
 void MinuitOptimizer::LoadVertexGeometry(VertexGeometry* vtxgeo) {
-  fgFoMCalculator->fVtxGeo = vtxgeo;	
+  fFoMCalculator->fVtxGeo = vtxgeo;	
+}
+
+bool MinuitOptimizer::SetFitBackend(std::string name) {
+  VertexFitBackend* backend = VertexFitBackend::Create(name);
+  if( backend==0 ) return false;
+  backend->SetMaxCalls(fFitBackend->GetMaxCalls());
+  delete fFitBackend;
+  fFitBackend = backend;
+  return true;
 }
 
 void MinuitOptimizer::SetNumberOfIterations(int iterations) {
-  fMinuitPointPosition->SetMaxIterations(iterations);
-  fMinuitPointDirection->SetMaxIterations(iterations);
-  fMinuitPointVertex->SetMaxIterations(iterations);
-  fMinuitExtendedVertex->SetMaxIterations(iterations); 
-  fMinuitTimeFit->SetMaxIterations(iterations);   
+  fFitBackend->SetMaxCalls(iterations);
 
   //fMinuitCorrectedVertex = new TMinuit();
   //fMinuitCorrectedVertex->SetPrintLevel(-1);
@@ -281,15 +279,15 @@ void MinuitOptimizer::SetNumberOfIterations(int iterations) {
 }
 
 void MinuitOptimizer::SetTimeFitWeight(double tweight) {
-  fgFoMCalculator->SetTimeFitWeight(tweight);	
+  fFoMCalculator->SetTimeFitWeight(tweight);	
 }
 
 void MinuitOptimizer::SetConeFitWeight(double cweight) {
-  fgFoMCalculator->SetConeFitWeight(cweight);	
+  fFoMCalculator->SetConeFitWeight(cweight);	
 }
 
 void MinuitOptimizer::SetMeanTimeCalculatorType(int type) {
-  fgFoMCalculator->SetMeanTimeCalculatorType(type);	
+  fFoMCalculator->SetMeanTimeCalculatorType(type);	
 }
 
 //Load vertex
@@ -320,46 +318,39 @@ void MinuitOptimizer::LoadVertex(double vtxX, double vtxY, double vtxZ, double v
 
 
 void MinuitOptimizer::FitPointTimeWithMinuit() {
-  fgFoMCalculator->fVtxGeo->CalcPointResiduals(fVtxX, fVtxY, fVtxZ, 0.0, 0.0, 0.0, 0.0);
+  fFoMCalculator->fVtxGeo->CalcPointResiduals(fVtxX, fVtxY, fVtxZ, 0.0, 0.0, 0.0, 0.0);
 
   // calculate mean and rms
   // ====================== 
   double meanvtxTime = 0.0;
-  meanvtxTime = fgFoMCalculator->FindSimpleTimeProperties(fConeAngle);  //returns weighted average of the expected vertex time
+  meanvtxTime = fFoMCalculator->FindSimpleTimeProperties(fConeAngle);  //returns weighted average of the expected vertex time
   // reset counter
   // =============
   time_fit_reset_itr();
   
-  // run Minuit
-  // ==========  
+  // run the fit
+  // ===========  
   // one-parameter fit to time profile
 
-  int err = 0;
   int flag = 0;
 
   double seedTime = meanvtxTime;
   double fitTime = 0.0;
   double fitTimeErr = 0.0;  
   
-  double* arglist = new double[10];
-  arglist[0]=1;  // 1: standard minimization
-                 // 2: try to improve minimum
-  
-  // re-initialize everything...
-  fMinuitTimeFit->mncler();
-  fMinuitTimeFit->SetFCN(vertex_time_lnl);
-  //end
-  fMinuitTimeFit->mnexcm("SET STR",arglist,1,err);
-  fMinuitTimeFit->mnparm(0,"vtxTime",seedTime,1.0,fTmin,fTmax,err);
+  std::vector<FitParameter> fitpar;
+  fitpar.push_back(FitParameter("vtxTime",seedTime,1.0,fTmin,fTmax));
   
-  flag = fMinuitTimeFit->Migrad();
-  fMinuitTimeFit->GetParameter(0,fitTime,fitTimeErr); //get the best time
-  delete [] arglist;
+  fFitBackend->Minimise([this](double* par, double& f, double*){ this->vertex_time_lnl(par, f); },
+                        false, 1, fitpar, fFitStats);  // strategy 1: standard minimization
+  flag = fFitStats.fStatus;
+  fitTime = fitpar[0].fValue; //get the best time
+  fitTimeErr = fitpar[0].fError;
   
   // fitting done; calculate best-fit figure of merit
   // =========================
   double fom = -9999.;
-  fgFoMCalculator->TimePropertiesLnL(fitTime, fom);
+  fFoMCalculator->TimePropertiesLnL(fitTime, fom);
   
   fVtxTime = fitTime;
   fVtxFOM = fom;
@@ -400,13 +391,13 @@ void MinuitOptimizer::FitPointPositionWithMinuit() {
     } 
     status |= RecoVertex::kFailPointPosition;
     fFittedVtx->SetStatus(status);
+    fFitStats.Reset();
     return;
   }
   
-  // run Minuit
-  // ==========  
+  // run the fit
+  // ===========  
   // three-parameter fit to vertex coordinates
-  int err = 0;
   int flag = 0;
 
   double fitXpos = 0.0;
@@ -420,26 +411,19 @@ void MinuitOptimizer::FitPointPositionWithMinuit() {
   double fitTimeposErr = 0.0; //JW
   
 
-  double* arglist = new double[10];
-  arglist[0]=1;  // 1: standard minimization
-                 // 2: try to improve minimum
-  
-  // re-initialize everything...
-  fMinuitPointPosition->mncler();
-  fMinuitPointPosition->SetFCN(point_position_chi2);
-  fMinuitPointPosition->mnexcm("SET STR",arglist,1,err);
-  fMinuitPointPosition->mnparm(0,"x",seedX,1.0,fXmin,fXmax,err);
-  fMinuitPointPosition->mnparm(1,"y",seedY,1.0,fYmin,fYmax,err);
-  fMinuitPointPosition->mnparm(2,"z",seedZ,5.0,fZmin,fZmax,err);
-  fMinuitPointPosition->mnparm(3,"Time",seedTime,1.0,fTmin,fTmax,err);
-
-  flag = fMinuitPointPosition->Migrad();
-  fMinuitPointPosition->GetParameter(0,fitXpos,fitXposErr);
-  fMinuitPointPosition->GetParameter(1,fitYpos,fitYposErr);
-  fMinuitPointPosition->GetParameter(2,fitZpos,fitZposErr);
-  fMinuitPointPosition->GetParameter(3,fitTimepos,fitTimeposErr);
+  std::vector<FitParameter> fitpar;
+  fitpar.push_back(FitParameter("x",seedX,1.0,fXmin,fXmax));
+  fitpar.push_back(FitParameter("y",seedY,1.0,fYmin,fYmax));
+  fitpar.push_back(FitParameter("z",seedZ,5.0,fZmin,fZmax));
+  fitpar.push_back(FitParameter("Time",seedTime,1.0,fTmin,fTmax));
 
-  delete [] arglist;
+  fFitBackend->Minimise([this](double* par, double& f, double*){ this->point_position_chi2(par, f); },
+                        false, 1, fitpar, fFitStats);  // strategy 1: standard minimization
+  flag = fFitStats.fStatus;
+  fitXpos = fitpar[0].fValue; fitXposErr = fitpar[0].fError;
+  fitYpos = fitpar[1].fValue; fitYposErr = fitpar[1].fError;
+  fitZpos = fitpar[2].fValue; fitZposErr = fitpar[2].fError;
+  fitTimepos = fitpar[3].fValue; fitTimeposErr = fitpar[3].fError;
   
   // sort results
   // ============
@@ -454,7 +438,7 @@ void MinuitOptimizer::FitPointPositionWithMinuit() {
   if( flag==0 ) fPass = 1; // anything else: abnormal termination 
 
   fItr = point_position_iterations();
-  fgFoMCalculator->PointPositionChi2(fVtxX,fVtxY,fVtxZ,fVtxTime,fVtxFOM);
+  fFoMCalculator->PointPositionChi2(fVtxX,fVtxY,fVtxZ,fVtxTime,fVtxFOM);
   
   // set vertex and direction
   // ========================
@@ -526,14 +510,14 @@ void MinuitOptimizer::FitPointDirectionWithMinuit() {
     } 
     status |= RecoVertex::kFailPointPosition;
     fFittedVtx->SetStatus(status);
+    fFitStats.Reset();
     return;
   }
   
-  // run Minuit
-  // ==========  
+  // run the fit
+  // ===========  
   // two-parameter fit to direction coordinates
   
-  int err = 0;
   int flag = 0;
 
   double dirTheta;
@@ -542,21 +526,15 @@ void MinuitOptimizer::FitPointDirectionWithMinuit() {
   double dirThetaErr;
   double dirPhiErr;
 
-  double* arglist = new double[10];
-  arglist[0]=1;  // 1: standard minimization
-                 // 2: try to improve minimum
-  // re-initialize everything...
-  fMinuitPointDirection->mncler();
-  fMinuitPointDirection->SetFCN(point_direction_chi2);
-  fMinuitPointDirection->mnexcm("SET STR",arglist,1,err);
-  fMinuitPointDirection->mnparm(0,"theta",seedTheta,0.125*TMath::Pi(),0.0,TMath::Pi(),err);
-  fMinuitPointDirection->mnparm(1,"phi",seedPhi,0.25*TMath::Pi(),-1.0*TMath::Pi(),+3.0*TMath::Pi(),err);
-
-  flag = fMinuitPointDirection->Migrad();
-  fMinuitPointDirection->GetParameter(0,dirTheta,dirThetaErr);
-  fMinuitPointDirection->GetParameter(1,dirPhi,dirPhiErr);
+  std::vector<FitParameter> fitpar;
+  fitpar.push_back(FitParameter("theta",seedTheta,0.125*TMath::Pi(),0.0,TMath::Pi()));
+  fitpar.push_back(FitParameter("phi",seedPhi,0.25*TMath::Pi(),-1.0*TMath::Pi(),+3.0*TMath::Pi()));
 
-  delete [] arglist;
+  fFitBackend->Minimise([this](double* par, double& f, double*){ this->point_direction_chi2(par, f); },
+                        false, 1, fitpar, fFitStats);  // strategy 1: standard minimization
+  flag = fFitStats.fStatus;
+  dirTheta = fitpar[0].fValue; dirThetaErr = fitpar[0].fError;
+  dirPhi = fitpar[1].fValue; dirPhiErr = fitpar[1].fError;
 
   // sort results
   // ============
@@ -573,7 +551,7 @@ void MinuitOptimizer::FitPointDirectionWithMinuit() {
   
   // calculate vertex
   // ================
-  fgFoMCalculator->PointDirectionChi2(fVtxX,fVtxY,fVtxZ,fDirX,fDirY,fDirZ,fConeAngle,fVtxFOM);
+  fFoMCalculator->PointDirectionChi2(fVtxX,fVtxY,fVtxZ,fDirX,fDirY,fDirZ,fConeAngle,fVtxFOM);
 
   // set vertex and direction
   // ========================
@@ -654,14 +632,14 @@ void MinuitOptimizer::FitPointVertexWithMinuit() {
     }   
     status |= RecoVertex::kFailPointVertex;
     this->fFittedVtx->SetStatus(status);
+    fFitStats.Reset();
     return;
   }
   
-  // run Minuit
-  // ==========  
+  // run the fit
+  // ===========  
   // five-parameter fit to vertex and direction
 
-  int err = 0;
   int flag = 0;
 
   double fitXpos = 0.0;
@@ -678,33 +656,27 @@ void MinuitOptimizer::FitPointVertexWithMinuit() {
   double fitThetaErr = 0.0;
   double fitPhiErr = 0.0;
   
-  double* arglist = new double[10];
-  arglist[0]=2;  // 1: standard minimization
-                 // 2: try to improve minimum
-
-  // re-initialize everything...
-  fMinuitPointVertex->mncler();
-  fMinuitPointVertex->SetFCN(point_vertex_chi2);
-  fMinuitPointVertex->mnexcm("SET STR",arglist,1,err);
-//  fMinuitPointVertex->mnparm(0,"x",seedX,1.0,-152,152,err); 
-//  fMinuitPointVertex->mnparm(1,"y",seedY,1.0,-212.46,183.54,err);
-//  fMinuitPointVertex->mnparm(2,"z",seedZ,1.0,15,319,err);
-  fMinuitPointVertex->mnparm(0,"x",seedX,1.0,fXmin,fXmax,err); 
-  fMinuitPointVertex->mnparm(1,"y",seedY,1.0,fYmin,fYmax,err); 
-  fMinuitPointVertex->mnparm(2,"z",seedZ,5.0,fZmin,fZmax,err); 
-  fMinuitPointVertex->mnparm(3,"theta",seedTheta,0.125*TMath::Pi(),0.0,TMath::Pi(),err);
-  fMinuitPointVertex->mnparm(4,"phi",seedPhi,0.25*TMath::Pi(),-1.0*TMath::Pi(),+3.0*TMath::Pi(),err);
-  fMinuitExtendedVertex->mnparm(5,"vtxTime",seedTime,1.0,fTmin,fTmax,err); 
-
-  flag = fMinuitPointVertex->Migrad();
-  fMinuitPointVertex->GetParameter(0,fitXpos,fitXposErr);
-  fMinuitPointVertex->GetParameter(1,fitYpos,fitYposErr);
-  fMinuitPointVertex->GetParameter(2,fitZpos,fitZposErr);
-  fMinuitPointVertex->GetParameter(3,fitTheta,fitThetaErr);
-  fMinuitPointVertex->GetParameter(4,fitPhi,fitPhiErr);
-  fMinuitPointVertex->GetParameter(5,fitTime,fitTimeErr);
-  
-  delete [] arglist;
+  // The vertex time is not a fit parameter: it stays at the seed time.  (The time
+  // parameter used to be declared on the extended vertex TMinuit by mistake, so this
+  // fit never moved it either.)
+  std::vector<FitParameter> fitpar;
+  fitpar.push_back(FitParameter("x",seedX,1.0,fXmin,fXmax));
+  fitpar.push_back(FitParameter("y",seedY,1.0,fYmin,fYmax));
+  fitpar.push_back(FitParameter("z",seedZ,5.0,fZmin,fZmax));
+  fitpar.push_back(FitParameter("theta",seedTheta,0.125*TMath::Pi(),0.0,TMath::Pi()));
+  fitpar.push_back(FitParameter("phi",seedPhi,0.25*TMath::Pi(),-1.0*TMath::Pi(),+3.0*TMath::Pi()));
+
+  fFitBackend->Minimise([this,seedTime](double* par, double& f, double*){
+                          double vtxpar[6] = { par[0], par[1], par[2], par[3], par[4], seedTime };
+                          this->point_vertex_chi2(vtxpar, f);
+                        }, false, 2, fitpar, fFitStats);  // strategy 2: try to improve minimum
+  flag = fFitStats.fStatus;
+  fitXpos = fitpar[0].fValue; fitXposErr = fitpar[0].fError;
+  fitYpos = fitpar[1].fValue; fitYposErr = fitpar[1].fError;
+  fitZpos = fitpar[2].fValue; fitZposErr = fitpar[2].fError;
+  fitTheta = fitpar[3].fValue; fitThetaErr = fitpar[3].fError;
+  fitPhi = fitpar[4].fValue; fitPhiErr = fitpar[4].fError;
+  fitTime = seedTime; fitTimeErr = 0.0;
   
   // sort results
   // ============
@@ -726,7 +698,7 @@ void MinuitOptimizer::FitPointVertexWithMinuit() {
   
   // fitting complete; calculate vertex FOM
   // ================
-  fgFoMCalculator->PointVertexChi2(fVtxX,fVtxY,fVtxZ,fDirX,fDirY,fDirZ,fConeAngle, fVtxTime,fVtxFOM); 
+  fFoMCalculator->PointVertexChi2(fVtxX,fVtxY,fVtxZ,fDirX,fDirY,fDirZ,fConeAngle, fVtxTime,fVtxFOM); 
   
   // set vertex and direction
   // ========================
@@ -804,14 +776,14 @@ void MinuitOptimizer::FitExtendedVertexWithMinuit() {
     }
     status |= RecoVertex::kFailExtendedVertex;
     fFittedVtx->SetStatus(status);
+    fFitStats.Reset();
     return;
   }
   
-  // run Minuit
-  // ==========  
+  // run the fit
+  // ===========  
   // six-parameter fit to vertex position, time and direction
 
-  int err = 0;
   int flag = 0;
 
   double fitXpos = 0.0;
@@ -828,32 +800,25 @@ void MinuitOptimizer::FitExtendedVertexWithMinuit() {
   double fitThetaErr = 0.0;
   double fitPhiErr = 0.0;
   
-  double* arglist = new double[10];
-  arglist[0]=2;  // 1: standard minimization
-                 // 2: try to improve minimum
-  
-  // re-initialize everything...
-  fMinuitExtendedVertex->mncler();
-  fMinuitExtendedVertex->SetFCN(extended_vertex_chi2);
-  fMinuitExtendedVertex->mnset();
-  fMinuitExtendedVertex->mnexcm("SET STR",arglist,1,err);
-  fMinuitExtendedVertex->mnparm(0,"x",seedX,1.0,fXmin,fXmax,err);
-  fMinuitExtendedVertex->mnparm(1,"y",seedY,1.0,fYmin,fYmax,err);
-  fMinuitExtendedVertex->mnparm(2,"z",seedZ,5.0,fZmin,fZmax,err);
-  fMinuitExtendedVertex->mnparm(3,"theta",seedTheta,0.125*TMath::Pi(),-1.0*TMath::Pi(),2.0*TMath::Pi(),err); 
-  fMinuitExtendedVertex->mnparm(4,"phi",seedPhi,0.125*TMath::Pi(),-2.0*TMath::Pi(), 2.0*TMath::Pi(),err);
-  fMinuitExtendedVertex->mnparm(5,"vtxTime",seedTime,1.0,fTmin,fTmax,err); //....TX
-  
-  flag = fMinuitExtendedVertex->Migrad();
-  
-  fMinuitExtendedVertex->GetParameter(0,fitXpos,fitXposErr);
-  fMinuitExtendedVertex->GetParameter(1,fitYpos,fitYposErr);
-  fMinuitExtendedVertex->GetParameter(2,fitZpos,fitZposErr);
-  fMinuitExtendedVertex->GetParameter(3,fitTheta,fitThetaErr);
-  fMinuitExtendedVertex->GetParameter(4,fitPhi,fitPhiErr);
-  fMinuitExtendedVertex->GetParameter(5,fitTime,fitTimeErr);
-
-  delete [] arglist;
+  std::vector<FitParameter> fitpar;
+  fitpar.push_back(FitParameter("x",seedX,1.0,fXmin,fXmax));
+  fitpar.push_back(FitParameter("y",seedY,1.0,fYmin,fYmax));
+  fitpar.push_back(FitParameter("z",seedZ,5.0,fZmin,fZmax));
+  fitpar.push_back(FitParameter("theta",seedTheta,0.125*TMath::Pi(),-1.0*TMath::Pi(),2.0*TMath::Pi())); 
+  fitpar.push_back(FitParameter("phi",seedPhi,0.125*TMath::Pi(),-2.0*TMath::Pi(), 2.0*TMath::Pi()));
+  fitpar.push_back(FitParameter("vtxTime",seedTime,1.0,fTmin,fTmax)); //....TX
+  
+  // the backend is given the derivatives of extended_vertex_chi2 if fUseAnalyticGradient
+  fFitBackend->Minimise([this](double* par, double& f, double* grad){ this->extended_vertex_chi2(par, f, grad); },
+                        fUseAnalyticGradient, 2, fitpar, fFitStats);  // strategy 2: try to improve minimum
+  flag = fFitStats.fStatus;
+  
+  fitXpos = fitpar[0].fValue; fitXposErr = fitpar[0].fError;
+  fitYpos = fitpar[1].fValue; fitYposErr = fitpar[1].fError;
+  fitZpos = fitpar[2].fValue; fitZposErr = fitpar[2].fError;
+  fitTheta = fitpar[3].fValue; fitThetaErr = fitpar[3].fError;
+  fitPhi = fitpar[4].fValue; fitPhiErr = fitpar[4].fError;
+  fitTime = fitpar[5].fValue; fitTimeErr = fitpar[5].fError;
   
   //correct angles, JW
   if(fitTheta < 0.0) fitTheta = -1.0 * fitTheta;
@@ -880,7 +845,7 @@ void MinuitOptimizer::FitExtendedVertexWithMinuit() {
   
   // fit complete; calculate fit results
   // ================
-  fgFoMCalculator->ExtendedVertexChi2(fVtxX,fVtxY,fVtxZ,
+  fFoMCalculator->ExtendedVertexChi2(fVtxX,fVtxY,fVtxZ,
                            fDirX,fDirY,fDirZ, 
                            fConeAngle, fVtxTime,fVtxFOM);
                            
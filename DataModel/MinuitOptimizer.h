@@ -18,6 +18,7 @@
 #include "RecoVertex.h"
 #include "VertexGeometry.h"
 #include "FoMCalculator.h"
+#include "VertexFitBackend.h"
 
 #include <vector>
 #include <iostream>
@@ -40,6 +41,7 @@ public:
   double fFoundVertex;
   
   int fPrintLevel;
+  bool fUseAnalyticGradient;
   int fPass = 0;
   int fItr = 0;
   
@@ -62,13 +64,14 @@ public:
   RecoVertex* fSeedVtx;
   RecoVertex* fFittedVtx;
   
-  TMinuit* fMinuitPointPosition;
-  TMinuit* fMinuitPointDirection;
-  TMinuit* fMinuitPointVertex; 
-  TMinuit* fMinuitExtendedVertex; 
-
-  TMinuit* fMinuitTimeFit;
-  
+  // Minimiser of all the fits (Minuit unless SetFitBackend() picks another)
+  VertexFitBackend* fFitBackend;
+  // Calls, iterations and convergence of the last fit
+  FitStatistics fFitStats;
+
+  // Each optimizer has its own FoMCalculator, and its backend minimises its own
+  // functions below, so different optimizers can fit on different threads at once.
+  FoMCalculator* fFoMCalculator;
  	
  	MinuitOptimizer();
   ~MinuitOptimizer();
@@ -79,6 +82,13 @@ public:
   void SetMeanTimeCalculatorType(int type);
   void SetNumberOfIterations(int iterations);
   void SetConeAngle(double cangle){ fConeAngle=cangle;}
+  /// Give the backend the analytic derivatives of the extended vertex FoM instead of
+  /// letting it take finite differences (default off)
+  void SetUseAnalyticGradient(bool use){ fUseAnalyticGradient=use;}
+  /// Minimise with the named VertexFitBackend ("Minuit" or "LBFGS").  Returns false, and
+  /// keeps the current backend, if there is no such backend.
+  bool SetFitBackend(std::string name);
+  std::string GetFitBackendName() const { return fFitBackend->GetName(); }
   void LoadVertexGeometry(VertexGeometry* vtxgeo);
   void LoadVertex(RecoVertex* vtx);
   void LoadVertex(double vtxX, double vtxY, double vtxZ, double vtxTime, double vtxDirX, double vtxDirY, double vtxDirZ);
@@ -91,6 +101,7 @@ public:
   double GetTime() {return fVtxTime;}
   double GetFOM() {return fVtxFOM;}
   RecoVertex* GetFittedVertex() {return fFittedVtx;}
+  const FitStatistics& GetFitStatistics() const {return fFitStats;}
   
   void time_fit_itr()        { fTimeFitItr++; }
   void point_position_itr()  { fPointPosItr++; }
@@ -109,6 +120,13 @@ public:
   int point_direction_iterations() { return fPointDirItr; }
   int point_vertex_iterations()    { return fPointVtxItr; }
   int extended_vertex_iterations() { return fExtendedVtxItr; }
+
+  // functions minimised by the backend (f = -fom, grad = df/dpar if not null)
+  void vertex_time_lnl(double* par, double& f);
+  void point_position_chi2(double* par, double& f);
+  void point_direction_chi2(double* par, double& f);
+  void point_vertex_chi2(double* par, double& f);
+  void extended_vertex_chi2(double* par, double& f, double* grad = 0);
  
   //KEPT FOR HISTORY; CURRENTLY NOT IN USE 
   //coneparameters
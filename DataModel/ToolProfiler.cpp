@@ -0,0 +1,273 @@
+#include "ToolProfiler.h"
+
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include "DataModel.h"
+#include "WaveformBlock.h"
+
+namespace {
+
+//Size of a known entry: number of waveforms, hits or words; false if it is not there
+typedef bool (*EntrySizeGetter)(DataModel &data, long &size);
+
+bool CardDataSize(DataModel &data, long &size){
+  std::vector<CardData> *Cdata = nullptr;
+  if (!data.CStore.Get("CardData",Cdata) || Cdata == nullptr) return false;
+  size = 0;
+  for (const CardData &aCardData : *Cdata) size += aCardData.Data.size();
+  return true;
+}
+
+bool InProgressTankEventsSize(DataModel &data, long &size){
+  std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t>>> *InProgressTankEvents = nullptr;
+  if (!data.CStore.Get("InProgressTankEvents",InProgressTankEvents) || InProgressTankEvents == nullptr) return false;
+  size = 0;
+  for (const auto &apair : *InProgressTankEvents) size += apair.second.size();
+  return true;
+}
+
+bool InProgressHitsSize(DataModel &data, long &size){
+  std::map<uint64_t, std::map<unsigned long,std::vector<Hit>>*> *InProgressHits = nullptr;
+  if (!data.CStore.Get("InProgressHits",InProgressHits) || InProgressHits == nullptr) return false;
+  size = 0;
+  for (const auto &apair : *InProgressHits){
+    if (apair.second == nullptr) continue;
+    for (const auto &hits : *apair.second) size += hits.second.size();
+  }
+  return true;
+}
+
+bool FinishedRawWaveformsSize(DataModel &data, long &size){
+  std::map<uint64_t, std::map<unsigned long,std::vector<Waveform<unsigned short>>>> *FinishedRawWaveforms = nullptr;
+  if (!data.CStore.Get("FinishedRawWaveforms",FinishedRawWaveforms) || FinishedRawWaveforms == nullptr) return false;
+  size = 0;
+  for (const auto &apair : *FinishedRawWaveforms){
+    for (const auto &waves : apair.second) size += waves.second.size();
+  }
+  return true;
+}
+
+bool RawADCDataSize(DataModel &data, long &size){
+  std::map<std::string,BoostStore*>::iterator it = data.Stores.find("ANNIEEvent");
+  if (it == data.Stores.end() || it->second == nullptr) return false;
+  //Copies the map or block out of the store; the time it takes is not charged to the tool
+  WaveformBlock<uint16_t> RawADCDataBlock;
+  std::map<unsigned long, std::vector<Waveform<uint16_t>>> RawADCData;
+  std::map<unsigned long, std::vector<WaveformView<uint16_t>>> RawADCViews;
+  if (!GetWaveformViews(*it->second,"RawADCData",RawADCDataBlock,RawADCData,RawADCViews)) return false;
+  size = 0;
+  for (const auto &apair : RawADCViews) size += apair.second.size();
+  return true;
+}
+
+bool HitsSize(DataModel &data, long &size){
+  std::map<std::string,BoostStore*>::iterator it = data.Stores.find("ANNIEEvent");
+  if (it == data.Stores.end() || it->second == nullptr) return false;
+  std::map<unsigned long,std::vector<Hit>> *Hits = nullptr;
+  if (!it->second->Get("Hits",Hits) || Hits == nullptr) return false;
+  size = 0;
+  for (const auto &apair : *Hits) size += apair.second.size();
+  return true;
+}
+
+const std::pair<const char*,EntrySizeGetter> ENTRY_SIZE_GETTERS[] = {
+  {"CardData",&CardDataSize},
+  {"InProgressTankEvents",&InProgressTankEventsSize},
+  {"InProgressHits",&InProgressHitsSize},
+  {"FinishedRawWaveforms",&FinishedRawWaveformsSize},
+  {"RawADCData",&RawADCDataSize},
+  {"Hits",&HitsSize}
+};
+const int NUM_ENTRY_SIZE_GETTERS = sizeof(ENTRY_SIZE_GETTERS)/sizeof(ENTRY_SIZE_GETTERS[0]);
+
+const char* PHASE_NAMES[3] = {"Initialise","Execute","Finalise"};
+
+}
+
+ToolProfiler::ToolProfiler():Epoch(WallNow()),MaxTraceEvents(200000),DroppedTraceEvents(0),FinalisedTools(0){}
+
+void ToolProfiler::Configure(Store &vars){
+  int max_trace_events = MaxTraceEvents;
+  std::string entries = "";
+  vars.Get("ToolProfilingTrace",TraceFile);
+  vars.Get("ToolProfilingSummary",SummaryFile);
+  vars.Get("ToolProfilingEntries",entries);
+  vars.Get("ToolProfilingMaxTraceEvents",max_trace_events);
+  MaxTraceEvents = max_trace_events < 0 ? 0 : max_trace_events;
+
+  Entries.clear();
+  EntryGetters.clear();
+  std::replace(entries.begin(),entries.end(),',',' ');
+  std::stringstream entrystream(entries);
+  std::string entry;
+  while (entrystream >> entry){
+    int getter = -1;
+    for (int i = 0; i < NUM_ENTRY_SIZE_GETTERS; i++) if (entry == ENTRY_SIZE_GETTERS[i].first) getter = i;
+    if (getter < 0){
+      std::cout << "ToolProfiler WARNING: no size known for entry " << entry << "; it is not recorded" << std::endl;
+      continue;
+    }
+    Entries.push_back(entry);
+    EntryGetters.push_back(getter);
+  }
+  LastEntrySize.assign(Entries.size(),-1);
+  MaxEntrySize.assign(Entries.size(),-1);
+}
+
+int ToolProfiler::AddTool(const std::string &name){
+  //Several instances of a tool get numbered names
+  int instances = 0;
+  for (const ToolRecord &record : Tools) instances += (record.Name == name || record.Name.compare(0,name.size()+1,name+"#") == 0);
+  ToolRecord record;
+  record.Name = instances == 0 ? name : name+"#"+std::to_string(instances+1);
+  Tools.push_back(record);
+  return Tools.size()-1;
+}
+
+ToolProfiler::CallStart ToolProfiler::Start() const {
+  CallStart start;
+  start.RSSKB = RSSNowKB();
+  start.CPU = CPUNow();
+  start.Wall = WallNow()-Epoch;
+  return start;
+}
+
+void ToolProfiler::Stop(int tool, Phase phase, const CallStart &start, DataModel &data){
+  double wall = WallNow()-Epoch-start.Wall;
+  double cpu = CPUNow()-start.CPU;
+  long rss = RSSNowKB();
+  ToolRecord &record = Tools.at(tool);
+  record.Calls[phase]++;
+  record.Wall[phase] += wall;
+  record.CPU[phase] += cpu;
+  record.RSSDeltaKB[phase] += rss-start.RSSKB;
+  record.PeakRSSKB = std::max(record.PeakRSSKB,rss);
+  if (phase == kExecute) record.ExecuteWall.push_back(wall);
+  if (Trace.size() < MaxTraceEvents) Trace.push_back(TraceEvent{tool,phase,start.Wall,wall,cpu,rss-start.RSSKB});
+  else DroppedTraceEvents++;
+
+  //Entry sizes, outside of the timed call; only changes go into the trace
+  for (size_t i = 0; i < Entries.size(); i++){
+    long size = -1;
+    if (!ENTRY_SIZE_GETTERS[EntryGetters[i]].second(data,size)) size = -1;
+    MaxEntrySize[i] = std::max(MaxEntrySize[i],size);
+    if (size != LastEntrySize[i] && Trace.size() < MaxTraceEvents){
+      EntrySamples.push_back(EntrySample{static_cast<int>(i),start.Wall+wall,size});
+    }
+    LastEntrySize[i] = size;
+  }
+}
+
+bool ToolProfiler::ToolFinalised(){
+  FinalisedTools++;
+  return FinalisedTools >= static_cast<int>(Tools.size());
+}
+
+double ToolProfiler::Percentile(const std::vector<float> &sorted, double fraction){
+  if (sorted.empty()) return 0.;
+  //Nearest rank
+  size_t rank = static_cast<size_t>(ceil(fraction*sorted.size()));
+  if (rank < 1) rank = 1;
+  if (rank > sorted.size()) rank = sorted.size();
+  return sorted[rank-1];
+}
+
+void ToolProfiler::PrintSummary(std::ostream &out) const {
+  double total_wall = 0.;
+  for (const ToolRecord &record : Tools) total_wall += record.Wall[kInitialise]+record.Wall[kExecute]+record.Wall[kFinalise];
+  std::ios::fmtflags flags = out.flags();
+  out << std::fixed;
+  out << "ToolProfiler: per tool cost (times in s unless stated; CPU is process CPU, RSS in MB)" << std::endl;
+  out << std::left << std::setw(28) << "Tool" << std::right << std::setw(9) << "Init" << std::setw(10) << "Executes"
+      << std::setw(11) << "ExecWall" << std::setw(11) << "ExecCPU" << std::setw(7) << "%Wall"
+      << std::setw(10) << "p50[ms]" << std::setw(10) << "p90[ms]" << std::setw(10) << "p99[ms]" << std::setw(10) << "max[ms]"
+      << std::setw(9) << "Final" << std::setw(10) << "dRSS" << std::setw(10) << "PeakRSS" << std::endl;
+  for (const ToolRecord &record : Tools){
+    std::vector<float> sorted = record.ExecuteWall;
+    std::sort(sorted.begin(),sorted.end());
+    double tool_wall = record.Wall[kInitialise]+record.Wall[kExecute]+record.Wall[kFinalise];
+    long rss_delta = record.RSSDeltaKB[kInitialise]+record.RSSDeltaKB[kExecute]+record.RSSDeltaKB[kFinalise];
+    out << std::left << std::setw(28) << record.Name << std::right << std::setprecision(3)
+        << std::setw(9) << record.Wall[kInitialise] << std::setw(10) << record.Calls[kExecute]
+        << std::setw(11) << record.Wall[kExecute] << std::setw(11) << record.CPU[kExecute]
+        << std::setprecision(1) << std::setw(7) << (total_wall > 0. ? 100.*tool_wall/total_wall : 0.)
+        << std::setprecision(3) << std::setw(10) << 1.e3*Percentile(sorted,0.5) << std::setw(10) << 1.e3*Percentile(sorted,0.9)
+        << std::setw(10) << 1.e3*Percentile(sorted,0.99) << std::setw(10) << (sorted.empty() ? 0. : 1.e3*sorted.back())
+        << std::setw(9) << record.Wall[kFinalise] << std::setprecision(1) << std::setw(10) << rss_delta/1024.
+        << std::setw(10) << record.PeakRSSKB/1024. << std::endl;
+  }
+  for (size_t i = 0; i < Entries.size(); i++){
+    out << "ToolProfiler: largest size of entry " << Entries[i] << ": " << MaxEntrySize[i] << std::endl;
+  }
+  if (DroppedTraceEvents > 0){
+    out << "ToolProfiler: " << DroppedTraceEvents << " calls left out of the trace (ToolProfilingMaxTraceEvents "
+        << MaxTraceEvents << ")" << std::endl;
+  }
+  out.flags(flags);
+}
+
+bool ToolProfiler::WriteTrace(const std::string &filename) const {
+  std::ofstream out(filename.c_str());
+  if (!out.is_open()) return false;
+  //Chrome trace event format: complete ("X") events for the calls, counter ("C") events for
+  //the entry sizes; times in microseconds
+  out << std::fixed << std::setprecision(3);
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+  out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"ToolChain\"}}";
+  for (const TraceEvent &event : Trace){
+    out << "," << std::endl << "{\"name\":\"" << Tools[event.Tool].Name << "\",\"cat\":\"" << PHASE_NAMES[event.Phase]
+        << "\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":" << 1.e6*event.Start << ",\"dur\":" << 1.e6*event.Wall
+        << ",\"args\":{\"phase\":\"" << PHASE_NAMES[event.Phase] << "\",\"cpu_us\":" << 1.e6*event.CPU
+        << ",\"rss_delta_kb\":" << event.RSSDeltaKB << "}}";
+  }
+  for (const EntrySample &sample : EntrySamples){
+    out << "," << std::endl << "{\"name\":\"" << Entries[sample.Entry] << "\",\"ph\":\"C\",\"pid\":0,\"ts\":"
+        << 1.e6*sample.Time << ",\"args\":{\"size\":" << sample.Size << "}}";
+  }
+  out << std::endl << "]}" << std::endl;
+  return !out.fail();
+}
+
+void ToolProfiler::Report(){
+  this->PrintSummary(std::cout);
+  if (SummaryFile != ""){
+    std::ofstream summary(SummaryFile.c_str());
+    if (summary.is_open()) this->PrintSummary(summary);
+    else std::cout << "ToolProfiler ERROR: could not write summary file " << SummaryFile << std::endl;
+  }
+  if (TraceFile != ""){
+    if (this->WriteTrace(TraceFile)) std::cout << "ToolProfiler: trace written to " << TraceFile << std::endl;
+    else std::cout << "ToolProfiler ERROR: could not write trace file " << TraceFile << std::endl;
+  }
+}
+
+double ToolProfiler::WallNow(){
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double ToolProfiler::CPUNow(){
+  timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID,&ts);
+  return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+long ToolProfiler::RSSNowKB(){
+  //Second field of /proc/self/statm: resident pages
+  FILE *statm = fopen("/proc/self/statm","r");
+  if (statm == nullptr) return 0;
+  long pages = 0, resident = 0;
+  int nread = fscanf(statm,"%ld %ld",&pages,&resident);
+  fclose(statm);
+  if (nread != 2) return 0;
+  return resident*(sysconf(_SC_PAGESIZE)/1024);
+}
@@ -0,0 +1,117 @@
+#ifndef TOOLPROFILER_H
+#define TOOLPROFILER_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Store.h"
+
+class DataModel;
+
+/**
+* \class ToolProfiler
+*
+* Per tool cost of a ToolChain: the wall time, process CPU time and resident memory change of
+* every Initialise/Execute/Finalise call of the tools, and the sizes of selected CStore and
+* ANNIEEvent entries after each call.  The tools are timed by the ProfiledTool that Factory()
+* wraps around them.  The profiler exists only if the ToolChainConfig turns ToolProfiling on,
+* so the wrappers cost a pointer test per call otherwise.  When the last tool has been
+* finalised, a summary table (calls, totals, Execute percentiles, memory) is printed.  A
+* Chrome trace JSON file (chrome://tracing, Perfetto) of the calls and entry sizes can be
+* written as well.
+*
+* ToolChainConfig entries:
+*   ToolProfiling 1                 turn the profiler on (default 0)
+*   ToolProfilingTrace file.json    write the calls to a Chrome trace file
+*   ToolProfilingSummary file.txt   also write the summary table to a file
+*   ToolProfilingEntries a,b        entries whose size is recorded after each call, out of
+*                                   CardData, InProgressTankEvents, InProgressHits,
+*                                   FinishedRawWaveforms (CStore) and RawADCData, Hits (ANNIEEvent)
+*   ToolProfilingMaxTraceEvents n   calls kept for the trace (default 200000; the summary
+*                                   always covers all calls)
+*/
+
+class ToolProfiler {
+
+ public:
+
+  enum Phase { kInitialise=0, kExecute=1, kFinalise=2 };
+
+  struct CallStart {
+    double Wall;   // s since the profiler was made
+    double CPU;    // s of process CPU time
+    long RSSKB;
+  };
+
+  ToolProfiler();
+
+  /// Read the ToolProfiling* entries of the ToolChainConfig
+  void Configure(Store &vars);
+
+  /// Register a tool; returns its index for Start/Stop
+  int AddTool(const std::string &name);
+
+  CallStart Start() const;
+  /// Record the call of a tool begun at start, then the sizes of the selected entries
+  void Stop(int tool, Phase phase, const CallStart &start, DataModel &data);
+
+  /// Called once per tool from its Finalise; returns true once all registered tools are done
+  bool ToolFinalised();
+
+  /// Print the summary and write the summary and trace files that were asked for
+  void Report();
+  void PrintSummary(std::ostream &out) const;
+  bool WriteTrace(const std::string &filename) const;
+
+ private:
+
+  struct ToolRecord {
+    std::string Name;
+    long Calls[3] = {0,0,0};
+    double Wall[3] = {0.,0.,0.};
+    double CPU[3] = {0.,0.,0.};
+    long RSSDeltaKB[3] = {0,0,0};
+    long PeakRSSKB = 0;
+    std::vector<float> ExecuteWall;   // s, one per Execute call, for the percentiles
+  };
+
+  struct TraceEvent {
+    int Tool;
+    int Phase;
+    double Start;    // s
+    double Wall;     // s
+    double CPU;      // s
+    long RSSDeltaKB;
+  };
+
+  struct EntrySample {
+    int Entry;
+    double Time;   // s
+    long Size;
+  };
+
+  static double WallNow();
+  static double CPUNow();
+  static long RSSNowKB();
+  static double Percentile(const std::vector<float> &sorted, double fraction);
+
+  double Epoch;
+  std::vector<ToolRecord> Tools;
+  std::vector<TraceEvent> Trace;
+  std::vector<EntrySample> EntrySamples;
+  std::vector<std::string> Entries;
+  std::vector<int> EntryGetters;   // index into the table of known entries
+  std::vector<long> LastEntrySize;
+  std::vector<long> MaxEntrySize;
+  size_t MaxTraceEvents;
+  long DroppedTraceEvents;
+  int FinalisedTools;
+  std::string TraceFile;
+  std::string SummaryFile;
+
+};
+
+#endif
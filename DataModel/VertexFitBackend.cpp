@@ -0,0 +1,275 @@
+#include "VertexFitBackend.h"
+
+#include "TMinuit.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+// A TMinuit minimising a closure instead of a global FCN.  TMinuit calls the FCN through
+// Eval(), so each fit reaches its own optimizer without going through any global state.
+// The closure gets the gradient array when Minuit asks for derivatives (flag 2, only after
+// SET GRADIENT), and a null pointer otherwise.
+class MinuitClosure : public TMinuit {
+
+ public:
+  MinuitClosure(std::function<void(double*, double&, double*)> fcn) : fFunction(fcn) {
+    this->SetPrintLevel(-1);
+    this->SetMaxIterations(5000);
+  }
+  Int_t Eval(Int_t, Double_t* grad, Double_t& f, Double_t* par, Int_t flag) override {
+    fFunction(par, f, (flag==2) ? grad : 0);
+    return 0;
+  }
+
+ private:
+  std::function<void(double*, double&, double*)> fFunction;
+};
+
+VertexFitBackend* VertexFitBackend::Create(const std::string& name) {
+  if( name=="Minuit" ) return new MinuitFitBackend();
+  if( name=="LBFGS" ) return new LBFGSFitBackend();
+  return 0;
+}
+
+bool VertexFitBackend::IsBackend(const std::string& name) {
+  return ( name=="Minuit" || name=="LBFGS" );
+}
+
+MinuitFitBackend::MinuitFitBackend() : fFunction(0), fStats(0) {
+  fMinuit = new MinuitClosure([this](double* par, double& f, double* grad){
+    (*fFunction)(par, f, grad);
+    fStats->fCalls++;
+    if( grad ) fStats->fGradientCalls++;
+  });
+}
+
+MinuitFitBackend::~MinuitFitBackend() {
+  delete fMinuit; fMinuit = 0;
+}
+
+void MinuitFitBackend::Minimise(const FitFunction& fcn, bool hasGradient, int strategy,
+                                std::vector<FitParameter>& par, FitStatistics& stats) {
+  stats.Reset();
+  fFunction = &fcn;
+  fStats = &stats;
+
+  int err = 0;
+  double arglist[10];
+  arglist[0] = strategy;
+
+  // re-initialize everything...
+  fMinuit->SetMaxIterations(fMaxCalls);
+  fMinuit->mncler();
+  fMinuit->mnexcm("SET STR",arglist,1,err);
+  if( hasGradient ){
+    arglist[0] = 1;  // 1: use the derivatives of the function without checking them
+    fMinuit->mnexcm("SET GRA",arglist,1,err);
+  }
+  else{
+    fMinuit->mnexcm("SET NOG",arglist,0,err);
+  }
+  for( unsigned int i=0; i<par.size(); i++ ){
+    fMinuit->mnparm(i,par[i].fName.c_str(),par[i].fValue,par[i].fStep,par[i].fMin,par[i].fMax,err);
+  }
+
+  int flag = fMinuit->Migrad();
+  for( unsigned int i=0; i<par.size(); i++ ){
+    fMinuit->GetParameter(i,par[i].fValue,par[i].fError);
+  }
+
+  stats.fConverged = ( flag==0 );  // flag = 0: normal termination
+  stats.fStatus = flag;            // anything else: abnormal termination
+  fFunction = 0;
+  fStats = 0;
+}
+
+LBFGSFitBackend::LBFGSFitBackend() : fMemory(5), fGradientTolerance(1e-3) {}
+
+// The parameters are measured in their steps, u = x/step, which brings positions, angles
+// and times to similar scales.  Each iteration goes along the L-BFGS direction of the
+// parameters that are free to move (not held at a bound by the gradient), projects the
+// step onto the bounds, and halves it until f falls enough (Armijo).  The fit has
+// converged when the gradient of the free parameters is below the tolerance, when an
+// iteration no longer lowers f, or when no step along the gradient lowers f at all.
+void LBFGSFitBackend::Minimise(const FitFunction& fcn, bool hasGradient, int,
+                               std::vector<FitParameter>& par, FitStatistics& stats) {
+  stats.Reset();
+  stats.fIterations = 0;
+
+  const int npar = par.size();
+  const double kDiffStep = 1e-4;     // central difference step, in parameter steps
+  const double kArmijo = 1e-4;
+  const double kMinProgress = 1e-12;
+  const int kMaxHalvings = 40;
+
+  std::vector<double> scale(npar), lo(npar), hi(npar), u(npar);
+  for( int i=0; i<npar; i++ ){
+    scale[i] = ( par[i].fStep>0.0 ) ? par[i].fStep : 1.0;
+    // as in Minuit, a parameter with equal limits is not bounded
+    bool bounded = ( par[i].fMax>par[i].fMin );
+    lo[i] = bounded ? par[i].fMin/scale[i] : -HUGE_VAL;
+    hi[i] = bounded ? par[i].fMax/scale[i] : HUGE_VAL;
+    u[i] = std::min(hi[i], std::max(lo[i], par[i].fValue/scale[i]));
+  }
+
+  std::vector<double> x(npar), gx(npar);
+  // central difference gradient at u, where f is already known, into g (in units of f per step)
+  auto differences = [&](const std::vector<double>& at, double f, std::vector<double>& g) {
+    for( int i=0; i<npar; i++ ) x[i] = at[i]*scale[i];
+    for( int i=0; i<npar; i++ ){
+      double up = std::min(hi[i], at[i]+kDiffStep);
+      double down = std::max(lo[i], at[i]-kDiffStep);
+      double fup = f, fdown = f;
+      x[i] = up*scale[i];
+      if( up>at[i] ){ fcn(x.data(), fup, 0); stats.fCalls++; }
+      x[i] = down*scale[i];
+      if( down<at[i] ){ fcn(x.data(), fdown, 0); stats.fCalls++; }
+      x[i] = at[i]*scale[i];
+      g[i] = ( up>down ) ? (fup-fdown)/(up-down) : 0.0;
+    }
+  };
+  // f at u, and its gradient in g (in units of f per step) if g is not null
+  auto evaluate = [&](const std::vector<double>& at, std::vector<double>* g) -> double {
+    for( int i=0; i<npar; i++ ) x[i] = at[i]*scale[i];
+    double f = 0.0;
+    if( g && hasGradient ){
+      fcn(x.data(), f, gx.data());
+      stats.fCalls++;
+      stats.fGradientCalls++;
+      for( int i=0; i<npar; i++ ) (*g)[i] = gx[i]*scale[i];
+      return f;
+    }
+    fcn(x.data(), f, 0);
+    stats.fCalls++;
+    if( g ) differences(at, f, *g);
+    return f;
+  };
+
+  std::vector<double> g(npar), d(npar), ut(npar), gt(npar), alphas;
+  std::deque<std::vector<double> > sList, yList;
+  std::deque<double> rhoList;
+  bool converged = false;
+  int status = 4;   // as Migrad: 4 when the call limit is reached
+
+  double f = evaluate(u, &g);
+  while( stats.fCalls<fMaxCalls ){
+    // the parameters at a bound that the gradient pushes against stay where they are
+    std::vector<bool> isFree(npar);
+    double gmax = 0.0;
+    for( int i=0; i<npar; i++ ){
+      isFree[i] = !( (u[i]<=lo[i] && g[i]>0.0) || (u[i]>=hi[i] && g[i]<0.0) );
+      if( isFree[i] ) gmax = std::max(gmax, std::fabs(g[i]));
+    }
+    if( gmax<=fGradientTolerance ){
+      converged = true;
+      status = 0;
+      break;
+    }
+
+    // L-BFGS two-loop recursion for d = -H*g
+    for( int i=0; i<npar; i++ ) d[i] = isFree[i] ? -g[i] : 0.0;
+    alphas.assign(sList.size(), 0.0);
+    for( int k=(int)sList.size()-1; k>=0; k-- ){
+      double sd = 0.0;
+      for( int i=0; i<npar; i++ ) sd += sList[k][i]*d[i];
+      alphas[k] = rhoList[k]*sd;
+      for( int i=0; i<npar; i++ ) if( isFree[i] ) d[i] -= alphas[k]*yList[k][i];
+    }
+    if( !sList.empty() ){
+      const std::vector<double>& s = sList.back();
+      const std::vector<double>& y = yList.back();
+      double sy = 0.0, yy = 0.0;
+      for( int i=0; i<npar; i++ ){ sy += s[i]*y[i]; yy += y[i]*y[i]; }
+      for( int i=0; i<npar; i++ ) d[i] *= sy/yy;
+    }
+    for( unsigned int k=0; k<sList.size(); k++ ){
+      double yd = 0.0;
+      for( int i=0; i<npar; i++ ) yd += yList[k][i]*d[i];
+      double beta = rhoList[k]*yd;
+      for( int i=0; i<npar; i++ ) if( isFree[i] ) d[i] += (alphas[k]-beta)*sList[k][i];
+    }
+    double dg = 0.0;
+    for( int i=0; i<npar; i++ ) dg += d[i]*g[i];
+    if( dg>=0.0 ){
+      // not a descent direction; start over from the gradient
+      sList.clear(); yList.clear(); rhoList.clear();
+      for( int i=0; i<npar; i++ ) d[i] = isFree[i] ? -g[i] : 0.0;
+    }
+
+    // backtracking line search; without curvature information the first try moves the
+    // fastest-changing parameter by one step
+    double alpha = 1.0;
+    if( sList.empty() ){
+      double dmax = 0.0;
+      for( int i=0; i<npar; i++ ) dmax = std::max(dmax, std::fabs(d[i]));
+      alpha = 1.0/dmax;
+    }
+    bool accepted = false;
+    double ft = f;
+    for( int halving=0; halving<kMaxHalvings && stats.fCalls<fMaxCalls; halving++, alpha*=0.5 ){
+      double decrease = 0.0;
+      bool moved = false;
+      for( int i=0; i<npar; i++ ){
+        ut[i] = std::min(hi[i], std::max(lo[i], u[i]+alpha*d[i]));
+        decrease += g[i]*(ut[i]-u[i]);
+        if( ut[i]!=u[i] ) moved = true;
+      }
+      if( !moved ) break;
+      // an analytic gradient comes with f, so take it along; differences wait for the step
+      ft = evaluate(ut, hasGradient ? &gt : 0);
+      if( ft<=f+kArmijo*decrease ){
+        accepted = true;
+        break;
+      }
+    }
+    if( !accepted ){
+      if( stats.fCalls>=fMaxCalls ) break;
+      if( !sList.empty() ){
+        sList.clear(); yList.clear(); rhoList.clear();
+        continue;
+      }
+      // no step along the gradient lowers f: a minimum to the resolution of the parameters
+      converged = true;
+      status = 0;
+      break;
+    }
+    // the accepted point's f is ft already, so only the difference points are new
+    if( !hasGradient ) differences(ut, ft, gt);
+    stats.fIterations++;
+
+    // curvature pair, kept only if it keeps the inverse Hessian positive definite
+    std::vector<double> s(npar), y(npar);
+    double sy = 0.0;
+    for( int i=0; i<npar; i++ ){
+      s[i] = ut[i]-u[i];
+      y[i] = gt[i]-g[i];
+      sy += s[i]*y[i];
+    }
+    if( sy>1e-12 ){
+      sList.push_back(s);
+      yList.push_back(y);
+      rhoList.push_back(1.0/sy);
+      if( (int)sList.size()>fMemory ){
+        sList.pop_front(); yList.pop_front(); rhoList.pop_front();
+      }
+    }
+
+    double progress = f-ft;
+    u = ut;
+    g = gt;
+    f = ft;
+    if( progress<=kMinProgress*std::max(1.0, std::fabs(f)) ){
+      converged = true;
+      status = 0;
+      break;
+    }
+  }
+
+  for( int i=0; i<npar; i++ ){
+    par[i].fValue = u[i]*scale[i];
+    par[i].fError = 0.0;
+  }
+  stats.fConverged = converged;
+  stats.fStatus = status;
+}
@@ -0,0 +1,125 @@
+#ifndef VERTEXFITBACKEND_H
+#define VERTEXFITBACKEND_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class TMinuit;
+
+/// A bounded parameter of a vertex fit.  fStep is the initial step, and the scale the
+/// L-BFGS backend measures the parameter in.
+struct FitParameter {
+  FitParameter(const std::string& name, double value, double step, double min, double max)
+    : fName(name), fValue(value), fStep(step), fMin(min), fMax(max), fError(0.0) {}
+  std::string fName;
+  double fValue;    ///< seed before the fit, result after it
+  double fStep;
+  double fMin;
+  double fMax;
+  double fError;    ///< error of the result, if the backend estimates it (0 otherwise)
+};
+
+/// What one fit cost and how it ended
+struct FitStatistics {
+  FitStatistics() { this->Reset(); }
+  void Reset() { fCalls = 0; fGradientCalls = 0; fIterations = -1; fConverged = false; fStatus = -1; }
+  int fCalls;           ///< evaluations of the function, with or without gradient
+  int fGradientCalls;   ///< evaluations that also gave the analytic gradient
+  int fIterations;      ///< iterations of the minimiser; -1 if the backend doesn't count them
+  bool fConverged;
+  int fStatus;          ///< status of the backend, 0 if it converged (for Minuit, what Migrad returned)
+};
+
+/// The function minimised by a fit: f at par, and df/dpar in grad if grad is not null
+typedef std::function<void(double* par, double& f, double* grad)> FitFunction;
+
+/**
+* \class VertexFitBackend
+*
+* A minimiser for the fits of MinuitOptimizer.  The optimizer describes a fit by its
+* function and bounded parameters; the backend minimises it and fills in the results and
+* the FitStatistics.  A backend is used by one optimizer on one thread at a time.
+*
+* Backends (Create() names):
+*   Minuit  TMinuit MIGRAD, as the fits always used.  Takes the analytic gradient of a
+*           function through SET GRADIENT when the fit provides one.
+*   LBFGS   limited-memory BFGS with the parameters projected onto their bounds.  Uses the
+*           analytic gradient when the fit provides one, central differences otherwise.
+*/
+
+class VertexFitBackend {
+
+ public:
+
+  virtual ~VertexFitBackend() {}
+
+  /// New backend by name ("Minuit" or "LBFGS"); null if there is no such backend
+  static VertexFitBackend* Create(const std::string& name);
+  static bool IsBackend(const std::string& name);
+
+  virtual std::string GetName() const = 0;
+
+  /// Minimise fcn from the values of par, leaving the results in par.  fcn fills its
+  /// gradient argument only if hasGradient.  strategy is Minuit's (1: standard,
+  /// 2: try to improve the minimum); other backends may ignore it.
+  virtual void Minimise(const FitFunction& fcn, bool hasGradient, int strategy,
+                        std::vector<FitParameter>& par, FitStatistics& stats) = 0;
+
+  /// Most evaluations of the function in a fit
+  void SetMaxCalls(int calls) { fMaxCalls = calls; }
+  int GetMaxCalls() const { return fMaxCalls; }
+
+ protected:
+
+  VertexFitBackend() : fMaxCalls(5000) {}
+
+  int fMaxCalls;
+
+};
+
+class MinuitFitBackend : public VertexFitBackend {
+
+ public:
+
+  MinuitFitBackend();
+  ~MinuitFitBackend();
+
+  std::string GetName() const { return "Minuit"; }
+  void Minimise(const FitFunction& fcn, bool hasGradient, int strategy,
+                std::vector<FitParameter>& par, FitStatistics& stats);
+
+ private:
+
+  MinuitFitBackend(const MinuitFitBackend&) = delete;
+  MinuitFitBackend& operator=(const MinuitFitBackend&) = delete;
+
+  TMinuit* fMinuit;
+  const FitFunction* fFunction;   // function of the fit in progress
+  FitStatistics* fStats;          // and its statistics
+
+};
+
+class LBFGSFitBackend : public VertexFitBackend {
+
+ public:
+
+  LBFGSFitBackend();
+
+  std::string GetName() const { return "LBFGS"; }
+  void Minimise(const FitFunction& fcn, bool hasGradient, int strategy,
+                std::vector<FitParameter>& par, FitStatistics& stats);
+
+  /// Number of past steps the inverse Hessian is built from
+  void SetMemory(int memory) { fMemory = memory; }
+  /// Converged once the gradient, in units of f per parameter step, is below this
+  void SetGradientTolerance(double tolerance) { fGradientTolerance = tolerance; }
+
+ private:
+
+  int fMemory;
+  double fGradientTolerance;
+
+};
+
+#endif
@@ -256,7 +256,7 @@ void VertexGeometry::LoadDigits(std::vector<RecoDigit>* vDigitList)
     fDistScatter[idigit] = 0.0;
 
     fDeltaTime[idigit] = 0.0;
-    fDeltaSigma[idigit] = 0.0;
+    fDeltaSigma[idigit] = Parameters::TimeResolution(fDigitType[idigit]);
     
     fDeltaAngle[idigit] = 0.0;
     fDeltaPoint[idigit] = 0.0;
@@ -425,57 +425,123 @@ void VertexGeometry::CalcResiduals(RecoVertex* myVertex)
 
 void VertexGeometry::CalcPointResiduals(double vtxX, double vtxY, double vtxZ, double vtxTime, double dirX, double dirY, double dirZ)
 {
-  this->CalcResiduals( vtxX, vtxY, vtxZ, vtxTime,
-                       dirX, dirY, dirZ );
+  double fC = Parameters::SpeedOfLight();
+  double fN = Parameters::Index0();
+  double vphoton = fC/fN;
 
+  this->CalcPointDistances( vtxX, vtxY, vtxZ,
+                            dirX, dirY, dirZ );
+
+  // point residual: DeltaTime - DistPoint/(fC/fN)
+  const double* digitT = fDigitT;
+  const double* distPoint = fDistPoint;
+  double* delta = fDelta;
   for( int idigit=0; idigit<fNDigits; idigit++ ){
-    fDelta[idigit] = fPointResidual[idigit];
+    delta[idigit] = (digitT[idigit] - vtxTime) - distPoint[idigit]/vphoton;
   }
 
+  this->CalcZenithAngles( dirX*dirX + dirY*dirY + dirZ*dirZ>0.0 );
+
   return;
 }
 
 void VertexGeometry::CalcExtendedResiduals(double vtxX, double vtxY, double vtxZ, double vtxTime, double dirX, double dirY, double dirZ )
 {
-  this->CalcResiduals( vtxX, vtxY, vtxZ, vtxTime,
-                       dirX, dirY, dirZ );
-
+  double thetadeg = Parameters::CherenkovAngle(); // degrees
+  double theta = thetadeg*(TMath::Pi()/180.0); // degrees->radians
+  double sintheta = sin(theta);
+  double costheta = cos(theta);
+
+  double fC = Parameters::SpeedOfLight();
+  double fVmu = fC;
+  double fN = Parameters::Index0();
+  double vphoton = fC/fN;
+
+  this->CalcPointDistances( vtxX, vtxY, vtxZ,
+                            dirX, dirY, dirZ );
+
+  // extended residual: DeltaTime - DistTrack/fVmu - DistPhoton/(fC/fN)
+  // inside the cone (phi<theta) the sines of CalcResiduals are written with cos(phi)
+  //   Ltrack  = Lpoint*sin(theta-phi)/sin(theta)
+  //           = Lpoint*(sin(theta)*cos(phi)-cos(theta)*sin(phi))/sin(theta)
+  //   Lphoton = Lpoint*sin(phi)/sin(theta)
+  // so the loop has no branches and no trigonometric functions, and vectorises
+  const double* digitT = fDigitT;
+  const double* distPoint = fDistPoint;
+  const double* cosZenith = fZenith;
+  double* delta = fDelta;
   for( int idigit=0; idigit<fNDigits; idigit++ ){
-    fDelta[idigit] = fExtendedResidual[idigit];
+    double Lpoint = distPoint[idigit];
+    double cosphi = cosZenith[idigit];
+    double sin2phi = 1.0-cosphi*cosphi;
+    double sinphi = sqrt( sin2phi>0.0 ? sin2phi : 0.0 );
+    double LtrackCone = Lpoint*(sintheta*cosphi-costheta*sinphi)/sintheta;
+    double LphotonCone = Lpoint*sinphi/sintheta;
+    bool insideCone = ( cosphi>costheta );
+    double Ltrack = insideCone ? LtrackCone : 0.0;
+    double Lphoton = insideCone ? LphotonCone : Lpoint;
+    delta[idigit] = (digitT[idigit] - vtxTime) - Ltrack/fVmu - Lphoton/vphoton;
   }
 
-  //std::cout << fDelta[46] << std::endl;
+  this->CalcZenithAngles( dirX*dirX + dirY*dirY + dirZ*dirZ>0.0 );
+
   return;
 }
 
-void VertexGeometry::CalcResiduals(double vtxX, double vtxY, double vtxZ, double vtxTime, double dirX, double dirY, double dirZ )
+void VertexGeometry::CalcPointDistances(double vtxX, double vtxY, double vtxZ, double dirX, double dirY, double dirZ)
 {
-  // reset arrays
-  // ============
-  for( int idigit=0; idigit<fNDigits; idigit++ ){
-    fConeAngle[idigit] = 0.0;
-    fZenith[idigit] = 0.0;
-    fAzimuth[idigit] = 0.0;
-    fSolidAngle[idigit] = 0.0;
-    fDistPoint[idigit] = 0.0;
-    fDistTrack[idigit] = 0.0;
-    fDistPhoton[idigit] = 0.0;  
-    fDistScatter[idigit] = 0.0; 
-    fDeltaTime[idigit] = 0.0; 
-    fDeltaSigma[idigit] = 0.0;
-    fDeltaAngle[idigit] = 0.0;
-    fDeltaPoint[idigit] = 0.0;
-    fDeltaTrack[idigit] = 0.0;
-    fDeltaPhoton[idigit] = 0.0;
-    fDeltaScatter[idigit] = 0.0;
-    fPointPath[idigit] = 0.0;
-    fExtendedPath[idigit] = 0.0;
-    fPointResidual[idigit] = 0.0;
-    fExtendedResidual[idigit] = 0.0;
-    fDelta[idigit] = 0.0;
-    fPointResidualMean = 0.0;
-    fExtendedResidualMean = 0.0;
+  // separate loops with and without a direction, so that neither has a branch
+  const double* digitX = fDigitX;
+  const double* digitY = fDigitY;
+  const double* digitZ = fDigitZ;
+  double* distPoint = fDistPoint;
+  double* cosZenith = fZenith;
+
+  if( dirX*dirX + dirY*dirY + dirZ*dirZ>0.0 ){
+    for( int idigit=0; idigit<fNDigits; idigit++ ){
+      double dx = digitX[idigit]-vtxX;
+      double dy = digitY[idigit]-vtxY;
+      double dz = digitZ[idigit]-vtxZ;
+      double ds = sqrt(dx*dx+dy*dy+dz*dz);
+      distPoint[idigit] = ds;
+      cosZenith[idigit] = (dx/ds)*dirX+(dy/ds)*dirY+(dz/ds)*dirZ;
+    }
+  }
+  else{
+    for( int idigit=0; idigit<fNDigits; idigit++ ){
+      double dx = digitX[idigit]-vtxX;
+      double dy = digitY[idigit]-vtxY;
+      double dz = digitZ[idigit]-vtxZ;
+      distPoint[idigit] = sqrt(dx*dx+dy*dy+dz*dz);
+      cosZenith[idigit] = 1.0;
+    }
   }
+
+  return;
+}
+
+void VertexGeometry::CalcZenithAngles(bool hasDirection)
+{
+  if( hasDirection ){
+    for( int idigit=0; idigit<fNDigits; idigit++ ){
+      fZenith[idigit] = acos(fZenith[idigit])/(TMath::Pi()/180.0); // radians->degrees
+    }
+  }
+  else{
+    for( int idigit=0; idigit<fNDigits; idigit++ ){
+      fZenith[idigit] = 0.0;
+    }
+  }
+
+  return;
+}
+
+void VertexGeometry::CalcResiduals(double vtxX, double vtxY, double vtxZ, double vtxTime, double dirX, double dirY, double dirZ )
+{
+  // every array is overwritten for each digit below
+  fPointResidualMean = 0.0;
+  fExtendedResidualMean = 0.0;
+
   // cone angle
   // ==========
   double thetadeg = Parameters::CherenkovAngle(); // degrees
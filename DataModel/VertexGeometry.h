@@ -17,13 +17,26 @@ class VertexGeometry {
  	
   static VertexGeometry* Instance();
 
+  /// The residuals of the vertex being tried are kept in the object, so each
+  /// reconstruction (see VertexRecoContext) needs a VertexGeometry of its own.
+  /// Instance() is a shared one, for code that has not moved to a VertexRecoContext.
+  VertexGeometry();
+  ~VertexGeometry();
+
   void LoadDigits(std::vector<RecoDigit>* vDigitList);
 
+  /// Calculate every per-digit quantity (angles, distances, paths, both residuals)
+  /// for a vertex; GetDelta() is the extended residual.
   void CalcResiduals(std::vector<RecoDigit>* vDigitList, RecoVertex* vtx);
   void CalcResiduals(RecoVertex* vtx);
   void CalcResiduals(double vx, double vy, double vz, double vtxTime,
 		      double px, double py, double pz);
 
+  /// Residual kernels of the fits, called for every FCN evaluation.  They only
+  /// calculate what the figures of merit read: GetDelta() (point or extended residual)
+  /// and GetAngle() (zenith, 0 without a direction).  GetDeltaSigma() is set by
+  /// LoadDigits().  The other per-digit quantities are left as they were; use
+  /// CalcResiduals() to get them.
   void CalcPointResiduals(double vx, double vy, double vz, double vtxTime,
 		           double px, double py, double pz);
   void CalcExtendedResiduals(double vx, double vy, double vz, double vtxTime,
@@ -266,9 +279,13 @@ class VertexGeometry {
   bool Print() {return true;};
 
   private:
+  // FoMCalculator::ExtendedVertexChi2 reads the per-digit arrays in a single loop
+  friend class FoMCalculator;
+
  	void Clear();
-  VertexGeometry();
-  ~VertexGeometry();
+
+  VertexGeometry(const VertexGeometry&) = delete;
+  VertexGeometry& operator=(const VertexGeometry&) = delete;
 
   void CalcSimpleVertex(double& vtxX, double& vtxY, double& vtxZ, double& vtxTime);
 
@@ -279,6 +296,12 @@ class VertexGeometry {
 
   void ChooseNextDigit(double& x, double& y, double& z, double& t);
 
+  // fDistPoint, and cos(zenith) in fZenith (1 without a direction)
+  void CalcPointDistances(double vx, double vy, double vz,
+                          double px, double py, double pz);
+  // fZenith from cos(zenith) to degrees
+  void CalcZenithAngles(bool hasDirection);
+
   int fNDigitsMax;
   int fNDigits;
   int fNFilterDigits;
@@ -0,0 +1,32 @@
+#include "VertexRecoContext.h"
+#include "ANNIEGeometry.h"
+#include "Parameters.h"
+
+VertexRecoContext::VertexRecoContext() : fDigitList(0) {
+  // The fits read these singletons; make them here rather than first in a fit on
+  // one of several threads
+  Parameters::Instance();
+  ANNIEGeometry::Instance();
+  fVtxGeo = new VertexGeometry();
+}
+
+VertexRecoContext::~VertexRecoContext() {
+  delete fVtxGeo; fVtxGeo = 0;
+}
+
+void VertexRecoContext::LoadDigits(std::vector<RecoDigit>* vDigitList) {
+  fDigitList = vDigitList;
+  fVtxGeo->LoadDigits(vDigitList);
+}
+
+MinuitOptimizer* VertexRecoContext::NewOptimizer() {
+  MinuitOptimizer* myOptimizer = new MinuitOptimizer();
+  myOptimizer->LoadVertexGeometry(fVtxGeo);
+  return myOptimizer;
+}
+
+FoMCalculator* VertexRecoContext::NewFoMCalculator() {
+  FoMCalculator* myFoMCalculator = new FoMCalculator();
+  myFoMCalculator->LoadVertexGeometry(fVtxGeo);
+  return myFoMCalculator;
+}
@@ -0,0 +1,55 @@
+#ifndef VERTEXRECOCONTEXT_H
+#define VERTEXRECOCONTEXT_H
+
+#include "RecoDigit.h"
+#include "VertexGeometry.h"
+#include "FoMCalculator.h"
+#include "MinuitOptimizer.h"
+
+#include <vector>
+
+/**
+* \class VertexRecoContext
+*
+* Everything one vertex reconstruction works on: the digits of an event, the residual
+* arrays of the vertex being tried (a VertexGeometry of the context's own), and the
+* FoMCalculators and MinuitOptimizers that fit them.  Contexts share no state, so several
+* events, or several seeds of one event, can be reconstructed at once with one context
+* per thread.  The reconstruction tools each own a context instead of sharing
+* VertexGeometry::Instance().
+*
+* Make the contexts on one thread (the constructor also makes the read-only Parameters
+* and ANNIEGeometry singletons the fits use), then use each on one thread at a time.
+* Threads that make optimizers need ROOT::EnableThreadSafety(), as TMinuits register
+* with gROOT.
+*/
+
+class VertexRecoContext {
+
+ public:
+
+  VertexRecoContext();
+  ~VertexRecoContext();
+
+  /// Load the digits of an event into the context's VertexGeometry
+  void LoadDigits(std::vector<RecoDigit>* vDigitList);
+
+  std::vector<RecoDigit>* GetDigits() { return fDigitList; }
+  VertexGeometry* GetVertexGeometry() { return fVtxGeo; }
+
+  /// A new optimizer fitting the digits of this context; the caller deletes it
+  MinuitOptimizer* NewOptimizer();
+  /// A new FoMCalculator for the digits of this context; the caller deletes it
+  FoMCalculator* NewFoMCalculator();
+
+ private:
+
+  VertexRecoContext(const VertexRecoContext&) = delete;
+  VertexRecoContext& operator=(const VertexRecoContext&) = delete;
+
+  std::vector<RecoDigit>* fDigitList;
+  VertexGeometry* fVtxGeo;
+
+};
+
+#endif
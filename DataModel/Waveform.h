@@ -4,6 +4,8 @@
 
 #include <SerialisableObject.h>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
@@ -14,7 +16,7 @@ class Waveform : public SerialisableObject{
 
 	public:
 	Waveform() : fStartTime(), fSamples(std::vector<T>{}) {serialise=true;}
-	Waveform(double tsin, std::vector<T> samplesin) : fStartTime(tsin), fSamples(samplesin){serialise=true;}
+	Waveform(double tsin, std::vector<T> samplesin) : fStartTime(tsin), fSamples(std::move(samplesin)){serialise=true;}
 	virtual ~Waveform(){}
 
 	inline double GetStartTime() const {return fStartTime;}
@@ -0,0 +1,265 @@
+/* vim:set noexpandtab tabstop=4 wrap */
+#ifndef WAVEFORMBLOCKCLASS_H
+#define WAVEFORMBLOCKCLASS_H
+
+#include <SerialisableObject.h>
+#include <stdint.h>
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Waveform.h"
+#include "CalibratedADCWaveform.h"
+
+/**
+* \class WaveformView
+*
+* Read-only view of one waveform held in a WaveformBlock.  It offers the accessors of
+* Waveform and CalibratedADCWaveform; Samples() is a range over the block's sample arena
+* rather than a std::vector.  A view stays valid until its block is changed or destroyed.
+* Views can also be made of a Waveform or CalibratedADCWaveform, so the same code reads
+* either layout; such a view stays valid while the waveform is unchanged.
+*/
+
+template <class T>
+class WaveformView {
+
+	public:
+
+	class SampleRange {
+		public:
+		SampleRange(const T* first, size_t n) : fFirst(first), fSize(n) {}
+		inline const T* begin() const {return fFirst;}
+		inline const T* end() const {return fFirst+fSize;}
+		inline const T* data() const {return fFirst;}
+		inline size_t size() const {return fSize;}
+		inline bool empty() const {return fSize==0;}
+		inline const T& front() const {return fFirst[0];}
+		inline const T& operator[](size_t i) const {return fFirst[i];}
+		inline const T& at(size_t i) const {
+			if(i>=fSize) throw std::out_of_range("WaveformView sample index out of range");
+			return fFirst[i];
+		}
+		private:
+		const T* fFirst;
+		size_t fSize;
+	};
+
+	WaveformView(const T* first, size_t n, double starttime, double baseline, double sigmabaseline) :
+		fSamples(first,n), fStartTime(starttime), fBaseline(baseline), fSigmaBaseline(sigmabaseline) {}
+	WaveformView(const Waveform<T>& wave) :
+		fSamples(wave.Samples().data(),wave.Samples().size()), fStartTime(wave.GetStartTime()),
+		fBaseline(0.), fSigmaBaseline(0.) {}
+	WaveformView(const CalibratedADCWaveform<T>& wave) :
+		fSamples(wave.Samples().data(),wave.Samples().size()), fStartTime(wave.GetStartTime()),
+		fBaseline(wave.GetBaseline()), fSigmaBaseline(wave.GetSigmaBaseline()) {}
+
+	inline double GetStartTime() const {return fStartTime;}
+	inline const SampleRange& Samples() const {return fSamples;}
+	inline T GetSample(int i) const {return fSamples.at(i);}
+	inline double GetBaseline() const {return fBaseline;}
+	inline double GetSigmaBaseline() const {return fSigmaBaseline;}
+
+	private:
+	SampleRange fSamples;
+	double fStartTime;
+	double fBaseline;
+	double fSigmaBaseline;
+};
+
+/**
+* \class WaveformBlock
+*
+* Columnar storage of all the waveforms of one event, as an alternative to
+* std::map<unsigned long, std::vector<Waveform<T>>> for RawADCData and CalibratedADCData.
+* The samples of every waveform sit back to back in one arena, and a table with one
+* entry per waveform, sorted by channel key and minibuffer, holds each waveform's
+* offset, length, start time and (for calibrated data) baseline.  An event is then
+* two allocations rather than one per waveform, and is serialised as two arrays.
+*
+* FromMap()/ToMap() convert from and to the map layout.  GetWaveformViews() reads
+* whichever of the two layouts a store holds as views, without copying any samples, so
+* files written before blocks existed can still be loaded.
+*/
+
+template <class T>
+class WaveformBlock : public SerialisableObject{
+
+	friend class boost::serialization::access;
+
+	public:
+
+	struct Entry {
+		unsigned long ChannelKey=0;
+		uint32_t Minibuffer=0;
+		uint64_t Offset=0;
+		uint32_t Size=0;
+		double StartTime=0.;
+		double Baseline=0.;
+		double SigmaBaseline=0.;
+
+		template<class Archive> void serialize(Archive & ar, const unsigned int version){
+			ar & ChannelKey;
+			ar & Minibuffer;
+			ar & Offset;
+			ar & Size;
+			ar & StartTime;
+			ar & Baseline;
+			ar & SigmaBaseline;
+		}
+	};
+
+	WaveformBlock() {serialise=true;}
+	virtual ~WaveformBlock(){}
+
+	inline void Clear() {fSamples.clear(); fEntries.clear();}
+	inline void Reserve(size_t nwaveforms, size_t nsamples) {fEntries.reserve(nwaveforms); fSamples.reserve(nsamples);}
+
+	/// Append a waveform as the next minibuffer of its channel
+	void Add(unsigned long channelkey, double starttime, const T* samples, size_t nsamples,
+			double baseline=0., double sigmabaseline=0.){
+		Entry entry;
+		entry.ChannelKey = channelkey;
+		entry.Offset = fSamples.size();
+		entry.Size = nsamples;
+		entry.StartTime = starttime;
+		entry.Baseline = baseline;
+		entry.SigmaBaseline = sigmabaseline;
+		fSamples.insert(fSamples.end(), samples, samples+nsamples);
+		//Waveforms normally arrive in channel order, so this is nearly always the end
+		typename std::vector<Entry>::iterator pos = std::upper_bound(fEntries.begin(), fEntries.end(), channelkey,
+			[](unsigned long key, const Entry& e){ return key < e.ChannelKey; });
+		entry.Minibuffer = (pos != fEntries.begin() && (pos-1)->ChannelKey == channelkey) ? (pos-1)->Minibuffer+1 : 0;
+		fEntries.insert(pos, entry);
+	}
+	inline void Add(unsigned long channelkey, const Waveform<T>& wave){
+		this->Add(channelkey, wave.GetStartTime(), wave.Samples().data(), wave.Samples().size());
+	}
+	inline void Add(unsigned long channelkey, const CalibratedADCWaveform<T>& wave){
+		this->Add(channelkey, wave.GetStartTime(), wave.Samples().data(), wave.Samples().size(),
+			wave.GetBaseline(), wave.GetSigmaBaseline());
+	}
+
+	inline size_t NumWaveforms() const {return fEntries.size();}
+	inline size_t NumSamples() const {return fSamples.size();}
+	inline const Entry& GetEntry(size_t i) const {return fEntries.at(i);}
+	inline WaveformView<T> At(size_t i) const {return this->View(fEntries.at(i));}
+
+	std::vector<unsigned long> ChannelKeys() const {
+		std::vector<unsigned long> keys;
+		for(const Entry& e : fEntries) if(keys.empty() || keys.back()!=e.ChannelKey) keys.push_back(e.ChannelKey);
+		return keys;
+	}
+	inline bool HasChannel(unsigned long channelkey) const {return this->NumMinibuffers(channelkey)>0;}
+	size_t NumMinibuffers(unsigned long channelkey) const {
+		std::pair<typename std::vector<Entry>::const_iterator,typename std::vector<Entry>::const_iterator> range = this->ChannelRange(channelkey);
+		return range.second-range.first;
+	}
+
+	/// The given minibuffer of a channel; throws std::out_of_range if there is none
+	WaveformView<T> Get(unsigned long channelkey, size_t minibuffer=0) const {
+		std::pair<typename std::vector<Entry>::const_iterator,typename std::vector<Entry>::const_iterator> range = this->ChannelRange(channelkey);
+		if(minibuffer >= (size_t)(range.second-range.first))
+			throw std::out_of_range("WaveformBlock has no minibuffer "+std::to_string(minibuffer)+" for channel "+std::to_string(channelkey));
+		return this->View(*(range.first+minibuffer));
+	}
+
+	/// Views of every waveform, by channel key and then minibuffer
+	void GetViews(std::map<unsigned long, std::vector<WaveformView<T>>>& views) const {
+		views.clear();
+		for(const Entry& e : fEntries) views[e.ChannelKey].push_back(this->View(e));
+	}
+
+	/// Replace the contents with the waveforms of a map, in map order
+	template <class W> void FromMap(const std::map<unsigned long, std::vector<W>>& wavemap){
+		this->Clear();
+		size_t nwaveforms=0, nsamples=0;
+		for(const auto& apair : wavemap){
+			nwaveforms += apair.second.size();
+			for(const W& wave : apair.second) nsamples += wave.Samples().size();
+		}
+		this->Reserve(nwaveforms, nsamples);
+		for(const auto& apair : wavemap){
+			for(const W& wave : apair.second) this->Add(apair.first, wave);
+		}
+	}
+
+	void ToMap(std::map<unsigned long, std::vector<Waveform<T>>>& wavemap) const {
+		wavemap.clear();
+		for(const Entry& e : fEntries){
+			wavemap[e.ChannelKey].emplace_back(e.StartTime,
+				std::vector<T>(fSamples.begin()+e.Offset, fSamples.begin()+e.Offset+e.Size));
+		}
+	}
+	void ToMap(std::map<unsigned long, std::vector<CalibratedADCWaveform<T>>>& wavemap) const {
+		wavemap.clear();
+		for(const Entry& e : fEntries){
+			wavemap[e.ChannelKey].emplace_back(e.StartTime,
+				std::vector<T>(fSamples.begin()+e.Offset, fSamples.begin()+e.Offset+e.Size),
+				e.Baseline, e.SigmaBaseline);
+		}
+	}
+
+	bool Print() {
+		cout<<"Waveforms : "<<fEntries.size()<<endl;
+		cout<<"Samples : "<<fSamples.size()<<endl;
+		cout<<"Channels : "<<this->ChannelKeys().size()<<endl;
+		return true;
+	}
+
+	protected:
+	std::vector<T> fSamples;       // sample arena, all waveforms back to back
+	std::vector<Entry> fEntries;   // sorted by channel key, then minibuffer
+
+	inline WaveformView<T> View(const Entry& e) const {
+		return WaveformView<T>(fSamples.data()+e.Offset, e.Size, e.StartTime, e.Baseline, e.SigmaBaseline);
+	}
+	std::pair<typename std::vector<Entry>::const_iterator,typename std::vector<Entry>::const_iterator>
+	ChannelRange(unsigned long channelkey) const {
+		return std::equal_range(fEntries.begin(), fEntries.end(), Entry{channelkey},
+			[](const Entry& a, const Entry& b){ return a.ChannelKey < b.ChannelKey; });
+	}
+
+	template<class Archive> void serialize(Archive & ar, const unsigned int version){
+		if(serialise){
+			ar & fSamples;
+			ar & fEntries;
+		}
+	}
+};
+
+/// Views of the waveforms of a map, by channel key and then minibuffer
+template <class W, class T>
+void GetViews(const std::map<unsigned long, std::vector<W>>& wavemap, std::map<unsigned long, std::vector<WaveformView<T>>>& views){
+	views.clear();
+	for(const auto& apair : wavemap){
+		std::vector<WaveformView<T>>& channel_views = views[apair.first];
+		channel_views.reserve(apair.second.size());
+		for(const W& wave : apair.second) channel_views.emplace_back(wave);
+	}
+}
+
+/// Get the waveforms stored under name as views: of a WaveformBlock stored as name+"Block",
+/// which is read into block, or else of a map of W (Waveform<T> or CalibratedADCWaveform<T>)
+/// stored as name, which is read into wavemap.  The views stay valid while block and wavemap do.
+template <class StoreT, class W, class T>
+bool GetWaveformViews(StoreT& store, const std::string& name, WaveformBlock<T>& block,
+		std::map<unsigned long, std::vector<W>>& wavemap, std::map<unsigned long, std::vector<WaveformView<T>>>& views){
+	wavemap.clear();
+	if(store.Get(name+"Block", block)){
+		block.GetViews(views);
+		return true;
+	}
+	block.Clear();
+	views.clear();
+	if(!store.Get(name, wavemap)) return false;
+	GetViews(wavemap, views);
+	return true;
+}
+
+#endif
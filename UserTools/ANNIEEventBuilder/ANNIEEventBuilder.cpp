@@ -19,6 +19,7 @@ bool ANNIEEventBuilder::Initialise(std::string configfile, DataModel &data){
   OrphanOldTankTimestamps = true;
   OldTimestampThreshold = 120; //seconds
   OrphanWarningValue = 20;
+  MaxOrphansInMemory = 1000;
   ExecutesPerBuild = 50;
   MRDTankTimeTolerance = 10;     //ms
   CTCTankTimeTolerance = 300;    //ns		//Edit: Changed Default CTCTankTolerance from 100ns to 300ns to allow for 256ns differences [M. Nieslony]
@@ -27,8 +28,10 @@ bool ANNIEEventBuilder::Initialise(std::string configfile, DataModel &data){
   DriftWarningValue = 5000000;   //ns
   pause_threshold = 5*60;        //s
   save_raw_data = false;	//Default option: Do not save the raw data (processed files get very large)
+  save_waveform_blocks = false;	//Store saved raw data as WaveformBlocks rather than maps of Waveforms
   store_beam_status = false;	//Should the beam status be stored? If yes, need the BeamDecoder tool in the ToolChain
   LAPPDOffsetFile = "None";	//File specifying the offset variables for the LAPPD global timestamps (if automatic determination goes wrong)
+  WriterQueueSize = 0;		//Number of built events that can wait for the writer thread (0: write on the main thread)
 
   /////////////////////////////////////////////////////////////////
   m_variables.Get("verbosity",verbosity);
@@ -45,10 +48,13 @@ bool ANNIEEventBuilder::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("CTCMRDTimeTolerance",CTCMRDTimeTolerance);
   m_variables.Get("CTCLAPPDTimeTolerance",CTCLAPPDTimeTolerance);
   m_variables.Get("OrphanFileBase",OrphanFileBase);
+  m_variables.Get("MaxOrphansInMemory",MaxOrphansInMemory);
   m_variables.Get("MaxStreamMatchingTimeSeparation",pause_threshold);
   m_variables.Get("SaveRawData",save_raw_data);
+  m_variables.Get("SaveWaveformBlocks",save_waveform_blocks);
   m_variables.Get("StoreBeamStatus",store_beam_status);
   m_variables.Get("LAPPDOffsetFile",LAPPDOffsetFile);
+  m_variables.Get("WriterQueueSize",WriterQueueSize);
   pause_threshold*=1E9;
 
   if(BuildType == "TankAndMRD" || BuildType == "TankAndMRDAndCTC" || BuildType == "TankAndMRDAndCTCAndLAPPD"){
@@ -65,9 +71,16 @@ bool ANNIEEventBuilder::Initialise(std::string configfile, DataModel &data){
     return false;
   }
 
-  m_data->CStore.Get("TankPMTCrateSpaceToChannelNumMap",TankPMTCrateSpaceToChannelNumMap);
-  m_data->CStore.Get("AuxCrateSpaceToChannelNumMap",AuxCrateSpaceToChannelNumMap);
-  m_data->CStore.Get("MRDCrateSpaceToChannelNumMap",MRDCrateSpaceToChannelNumMap);
+  //Crate space maps are published by LoadGeometry keyed by {crate,slot,channel}; pack them once here
+  std::map<std::vector<int>,int> CrateSpaceMap;
+  m_data->CStore.Get("TankPMTCrateSpaceToChannelNumMap",CrateSpaceMap);
+  TankPMTCrateSpaceToChannelNumMap = PackCrateSpaceMap(CrateSpaceMap);
+  CrateSpaceMap.clear();
+  m_data->CStore.Get("AuxCrateSpaceToChannelNumMap",CrateSpaceMap);
+  AuxCrateSpaceToChannelNumMap = PackCrateSpaceMap(CrateSpaceMap);
+  CrateSpaceMap.clear();
+  m_data->CStore.Get("MRDCrateSpaceToChannelNumMap",CrateSpaceMap);
+  MRDCrateSpaceToChannelNumMap = PackCrateSpaceMap(CrateSpaceMap);
   m_data->CStore.Get("ChannelNumToTankPMTCrateSpaceMap",ChannelNumToTankPMTCrateSpaceMap);
   m_data->CStore.Get("AuxChannelNumToCrateSpaceMap",AuxChannelNumToCrateSpaceMap);
 
@@ -76,6 +89,13 @@ bool ANNIEEventBuilder::Initialise(std::string configfile, DataModel &data){
     int NumAuxChannels = AuxCrateSpaceToChannelNumMap.size();
     if(verbosity>4) std::cout << "TOTAL TANK + AUX CHANNELS: " << NumTankPMTChannels + NumAuxChannels << std::endl;
     if(verbosity>4) std::cout << "CURRENT SET THRESHOLD FOR BUILDING PMT EVENTS: " << NumWavesInCompleteSet << std::endl;
+    //The tank wave maps from PMTDataDecoder must use the key layout this tool was built against
+    int TankWaveKeyVersion = 1;
+    m_data->CStore.Get("TankWaveKeyVersion",TankWaveKeyVersion);
+    if(TankWaveKeyVersion != TANK_WAVE_KEY_VERSION){
+      Log("ANNIEEventBuilder ERROR: InProgressTankEvents key version "+std::to_string(TankWaveKeyVersion)+" does not match expected version "+std::to_string(TANK_WAVE_KEY_VERSION)+". Please run an up-to-date PMTDataDecoder upstream of this tool",v_error,verbosity);
+      return false;
+    }
   }
 
   m_data->CStore.Set("SaveRawData",save_raw_data);
@@ -83,12 +103,15 @@ bool ANNIEEventBuilder::Initialise(std::string configfile, DataModel &data){
   m_data->CStore.Set("NewCalibratedData",false);
   m_data->CStore.Set("NewHitsData",false);
 
-  FinishedTankEvents = new std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > >; 
-  FinishedTankEventsSampleSize = new std::map<uint64_t, std::map<std::vector<int>, int>>;
+  FinishedTankEvents = new std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t> > >; 
+  FinishedTankEventsSampleSize = new std::map<uint64_t, std::map<CardChannelKey, int>>;
 
   //////////////////////initialize subrun index//////////////
   ProcessedStore = new BoostStore(false,2);
-  ANNIEEvent = new BoostStore(false,2);
+  if(WriterQueueSize<0) WriterQueueSize = 0;
+  if(WriterQueueSize>0) Log("ANNIEEventBuilder: Writing ANNIEEvents from a writer thread, queue size "+std::to_string(WriterQueueSize),v_message,verbosity);
+  EventWriter = new ANNIEEventWriter(WriterQueueSize);
+  ANNIEEvent = new ANNIEEventEntry;
   ANNIEEventNum = 0;
   CurrentRunNum = -1;
   CurrentSubRunNum = -1;
@@ -111,7 +134,7 @@ bool ANNIEEventBuilder::Execute(){
   bool NewEntryAvailable;
   m_data->CStore.Get("NewRawDataEntryAccessed",NewEntryAvailable);
   if(!NewEntryAvailable){ //Something went wrong processing raw data.  Stop and save what's left
-    Log("ANNIEEventBuilder Tool: There's no new PMT/MRD data.  Stopping loop, ANNIEEvent BoostStore will save.",v_warning,verbosity); 
+    LOG_LAZY("ANNIEEventBuilder Tool: There's no new PMT/MRD data.  Stopping loop, ANNIEEvent BoostStore will save.",v_warning,verbosity); 
     m_data->vars.Set("StopLoop",1);
   }
   
@@ -126,7 +149,7 @@ bool ANNIEEventBuilder::Execute(){
   //Don't include completed file boolean in the toolchain stopping condition for now, but might be an option later
   //toolchain_stopping |= file_completed;
   if(toolchain_stopping){
-    Log("ANNIEEventBuilder: StopLoop or FileCompleted detected, forcing building of any remaining events in the timestream",v_warning,verbosity);
+    LOG_LAZY("ANNIEEventBuilder: StopLoop or FileCompleted detected, forcing building of any remaining events in the timestream",v_warning,verbosity);
   }
     
   ExecuteCount+=1;
@@ -167,7 +190,7 @@ bool ANNIEEventBuilder::Execute(){
     //Check to see if there's new PMT data
     m_data->CStore.Get("NewTankPMTDataAvailable",IsNewTankData);
     if((!IsNewTankData)&&(!toolchain_stopping)){
-      Log("ANNIEEventBuilder:: No new Tank Data.  Not building ANNIEEvent. ",v_message, verbosity);
+      LOG_LAZY("ANNIEEventBuilder:: No new Tank Data.  Not building ANNIEEvent. ",v_message, verbosity);
       return true;
     }
     else if(IsNewTankData) this->ProcessNewTankPMTData();
@@ -178,14 +201,14 @@ bool ANNIEEventBuilder::Execute(){
 
     std::vector<uint64_t> PMTEventsToDelete;
     if (save_raw_data){
-      for(std::pair<uint64_t,std::map<std::vector<int>, std::vector<uint16_t>>> apair : *FinishedTankEvents){
+      for(const std::pair<const uint64_t,std::map<CardChannelKey, std::vector<uint16_t>>> &apair : *FinishedTankEvents){
         std::map<std::string,bool> DataStreams;
         DataStreams.emplace("Tank",1);
         DataStreams.emplace("MRD",0);
         DataStreams.emplace("CTC",0);
         DataStreams.emplace("LAPPD",0);
         uint64_t PMTCounterTime = apair.first;
-        std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = apair.second;
+        const std::map<CardChannelKey, std::vector<uint16_t>> &aWaveMap = apair.second;
         this->BuildANNIEEventRunInfo(RunNumber,SubRunNumber,PartNumber,RunType,StarTime);
         this->BuildANNIEEventTankRaw(PMTCounterTime, aWaveMap);
         ANNIEEvent->Set("DataStreams",DataStreams);
@@ -203,12 +226,12 @@ bool ANNIEEventBuilder::Execute(){
         DataStreams.emplace("LAPPD",0);
         uint64_t PMTCounterTime = apair.first;
         std::map<unsigned long,std::vector<Hit>>* aFinishedHits = apair.second;
-        std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHits = FinishedRecoADCHits->at(PMTCounterTime);
+        std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHits = std::move(FinishedRecoADCHits->at(PMTCounterTime));
         std::map<unsigned long,std::vector<Hit>>* aFinishedHitsAux = FinishedHitsAux->at(PMTCounterTime);
-        std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHitsAux = FinishedRecoADCHitsAux->at(PMTCounterTime);
-        std::map<unsigned long,std::vector<int>> RawAcqSize = FinishedRawAcqSize->at(PMTCounterTime);
+        std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHitsAux = std::move(FinishedRecoADCHitsAux->at(PMTCounterTime));
+        std::map<unsigned long,std::vector<int>> RawAcqSize = std::move(FinishedRawAcqSize->at(PMTCounterTime));
         this->BuildANNIEEventRunInfo(RunNumber,SubRunNumber,PartNumber,RunType,StarTime);
-        this->BuildANNIEEventTankHits(PMTCounterTime, aFinishedHits, aFinishedRecoADCHits, aFinishedHitsAux, aFinishedRecoADCHitsAux, RawAcqSize);
+        this->BuildANNIEEventTankHits(PMTCounterTime, aFinishedHits, std::move(aFinishedRecoADCHits), aFinishedHitsAux, std::move(aFinishedRecoADCHitsAux), std::move(RawAcqSize));
         ANNIEEvent->Set("DataStreams",DataStreams);
         this->SaveEntryToFile(CurrentRunNum,CurrentSubRunNum,CurrentPartNum);
         //Erase this entry from the InProgressTankEventsMap
@@ -240,10 +263,10 @@ bool ANNIEEventBuilder::Execute(){
  
     //Assume a whole processed file will have all it's PMT data finished
     std::vector<uint64_t> PMTEventsToDelete;
-    for(std::pair<uint64_t,std::map<std::vector<int>, std::vector<uint16_t>>> apair : *InProgressTankEvents){
+    for(const std::pair<const uint64_t,std::map<CardChannelKey, std::vector<uint16_t>>> &apair : *InProgressTankEvents){
       uint64_t PMTCounterTime = apair.first;
       if(verbosity>4) std::cout << "Finished waveset has clock counter: " << PMTCounterTime << std::endl;
-      std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = apair.second;
+      const std::map<CardChannelKey, std::vector<uint16_t>> &aWaveMap = apair.second;
       if(verbosity>4) std::cout << "Number of waves for this counter: " << aWaveMap.size() << std::endl;
       //For this counter, need to have the number of TankPMT channels plus number of aux channels
       if(aWaveMap.size() >= (NumWavesInCompleteSet)){
@@ -268,7 +291,7 @@ bool ANNIEEventBuilder::Execute(){
     m_data->CStore.Get("NewMRDDataAvailable",IsNewMRDData);
     std::vector<uint64_t> MRDEventsToDelete;
     if((!IsNewMRDData)&&(!toolchain_stopping)){
-      Log("ANNIEEventBuilder:: No new MRD Data.  Not building ANNIEEvent: ",v_message, verbosity);
+      LOG_LAZY("ANNIEEventBuilder:: No new MRD Data.  Not building ANNIEEvent: ",v_message, verbosity);
       return true;
     }
     m_data->CStore.Get("MRDEvents",myMRDMaps.MRDEvents);
@@ -368,13 +391,13 @@ bool ANNIEEventBuilder::Execute(){
       // otherwise doing so will prevent building attempts
       if(NumTankTimestamps>EventsPerPairing){
         m_data->CStore.Set("PauseTankDecoding",true);
-        Log("ANNIEEventBuilder: Pausing tank stream",v_debug,verbosity);
+        LOG_LAZY("ANNIEEventBuilder: Pausing tank stream",v_debug,verbosity);
       }
     }
     if((static_cast<int64_t>(most_recent_mrd)-static_cast<int64_t>(slowest_stream_timestamp))>pause_threshold){
       if(NumMRDTimestamps>EventsPerPairing){
         m_data->CStore.Set("PauseMRDDecoding",true);
-        Log("ANNIEEventBuilder: Pausing mrd stream",v_debug,verbosity);
+        LOG_LAZY("ANNIEEventBuilder: Pausing mrd stream",v_debug,verbosity);
       }
     }
     
@@ -411,16 +434,16 @@ bool ANNIEEventBuilder::Execute(){
         if(verbosity>4) std::cout << "TANK EVENT WITH TIMESTAMP " << TankCounterTime << " HAS REQUIRED MINIMUM NUMBER OF WAVES TO BUILD" << std::endl;
         this->BuildANNIEEventRunInfo(CurrentRunNum, CurrentSubRunNum, CurrentPartNum, CurrentRunType,CurrentStarTime);
         if (save_raw_data){
-          std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = FinishedTankEvents->at(TankCounterTime);
+          const std::map<CardChannelKey, std::vector<uint16_t>> &aWaveMap = FinishedTankEvents->at(TankCounterTime);
           if(verbosity>4) std::cout << "BUILDING AN ANNIE EVENT" << std::endl;
           this->BuildANNIEEventTankRaw(TankCounterTime, aWaveMap);
         } else {
           std::map<unsigned long,std::vector<Hit>>* aFinishedHits = FinishedHits->at(TankCounterTime);
-          std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHits = FinishedRecoADCHits->at(TankCounterTime);
+          std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHits = std::move(FinishedRecoADCHits->at(TankCounterTime));
           std::map<unsigned long,std::vector<Hit>>* aFinishedHitsAux = FinishedHitsAux->at(TankCounterTime);
-          std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHitsAux = FinishedRecoADCHitsAux->at(TankCounterTime);
-          std::map<unsigned long,std::vector<int>> RawAcqSize = FinishedRawAcqSize->at(TankCounterTime);
-          this->BuildANNIEEventTankHits(TankCounterTime, aFinishedHits, aFinishedRecoADCHits, aFinishedHitsAux, aFinishedRecoADCHitsAux, RawAcqSize);
+          std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHitsAux = std::move(FinishedRecoADCHitsAux->at(TankCounterTime));
+          std::map<unsigned long,std::vector<int>> RawAcqSize = std::move(FinishedRawAcqSize->at(TankCounterTime));
+          this->BuildANNIEEventTankHits(TankCounterTime, aFinishedHits, std::move(aFinishedRecoADCHits), aFinishedHitsAux, std::move(aFinishedRecoADCHitsAux), std::move(RawAcqSize));
       
         }
         this->BuildANNIEEventMRD(MRDHits, MRDTimeStamp, MRDTriggerType, beam_tdc, cosmic_tdc);
@@ -559,7 +582,7 @@ std::cout<<std::endl;
       // otherwise doing so will prevent building attempts
       if(NumTankTimestamps>EventsPerPairing){
         m_data->CStore.Set("PauseTankDecoding",true);
-        Log("ANNIEEventBuilder: Pausing tank stream",v_debug,verbosity);
+        LOG_LAZY("ANNIEEventBuilder: Pausing tank stream",v_debug,verbosity);
       } else {
         m_data->CStore.Set("PauseTankDecoding",false);
       }
@@ -567,7 +590,7 @@ std::cout<<std::endl;
     if((static_cast<int64_t>(most_recent_mrd)-static_cast<int64_t>(slowest_stream_timestamp))>pause_threshold){
       if(NumMRDTimestamps>EventsPerPairing){
         m_data->CStore.Set("PauseMRDDecoding",true);
-        Log("ANNIEEventBuilder: Pausing mrd stream",v_debug,verbosity);
+        LOG_LAZY("ANNIEEventBuilder: Pausing mrd stream",v_debug,verbosity);
       } else {
         m_data->CStore.Set("PauseMRDDecoding",false);
       }
@@ -575,7 +598,7 @@ std::cout<<std::endl;
     if((static_cast<int64_t>(most_recent_ctc)-static_cast<int64_t>(slowest_stream_timestamp))>pause_threshold){
       if(NumTrigs>EventsPerPairing){
         m_data->CStore.Set("PauseCTCDecoding",true);
-        Log("ANNIEEventBuilder: Pausing ctc stream",v_debug,verbosity);
+        LOG_LAZY("ANNIEEventBuilder: Pausing ctc stream",v_debug,verbosity);
       } else {
         m_data->CStore.Set("PauseCTCDecoding",false);
       }
@@ -584,7 +607,7 @@ std::cout<<std::endl;
       if((static_cast<int64_t>(most_recent_lappd)-static_cast<int64_t>(slowest_stream_timestamp))>pause_threshold){
       if(NumLAPPDTimestamps>EventsPerPairing){
         m_data->CStore.Set("PauseLAPPDDecoding",true);
-        Log("ANNIEEventBuilder: Pausing LAPPD stream",v_debug,verbosity);
+        LOG_LAZY("ANNIEEventBuilder: Pausing LAPPD stream",v_debug,verbosity);
       } else {
         m_data->CStore.Set("PauseLAPPDDecoding",false);
       }
@@ -609,18 +632,18 @@ std::cout<<std::endl;
     // OR if the toolchain is being stopped (reached and of file, for example)
     if((MinStamps>EventsPerPairing)||toolchain_stopping){
       /*if(verbosity>4) std::cout << "MERGING COSMIC/MRD PAIRS " << std::endl;
-      ThisBuildMap = this->PairCTCCosmicPairs(ThisBuildMap,std::max(most_recent_mrd,most_recent_ctc),toolchain_stopping);
+      this->PairCTCCosmicPairs(ThisBuildMap,std::max(most_recent_mrd,most_recent_ctc),toolchain_stopping);
       this->ManageOrphanage();*/
 
       if(verbosity>4) std::cout << "BEGINNING STREAM MERGING " << std::endl;
       //Prioritize tank matching vs. MRD matching -> check slowest in progress timestamp
       uint64_t max_matching_time = (slowest_stream_timestamp < slowest_in_progress_tank)? slowest_stream_timestamp : slowest_in_progress_tank;
       if (verbosity > 3) std::cout <<"ANNIEEventBuilder Tool: slowest_stream_timestamp: "<<slowest_stream_timestamp<<", slowest_in_progress_tank: "<<slowest_in_progress_tank<<", max_matching_time: "<<max_matching_time<<std::endl;
-      //ThisBuildMap = this->MergeStreams(ThisBuildMap,slowest_stream_timestamp,toolchain_stopping);
-      ThisBuildMap = this->MergeStreams(ThisBuildMap,max_matching_time,toolchain_stopping);
-      Log("ANNIEEventBuilder: Calling ManageOrphanage post MergeStreams",v_debug,verbosity);
+      //this->MergeStreams(ThisBuildMap,slowest_stream_timestamp,toolchain_stopping);
+      this->MergeStreams(ThisBuildMap,max_matching_time,toolchain_stopping);
+      LOG_LAZY("ANNIEEventBuilder: Calling ManageOrphanage post MergeStreams",v_debug,verbosity);
       this->ManageOrphanage();
-      Log("ANNIEEventBuilder: Done managing orphanage",v_debug,verbosity);
+      LOG_LAZY("ANNIEEventBuilder: Done managing orphanage",v_debug,verbosity);
 
       std::vector<uint64_t> TimesToDelete;
 
@@ -658,16 +681,16 @@ std::cout<<std::endl;
             uint64_t TankPMTTime = buildset_entries.second;
             if(verbosity>4) std::cout << "TANK EVENT WITH TIMESTAMP " << TankPMTTime << "HAS REQUIRED MINIMUM NUMBER OF WAVES TO BUILD" << std::endl;
             if (save_raw_data) {
-              std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = FinishedTankEvents->at(TankPMTTime);
+              const std::map<CardChannelKey, std::vector<uint16_t>> &aWaveMap = FinishedTankEvents->at(TankPMTTime);
               this->BuildANNIEEventTankRaw(TankPMTTime, aWaveMap);
             }
             else {
               std::map<unsigned long,std::vector<Hit>>* aFinishedHits = FinishedHits->at(TankPMTTime);
-              std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHits = FinishedRecoADCHits->at(TankPMTTime);
+              std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHits = std::move(FinishedRecoADCHits->at(TankPMTTime));
               std::map<unsigned long,std::vector<Hit>>* aFinishedHitsAux = FinishedHitsAux->at(TankPMTTime);
-              std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHitsAux = FinishedRecoADCHitsAux->at(TankPMTTime);
-              std::map<unsigned long,std::vector<int>> RawAcqSize = FinishedRawAcqSize->at(TankPMTTime);
-              this->BuildANNIEEventTankHits(TankPMTTime, aFinishedHits, aFinishedRecoADCHits, aFinishedHitsAux, aFinishedRecoADCHitsAux, RawAcqSize);
+              std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHitsAux = std::move(FinishedRecoADCHitsAux->at(TankPMTTime));
+              std::map<unsigned long,std::vector<int>> RawAcqSize = std::move(FinishedRawAcqSize->at(TankPMTTime));
+              this->BuildANNIEEventTankHits(TankPMTTime, aFinishedHits, std::move(aFinishedRecoADCHits), aFinishedHitsAux, std::move(aFinishedRecoADCHitsAux), std::move(RawAcqSize));
               TimesToDelete.push_back(TankPMTTime);
             }
             FinishedTankEventsSampleSize->erase(TankPMTTime);
@@ -710,7 +733,7 @@ std::cout<<std::endl;
           //std::cout <<"datastreams[tank]=0"<<std::endl;
           uint64_t default_clocktime=0;
           if (save_raw_data){
-            std::map<std::vector<int>, std::vector<uint16_t>> empty_wavemap;
+            std::map<CardChannelKey, std::vector<uint16_t>> empty_wavemap;
             this->BuildANNIEEventTankRaw(default_clocktime, empty_wavemap);
           } else {
             std::map<unsigned long,std::vector<Hit>>* emptyHits = new std::map<unsigned long,std::vector<Hit>>;
@@ -792,7 +815,7 @@ std::cout<<std::endl;
       // otherwise doing so will prevent building attempts
       if(NumTankTimestamps>EventsPerPairing){
         m_data->CStore.Set("PauseTankDecoding",true);
-        Log("ANNIEEventBuilder: Pausing tank stream",v_debug,verbosity);
+        LOG_LAZY("ANNIEEventBuilder: Pausing tank stream",v_debug,verbosity);
       } else {
       m_data->CStore.Set("PauseTankDecoding",false);
       }
@@ -800,7 +823,7 @@ std::cout<<std::endl;
     if((static_cast<int64_t>(most_recent_ctc)-static_cast<int64_t>(slowest_stream_timestamp))>pause_threshold){
       if(NumTrigs>EventsPerPairing){
         m_data->CStore.Set("PauseCTCDecoding",true);
-        Log("ANNIEEventBuilder: Pausing ctc stream",v_debug,verbosity);
+        LOG_LAZY("ANNIEEventBuilder: Pausing ctc stream",v_debug,verbosity);
       } else {
         m_data->CStore.Set("PauseCTCDecoding",false);
       }
@@ -822,11 +845,11 @@ std::cout<<std::endl;
 
       uint64_t max_matching_time = (slowest_stream_timestamp < slowest_in_progress_tank)? slowest_stream_timestamp : slowest_in_progress_tank;
       if(verbosity>4) std::cout << "BEGINNING STREAM MERGING " << std::endl;
-      ThisBuildMap = this->MergeStreams(ThisBuildMap,max_matching_time,toolchain_stopping);
-      //ThisBuildMap = this->MergeStreams(ThisBuildMap,slowest_stream_timestamp,toolchain_stopping);
-      Log("ANNIEEventBuilder: Calling ManageOrphanage post MergeStreams",v_debug,verbosity);
+      this->MergeStreams(ThisBuildMap,max_matching_time,toolchain_stopping);
+      //this->MergeStreams(ThisBuildMap,slowest_stream_timestamp,toolchain_stopping);
+      LOG_LAZY("ANNIEEventBuilder: Calling ManageOrphanage post MergeStreams",v_debug,verbosity);
       this->ManageOrphanage();
-      Log("ANNIEEventBuilder: Done managing orphanage",v_debug,verbosity);
+      LOG_LAZY("ANNIEEventBuilder: Done managing orphanage",v_debug,verbosity);
 
       std::vector<uint64_t> TimesToDelete;
       for(std::pair<uint64_t, std::map<std::string,uint64_t>> buildmap_entries : ThisBuildMap){
@@ -862,16 +885,16 @@ std::cout<<std::endl;
             uint64_t TankPMTTime = buildset_entries.second;
             if(verbosity>4) std::cout << "TANK EVENT WITH TIMESTAMP " << TankPMTTime << "HAS REQUIRED MINIMUM NUMBER OF WAVES TO BUILD" << std::endl;
             if (save_raw_data) {
-              std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = FinishedTankEvents->at(TankPMTTime);
+              const std::map<CardChannelKey, std::vector<uint16_t>> &aWaveMap = FinishedTankEvents->at(TankPMTTime);
               this->BuildANNIEEventTankRaw(TankPMTTime, aWaveMap);
             }
             else {
               std::map<unsigned long,std::vector<Hit>>* aFinishedHits = FinishedHits->at(TankPMTTime);
-              std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHits = FinishedRecoADCHits->at(TankPMTTime);
+              std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHits = std::move(FinishedRecoADCHits->at(TankPMTTime));
               std::map<unsigned long,std::vector<Hit>>* aFinishedHitsAux = FinishedHitsAux->at(TankPMTTime);
-              std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHitsAux = FinishedRecoADCHitsAux->at(TankPMTTime);
-              std::map<unsigned long,std::vector<int>> RawAcqSize = FinishedRawAcqSize->at(TankPMTTime);
-              this->BuildANNIEEventTankHits(TankPMTTime, aFinishedHits, aFinishedRecoADCHits, aFinishedHitsAux, aFinishedRecoADCHitsAux, RawAcqSize);
+              std::map<unsigned long,std::vector<std::vector<ADCPulse>>> aFinishedRecoADCHitsAux = std::move(FinishedRecoADCHitsAux->at(TankPMTTime));
+              std::map<unsigned long,std::vector<int>> RawAcqSize = std::move(FinishedRawAcqSize->at(TankPMTTime));
+              this->BuildANNIEEventTankHits(TankPMTTime, aFinishedHits, std::move(aFinishedRecoADCHits), aFinishedHitsAux, std::move(aFinishedRecoADCHitsAux), std::move(RawAcqSize));
               TimesToDelete.push_back(TankPMTTime);
             }
             FinishedTankEventsSampleSize->erase(TankPMTTime);
@@ -951,7 +974,7 @@ std::cout<<std::endl;
       // otherwise doing so will prevent building attempts
       if(NumMRDTimestamps>EventsPerPairing){
         m_data->CStore.Set("PauseMRDDecoding",true);
-        Log("ANNIEEventBuilder: Pausing MRD stream",v_debug,verbosity);
+        LOG_LAZY("ANNIEEventBuilder: Pausing MRD stream",v_debug,verbosity);
       } else {
       m_data->CStore.Set("PauseMRDDecoding",false);
       }
@@ -959,7 +982,7 @@ std::cout<<std::endl;
     if((static_cast<int64_t>(most_recent_ctc)-static_cast<int64_t>(slowest_stream_timestamp))>pause_threshold){
       if(NumTrigs>EventsPerPairing){
         m_data->CStore.Set("PauseCTCDecoding",true);
-        Log("ANNIEEventBuilder: Pausing ctc stream",v_debug,verbosity);
+        LOG_LAZY("ANNIEEventBuilder: Pausing ctc stream",v_debug,verbosity);
       } else {
         m_data->CStore.Set("PauseCTCDecoding",false);
       }
@@ -980,10 +1003,10 @@ std::cout<<std::endl;
     if((MinStamps>EventsPerPairing)||toolchain_stopping){
 
       if(verbosity>4) std::cout << "BEGINNING STREAM MERGING " << std::endl;
-      ThisBuildMap = this->MergeStreams(ThisBuildMap,slowest_stream_timestamp,toolchain_stopping);
-      Log("ANNIEEventBuilder: Calling ManageOrphanage post MergeStreams",v_debug,verbosity);
+      this->MergeStreams(ThisBuildMap,slowest_stream_timestamp,toolchain_stopping);
+      LOG_LAZY("ANNIEEventBuilder: Calling ManageOrphanage post MergeStreams",v_debug,verbosity);
       this->ManageOrphanage();
-      Log("ANNIEEventBuilder: Done managing orphanage",v_debug,verbosity);
+      LOG_LAZY("ANNIEEventBuilder: Done managing orphanage",v_debug,verbosity);
 
       for(std::pair<uint64_t, std::map<std::string,uint64_t>> buildmap_entries : ThisBuildMap){
         std::map<std::string,bool> DataStreams;
@@ -1064,9 +1087,9 @@ bool ANNIEEventBuilder::Finalise(){
     std::map<uint64_t,double> TankOrphansTDiff;
     if (save_raw_data){
     if (verbosity > 4) std::cout <<"ANNIEEventBuilder: Remaining in progress events in Finalise step: "<<InProgressTankEvents->size()<<std::endl;
-    for(std::pair<uint64_t,std::map<std::vector<int>, std::vector<uint16_t>>> apair : *InProgressTankEvents){
+    for(const std::pair<const uint64_t,std::map<CardChannelKey, std::vector<uint16_t>>> &apair : *InProgressTankEvents){
       uint64_t PMTCounterTimeNs = apair.first;
-      std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = apair.second;
+      const std::map<CardChannelKey, std::vector<uint16_t>> &aWaveMap = apair.second;
       if(aWaveMap.size() < (NumWavesInCompleteSet)){
         TankOrphans.emplace(PMTCounterTimeNs,"incomplete_tank_event");
         TankOrphansWaveMap.emplace(PMTCounterTimeNs,aWaveMap.size());
@@ -1096,8 +1119,11 @@ bool ANNIEEventBuilder::Finalise(){
 
   if(verbosity>4) std::cout << "ANNIEEvent Finalising.  Closing any open ANNIEEvent Boostore" << std::endl;
   if(verbosity>2) std::cout << "ANNIEEventBuilder: Saving and closing file." << std::endl;
-  ANNIEEvent->Close();
-  ANNIEEvent->Delete();
+  //Wait for the writer to store all built events before the file is closed
+  EventWriter->Finalise();
+  if(verbosity>2) std::cout << "ANNIEEventBuilder: " << EventWriter->EntriesWritten() << " of " << ANNIEEventNum <<
+          " built ANNIEEvents written" << std::endl;
+  delete EventWriter;
   delete ANNIEEvent;
   if(verbosity>2) std::cout << "PMT/MRD Orphan number at finalise: " << myOrphanage.OrphanTankTimestamps.size() <<
           "," << myOrphanage.OrphanMRDTimestamps.size() << std::endl;
@@ -1119,7 +1145,7 @@ void ANNIEEventBuilder::ProcessNewCTCData(){
       if(verbosity>5) std::cout << "CTCTIMESTAMP,WORD" << CTCTimeStamp << "," << CTCWord << std::endl;
     }
   }
-  RemoveDuplicates(myTimeStream.CTCTimestamps);
+  TimeStreamMerger::SortStream(myTimeStream.CTCTimestamps);
 
   std::vector<uint64_t> aux_trigword_delete;
   //Read in auxiliary triggerword information, use information from trigword 40 (min-bias) & 41 (CC-extended readout)
@@ -1205,7 +1231,7 @@ void ANNIEEventBuilder::ProcessNewMRDData(){
     myTimeStream.BeamMRDTimestamps.push_back(MRDTimeStamp);
     if(verbosity>5) std::cout << "MRDTIMESTAMPTRIGTYPE," << MRDTimeStamp << "," << myMRDMaps.MRDTriggerTypeMap.at(MRDTimeStamp) << std::endl;
   }
-  RemoveDuplicates(myTimeStream.BeamMRDTimestamps);
+  TimeStreamMerger::SortStream(myTimeStream.BeamMRDTimestamps);
   return;
 }
 
@@ -1233,9 +1259,9 @@ void ANNIEEventBuilder::ProcessNewTankPMTData(){
   
   if (save_raw_data){
   if (verbosity > 4) std::cout <<"ANNIEEventBuilder Tool: Number of InProgressTankEvents: "<<InProgressTankEvents->size()<<std::endl;
-  for(std::pair<uint64_t,std::map<std::vector<int>, std::vector<uint16_t>>> apair : *InProgressTankEvents){
+  for(const std::pair<const uint64_t,std::map<CardChannelKey, std::vector<uint16_t>>> &apair : *InProgressTankEvents){
     uint64_t PMTCounterTimeNs = apair.first;
-    std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = apair.second;
+    const std::map<CardChannelKey, std::vector<uint16_t>> &aWaveMap = apair.second;
     if(verbosity>4) std::cout << "TS: " << PMTCounterTimeNs <<", Number of waves for this counter: " << aWaveMap.size() << std::endl;
     //std::cout <<"MaxObservedNumWaves: "<<MaxObservedNumWaves<<std::endl;
 
@@ -1266,11 +1292,10 @@ void ANNIEEventBuilder::ProcessNewTankPMTData(){
     //std::cout <<"aWaveMap.size(): "<<aWaveMap.size()<<", NumWavesInCompleteSet: "<<NumWavesInCompleteSet<<std::endl;
     if(aWaveMap.size() >= (NumWavesInCompleteSet) || ((aWaveMap.size() == NumWavesInCompleteSet-1) && (AlmostCompleteWaveforms.at(PMTCounterTimeNs)>=5))){
       FinishedTankEvents->emplace(PMTCounterTimeNs,aWaveMap);
-      std::map<std::vector<int>,int> aWaveMapSampleSize;
-      for (std::pair<std::vector<int>,std::vector<uint16_t>> wavemappair : aWaveMap){
-        std::vector<int> temp_channel = wavemappair.first;
+      std::map<CardChannelKey,int> aWaveMapSampleSize;
+      for (const std::pair<const CardChannelKey,std::vector<uint16_t>> &wavemappair : aWaveMap){
         int temp_size = int(aWaveMap.size());
-        aWaveMapSampleSize.emplace(temp_channel,temp_size);
+        aWaveMapSampleSize.emplace_hint(aWaveMapSampleSize.end(),wavemappair.first,temp_size);
       }    
       FinishedTankEventsSampleSize->emplace(PMTCounterTimeNs,aWaveMapSampleSize);
       if (save_raw_data) myTimeStream.BeamTankTimestamps.push_back(PMTCounterTimeNs);
@@ -1295,7 +1320,7 @@ void ANNIEEventBuilder::ProcessNewTankPMTData(){
       TankOrphansTDiff.emplace(PMTCounterTimeNs,0);
     }
   }
-  RemoveDuplicates(myTimeStream.BeamTankTimestamps);
+  TimeStreamMerger::SortStream(myTimeStream.BeamTankTimestamps);
  
   std::cout <<"myTimeStream.BeamTankTimestamps.size(): "<<myTimeStream.BeamTankTimestamps.size()<<", FinishedTankEventsSampleSize size: "<<FinishedTankEventsSampleSize->size()<<std::endl;
 
@@ -1355,7 +1380,7 @@ void ANNIEEventBuilder::ProcessNewTankPMTData(){
     //std::cout <<"aChkey.size(): "<<aChkey.size()<<", NumWavesInCompleteSet: "<<NumWavesInCompleteSet<<std::endl;
     if(aChkey.size() >= (NumWavesInCompleteSet) || ((aChkey.size() == NumWavesInCompleteSet-1) && (AlmostCompleteWaveforms.at(PMTCounterTimeNs)>=5))){
       FinishedHits->emplace(PMTCounterTimeNs,aHit);
-      std::map<std::vector<int>,int> aWaveMapSampleSize;
+      std::map<CardChannelKey,int> aWaveMapSampleSize;
       for (int i_ch=0; i_ch < (int) aChkey.size(); i_ch++){
         unsigned long temp_chkey = aChkey.at(i_ch);
         std::vector<int> temp_channel;
@@ -1365,8 +1390,7 @@ void ANNIEEventBuilder::ProcessNewTankPMTData(){
         int temp_size = int(aChkey.size());
         int temp_cardid;
         this->ElectronicsSpacetoCardID(temp_channel.at(0),temp_channel.at(1),temp_cardid);
-        std::vector<int> temp_cardch{temp_cardid,temp_channel.at(2)};
-        aWaveMapSampleSize.emplace(temp_cardch,temp_size);
+        aWaveMapSampleSize.emplace(MakeCardChannelKey(temp_cardid,temp_channel.at(2)),temp_size);
       }    
       FinishedTankEventsSampleSize->emplace(PMTCounterTimeNs,aWaveMapSampleSize);
       myTimeStream.BeamTankTimestamps.push_back(PMTCounterTimeNs);
@@ -1390,7 +1414,7 @@ void ANNIEEventBuilder::ProcessNewTankPMTData(){
       TankOrphansTDiff.emplace(PMTCounterTimeNs,0);
     }
   }
-  RemoveDuplicates(myTimeStream.BeamTankTimestamps);
+  TimeStreamMerger::SortStream(myTimeStream.BeamTankTimestamps);
  
   //std::cout <<"myTimeStream.BeamTankTimestamps.size(): "<<myTimeStream.BeamTankTimestamps.size()<<", FinishedTankEventsSampleSize size: "<<FinishedTankEventsSampleSize->size()<<std::endl;
 
@@ -1425,11 +1449,8 @@ void ANNIEEventBuilder::ProcessNewTankPMTData(){
   return;
 }
 
-std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::PairCTCCosmicPairs(std::map<uint64_t,std::map<std::string,uint64_t>> BuildMap, uint64_t max_timestamp, bool force_matching){
+void ANNIEEventBuilder::PairCTCCosmicPairs(std::map<uint64_t,std::map<std::string,uint64_t>> &BuildMap, uint64_t max_timestamp, bool force_matching){
   uint32_t CosmicWord = 36;  //TS_in(35) + 1, where 35 is the MRD_CR_Trigger
-  std::vector<uint64_t> MRDCosmicTimes;
-  std::vector<uint64_t> MRDStampsToDelete;
-  std::map<uint64_t,uint64_t> PairedCTCMRDTimes;
   std::map<uint64_t,std::string> MRDOrphans;
   std::map<uint64_t,double> MRDOrphansTDiff;
   std::map<uint64_t,std::string> TankOrphans;
@@ -1438,77 +1459,59 @@ std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::PairCTCCosm
   std::map<uint64_t,std::vector<std::vector<int>>> TankOrphansChannels;
   std::map<uint64_t,double> TankOrphansTDiff;
 
-
-  for(auto&& aTS : myTimeStream.BeamMRDTimestamps) {
-    if((aTS>max_timestamp)&&(!force_matching)) break; // don't try to match yet
-    std::string MRDTriggerType = myMRDMaps.MRDTriggerTypeMap[aTS];
-    if(MRDTriggerType == "Cosmic"){
-      MRDCosmicTimes.push_back(aTS);
-    }
+  //Only cosmic CTC timestamps are candidates; they keep the order of the CTC stream
+  std::vector<uint64_t> CosmicCTCTimes;
+  size_t NumMatchableCTC = TimeStreamMerger::NumMatchable(myTimeStream.CTCTimestamps,max_timestamp,force_matching);
+  for(size_t i_ctc=0; i_ctc < NumMatchableCTC; i_ctc++){
+    uint64_t aCtcTS = myTimeStream.CTCTimestamps.at(i_ctc);
+    if(TimeToTriggerWordMap->at(aCtcTS).at(0) == CosmicWord) CosmicCTCTimes.push_back(aCtcTS);
   }
- 
-  //Now, loop through CTC timestamps and pair any cosmic triggers
-  //With Cosmic candidates in time tolerance
-
-  //First, pair up myTimeStream.CTCTimestamps and MRD/PMT timestamps
-  std::map<uint64_t,uint64_t> PairedCTCCosmicTimes;
 
-  //Form CTC-MRD pairs
+  //Now, pair the MRD cosmic candidates with cosmic CTC timestamps in time tolerance.
+  //CosmicCTCMatch holds the paired MRD timestamp for each cosmic CTC (0: no pair)
+  std::vector<uint64_t> CosmicCTCMatch(CosmicCTCTimes.size(),0);
   if(verbosity>3) std::cout << "Finding CTC-MRD pairs..." << std::endl;
-  for(auto&& aMrdTS : MRDCosmicTimes){
-    double TSDiff_current=0;
-    for(auto&& aCtcTS : myTimeStream.CTCTimestamps){
-      if((aCtcTS>max_timestamp)&&(!force_matching)) continue;        // do not try to match just yet
-      if(TimeToTriggerWordMap->at(aCtcTS).at(0) != CosmicWord) continue;   // not a cosmic CTC
-      double TSDiff =  static_cast<double>(aMrdTS) - 
-                       static_cast<double>(aCtcTS);
-      if(verbosity>4) std::cout << "CosmicTS - CTCTS in nanoseconds is " << TSDiff << std::endl;
-      if(TSDiff>CTCMRDTimeTolerance){ // MRD timestamp is later than this CTC one. Check next CTC timestamp.
-        TSDiff_current=TSDiff;
-        continue;
-      } else if (TSDiff<(-1.*static_cast<double>(CTCMRDTimeTolerance))){ // We've crossed past where a pair would be found
-        if(verbosity>4) std::cout << "NO CTC STAMP FOUND MATCHING COSMIC STAMP... MRD TO ORPHANAGE" << std::endl;
-        MRDOrphans.emplace(aMrdTS,"mrd_cosmic_no_ctc");
-        double min_tdiff = (fabs(TSDiff)<fabs(TSDiff_current))? TSDiff : TSDiff_current;
-        MRDOrphansTDiff.emplace(aMrdTS,min_tdiff);
-        break;
-      } else { //We've found a valid CTC-MRD pair!
-        if(verbosity>4) std::cout << "FOUND A MATCHING CTC TIME FOR THIS COSMIC MRD TIMESTAMP. NICE, PAIR EM." << std::endl;
-        PairedCTCMRDTimes.emplace(aCtcTS, aMrdTS);
-        break;
-      }
+  size_t NumMatchableMRD = TimeStreamMerger::NumMatchable(myTimeStream.BeamMRDTimestamps,max_timestamp,force_matching);
+  for(size_t i_mrd=0; i_mrd < NumMatchableMRD; i_mrd++){
+    uint64_t aMrdTS = myTimeStream.BeamMRDTimestamps.at(i_mrd);
+    if(myMRDMaps.MRDTriggerTypeMap[aMrdTS] != "Cosmic") continue;
+    size_t match_index;
+    double min_tdiff;
+    TimeStreamMerger::MatchStatus status = TimeStreamMerger::MatchToStream(aMrdTS,CosmicCTCTimes,CosmicCTCTimes.size(),CTCMRDTimeTolerance,match_index,min_tdiff);
+    if(status == TimeStreamMerger::MatchOrphan){
+      if(verbosity>4) std::cout << "NO CTC STAMP FOUND MATCHING COSMIC STAMP... MRD TO ORPHANAGE" << std::endl;
+      MRDOrphans.emplace(aMrdTS,"mrd_cosmic_no_ctc");
+      MRDOrphansTDiff.emplace(aMrdTS,min_tdiff);
+    } else if(status == TimeStreamMerger::MatchFound && CosmicCTCMatch.at(match_index) == 0){
+      if(verbosity>4) std::cout << "FOUND A MATCHING CTC TIME FOR THIS COSMIC MRD TIMESTAMP. NICE, PAIR EM." << std::endl;
+      CosmicCTCMatch.at(match_index) = aMrdTS;
     }
   }
 
   //Neat.  Now, add timestamps to the buildmap.
   std::vector<uint64_t> BuiltCTCs;
-  for(std::pair<uint64_t, uint64_t> aPair : PairedCTCMRDTimes){
-    uint64_t CTCTimestamp = aPair.first;
-    uint64_t CosmicTimestamp = aPair.second;
+  std::vector<uint64_t> BuiltMRDs;
+  for(size_t i_ctc=0; i_ctc < CosmicCTCTimes.size(); i_ctc++){
+    if(CosmicCTCMatch.at(i_ctc) == 0) continue;
+    uint64_t CTCTimestamp = CosmicCTCTimes.at(i_ctc);
+    uint64_t CosmicTimestamp = CosmicCTCMatch.at(i_ctc);
     std::map<std::string,uint64_t> aBuildSet;
     aBuildSet.emplace("CTC",TimeToTriggerWordMap->at(CTCTimestamp).at(0));
     aBuildSet.emplace("MRD",CosmicTimestamp);
-    myTimeStream.BeamMRDTimestamps.erase(std::remove(myTimeStream.BeamMRDTimestamps.begin(),
-         myTimeStream.BeamMRDTimestamps.end(),CosmicTimestamp), 
-         myTimeStream.BeamMRDTimestamps.end());
     if(verbosity>4) std::cout << "BUILDING A CTC/COSMIC /BeaBUILD MAP ENTRY. CTC IS " << CTCTimestamp << std::endl;
     BuildMap.emplace(CTCTimestamp,aBuildSet);
     BuiltCTCs.push_back(CTCTimestamp);
+    BuiltMRDs.push_back(CosmicTimestamp);
   }
-  
 
-  //Delete CTCTimestamps that have a PMT or MRD pair from CTC timestamp tracker
-  for(int j=0;j < (int) BuiltCTCs.size();j++){
-    if(verbosity>4) std::cout << "REMOVING CTC TIME OF " << BuiltCTCs.at(j) << "FROM CTCTIMESTAMPS VECTOR" << std::endl;
-    myTimeStream.CTCTimestamps.erase(std::remove(myTimeStream.CTCTimestamps.begin(),
-        myTimeStream.CTCTimestamps.end(),BuiltCTCs.at(j)), 
-        myTimeStream.CTCTimestamps.end());
-  }
+  //Delete CTC and MRD timestamps that were paired from the timestreams
+  TimeStreamMerger::EraseTimestamps(myTimeStream.BeamMRDTimestamps,BuiltMRDs);
+  TimeStreamMerger::EraseTimestamps(myTimeStream.CTCTimestamps,BuiltCTCs);
 
   //Move MRD timestamps with no pairs to the orphanage.  Just empty Tank and CTC vectors for 
   //Input to function.  TODO; could overload function
   this->MoveToOrphanage(TankOrphans, TankOrphansWaveMap, TankOrphansChannels, TankOrphansTDiff, MRDOrphans, MRDOrphansTDiff, CTCOrphans);
-  return BuildMap;
+  return;
 }
 
 void ANNIEEventBuilder::RemoveCosmics(){
@@ -1524,10 +1527,8 @@ void ANNIEEventBuilder::RemoveCosmics(){
       }
     }
   }
+  TimeStreamMerger::EraseTimestamps(myTimeStream.BeamMRDTimestamps,MRDStampsToDelete);
   for (int j=0; j < (int) MRDStampsToDelete.size(); j++){
-    myTimeStream.BeamMRDTimestamps.erase(std::remove(myTimeStream.BeamMRDTimestamps.begin(),
-        myTimeStream.BeamMRDTimestamps.end(),MRDStampsToDelete.at(j)), 
-        myTimeStream.BeamMRDTimestamps.end());
     myMRDMaps.MRDEvents.erase(MRDStampsToDelete.at(j));
     myMRDMaps.MRDTriggerTypeMap.erase(MRDStampsToDelete.at(j));
     myMRDMaps.MRDBeamLoopbackMap.erase(MRDStampsToDelete.at(j));
@@ -1536,8 +1537,34 @@ void ANNIEEventBuilder::RemoveCosmics(){
   return;
 }
 
+void ANNIEEventBuilder::PairStreamWithCTC(const std::vector<uint64_t> &Stream, uint64_t max_timestamp, bool force_matching,
+                                          double Tolerance, std::vector<int> &CTCMatch, int &LargestCTCIndex,
+                                          std::map<uint64_t,double> &Orphans, std::map<uint64_t,double> &Displaced){
+  size_t NumMatchable = TimeStreamMerger::NumMatchable(Stream,max_timestamp,force_matching);
+  for(size_t i_ts=0; i_ts < NumMatchable; i_ts++){
+    uint64_t aTS = Stream.at(i_ts);
+    size_t match_index;
+    double min_tdiff;
+    TimeStreamMerger::MatchStatus status = TimeStreamMerger::MatchToStream(aTS,myTimeStream.CTCTimestamps,CTCMatch.size(),Tolerance,match_index,min_tdiff);
+    if(status == TimeStreamMerger::MatchOrphan){
+      if(verbosity>9) std::cout << "NO CTC STAMP FOUND MATCHING STAMP " << aTS << ", TDIFF " << min_tdiff << std::endl;
+      Orphans.emplace(aTS,min_tdiff);
+    } else if(status == TimeStreamMerger::MatchFound){
+      if(CTCMatch.at(match_index) < 0){
+        if(verbosity>4) std::cout << "FOUND A MATCHING CTC TIME FOR TIMESTAMP " << aTS << ". NICE, PAIR EM." << std::endl;
+        CTCMatch.at(match_index) = (int) i_ts;
+        if((int) match_index > LargestCTCIndex) LargestCTCIndex = (int) match_index;
+      } else {
+        //An earlier timestamp of this stream already took the CTC timestamp
+        double TSDiff = static_cast<double>(aTS) - static_cast<double>(myTimeStream.CTCTimestamps.at(match_index));
+        Displaced.emplace(aTS,TSDiff);
+      }
+    }
+  }
+}
+
 
-std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::MergeStreams(std::map<uint64_t,std::map<std::string,uint64_t>> BuildMap, uint64_t max_timestamp, bool force_matching){
+void ANNIEEventBuilder::MergeStreams(std::map<uint64_t,std::map<std::string,uint64_t>> &BuildMap, uint64_t max_timestamp, bool force_matching){
   //This method takes timestamps from the BeamMRDTimestamps, BeamTankTimestamps, and
   //CTCTimestamps vectors (acquired as the building continues) and builds maps 
   //stored in the BuildMap and used to build ANNIEEvents.
@@ -1560,9 +1587,9 @@ std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::MergeStream
     std::vector<uint64_t> InProgressTankEventsToDelete;
     //Add remaining Tank timestamps that have almost complete waveforms
     if (save_raw_data){
-    for(std::pair<uint64_t,std::map<std::vector<int>, std::vector<uint16_t>>> apair : *InProgressTankEvents){
+    for(const std::pair<const uint64_t,std::map<CardChannelKey, std::vector<uint16_t>>> &apair : *InProgressTankEvents){
       uint64_t PMTCounterTimeNs = apair.first;
-      std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = apair.second;
+      const std::map<CardChannelKey, std::vector<uint16_t>> &aWaveMap = apair.second;
       if(verbosity>4) std::cout << "TS: " << PMTCounterTimeNs <<", Number of waves for this counter: " << aWaveMap.size() << std::endl;
    
       //Push back any new timestamps, then remove duplicates in the end
@@ -1572,11 +1599,10 @@ std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::MergeStream
       }
       if (aWaveMap.size() >= (NumWavesInCompleteSet-1)){
         FinishedTankEvents->emplace(PMTCounterTimeNs,aWaveMap);
-        std::map<std::vector<int>,int> aWaveMapSampleSize;
-        for (std::pair<std::vector<int>,std::vector<uint16_t>> wavemappair : aWaveMap){
-          std::vector<int> temp_channel = wavemappair.first;
+        std::map<CardChannelKey,int> aWaveMapSampleSize;
+        for (const std::pair<const CardChannelKey,std::vector<uint16_t>> &wavemappair : aWaveMap){
           int temp_size = int(aWaveMap.size());
-          aWaveMapSampleSize.emplace(temp_channel,temp_size);
+          aWaveMapSampleSize.emplace_hint(aWaveMapSampleSize.end(),wavemappair.first,temp_size);
         } 
         FinishedTankEventsSampleSize->emplace(PMTCounterTimeNs,aWaveMapSampleSize);
         myTimeStream.BeamTankTimestamps.push_back(PMTCounterTimeNs);
@@ -1585,7 +1611,7 @@ std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::MergeStream
         InProgressTankEventsToDelete.push_back(PMTCounterTimeNs);
       }
     }
-    RemoveDuplicates(myTimeStream.BeamTankTimestamps);
+    TimeStreamMerger::SortStream(myTimeStream.BeamTankTimestamps);
 
     //Since timestamp pairing has been done for finished Tank Events,
     //Erase the finished Tank Events from the InProgressTankEventsMap
@@ -1608,7 +1634,7 @@ std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::MergeStream
     int NumAuxChannels = AuxCrateSpaceToChannelNumMap.size();
     if(aChkey.size() >= (NumWavesInCompleteSet-1)){
       FinishedHits->emplace(PMTCounterTimeNs,aHit);
-      std::map<std::vector<int>,int> aWaveMapSampleSize;
+      std::map<CardChannelKey,int> aWaveMapSampleSize;
         for (int i_ch=0; i_ch < (int) aChkey.size(); i_ch++){
           unsigned long temp_chkey = aChkey.at(i_ch);
           std::vector<int> temp_channel;
@@ -1618,8 +1644,7 @@ std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::MergeStream
           int temp_size = int(aChkey.size());
           int temp_cardid;
           this->ElectronicsSpacetoCardID(temp_channel.at(0),temp_channel.at(1),temp_cardid);
-          std::vector<int> temp_cardch{temp_cardid,temp_channel.at(2)};
-          aWaveMapSampleSize.emplace(temp_cardch,temp_size);
+          aWaveMapSampleSize.emplace(MakeCardChannelKey(temp_cardid,temp_channel.at(2)),temp_size);
         }
         FinishedTankEventsSampleSize->emplace(PMTCounterTimeNs,aWaveMapSampleSize);
         myTimeStream.BeamTankTimestamps.push_back(PMTCounterTimeNs);
@@ -1627,7 +1652,7 @@ std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::MergeStream
         InProgressTankEventsToDelete.push_back(PMTCounterTimeNs);
       }
     }
-    RemoveDuplicates(myTimeStream.BeamTankTimestamps);
+    TimeStreamMerger::SortStream(myTimeStream.BeamTankTimestamps);
 
     for (unsigned int j=0; j< InProgressTankEventsToDelete.size(); j++){
       InProgressHits->erase(InProgressTankEventsToDelete.at(j));
@@ -1639,103 +1664,35 @@ std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::MergeStream
   // only attempt matching of any kind on timestamps older than the newest timestamp we have
   // from ALL streams - i.e. if the slowest stream has only read up to 4pm, do not try to do
   // matching on any timestamps newer than this
+  //All timestreams are sorted, so every timestamp is paired with the CTC stream by a binary
+  //search.  The pairs are recorded per CTC timestamp as the index of the paired timestamp in
+  //its stream (-1: no pair); the first timestamp of a stream to claim a CTC timestamp keeps it.
+  size_t NumMatchableCTC = TimeStreamMerger::NumMatchable(myTimeStream.CTCTimestamps,max_timestamp,force_matching);
+  std::vector<int> CTCTankMatch(NumMatchableCTC,-1);
+  std::vector<int> CTCMRDMatch(NumMatchableCTC,-1);
+  std::vector<int> CTCLAPPDMatch(NumMatchableCTC,-1);
+  std::map<uint64_t,double> TankDisplaced;
+  std::map<uint64_t,double> MRDDisplaced;
+  std::map<uint64_t,double> LAPPDDisplaced;
+  int LargestCTCIndex=0;
+
   //Form CTC-MRD pairs
-  uint64_t max_ctc=0;
   if(verbosity>3) std::cout << "Finding CTC-MRD pairs..." << std::endl;
-  for(auto&& aMrdTS : myTimeStream.BeamMRDTimestamps){
-    if((aMrdTS>max_timestamp)&&(!force_matching)) continue;   // don't try to match just yet
-    double TSDiff_current=0;
-    for(auto&& aCtcTS : myTimeStream.CTCTimestamps){
-      if((aCtcTS>max_timestamp)&&(!force_matching)) continue; // don't try to match this just yet
-      double TSDiff =  static_cast<double>(aMrdTS) - 
-                       static_cast<double>(aCtcTS);
-      if(verbosity>9) std::cout << "MRDTS - CTCTS in nanoseconds is " << TSDiff << std::endl;
-      if(TSDiff>CTCMRDTimeTolerance){ // MRD timestamp is later than CTC timestamp; try next CTC timestamp
-        TSDiff_current = TSDiff;
-        continue;
-      } else if (TSDiff<(-1.*static_cast<double>(CTCMRDTimeTolerance))){ //We've crossed past where a pair would be found
-        if(verbosity>9) std::cout << "NO CTC STAMP FOUND MATCHING MRD STAMP... MRD TO ORPHANAGE" << std::endl;
-        MRDOrphans.emplace(aMrdTS,"mrd_beam_no_ctc");
-        double min_tdiff = (fabs(TSDiff)<fabs(TSDiff_current))? TSDiff:TSDiff_current;
-        MRDOrphansTDiff.emplace(aMrdTS,min_tdiff);
-        break;
-      } else { //We've found a valid CTC-MRD pair!
-        if(verbosity>4) std::cout << "FOUND A MATCHING CTC TIME FOR THIS MRD TIMESTAMP. NICE, PAIR EM." << std::endl;
-        PairedCTCMRDTimes.emplace(aCtcTS, aMrdTS);
-        max_ctc=aCtcTS;
-        break;
-      }
-    }
-  }
+  this->PairStreamWithCTC(myTimeStream.BeamMRDTimestamps,max_timestamp,force_matching,CTCMRDTimeTolerance,CTCMRDMatch,LargestCTCIndex,MRDOrphansTDiff,MRDDisplaced);
+  for(auto&& aOrphan : MRDOrphansTDiff) MRDOrphans.emplace(aOrphan.first,"mrd_beam_no_ctc");
 
   //Now form CTC-PMT pairs
   if(verbosity>3) std::cout << "Finding CTC-Tank pairs..." << std::endl;
-  for(auto&& aTankTS : myTimeStream.BeamTankTimestamps){
-    if((aTankTS>max_timestamp)&&(!force_matching)) continue; // don't try to match just yet
-    double TSDiff_current=0;
-    for(auto&& aCtcTS : myTimeStream.CTCTimestamps){
-      if((aCtcTS>max_timestamp)&&(!force_matching)) continue; // don't try to match just yet
-      double TSDiff =  static_cast<double>(aTankTS) - 
-                       static_cast<double>(aCtcTS);
-      if(verbosity>9) std::cout << "TankTS - CTCTS in nanoseconds is " << TSDiff << std::endl;
-      if(TSDiff>CTCTankTimeTolerance){ // Need to move forward in indices
-        TSDiff_current = TSDiff;
-        continue;
-      } else if (TSDiff<(-1.*static_cast<double>(CTCTankTimeTolerance))){ //We've crossed past where a pair would be found
-        if(verbosity>9) {
-          std::cout << "NO CTC STAMP FOUND MATCHING TANK STAMP... TANK TO ORPHANAGE" << std::endl;
-          std::cout <<"TSDiff: "<<TSDiff<<std::endl;
-        }
-        TankOrphans.emplace(aTankTS,"tank_no_ctc");
-        TankOrphansWaveMap.emplace(aTankTS,NumWavesInCompleteSet);
-        //std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = FinishedTankEvents->at(aTankTS);
-        std::map<std::vector<int>, int> aWaveMapSampleSize = FinishedTankEventsSampleSize->at(aTankTS);
-        std::vector<std::vector<int>> aWaveMapChannels = GetChannelsFromWaveMapSampleSize(aWaveMapSampleSize);
-        TankOrphansChannels.emplace(aTankTS,aWaveMapChannels);
-	double min_tdiff = (fabs(TSDiff_current) < fabs(TSDiff))? TSDiff_current : TSDiff;
-	TankOrphansTDiff.emplace(aTankTS,min_tdiff);
-        break;
-      } else { //We've found a valid CTC-Tank pair!
-        if(verbosity>4) std::cout << "FOUND A MATCHING CTC TIME FOR THIS TANK TIMESTAMP. NICE, PAIR EM." << std::endl;
-        PairedCTCTankTimes.emplace(aCtcTS, aTankTS);
-        if(aCtcTS>max_ctc) max_ctc=aCtcTS;
-        break;
-      }
-    }
-  }
+  this->PairStreamWithCTC(myTimeStream.BeamTankTimestamps,max_timestamp,force_matching,CTCTankTimeTolerance,CTCTankMatch,LargestCTCIndex,TankOrphansTDiff,TankDisplaced);
+  for(auto&& aOrphan : TankOrphansTDiff) TankOrphans.emplace(aOrphan.first,"tank_no_ctc");
 
   //Now match CTC-LAPPD timestamps
   if (BuildType == "TankAndMRDAndCTCAndLAPPD"){
     if(verbosity>3) std::cout << "Finding CTC-LAPPD pairs..." << std::endl;
-    for(auto&& aLAPPDTS : myTimeStream.LAPPDGlobalTimestamps){
-      if((aLAPPDTS>max_timestamp)&&(!force_matching)) continue;   // don't try to match just yet
-      double TSDiff_current=0;
-      for(auto&& aCtcTS : myTimeStream.CTCTimestamps){
-        if((aCtcTS>max_timestamp)&&(!force_matching)) continue; // don't try to match this just yet
-        double TSDiff =  static_cast<double>(aLAPPDTS) -
-                       static_cast<double>(aCtcTS);
-        if(verbosity>9) std::cout << "LAPPDTS - CTCTS in nanoseconds is " << TSDiff << std::endl;
-        if(TSDiff>CTCLAPPDTimeTolerance){ // MRD timestamp is later than CTC timestamp; try next CTC timestamp
-          TSDiff_current = TSDiff;
-          continue;
-        } else if (TSDiff<(-1.*static_cast<double>(CTCLAPPDTimeTolerance))){ //We've crossed past where a pair would be found    
-          if(verbosity>9) std::cout << "NO CTC STAMP FOUND MATCHING LAPPD STAMP... LAPPD TO ORPHANAGE" << std::endl;
-          LAPPDOrphans.emplace(aLAPPDTS,"lappd_beam_no_ctc");
-          double min_tdiff = (fabs(TSDiff)<fabs(TSDiff_current))? TSDiff:TSDiff_current;
-          LAPPDOrphansTDiff.emplace(aLAPPDTS,min_tdiff);
-          break; 
-        } else { //We've found a valid CTC-LAPPD pair!
-          if(verbosity>4) std::cout << "FOUND A MATCHING CTC TIME FOR THIS LAPPD TIMESTAMP. NICE, PAIR EM." << std::endl;
-          PairedCTCLAPPDTimes.emplace(aCtcTS, aLAPPDTS);
-          max_ctc=aCtcTS;
-          break;
-        }
-      }
-    }
+    this->PairStreamWithCTC(myTimeStream.LAPPDGlobalTimestamps,max_timestamp,force_matching,CTCLAPPDTimeTolerance,CTCLAPPDMatch,LargestCTCIndex,LAPPDOrphansTDiff,LAPPDDisplaced);
+    for(auto&& aOrphan : LAPPDOrphansTDiff) LAPPDOrphans.emplace(aOrphan.first,"lappd_beam_no_ctc");
   }
 
-  int LargestCTCIndex = std::distance(myTimeStream.CTCTimestamps.begin(),std::find(myTimeStream.CTCTimestamps.begin(),myTimeStream.CTCTimestamps.end(),max_ctc));
-  if(max_ctc==0) LargestCTCIndex=0;
   if(verbosity>4) std::cout << "LARGEST CTC INDEX WAS " << LargestCTCIndex << std::endl;
   if(verbosity>4) std::cout << "AND CTCTIMESTAMPS SIZE IS " << myTimeStream.CTCTimestamps.size() << std::endl;
   
@@ -1744,125 +1701,85 @@ std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::MergeStream
   // Any logic needed for pairing CTC/MRD pairs?  I don't think so, since cosmics 
   // handled in a different method..
   std::vector<uint64_t> BuiltCTCs;
+  std::vector<uint64_t> BuiltTankTimes;
+  std::vector<uint64_t> BuiltMRDTimes;
+  std::vector<uint64_t> BuiltLAPPDTimes;
   for(int i=0; i<(LargestCTCIndex-1); i++){
     uint64_t CTCKey = myTimeStream.CTCTimestamps.at(i);
     if(verbosity>4) std::cout << "TRYING TO BUILD A SET WITH CTCTIMESTAMP INDEX " << i << std::endl;
 
-    bool have_tankmatch = false;
-    bool have_mrdmatch = false;    
-    bool have_lappdmatch = false;
-    std::map<uint64_t, uint64_t>::iterator it_tank = PairedCTCTankTimes.find(CTCKey);
-    if(it_tank != PairedCTCTankTimes.end()) have_tankmatch = true;
-    std::map<uint64_t, uint64_t>::iterator it_mrd = PairedCTCMRDTimes.find(CTCKey);
-    if(it_mrd != PairedCTCMRDTimes.end()) have_mrdmatch = true;
-    std::map<uint64_t, uint64_t>::iterator it_lappd = PairedCTCLAPPDTimes.find(CTCKey);
-    if(it_lappd != PairedCTCLAPPDTimes.end()) have_lappdmatch = true;
-    if (have_tankmatch && have_mrdmatch && have_lappdmatch){
-      std::map<std::string,uint64_t> aBuildSet;
-      for (int i_ctckey=0; i_ctckey < (int) TimeToTriggerWordMap->at(CTCKey).size(); i_ctckey++){
-        if (TimeToTriggerWordMap->at(CTCKey).size() > 1){
-          Log("ANNIEEventBuilding tool: Error! Multiple triggerwords for the same timestamp. Timestamp = "+std::to_string(CTCKey),v_error,verbosity);
-        } else if (TimeToTriggerWordMap->at(CTCKey).size() == 0){
-          Log("ANNIEEventBuilding tool: Error! No triggerwords available for timestamp. Timestamp = "+std::to_string(CTCKey),v_error,verbosity);
-        }
-        aBuildSet.emplace("CTC",TimeToTriggerWordMap->at(CTCKey).at(0));
-      }
-      aBuildSet.emplace("TankPMT",it_tank->second);
-      aBuildSet.emplace("MRD",it_mrd->second);
-      aBuildSet.emplace("LAPPD",it_lappd->second);
-      myTimeStream.BeamTankTimestamps.erase(std::remove(myTimeStream.BeamTankTimestamps.begin(),
-           myTimeStream.BeamTankTimestamps.end(),it_tank->second),
-           myTimeStream.BeamTankTimestamps.end());
-      myTimeStream.BeamMRDTimestamps.erase(std::remove(myTimeStream.BeamMRDTimestamps.begin(),
-           myTimeStream.BeamMRDTimestamps.end(),it_mrd->second),
-           myTimeStream.BeamMRDTimestamps.end());
-      myTimeStream.LAPPDGlobalTimestamps.erase(std::remove(myTimeStream.LAPPDGlobalTimestamps.begin(),
-           myTimeStream.LAPPDGlobalTimestamps.end(), it_lappd->second),
-           myTimeStream.LAPPDGlobalTimestamps.end());
-      if(verbosity>4) std::cout << "BUILDING A BUILD MAP (PMT+MRD+LAPPD) ENTRY. CTC IS " << CTCKey << std::endl;
-      BuildMap.emplace(CTCKey,aBuildSet);
-      BuiltCTCs.push_back(CTCKey);
-    }
-    if(have_tankmatch && have_mrdmatch){
-      std::map<std::string,uint64_t> aBuildSet;
-      for (int i_ctckey=0; i_ctckey < (int) TimeToTriggerWordMap->at(CTCKey).size(); i_ctckey++){
-        if (TimeToTriggerWordMap->at(CTCKey).size() > 1){
-          Log("ANNIEEventBuilding tool: Error! Multiple triggerwords for the same timestamp. Timestamp = "+std::to_string(CTCKey),v_error,verbosity);
-        } else if (TimeToTriggerWordMap->at(CTCKey).size() == 0){
-          Log("ANNIEEventBuilding tool: Error! No triggerwords available for timestamp. Timestamp = "+std::to_string(CTCKey),v_error,verbosity);
-        }
-        aBuildSet.emplace("CTC",TimeToTriggerWordMap->at(CTCKey).at(0));
-      }
-      aBuildSet.emplace("TankPMT",it_tank->second);
-      aBuildSet.emplace("MRD",it_mrd->second);
-      myTimeStream.BeamTankTimestamps.erase(std::remove(myTimeStream.BeamTankTimestamps.begin(),
-           myTimeStream.BeamTankTimestamps.end(),it_tank->second), 
-           myTimeStream.BeamTankTimestamps.end());
-      myTimeStream.BeamMRDTimestamps.erase(std::remove(myTimeStream.BeamMRDTimestamps.begin(),
-           myTimeStream.BeamMRDTimestamps.end(),it_mrd->second), 
-           myTimeStream.BeamMRDTimestamps.end());
-      if(verbosity>4) std::cout << "BUILDING A BUILD MAP ENTRY. CTC IS " << CTCKey << std::endl;
-      BuildMap.emplace(CTCKey,aBuildSet);
-      BuiltCTCs.push_back(CTCKey);
-    } else if (have_tankmatch && !have_mrdmatch){
-      std::map<std::string,uint64_t> aBuildSet;
-      for (int i_ctckey=0; i_ctckey < (int) TimeToTriggerWordMap->at(CTCKey).size(); i_ctckey++){
-        if (TimeToTriggerWordMap->at(CTCKey).size() > 1){
-          Log("ANNIEEventBuilding tool: Error! Multiple triggerwords for the same timestamp. Timestamp = "+std::to_string(CTCKey),v_error,verbosity);
-        } else if (TimeToTriggerWordMap->at(CTCKey).size() == 0){
-          Log("ANNIEEventBuilding tool: Error! No triggerwords available for timestamp. Timestamp = "+std::to_string(CTCKey),v_error,verbosity);
-        }
-        aBuildSet.emplace("CTC",TimeToTriggerWordMap->at(CTCKey).at(0));
-      }
-      aBuildSet.emplace("TankPMT",it_tank->second);
-      myTimeStream.BeamTankTimestamps.erase(std::remove(myTimeStream.BeamTankTimestamps.begin(),
-           myTimeStream.BeamTankTimestamps.end(),it_tank->second), 
-           myTimeStream.BeamTankTimestamps.end());
-      if(verbosity>4) std::cout << "BUILDING A PMT ONLY BUILD MAP ENTRY. CTC IS " << CTCKey << std::endl;
-      BuildMap.emplace(CTCKey,aBuildSet);
-      BuiltCTCs.push_back(CTCKey);
-    } else if (!have_tankmatch && have_mrdmatch){
-      std::map<std::string,uint64_t> aBuildSet;
-      for (int i_ctckey=0; i_ctckey < (int) TimeToTriggerWordMap->at(CTCKey).size(); i_ctckey++){
-        if (TimeToTriggerWordMap->at(CTCKey).size() > 1){
-          Log("ANNIEEventBuilding tool: Error! Multiple triggerwords for the same timestamp. Timestamp = "+std::to_string(CTCKey),v_error,verbosity);
-        } else if (TimeToTriggerWordMap->at(CTCKey).size() == 0){
-          Log("ANNIEEventBuilding tool: Error! No triggerwords available for timestamp. Timestamp = "+std::to_string(CTCKey),v_error,verbosity);
-        }
-        aBuildSet.emplace("CTC",TimeToTriggerWordMap->at(CTCKey).at(0));
-      }
-      aBuildSet.emplace("MRD",it_mrd->second);
-      myTimeStream.BeamMRDTimestamps.erase(std::remove(myTimeStream.BeamMRDTimestamps.begin(),
-             myTimeStream.BeamMRDTimestamps.end(),it_mrd->second),                             
-             myTimeStream.BeamMRDTimestamps.end());
-      if (verbosity > 4) std::cout << "BUILDING A MRD ONLY BUILD MAP ENTRY. CTC IS " << CTCKey << std::endl;   
-      BuildMap.emplace(CTCKey,aBuildSet);
-      BuiltCTCs.push_back(CTCKey);
-   } else if (!have_tankmatch && !have_mrdmatch){
+    bool have_tankmatch = (CTCTankMatch.at(i) >= 0);
+    bool have_mrdmatch = (CTCMRDMatch.at(i) >= 0);
+    bool have_lappdmatch = (CTCLAPPDMatch.at(i) >= 0);
+    if (!have_tankmatch && !have_mrdmatch){
       if(verbosity>4) std::cout << "NO MRD OR TANK TIMESTAMP FOR THIS CTC TIME... ORPHAN THE CTC" << std::endl;
-      //uint64_t latest_tank_orphan = TankOrphans.at(TankOrphans.size()-1);
-      //uint64_t latest_MRD_orphan = MRDOrphans.at(MRDOrphans.size()-1);
-      //if(CTCKey < latest_tank_orphan && CTCKey < latest_MRD_orphan){
       CTCOrphans.emplace(CTCKey,"ctc_no_mrd_or_tank");
-      //}
-    } else {
-      //This case should not happen
-      // beam ctc and mrd match, but no tank
-      // at the least do we need to orphan the CTC and MRD events?
-      //CTCOrphans.emplace(CTCKey,"ctc_mrd_no_tank");
-      //MRDOrphans.emplace(it_mrd->second,"ctc_mrd_no_tank");
-      //if(verbosity>4) std::cout << "CTC TIMESTAMP " << CTCKey << " PAIRS WITH EITHER A PMT OR MRD..."  << std::endl;
-      Log("ANNIEEventBuilder tool: Something went wrong with merging: have_tankmatch: "+std::to_string(have_tankmatch)+", "+std::to_string(have_mrdmatch),v_error,verbosity);
+      continue;
     }
-  }
 
-  //Delete myTimeStream.CTCTimestamps that have a PMT or MRD pair from CTC timestamp tracker
-  for(int j=0;j < (int) BuiltCTCs.size();j++){
-    if(verbosity>4) std::cout << "REMOVING CTC TIME OF " << BuiltCTCs.at(j) << "FROM CTCTIMESTAMPS VECTOR" << std::endl;
-    myTimeStream.CTCTimestamps.erase(std::remove(myTimeStream.CTCTimestamps.begin(),
-        myTimeStream.CTCTimestamps.end(),BuiltCTCs.at(j)), 
-        myTimeStream.CTCTimestamps.end());
-  }
+    std::map<std::string,uint64_t> aBuildSet;
+    const std::vector<uint32_t> &CTCWords = TimeToTriggerWordMap->at(CTCKey);
+    if (CTCWords.size() > 1){
+      Log("ANNIEEventBuilding tool: Error! Multiple triggerwords for the same timestamp. Timestamp = "+std::to_string(CTCKey),v_error,verbosity);
+    } else if (CTCWords.size() == 0){
+      Log("ANNIEEventBuilding tool: Error! No triggerwords available for timestamp. Timestamp = "+std::to_string(CTCKey),v_error,verbosity);
+    }
+    if (CTCWords.size() > 0) aBuildSet.emplace("CTC",CTCWords.at(0));
+    if (have_tankmatch){
+      uint64_t TankTS = myTimeStream.BeamTankTimestamps.at(CTCTankMatch.at(i));
+      aBuildSet.emplace("TankPMT",TankTS);
+      BuiltTankTimes.push_back(TankTS);
+    }
+    if (have_mrdmatch){
+      uint64_t MRDTS = myTimeStream.BeamMRDTimestamps.at(CTCMRDMatch.at(i));
+      aBuildSet.emplace("MRD",MRDTS);
+      BuiltMRDTimes.push_back(MRDTS);
+    }
+    //LAPPD data is only added to sets that have both PMT and MRD data
+    if (have_tankmatch && have_mrdmatch && have_lappdmatch){
+      uint64_t LAPPDTS = myTimeStream.LAPPDGlobalTimestamps.at(CTCLAPPDMatch.at(i));
+      aBuildSet.emplace("LAPPD",LAPPDTS);
+      BuiltLAPPDTimes.push_back(LAPPDTS);
+    }
+    if(verbosity>4) std::cout << "BUILDING A BUILD MAP ENTRY (PMT: " << have_tankmatch << ", MRD: " << have_mrdmatch << ", LAPPD: " << (have_tankmatch && have_mrdmatch && have_lappdmatch) << "). CTC IS " << CTCKey << std::endl;
+    BuildMap.emplace(CTCKey,aBuildSet);
+    BuiltCTCs.push_back(CTCKey);
+  }
+
+  //All CTC timestamps before the watermark (the CTC timestamp at index LargestCTCIndex-1) have now
+  //been built or orphaned.  Timestamps that lost their CTC timestamp to an earlier one of the same
+  //stream and lie entirely before the watermark can no longer be paired; orphan them right away.
+  if (LargestCTCIndex > 1){
+    double Watermark = static_cast<double>(myTimeStream.CTCTimestamps.at(LargestCTCIndex-1));
+    for(auto&& aDisplaced : MRDDisplaced){
+      if((static_cast<double>(aDisplaced.first) - Watermark) >= -CTCMRDTimeTolerance) continue;
+      MRDOrphans.emplace(aDisplaced.first,"mrd_beam_no_ctc");
+      MRDOrphansTDiff.emplace(aDisplaced.first,aDisplaced.second);
+    }
+    for(auto&& aDisplaced : TankDisplaced){
+      if((static_cast<double>(aDisplaced.first) - Watermark) >= -CTCTankTimeTolerance) continue;
+      TankOrphans.emplace(aDisplaced.first,"tank_no_ctc");
+      TankOrphansTDiff.emplace(aDisplaced.first,aDisplaced.second);
+    }
+    for(auto&& aDisplaced : LAPPDDisplaced){
+      if((static_cast<double>(aDisplaced.first) - Watermark) >= -CTCLAPPDTimeTolerance) continue;
+      LAPPDOrphans.emplace(aDisplaced.first,"lappd_beam_no_ctc");
+      LAPPDOrphansTDiff.emplace(aDisplaced.first,aDisplaced.second);
+    }
+  }
+  for(auto&& aOrphan : TankOrphans){
+    uint64_t aTankTS = aOrphan.first;
+    TankOrphansWaveMap.emplace(aTankTS,NumWavesInCompleteSet);
+    const std::map<CardChannelKey, int> &aWaveMapSampleSize = FinishedTankEventsSampleSize->at(aTankTS);
+    TankOrphansChannels.emplace(aTankTS,GetChannelsFromWaveMapSampleSize(aWaveMapSampleSize));
+  }
+
+  //Delete the built timestamps from the timestreams
+  TimeStreamMerger::EraseTimestamps(myTimeStream.BeamTankTimestamps,BuiltTankTimes);
+  TimeStreamMerger::EraseTimestamps(myTimeStream.BeamMRDTimestamps,BuiltMRDTimes);
+  TimeStreamMerger::EraseTimestamps(myTimeStream.LAPPDGlobalTimestamps,BuiltLAPPDTimes);
+  if(verbosity>4) std::cout << "REMOVING " << BuiltCTCs.size() << " BUILT CTC TIMES FROM CTCTIMESTAMPS VECTOR" << std::endl;
+  TimeStreamMerger::EraseTimestamps(myTimeStream.CTCTimestamps,BuiltCTCs);
 
   //If the toolchain is stopping, move remaining incomplete PMT timestamps to orphanage
   if (force_matching) {
@@ -1871,10 +1788,10 @@ std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::MergeStream
       std::vector<uint64_t> InProgressTankEventsToDelete;
       if (save_raw_data){
       if (verbosity > 2) std::cout <<"ANNIEEventBuilder Tool: Size of InprogressTankEvents: "<<InProgressTankEvents->size()<<std::endl;
-      for(std::pair<uint64_t,std::map<std::vector<int>, std::vector<uint16_t>>> apair : *InProgressTankEvents){
+      for(const std::pair<const uint64_t,std::map<CardChannelKey, std::vector<uint16_t>>> &apair : *InProgressTankEvents){
         uint64_t PMTCounterTimeNs = apair.first;
         if (verbosity > 4) std::cout <<"ANNIEEventBuilder Tool: PMTCounterTimeNs of InProgressTankEvent: "<<PMTCounterTimeNs<<std::endl;
-        std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = apair.second;
+        const std::map<CardChannelKey, std::vector<uint16_t>> &aWaveMap = apair.second;
         if(aWaveMap.size() < (NumWavesInCompleteSet)){
           InProgressTankEventsToDelete.push_back(PMTCounterTimeNs);
           TankOrphans.emplace(PMTCounterTimeNs,"incomplete_tank_event");
@@ -1924,9 +1841,9 @@ std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::MergeStream
   //std::cout <<"ManageOprhanae"<<std::endl;
   this->ManageOrphanage();
 
-  Log("ANNIEEventBuilder: Returning from Merging the Streams",v_debug,verbosity);
+  LOG_LAZY("ANNIEEventBuilder: Returning from Merging the Streams",v_debug,verbosity);
 
-  return BuildMap;
+  return;
 }
 
 void ANNIEEventBuilder::MoveToOrphanageLAPPD(std::map<uint64_t, std::string> LAPPDOrphans,
@@ -1936,19 +1853,18 @@ void ANNIEEventBuilder::MoveToOrphanageLAPPD(std::map<uint64_t, std::string> LAP
   for (auto&& nextorphan : LAPPDOrphans){
     uint64_t LAPPDOrphanStamp = nextorphan.first;
 
-    //build map of orphan info to save to OrphanStore
-    std::map<std::string,std::string> orphaninfo;
-    orphaninfo.emplace("reason",nextorphan.second);
+    //build the orphan record to save to OrphanStore
+    OrphanRecord orphan;
+    orphan.Reason = nextorphan.second;
 
     // move to orphanage
-    myOrphanage.OrphanLAPPDTimestamps.emplace(LAPPDOrphanStamp,orphaninfo);
-
-    // remove the orphan from the timestream
-    myTimeStream.LAPPDGlobalTimestamps.erase(std::remove(myTimeStream.LAPPDGlobalTimestamps.begin(),
-         myTimeStream.LAPPDGlobalTimestamps.end(),LAPPDOrphanStamp),
-         myTimeStream.LAPPDGlobalTimestamps.end());
+    myOrphanage.OrphanLAPPDTimestamps.emplace(LAPPDOrphanStamp,std::move(orphan));
   }
+  // remove the orphans from the timestream
+  TimeStreamMerger::EraseTimestamps(myTimeStream.LAPPDGlobalTimestamps,LAPPDOrphans);
 
+  //Save orphans early rather than letting them pile up until the next ManageOrphanage
+  if ((int) myOrphanage.size() >= MaxOrphansInMemory) this->ManageOrphanage();
 }
 
 void ANNIEEventBuilder::MoveToOrphanage(std::map<uint64_t, std::string> TankOrphans,
@@ -1963,65 +1879,86 @@ void ANNIEEventBuilder::MoveToOrphanage(std::map<uint64_t, std::string> TankOrph
   for(auto&& nextorphan : CTCOrphans){
     uint64_t CTCOrphanStamp = nextorphan.first;
     
-    // build map of orphan info to save to OrphanStore
-    std::map<std::string,std::string> orphaninfo;
-    orphaninfo.emplace("reason",nextorphan.second);
-    orphaninfo.emplace("ctc_word",to_string(TimeToTriggerWordMap->at(CTCOrphanStamp).at(0)));
+    // build the orphan record to save to OrphanStore
+    OrphanRecord orphan;
+    orphan.Reason = nextorphan.second;
+    orphan.TriggerWord = TimeToTriggerWordMap->at(CTCOrphanStamp).at(0);
     
     // move to orphanage
-    myOrphanage.OrphanCTCTimestamps.emplace(CTCOrphanStamp,orphaninfo);
-    
-    // remove the orphan from the timestream
-    myTimeStream.CTCTimestamps.erase(std::remove(myTimeStream.CTCTimestamps.begin(),
-         myTimeStream.CTCTimestamps.end(),CTCOrphanStamp), 
-         myTimeStream.CTCTimestamps.end());
+    myOrphanage.OrphanCTCTimestamps.emplace(CTCOrphanStamp,std::move(orphan));
   }
+  // remove the orphans from the timestream
+  TimeStreamMerger::EraseTimestamps(myTimeStream.CTCTimestamps,CTCOrphans);
   
   for(auto&& nextorphan : TankOrphans){
     uint64_t TankOrphanStamp = nextorphan.first;
-    int num_waveforms = TankOrphansWaveMap[TankOrphanStamp];    
-    std::vector<std::vector<int>> TankOrphansChannelsEntry = TankOrphansChannels[TankOrphanStamp];
-    double TankOrphansTDiffEntry = TankOrphansTDiff[TankOrphanStamp];
 
-    // build map of orphan info to save to OrphanStore
-    std::map<std::string,std::string> orphaninfo;
-    orphaninfo.emplace("reason",nextorphan.second);
-    orphaninfo.emplace("numwaves",std::to_string(num_waveforms));    
+    // build the orphan record to save to OrphanStore
+    OrphanRecord orphan;
+    orphan.Reason = nextorphan.second;
+    orphan.NumWaves = TankOrphansWaveMap[TankOrphanStamp];
+    orphan.MinTDiff = TankOrphansTDiff[TankOrphanStamp];
+    const std::vector<std::vector<int>> &TankOrphansChannelsEntry = TankOrphansChannels[TankOrphanStamp];
+    orphan.Channels.reserve(TankOrphansChannelsEntry.size());
+    for (const std::vector<int> &channel : TankOrphansChannelsEntry){
+      orphan.Channels.push_back((channel.size()==3)? MakeCrateSlotChannelKey(channel) : 0);
+    }
 
     // move to orphanage
-    myOrphanage.OrphanTankTimestamps.emplace(TankOrphanStamp,orphaninfo);
-    myOrphanage.OrphanTankTimestampsChannels.emplace(TankOrphanStamp,TankOrphansChannelsEntry);
-    myOrphanage.OrphanTankTimestampsTDiff.emplace(TankOrphanStamp,TankOrphansTDiffEntry);    
-
-    // remove the orphan from the timestream
-    myTimeStream.BeamTankTimestamps.erase(std::remove(myTimeStream.BeamTankTimestamps.begin(),
-               myTimeStream.BeamTankTimestamps.end(),TankOrphanStamp), 
-               myTimeStream.BeamTankTimestamps.end());
+    myOrphanage.OrphanTankTimestamps.emplace(TankOrphanStamp,std::move(orphan));
   }
+  TimeStreamMerger::EraseTimestamps(myTimeStream.BeamTankTimestamps,TankOrphans);
   //std::cout <<"Move to orphanage: BeamTankTimestamps.size(): "<<myTimeStream.BeamTankTimestamps.size()<<std::endl;
 
   for(auto&& nextorphan : MRDOrphans){
     uint64_t MrdOrphanStamp = nextorphan.first;
     
-    // build map of orphan info to save to OrphanStore
-    std::map<std::string,std::string> orphaninfo;
-    orphaninfo.emplace("reason",nextorphan.second);
-   
-    double MRDOrphansTDiffEntry = MRDOrphansTDiff[MrdOrphanStamp];
+    // build the orphan record to save to OrphanStore
+    OrphanRecord orphan;
+    orphan.Reason = nextorphan.second;
+    orphan.MinTDiff = MRDOrphansTDiff[MrdOrphanStamp];
  
     // move to orphanage
-    myOrphanage.OrphanMRDTimestamps.emplace(MrdOrphanStamp,orphaninfo);
-    myOrphanage.OrphanMRDTimestampsTDiff.emplace(MrdOrphanStamp,MRDOrphansTDiffEntry);    
-
-    // remove the orphan from the timestream
-    myTimeStream.BeamMRDTimestamps.erase(std::remove(myTimeStream.BeamMRDTimestamps.begin(),
-               myTimeStream.BeamMRDTimestamps.end(),MrdOrphanStamp), 
-               myTimeStream.BeamMRDTimestamps.end());
+    myOrphanage.OrphanMRDTimestamps.emplace(MrdOrphanStamp,std::move(orphan));
   }
+  TimeStreamMerger::EraseTimestamps(myTimeStream.BeamMRDTimestamps,MRDOrphans);
   if(verbosity>3) std::cout << "ORPHAN MOVEMENT COMPLETE" << std::endl;
+
+  //Save orphans early rather than letting them pile up until the next ManageOrphanage
+  if ((int) myOrphanage.size() >= MaxOrphansInMemory) this->ManageOrphanage();
   return;
 }
 
+void ANNIEEventBuilder::SaveOrphanRecord(const std::string &OrphanFile, const std::string &EventType, uint64_t Timestamp, const OrphanRecord &orphan){
+  //The Info map and the channel vectors keep the OrphanStore layout readers expect
+  std::map<std::string,std::string> orphaninfo;
+  orphaninfo.emplace("reason",orphan.Reason);
+  if (EventType == "Tank") orphaninfo.emplace("numwaves",std::to_string(orphan.NumWaves));
+  else if (EventType == "CTC") orphaninfo.emplace("ctc_word",std::to_string(orphan.TriggerWord));
+  std::vector<std::vector<int>> WaveMapChannels;
+  std::vector<unsigned long> WaveMapChankeys;
+  for (CrateSlotChannelKey current_cratespace : orphan.Channels){
+    WaveMapChannels.push_back(CrateSlotChannelFromKey(current_cratespace));
+    //Convert to channelkeys for convenience
+    std::unordered_map<CrateSlotChannelKey,int>::const_iterator it_chankey = TankPMTCrateSpaceToChannelNumMap.find(current_cratespace);
+    unsigned long current_chankey = (it_chankey != TankPMTCrateSpaceToChannelNumMap.end())? it_chankey->second : 0;
+    WaveMapChankeys.push_back(current_chankey);
+  }
+
+  OrphanStore->Set("EventType",EventType);
+  OrphanStore->Set("Timestamp",Timestamp);
+  OrphanStore->Set("Reason",orphan.Reason);
+  OrphanStore->Set("NumWaves",orphan.NumWaves);
+  OrphanStore->Set("TriggerWord",orphan.TriggerWord);
+  OrphanStore->Set("Info",orphaninfo); // redundant for now, but maybe we'll add more info later
+  //CTC and LAPPD orphans have always been saved with this spelling of the key
+  OrphanStore->Set((EventType == "Tank" || EventType == "MRD")? "WaveformChannels" : "WaveFormChannels",WaveMapChannels);
+  OrphanStore->Set("WaveformChankeys",WaveMapChankeys);
+  OrphanStore->Set("MinTDiff",(EventType == "Tank" || EventType == "MRD")? orphan.MinTDiff : 0.);
+  OrphanStore->Save(OrphanFile);
+  OrphanStore->Delete();
+}
+
 void ANNIEEventBuilder::ManageOrphanage(){
   
   // TODO
@@ -2038,29 +1975,10 @@ void ANNIEEventBuilder::ManageOrphanage(){
   
   for(auto&& nextorphan : myOrphanage.OrphanTankTimestamps){
     // copy the orphan info into OrphanStore
-    OrphanStore->Set("EventType",std::string("Tank"));
-    OrphanStore->Set("Timestamp",nextorphan.first);
-    OrphanStore->Set("Reason",nextorphan.second.at("reason"));
-    OrphanStore->Set("NumWaves",std::stoi(nextorphan.second.at("numwaves")));
-    OrphanStore->Set("TriggerWord",-1);
-    OrphanStore->Set("Info",nextorphan.second); // redundant for now, but maybe we'll add more info later
-    std::vector<std::vector<int>> CurrentWaveMapChannels = myOrphanage.OrphanTankTimestampsChannels[nextorphan.first];
-    OrphanStore->Set("WaveformChannels",CurrentWaveMapChannels);
-    //Convert to channelkeys for convenience
-    std::vector<unsigned long> CurrentWaveMapChankeys;
-    for (int i_channel = 0; i_channel < (int) CurrentWaveMapChannels.size(); i_channel++){
-      std::vector<int> current_cratespace = CurrentWaveMapChannels.at(i_channel);
-      unsigned long current_chankey = TankPMTCrateSpaceToChannelNumMap[current_cratespace];
-      CurrentWaveMapChankeys.push_back(current_chankey);
-    }
-    OrphanStore->Set("WaveformChankeys",CurrentWaveMapChankeys);
-    double orphan_min_tdiff = myOrphanage.OrphanTankTimestampsTDiff[nextorphan.first];
-    OrphanStore->Set("MinTDiff",orphan_min_tdiff);
-    OrphanStore->Save(OrphanFile);
-    OrphanStore->Delete();
+    this->SaveOrphanRecord(OrphanFile,"Tank",nextorphan.first,nextorphan.second);
     
     // cleanup from events to process
-    if (std::find(myTimeStream.BeamTankTimestamps.begin(),myTimeStream.BeamTankTimestamps.end(),nextorphan.first)==myTimeStream.BeamTankTimestamps.end()) {
+    if (!TimeStreamMerger::HasTimestamp(myTimeStream.BeamTankTimestamps,nextorphan.first)) {
     if (FinishedTankEventsSampleSize->count(nextorphan.first)>0) FinishedTankEventsSampleSize->erase(nextorphan.first);
     if (!(FinishedTankEvents->count(nextorphan.first)>0)) std::cout <<"no nextorphan.first in FinishedTankEvents"<<std::endl;
     if (save_raw_data && FinishedTankEvents->count(nextorphan.first)>0) {
@@ -2080,20 +1998,7 @@ void ANNIEEventBuilder::ManageOrphanage(){
   //std::cout<<"managing mrd orphans"<<std::endl;
   for(auto&& nextorphan : myOrphanage.OrphanMRDTimestamps){
     // copy the orphan info into OrphanStore
-    OrphanStore->Set("EventType",std::string("MRD"));
-    OrphanStore->Set("Timestamp",nextorphan.first);
-    OrphanStore->Set("Reason",nextorphan.second.at("reason"));
-    OrphanStore->Set("NumWaves",0);
-    OrphanStore->Set("TriggerWord",-1);
-    OrphanStore->Set("Info",nextorphan.second); // redundant for now, but maybe we'll add more info later
-    std::vector<std::vector<int>> empty_vector;
-    OrphanStore->Set("WaveformChannels",empty_vector);
-    std::vector<unsigned long> empty_unsigned;
-    OrphanStore->Set("WaveformChankeys",empty_unsigned);
-    double min_tdiff = myOrphanage.OrphanMRDTimestampsTDiff[nextorphan.first];
-    OrphanStore->Set("MinTDiff",min_tdiff);
-    OrphanStore->Save(OrphanFile);
-    OrphanStore->Delete();
+    this->SaveOrphanRecord(OrphanFile,"MRD",nextorphan.first,nextorphan.second);
     
     // cleanup from events to process
     myMRDMaps.MRDEvents.erase(nextorphan.first);
@@ -2104,19 +2009,7 @@ void ANNIEEventBuilder::ManageOrphanage(){
  // std::cout<<"Managing CTC orphans"<<std::endl;
   for(auto&& nextorphan : myOrphanage.OrphanCTCTimestamps){
     // copy the orphan info into OrphanStore
-    OrphanStore->Set("EventType",std::string("CTC"));
-    OrphanStore->Set("Timestamp",nextorphan.first);
-    OrphanStore->Set("Reason",nextorphan.second.at("reason"));
-    OrphanStore->Set("NumWaves",0);
-    OrphanStore->Set("TriggerWord",std::stoi(nextorphan.second.at("ctc_word")));
-    OrphanStore->Set("Info",nextorphan.second); // CTC word
-    std::vector<std::vector<int>> empty_vector;
-    OrphanStore->Set("WaveFormChannels",empty_vector);
-    std::vector<unsigned long> empty_unsigned;
-    OrphanStore->Set("WaveformChankeys",empty_unsigned);
-    OrphanStore->Set("MinTDiff",0.);
-    OrphanStore->Save(OrphanFile);
-    OrphanStore->Delete();
+    this->SaveOrphanRecord(OrphanFile,"CTC",nextorphan.first,nextorphan.second);
     
     // cleanup from events to process
     TimeToTriggerWordMap->erase(nextorphan.first);
@@ -2130,32 +2023,16 @@ void ANNIEEventBuilder::ManageOrphanage(){
   //Managing LAPPD orphans
   for(auto&& nextorphan : myOrphanage.OrphanLAPPDTimestamps){
     // copy the orphan info into OrphanStore
-    OrphanStore->Set("EventType",std::string("LAPPD"));
-    OrphanStore->Set("Timestamp",nextorphan.first);
-    OrphanStore->Set("Reason",nextorphan.second.at("reason"));
-    OrphanStore->Set("NumWaves",0);
-    OrphanStore->Set("TriggerWord",-1);
-    OrphanStore->Set("Info",nextorphan.second); // CTC word
-    std::vector<std::vector<int>> empty_vector;
-    OrphanStore->Set("WaveFormChannels",empty_vector);
-    std::vector<unsigned long> empty_unsigned;
-    OrphanStore->Set("WaveformChankeys",empty_unsigned);
-    OrphanStore->Set("MinTDiff",0.);
-    OrphanStore->Save(OrphanFile);
-    OrphanStore->Delete();
+    this->SaveOrphanRecord(OrphanFile,"LAPPD",nextorphan.first,nextorphan.second);
 
     // cleanup from events to process
     FinishedLAPPDPsecData->erase(nextorphan.first);
   }
 
   myOrphanage.OrphanTankTimestamps.clear();
-  myOrphanage.OrphanTankTimestampsChannels.clear();
-  myOrphanage.OrphanTankTimestampsTDiff.clear();
   myOrphanage.OrphanMRDTimestamps.clear();
-  myOrphanage.OrphanMRDTimestampsTDiff.clear();
   myOrphanage.OrphanCTCTimestamps.clear();
   myOrphanage.OrphanLAPPDTimestamps.clear();
-  myOrphanage.OrphanLAPPDTimestampsTDiff.clear();
 //  std::cout<<"timestamps cleared, returning"<<std::endl;
   return;
 }
@@ -2204,7 +2081,7 @@ std::map<uint64_t,uint64_t> ANNIEEventBuilder::PairTankPMTAndMRDTriggers(){
         if(verbosity>3) std::cout << "MOVING TANK TIMESTAMP TO ORPHANAGE" << std::endl;
         TankOrphans.emplace(myTimeStream.BeamTankTimestamps.at(i),"tank_no_mrd");
         TankOrphansWaveMap.emplace(myTimeStream.BeamTankTimestamps.at(i),NumWavesInCompleteSet);
-        std::map<std::vector<int>, int> aWaveMapSampleSize = FinishedTankEventsSampleSize->at(myTimeStream.BeamTankTimestamps.at(i));
+        const std::map<CardChannelKey, int> &aWaveMapSampleSize = FinishedTankEventsSampleSize->at(myTimeStream.BeamTankTimestamps.at(i));
         std::vector<std::vector<int>> aWaveMapChannels = GetChannelsFromWaveMapSampleSize(aWaveMapSampleSize);
         TankOrphansChannels.emplace(myTimeStream.BeamTankTimestamps.at(i),aWaveMapChannels);
         TankOrphansTDiff.emplace(myTimeStream.BeamTankTimestamps.at(i),TSDiff);
@@ -2280,7 +2157,7 @@ void ANNIEEventBuilder::BuildANNIEEventMRD(std::vector<std::pair<unsigned long,i
   mrd_loopback_tdc.emplace("BeamLoopbackTDC",beam_tdc);
   mrd_loopback_tdc.emplace("CosmicLoopbackTDC",cosmic_tdc);
 
-  Log("ANNIEEventBuilder: TDCData size: "+std::to_string(TDCData->size()),v_debug,verbosity);
+  LOG_LAZY("ANNIEEventBuilder: TDCData size: "+std::to_string(TDCData->size()),v_debug,verbosity);
 
   ANNIEEvent->Set("TDCData",TDCData,true);
   TimeClass timeclass_timestamp(MRDTimeStamp);
@@ -2333,33 +2210,36 @@ void ANNIEEventBuilder::BuildANNIEEventCTC(uint64_t CTCTime, uint32_t CTCWord, i
 }
 
 void ANNIEEventBuilder::BuildANNIEEventTankRaw(uint64_t ClockTime, 
-        std::map<std::vector<int>, std::vector<uint16_t>> WaveMap)
+        const std::map<CardChannelKey, std::vector<uint16_t>> &WaveMap)
 {
   if(verbosity>v_message)std::cout << "Building an ANNIE Event Tank (RAW)" << std::endl;
 
   ///////////////LOAD RAW PMT DATA INTO ANNIEEVENT///////////////
   std::map<unsigned long, std::vector<Waveform<uint16_t>> > RawADCData;
   std::map<unsigned long, std::vector<Waveform<uint16_t>> > RawADCAuxData;
-  for(std::pair<std::vector<int>, std::vector<uint16_t>> apair : WaveMap){
-    int CardID = apair.first.at(0);
-    int ChannelID = apair.first.at(1);
+  WaveformBlock<uint16_t> RawADCDataBlock;
+  WaveformBlock<uint16_t> RawADCAuxDataBlock;
+  for(const std::pair<const CardChannelKey, std::vector<uint16_t>> &apair : WaveMap){
+    int CardID = CardIDFromKey(apair.first);
+    int ChannelID = ChannelIDFromKey(apair.first);
     int CrateNum=-1;
     int SlotNum=-1;
     this->CardIDToElectronicsSpace(CardID, CrateNum, SlotNum);
-    std::vector<uint16_t> TheWaveform = apair.second;
-    Waveform<uint16_t> TheWave(ClockTime, TheWaveform);
-    //Placing waveform in a vector in case we want a hefty-mode minibuffer storage eventually
-    std::vector<Waveform<uint16_t>> WaveVec{TheWave};
     
-    std::vector<int> CrateSpace{CrateNum,SlotNum,ChannelID};
+    CrateSlotChannelKey CrateSpace = MakeCrateSlotChannelKey(CrateNum,SlotNum,ChannelID);
+    std::map<unsigned long, std::vector<Waveform<uint16_t>> >* ADCData = nullptr;
+    WaveformBlock<uint16_t>* ADCDataBlock = nullptr;
     unsigned long ChannelKey;
-    if(TankPMTCrateSpaceToChannelNumMap.count(CrateSpace)>0){
-      ChannelKey = TankPMTCrateSpaceToChannelNumMap.at(CrateSpace);
-      RawADCData.emplace(ChannelKey,WaveVec);
-    }
-    else if (AuxCrateSpaceToChannelNumMap.count(CrateSpace)>0){
-      ChannelKey = AuxCrateSpaceToChannelNumMap.at(CrateSpace);
-      RawADCAuxData.emplace(ChannelKey,WaveVec);
+    std::unordered_map<CrateSlotChannelKey,int>::const_iterator it_chankey;
+    if((it_chankey = TankPMTCrateSpaceToChannelNumMap.find(CrateSpace)) != TankPMTCrateSpaceToChannelNumMap.end()){
+      ChannelKey = it_chankey->second;
+      ADCData = &RawADCData;
+      ADCDataBlock = &RawADCDataBlock;
+    }
+    else if ((it_chankey = AuxCrateSpaceToChannelNumMap.find(CrateSpace)) != AuxCrateSpaceToChannelNumMap.end()){
+      ChannelKey = it_chankey->second;
+      ADCData = &RawADCAuxData;
+      ADCDataBlock = &RawADCAuxDataBlock;
     } else{
       Log("ANNIEEventBuilder:: Cannot find channel key for crate space entry: ",v_error, verbosity);
       Log("ANNIEEventBuilder::CrateNum "+to_string(CrateNum),v_error, verbosity);
@@ -2368,13 +2248,25 @@ void ANNIEEventBuilder::BuildANNIEEventTankRaw(uint64_t ClockTime,
       Log("ANNIEEventBuilder:: Passing over the wave; PMT DATA LOST",v_error, verbosity);
       continue;
     }
+    if(save_waveform_blocks){
+      ADCDataBlock->Add(ChannelKey, ClockTime, apair.second.data(), apair.second.size());
+      continue;
+    }
+    //Placing waveform in a vector in case we want a hefty-mode minibuffer storage eventually
+    std::vector<Waveform<uint16_t>> WaveVec{Waveform<uint16_t>(ClockTime, apair.second)};
+    ADCData->emplace(ChannelKey,std::move(WaveVec));
   }
-  if(RawADCData.size() == 0){
+  if(RawADCData.size() == 0 && RawADCDataBlock.NumWaveforms() == 0){
     std::cout << "No Raw ADC Data in entry.  Not putting to ANNIEEvent." << std::endl;
   }
   //std::cout << "Setting ANNIE Event information" << std::endl;
-  ANNIEEvent->Set("RawADCData",RawADCData);
-  ANNIEEvent->Set("RawADCAuxData",RawADCAuxData);
+  if(save_waveform_blocks){
+    ANNIEEvent->Set("RawADCDataBlock",RawADCDataBlock);
+    ANNIEEvent->Set("RawADCAuxDataBlock",RawADCAuxDataBlock);
+  } else {
+    ANNIEEvent->Set("RawADCData",RawADCData);
+    ANNIEEvent->Set("RawADCAuxData",RawADCAuxData);
+  }
   ANNIEEvent->Set("EventTimeTank",ClockTime);
   if(verbosity>v_debug) std::cout << "ANNIEEventBuilder: ANNIE Event "+
       to_string(ANNIEEventNum)+" built." << std::endl;
@@ -2392,22 +2284,22 @@ void ANNIEEventBuilder::BuildANNIEEventTankHits(uint64_t ClockTime,
 
   //std::cout << "Setting ANNIE Event information" << std::endl;
   ANNIEEvent->Set("Hits",PMTHits, true);
-  ANNIEEvent->Set("RecoADCData",PMTRecoADCHits);
+  ANNIEEvent->Set("RecoADCData",std::move(PMTRecoADCHits));
   ANNIEEvent->Set("AuxHits",PMTHitsAux,true);
-  ANNIEEvent->Set("RecoAuxADCData",PMTRecoADCHitsAux);
-  ANNIEEvent->Set("RawAcqSize",PMTRawAcqSize);
+  ANNIEEvent->Set("RecoAuxADCData",std::move(PMTRecoADCHitsAux));
+  ANNIEEvent->Set("RawAcqSize",std::move(PMTRawAcqSize));
   ANNIEEvent->Set("EventTimeTank",ClockTime);
   if(verbosity>v_debug) std::cout << "ANNIEEventBuilder: ANNIE Event "+
       to_string(ANNIEEventNum)+" built." << std::endl;
   return;
 }
 
-std::vector<std::vector<int>> ANNIEEventBuilder::GetChannelsFromWaveMapSampleSize(std::map<std::vector<int>,int> WaveMap){
+std::vector<std::vector<int>> ANNIEEventBuilder::GetChannelsFromWaveMapSampleSize(const std::map<CardChannelKey,int> &WaveMap){
 
     std::vector<std::vector<int>> CrateSpaceVector;
-      for(std::pair<std::vector<int>, int> apair : WaveMap){
-      int CardID = apair.first.at(0);
-      int ChannelID = apair.first.at(1);
+      for(const std::pair<const CardChannelKey, int> &apair : WaveMap){
+      int CardID = CardIDFromKey(apair.first);
+      int ChannelID = ChannelIDFromKey(apair.first);
       int CrateNum=-1;
       int SlotNum=-1;
       this->CardIDToElectronicsSpace(CardID, CrateNum, SlotNum);
@@ -2418,12 +2310,12 @@ std::vector<std::vector<int>> ANNIEEventBuilder::GetChannelsFromWaveMapSampleSiz
     return CrateSpaceVector;
 }
 
-std::vector<std::vector<int>> ANNIEEventBuilder::GetChannelsFromWaveMap(std::map<std::vector<int>,std::vector<uint16_t>> WaveMap){
+std::vector<std::vector<int>> ANNIEEventBuilder::GetChannelsFromWaveMap(const std::map<CardChannelKey,std::vector<uint16_t>> &WaveMap){
 
     std::vector<std::vector<int>> CrateSpaceVector;
-      for(std::pair<std::vector<int>, std::vector<uint16_t>> apair : WaveMap){
-      int CardID = apair.first.at(0);
-      int ChannelID = apair.first.at(1);
+      for(const std::pair<const CardChannelKey, std::vector<uint16_t>> &apair : WaveMap){
+      int CardID = CardIDFromKey(apair.first);
+      int ChannelID = ChannelIDFromKey(apair.first);
       int CrateNum=-1;
       int SlotNum=-1;
       this->CardIDToElectronicsSpace(CardID, CrateNum, SlotNum);
@@ -2453,11 +2345,11 @@ void ANNIEEventBuilder::SaveEntryToFile(int RunNum, int SubRunNum, int PartNum)
   /*if(verbosity>4)*/ std::cout << "ANNIEEvent: Saving ANNIEEvent entry"+to_string(ANNIEEventNum) << std::endl;
   std::string Filename = SavePath + ProcessedFilesBasename + "_"+BuildType+"_R" + to_string(RunNum) + 
       "S" + to_string(SubRunNum) + "p" + to_string(PartNum);
-  ANNIEEvent->Save(Filename);
-  //std::cout <<"ANNIEEvent saved, now delete"<<std::endl;
-  ANNIEEvent->Delete();		//Delete() will delete the last entry in the store from memory and enable us to set a new pointer (won't erase the entry from saved file)
-  //std::cout <<"ANNIEEvent deleted"<<std::endl;
+  //The writer owns the entry from here on; start a new one for the next event
+  EventWriter->Write(ANNIEEvent,Filename);
+  ANNIEEvent = new ANNIEEventEntry;
   ANNIEEventNum+=1;
+  m_data->CStore.Set("NumANNIEEventsBuilt",ANNIEEventNum);
   return;
 }
 
@@ -2484,9 +2376,7 @@ void ANNIEEventBuilder::OpenNewANNIEEvent(int RunNum, int SubRunNum, int PartNum
   if(verbosity>v_warning) std::cout << "ANNIEEventBuilder: New run or subrun encountered. Opening new BoostStore" << std::endl;
   if(verbosity>v_debug) std::cout << "ANNIEEventBuilder: Current run,subrun:" << CurrentRunNum << "," << CurrentSubRunNum << std::endl;
   if(verbosity>v_debug) std::cout << "ANNIEEventBuilder: Encountered run,subrun,part:" << RunNum << "," << SubRunNum << ","<<PartNum<<std::endl;
-  ANNIEEvent->Close();
-  ANNIEEvent->Delete();
-  delete ANNIEEvent; ANNIEEvent = new BoostStore(false,2);
+  EventWriter->CloseFile();
   OrphanStore->Close();
   OrphanStore->Delete();
   delete OrphanStore; OrphanStore = new BoostStore(false,2);
@@ -2532,15 +2422,16 @@ bool ANNIEEventBuilder::FetchWaveformsHits(){
   for (std::pair<uint64_t, std::map<unsigned long,std::vector<Hit>>*> apair : *FinishedHits){
     uint64_t aTimestamp = apair.first;
     if (FinishedRecoADCHits->count(apair.first)==0){
-      FinishedRecoADCHits->emplace(apair.first,InProgressRecoADCHits->at(aTimestamp));
-      FinishedRecoADCHitsAux->emplace(apair.first,InProgressRecoADCHitsAux->at(aTimestamp));
+      //The InProgress entries are erased below, so their pulses are moved rather than copied
+      FinishedRecoADCHits->emplace(apair.first,std::move(InProgressRecoADCHits->at(aTimestamp)));
+      FinishedRecoADCHitsAux->emplace(apair.first,std::move(InProgressRecoADCHitsAux->at(aTimestamp)));
       FinishedHitsAux->emplace(apair.first,InProgressHitsAux->at(aTimestamp));
       myTimeStream.BeamTankTimestamps.push_back(aTimestamp);
       TimeStampsToDelete.push_back(aTimestamp);
     }
   }
 
-  RemoveDuplicates(myTimeStream.BeamTankTimestamps);
+  TimeStreamMerger::SortStream(myTimeStream.BeamTankTimestamps);
 
   std::cout <<"Erase processed timestamps"<<std::endl;
   for (int i_del=0; i_del < (int) TimeStampsToDelete.size(); i_del++){
@@ -2756,6 +2647,7 @@ std::cout <<"***NEW BEST MATCH: min_dev: "<<min_dev<<", min_mean: "<<min_mean<<"
       myTimeStream.LAPPDGlobalTimestamps.push_back(timestamp_lappd+lappd_time_offset);
       LAPPD_timestamps_to_delete.push_back(timestamp_lappd);
     }
+    TimeStreamMerger::SortStream(myTimeStream.LAPPDGlobalTimestamps);
     //Erase corresponding entry from in-progress map
     for (int i_delete=0; i_delete < (int) LAPPD_timestamps_to_delete.size(); i_delete++){
       LAPPDPsecMap.erase(LAPPD_timestamps_to_delete.at(i_delete));
@@ -8,14 +8,19 @@
 #include <numeric>
 
 #include "Tool.h"
+#include "LazyLog.h"
 #include "TimeClass.h"
 #include "TriggerClass.h"
 #include "Waveform.h"
 #include "ANNIEalgorithms.h"
 #include "ADCPulse.h"
 #include "CalibratedADCWaveform.h"
+#include "WaveformBlock.h"
 #include "BeamStatus.h"
 #include "PsecData.h"
+#include "CardChannelKey.h"
+#include "TimeStreamMerger.h"
+#include "ANNIEEventWriter.h"
 
 /**
 * \class ANNIEEventBuilder
@@ -35,16 +40,22 @@ struct MRDEventMaps{
   ~MRDEventMaps(){}
 };
 
-//########## VECTORS AND MAPS USED TO HOLD TIMESTAMPS OF ORPHANED DATA  ########
+//########## COMPACT RECORD OF ONE ORPHANED TIMESTAMP, AS WRITTEN TO THE ORPHANSTORE  ########
+struct OrphanRecord{
+  std::string Reason;          //Why the timestamp was orphaned, e.g. "tank_no_ctc"
+  int NumWaves = 0;            //Tank: number of waveforms found for the timestamp
+  int TriggerWord = -1;        //CTC: trigger word of the timestamp
+  double MinTDiff = 0.;        //Time difference to the closest CTC timestamp it could have been paired with
+  std::vector<CrateSlotChannelKey> Channels;  //Tank: crate space of the waveforms found for the timestamp
+};
+
+//########## MAPS USED TO HOLD TIMESTAMPS OF ORPHANED DATA UNTIL THEY ARE SAVED TO THE ORPHANSTORE  ########
 struct Orphanage{
-  std::map<uint64_t, std::map<std::string,std::string>> OrphanTankTimestamps;  //Contains timestamps for all PMT events that were out of step with the rest of the stream
-  std::map<uint64_t, std::vector<std::vector<int>>> OrphanTankTimestampsChannels;  //Contains timestamps & channels in WaveMap for all PMT events that were out of sync with the rest of the stream
-  std::map<uint64_t, double> OrphanTankTimestampsTDiff;  //Contains timestamps & timestamp differences to next triggerword in WaveMap for all PMT events that were out of sync with the rest of the stream
-  std::map<uint64_t, std::map<std::string,std::string>> OrphanCTCTimestamps;  //CTC timestamps with no PMT/MRD pair.
-  std::map<uint64_t, std::map<std::string,std::string>> OrphanMRDTimestamps;  //Contains timestamps for all MRD events that were out of step with the rest of the stream
-  std::map<uint64_t, double> OrphanMRDTimestampsTDiff;  //Contains timestamps & timestamp differences to next triggerword for MRD events that were not within fault tolerance of the CTC timestamp
-  std::map<uint64_t, std::map<std::string,std::string>> OrphanLAPPDTimestamps;  //Contains timestamps for all LAPPD events that were out of step with the rest of the stream
-  std::map<uint64_t, double> OrphanLAPPDTimestampsTDiff;  //Contains timestamps & timestamp differences to next triggerword in WaveMap for all LAPPD events that were out of sync with the rest of the stream
+  std::map<uint64_t, OrphanRecord> OrphanTankTimestamps;  //Contains timestamps for all PMT events that were out of step with the rest of the stream
+  std::map<uint64_t, OrphanRecord> OrphanCTCTimestamps;  //CTC timestamps with no PMT/MRD pair.
+  std::map<uint64_t, OrphanRecord> OrphanMRDTimestamps;  //Contains timestamps for all MRD events that were out of step with the rest of the stream
+  std::map<uint64_t, OrphanRecord> OrphanLAPPDTimestamps;  //Contains timestamps for all LAPPD events that were out of step with the rest of the stream
+  size_t size() const { return OrphanTankTimestamps.size() + OrphanCTCTimestamps.size() + OrphanMRDTimestamps.size() + OrphanLAPPDTimestamps.size(); }
   ~Orphanage(){}
 };
 
@@ -77,13 +88,13 @@ class ANNIEEventBuilder: public Tool {
   void CardIDToElectronicsSpace(int CardID, int &CrateNum, int &SlotNum);
   void ElectronicsSpacetoCardID(int CrateNum, int SlotNum, int &CardID);
   void RemoveCosmics();             // Removes events from MRD stream labeled as a cosmic trigger only (TankAndMRD only)
-  std::vector<std::vector<int>> GetChannelsFromWaveMapSampleSize(std::map<std::vector<int>,int> WaveMap);  //Returns the channels for WaveMap entries (used for orphaned events)
-  std::vector<std::vector<int>> GetChannelsFromWaveMap(std::map<std::vector<int>,std::vector<uint16_t>> WaveMap);
+  std::vector<std::vector<int>> GetChannelsFromWaveMapSampleSize(const std::map<CardChannelKey,int> &WaveMap);  //Returns the channels for WaveMap entries (used for orphaned events)
+  std::vector<std::vector<int>> GetChannelsFromWaveMap(const std::map<CardChannelKey,std::vector<uint16_t>> &WaveMap);
   std::vector<std::vector<int>> GetChannelsFromHitMap(std::vector<unsigned long> HitMap);
 
   //Methods to add info from different data streams to ANNIEEvent booststore
   void BuildANNIEEventRunInfo(int RunNum, int SubRunNum, int PartNum, int RunType, uint64_t RunStartTime);  //Loads run level information, as well as the entry number
-  void BuildANNIEEventTankRaw(uint64_t CounterTime, std::map<std::vector<int>, std::vector<uint16_t>> WaveMap);
+  void BuildANNIEEventTankRaw(uint64_t CounterTime, const std::map<CardChannelKey, std::vector<uint16_t>> &WaveMap);
   void BuildANNIEEventTankHits(uint64_t CounterTime, std::map<unsigned long,std::vector<Hit>>* PMTHits, std::map<unsigned long,std::vector<std::vector<ADCPulse>>> PMTRecoADCHits,
     std::map<unsigned long,std::vector<Hit>>* PMTHitsAux, std::map<unsigned long,std::vector<std::vector<ADCPulse>>> PMTRecoADCHitsAux, std::map<unsigned long,std::vector<int>> PMTRawAcqSize);
   void BuildANNIEEventCTC(uint64_t CTCTime, uint32_t TriggerWord, int TriggerWordExtended);
@@ -108,9 +119,13 @@ class ANNIEEventBuilder: public Tool {
 
   //Methods used to merge CTC/PMT/MRD streams
   std::map<uint64_t,uint64_t> PairTankPMTAndMRDTriggers();  // Return pairs of Tank and PMT timestamps
-  std::map<uint64_t,std::map<std::string,uint64_t>> PairCTCCosmicPairs(std::map<uint64_t,std::map<std::string,uint64_t>> BuildMap, uint64_t max_timestamp, bool force_matching=false); //Pair Cosmics with Cosmic muon trigger words
-  std::map<uint64_t,std::map<std::string,uint64_t>> MergeStreams(std::map<uint64_t,std::map<std::string,uint64_t>> BuildMap, uint64_t max_timestamp, bool force_matching=false);       // TankAndMRDAndCTC pairing mode;
+  void PairCTCCosmicPairs(std::map<uint64_t,std::map<std::string,uint64_t>> &BuildMap, uint64_t max_timestamp, bool force_matching=false); //Pair Cosmics with Cosmic muon trigger words
+  void MergeStreams(std::map<uint64_t,std::map<std::string,uint64_t>> &BuildMap, uint64_t max_timestamp, bool force_matching=false);       // TankAndMRDAndCTC pairing mode;
+  void PairStreamWithCTC(const std::vector<uint64_t> &Stream, uint64_t max_timestamp, bool force_matching,
+                         double Tolerance, std::vector<int> &CTCMatch, int &LargestCTCIndex,
+                         std::map<uint64_t,double> &Orphans, std::map<uint64_t,double> &Displaced); //Pair a sorted timestream with the CTC stream (see MergeStreams)
   void ManageOrphanage();
+  void SaveOrphanRecord(const std::string &OrphanFile, const std::string &EventType, uint64_t Timestamp, const OrphanRecord &orphan);
   void MoveToOrphanage(std::map<uint64_t,std::string> TankOrphans,
                        std::map<uint64_t,int> TankOrphansWaveMap,
                        std::map<uint64_t, std::vector<std::vector<int>>> TankOrphansChannels,
@@ -138,17 +153,17 @@ class ANNIEEventBuilder: public Tool {
 
  private:
 
-  std::map<std::vector<int>,int> TankPMTCrateSpaceToChannelNumMap;
-  std::map<std::vector<int>,int> AuxCrateSpaceToChannelNumMap;
-  std::map<std::vector<int>,int> MRDCrateSpaceToChannelNumMap;
+  std::unordered_map<CrateSlotChannelKey,int> TankPMTCrateSpaceToChannelNumMap;  //Key: CrateSlotChannelKey(crate,slot,channel), value: channel key
+  std::unordered_map<CrateSlotChannelKey,int> AuxCrateSpaceToChannelNumMap;
+  std::unordered_map<CrateSlotChannelKey,int> MRDCrateSpaceToChannelNumMap;
   std::map<int,std::vector<int>> ChannelNumToTankPMTCrateSpaceMap;
   std::map<int,std::vector<int>> AuxChannelNumToCrateSpaceMap;
 
 
   //####### MAPS THAT ARE LOADED FROM OR CONTAIN INFO FROM THE CSTORE (FROM MRD/PMT DECODING) #########
-  std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > >* InProgressTankEvents;  //Key: {MTCTime}, value: map of in-progress PMT trigger decoding from WaveBank
-  std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > > *FinishedTankEvents;  //Key: {MTCTime}, value: map of fully-built waveforms from WaveBank
-  std::map<uint64_t, std::map<std::vector<int>, int > > *FinishedTankEventsSampleSize;  //Key: {MTCTime}, value: map of fully-built waveforms from WaveBank
+  std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t> > >* InProgressTankEvents;  //Key: {MTCTime}, value: map of in-progress PMT trigger decoding from WaveBank
+  std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t> > > *FinishedTankEvents;  //Key: {MTCTime}, value: map of fully-built waveforms from WaveBank
+  std::map<uint64_t, std::map<CardChannelKey, int > > *FinishedTankEventsSampleSize;  //Key: {MTCTime}, value: map of fully-built waveforms from WaveBank
   std::map<uint64_t,std::vector<uint32_t>>* TimeToTriggerWordMap;  // Key: CTCTimestamp, value: Trigger Mask ID;
   std::map<uint64_t,std::vector<uint32_t>>* TimeToTriggerWordMapComplete;  // Key: CTCTimestamp, value: Trigger Mask ID;
   MRDEventMaps myMRDMaps;
@@ -161,8 +176,8 @@ class ANNIEEventBuilder: public Tool {
   std::map<uint64_t,int> CTCExtended;	// Key: CTCTimestamp, value: Boolean map indicating whether there was an extended readout window and which type (CC/NC), Value 0: No extended readout, value 1: CC extended readout, value 2: Non-CC extended readout
 
   //###### Extra maps used for FIFO overflow info and TimestampsFromTheFuture
-  std::map<uint64_t, std::map<std::vector<int>, int> >* FIFOPMTWaves = nullptr;
-  std::map<uint64_t, std::map<std::vector<int>,uint64_t>>* TimestampsFromTheFuture = nullptr;
+  std::map<uint64_t, std::map<CardChannelKey, int> >* FIFOPMTWaves = nullptr;
+  std::map<uint64_t, std::map<CardChannelKey,uint64_t>>* TimestampsFromTheFuture = nullptr;
 
   //###### Beam status map
   std::map<uint64_t,BeamStatus> *BeamStatusMap;                         //Map containing the beam status information
@@ -199,9 +214,12 @@ class ANNIEEventBuilder: public Tool {
   int OldTimestampThreshold;  // Threshold where a timestamp relative to the newest timestamp crosses before moving to the orphanage
   int OrphanWarningValue;    //Number of orphanage placements in a pairing event to print a warning
   Orphanage myOrphanage;
+  int MaxOrphansInMemory;   //Orphans held before they are saved to the OrphanStore ahead of the next ManageOrphanage call
 
   BoostStore* ProcessedStore = nullptr;
-  BoostStore *ANNIEEvent = nullptr;
+  ANNIEEventEntry *ANNIEEvent = nullptr;   //Entry currently being built; handed to the EventWriter by SaveEntryToFile
+  ANNIEEventWriter *EventWriter = nullptr;
+  int WriterQueueSize;  //Built events that may wait for the writer thread before building blocks (0: no writer thread)
   std::map<unsigned long, std::vector<Hit>> *TDCData = nullptr;
 
   bool lappd_aligned = false;
@@ -224,6 +242,7 @@ class ANNIEEventBuilder: public Tool {
   std::string BuildType;
 
   bool save_raw_data;	//Should raw VME data be saved (complete waveforms)
+  bool save_waveform_blocks;	//Save the raw waveforms as WaveformBlocks (RawADCDataBlock) instead of maps
   bool store_beam_status;   //Should beam status information be saved to ANNIEEvent Store?
 
   uint64_t NewestTankTimestamp = 0;
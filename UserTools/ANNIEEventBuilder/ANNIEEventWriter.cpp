@@ -0,0 +1,100 @@
+#include "ANNIEEventWriter.h"
+
+ANNIEEventEntry::~ANNIEEventEntry(){
+  for(std::function<void()> &owned : OwnedPointers) owned();
+}
+
+void ANNIEEventEntry::Fill(BoostStore *store){
+  for(std::function<void(BoostStore*)> &setter : Setters) setter(store);
+  Setters.clear();
+  OwnedPointers.clear();
+}
+
+ANNIEEventWriter::ANNIEEventWriter(int queuesize):OutputStore(new BoostStore(false,2)),QueueSize(queuesize),NumWritten(0),StopWriter(false){
+  if(QueueSize>0) Writer = std::thread(&ANNIEEventWriter::WriterThread, this);
+}
+
+ANNIEEventWriter::~ANNIEEventWriter(){
+  this->Finalise();
+}
+
+void ANNIEEventWriter::Write(ANNIEEventEntry *entry, std::string filename){
+  WriteJob job{entry,filename};
+  if(!Writer.joinable()){
+    this->RunJob(job);
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(QueueMutex);
+    QueueCV.wait(lock,[this]{ return (int) Queue.size() < QueueSize; });
+    Queue.push_back(job);
+  }
+  QueueCV.notify_all();
+}
+
+void ANNIEEventWriter::CloseFile(){
+  WriteJob job{nullptr,""};
+  if(!Writer.joinable()){
+    this->RunJob(job);
+    return;
+  }
+  {
+    //A close request does not count against the queue size; it must not block behind full queues
+    std::lock_guard<std::mutex> lock(QueueMutex);
+    Queue.push_back(job);
+  }
+  QueueCV.notify_all();
+}
+
+void ANNIEEventWriter::Finalise(){
+  if(Writer.joinable()){
+    {
+      std::lock_guard<std::mutex> lock(QueueMutex);
+      StopWriter = true;
+    }
+    QueueCV.notify_all();
+    Writer.join();    //the writer thread empties the queue before returning
+  }
+  if(OutputStore){
+    OutputStore->Close();
+    OutputStore->Delete();
+    delete OutputStore;
+    OutputStore = nullptr;
+  }
+}
+
+long ANNIEEventWriter::EntriesWritten(){
+  std::lock_guard<std::mutex> lock(QueueMutex);
+  return NumWritten;
+}
+
+void ANNIEEventWriter::RunJob(WriteJob &job){
+  if(job.Entry == nullptr){
+    OutputStore->Close();
+    OutputStore->Delete();
+    delete OutputStore;
+    OutputStore = new BoostStore(false,2);
+    return;
+  }
+  job.Entry->Fill(OutputStore);
+  OutputStore->Save(job.Filename);
+  OutputStore->Delete();  //Delete() only clears the entry from memory, it stays in the file
+  delete job.Entry;
+  std::lock_guard<std::mutex> lock(QueueMutex);
+  NumWritten++;
+}
+
+void ANNIEEventWriter::WriterThread(){
+  while(true){
+    WriteJob job;
+    {
+      std::unique_lock<std::mutex> lock(QueueMutex);
+      QueueCV.wait(lock,[this]{ return StopWriter || !Queue.empty(); });
+      if(Queue.empty()) return;   //only reached once StopWriter is set
+      job = Queue.front();
+      Queue.pop_front();
+    }
+    QueueCV.notify_all();   //wake a Write() waiting for space
+    this->RunJob(job);
+  }
+}
@@ -0,0 +1,96 @@
+#ifndef ANNIEEventWriter_H
+#define ANNIEEventWriter_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "BoostStore.h"
+
+/**
+* \class ANNIEEventEntry
+*
+* One ANNIEEvent entry as assembled by the ANNIEEventBuilder.  Set() takes the same
+* arguments as BoostStore::Set, but only records the values; they are put into (and
+* serialised by) the output BoostStore when the ANNIEEventWriter writes the entry.
+* Pointers set with persist=true belong to the entry until then, and to the output
+* store afterwards, just as they would belong to a BoostStore.
+*/
+
+class ANNIEEventEntry {
+
+ public:
+
+  ANNIEEventEntry(){}
+  ~ANNIEEventEntry();
+
+  template<typename T> void Set(std::string name, T in){
+    Setters.push_back([name,value=std::move(in)](BoostStore *store) mutable { store->Set(name,std::move(value)); });
+  }
+  template<typename T> void Set(std::string name, T *in, bool persist=true){
+    Setters.push_back([name,in,persist](BoostStore *store){ store->Set(name,in,persist); });
+    if(persist) OwnedPointers.push_back([in](){ delete in; });
+  }
+
+  void Fill(BoostStore *store); ///< Set all recorded values in store, handing over any persistent pointers
+
+ private:
+
+  ANNIEEventEntry(const ANNIEEventEntry&) = delete;
+  ANNIEEventEntry& operator=(const ANNIEEventEntry&) = delete;
+
+  std::vector<std::function<void(BoostStore*)>> Setters;
+  std::vector<std::function<void()>> OwnedPointers;  // deletes persistent pointers of an entry that is never written
+
+};
+
+/**
+* \class ANNIEEventWriter
+*
+* Writes ANNIEEventEntries to a multi-entry BoostStore file.  With a queue size of 0
+* each entry is written on the calling thread.  Otherwise the entries are handed to a
+* writer thread through a queue of at most that many entries, and Write() only blocks
+* while the queue is full.  CloseFile() and Finalise() are queued behind all pending
+* entries, so entries are always written, and files closed, in the order they were
+* submitted.
+*/
+
+class ANNIEEventWriter {
+
+ public:
+
+  ANNIEEventWriter(int queuesize=0);
+  ~ANNIEEventWriter();
+
+  void Write(ANNIEEventEntry *entry, std::string filename); ///< Takes ownership of entry
+  void CloseFile();   ///< Close the current output file once all queued entries are written
+  void Finalise();    ///< Write all queued entries, close the output file and stop the writer thread
+  long EntriesWritten();
+
+ private:
+
+  struct WriteJob {
+    ANNIEEventEntry *Entry;   // nullptr: close the output file
+    std::string Filename;
+  };
+
+  void RunJob(WriteJob &job);
+  void WriterThread();
+
+  BoostStore *OutputStore;
+  int QueueSize;
+  long NumWritten;
+
+  std::thread Writer;
+  std::mutex QueueMutex;
+  std::condition_variable QueueCV;
+  std::deque<WriteJob> Queue;
+  bool StopWriter;
+
+};
+
+#endif
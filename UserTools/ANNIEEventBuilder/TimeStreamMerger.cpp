@@ -0,0 +1,48 @@
+#include "TimeStreamMerger.h"
+
+#include <algorithm>
+#include <cmath>
+
+void TimeStreamMerger::SortStream(std::vector<uint64_t> &stream){
+  if (!std::is_sorted(stream.begin(),stream.end())) std::sort(stream.begin(),stream.end());
+  stream.erase(std::unique(stream.begin(),stream.end()),stream.end());
+}
+
+size_t TimeStreamMerger::NumMatchable(const std::vector<uint64_t> &stream, uint64_t max_timestamp, bool force_matching){
+  if (force_matching) return stream.size();
+  return std::upper_bound(stream.begin(),stream.end(),max_timestamp) - stream.begin();
+}
+
+TimeStreamMerger::MatchStatus TimeStreamMerger::MatchToStream(uint64_t timestamp, const std::vector<uint64_t> &ctc_stream,
+    size_t num_matchable, double tolerance, size_t &match_index, double &min_tdiff){
+
+  //The differences are formed in double precision, exactly as in the former linear
+  //scans, so that the tolerance windows stay bit-for-bit the same
+  const double ts = static_cast<double>(timestamp);
+  std::vector<uint64_t>::const_iterator it_end = ctc_stream.begin() + num_matchable;
+  //First CTC timestamp that is not earlier than the tolerance window
+  std::vector<uint64_t>::const_iterator it_ctc = std::partition_point(ctc_stream.begin(),it_end,
+      [ts,tolerance](uint64_t ctc){ return (ts - static_cast<double>(ctc)) > tolerance; });
+  if (it_ctc == it_end) return MatchPending;
+
+  double TSDiff = ts - static_cast<double>(*it_ctc);
+  if (TSDiff < -tolerance){
+    double TSDiff_previous = (it_ctc == ctc_stream.begin())? 0. : ts - static_cast<double>(*(it_ctc-1));
+    min_tdiff = (fabs(TSDiff) < fabs(TSDiff_previous))? TSDiff : TSDiff_previous;
+    return MatchOrphan;
+  }
+  match_index = it_ctc - ctc_stream.begin();
+  return MatchFound;
+}
+
+void TimeStreamMerger::EraseTimestamps(std::vector<uint64_t> &stream, std::vector<uint64_t> timestamps){
+  if (timestamps.empty() || stream.empty()) return;
+  std::sort(timestamps.begin(),timestamps.end());
+  stream.erase(std::remove_if(stream.begin(),stream.end(),
+      [&timestamps](uint64_t ts){ return std::binary_search(timestamps.begin(),timestamps.end(),ts); }),
+      stream.end());
+}
+
+bool TimeStreamMerger::HasTimestamp(const std::vector<uint64_t> &stream, uint64_t timestamp){
+  return std::binary_search(stream.begin(),stream.end(),timestamp);
+}
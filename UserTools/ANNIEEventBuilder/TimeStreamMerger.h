@@ -0,0 +1,63 @@
+#ifndef TimeStreamMerger_H
+#define TimeStreamMerger_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+#include <map>
+
+/**
+* \class TimeStreamMerger
+*
+* Helpers used by the ANNIEEventBuilder to merge the Tank, MRD, LAPPD and CTC
+* timestamp streams held in the TimeStream struct.
+*
+* Every stream is kept sorted and free of duplicates.  That turns matching a
+* timestamp against the CTC stream into a binary search over the part of the
+* stream that lies behind the matching watermark, and removing the timestamps
+* consumed by a build cycle into a single pass over the stream.
+*/
+
+class TimeStreamMerger {
+
+ public:
+
+  enum MatchStatus {
+    MatchPending,   ///< No CTC timestamp behind the watermark could be checked yet
+    MatchFound,     ///< A CTC timestamp lies within the tolerance window
+    MatchOrphan     ///< The CTC stream has moved past the tolerance window
+  };
+
+  /// Sort a timestream and drop duplicate entries.  Newly appended timestamps are
+  /// normally later than the ones already held, so the sort is skipped in that case.
+  static void SortStream(std::vector<uint64_t> &stream);
+
+  /// Number of leading entries of a sorted stream that may be used for matching,
+  /// i.e. entries not newer than max_timestamp (or all entries if force_matching)
+  static size_t NumMatchable(const std::vector<uint64_t> &stream, uint64_t max_timestamp, bool force_matching);
+
+  /// Look for the earliest of the first num_matchable entries of the sorted CTC stream
+  /// that lies within tolerance of timestamp.  On MatchFound, match_index is the index
+  /// of that CTC timestamp.  On MatchOrphan, min_tdiff is the signed time difference
+  /// (timestamp - CTC) to the closest CTC timestamp on either side of the window.
+  static MatchStatus MatchToStream(uint64_t timestamp, const std::vector<uint64_t> &ctc_stream,
+      size_t num_matchable, double tolerance, size_t &match_index, double &min_tdiff);
+
+  /// Remove a set of timestamps from a sorted stream in one pass
+  static void EraseTimestamps(std::vector<uint64_t> &stream, std::vector<uint64_t> timestamps);
+
+  /// Remove the keys of a timestamp-keyed map from a sorted stream in one pass
+  template<typename T> static void EraseTimestamps(std::vector<uint64_t> &stream, const std::map<uint64_t,T> &timestamps){
+    if (timestamps.empty()) return;
+    std::vector<uint64_t> keys;
+    keys.reserve(timestamps.size());
+    for (typename std::map<uint64_t,T>::const_iterator it = timestamps.begin(); it != timestamps.end(); ++it) keys.push_back(it->first);
+    EraseTimestamps(stream,keys);
+  }
+
+  /// Check whether a sorted stream holds a timestamp
+  static bool HasTimestamp(const std::vector<uint64_t> &stream, uint64_t timestamp);
+
+};
+
+#endif
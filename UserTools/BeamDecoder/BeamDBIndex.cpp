@@ -0,0 +1,54 @@
+#include "BeamDBIndex.h"
+
+#include <algorithm>
+
+BeamDBIndex::BeamDBIndex():Cursor(0){}
+
+void BeamDBIndex::Build(const std::map<int, std::pair<uint64_t, uint64_t>> &beam_db_index){
+  Chunks.clear();
+  MaxEndMs.clear();
+  Cursor = 0;
+  Chunks.reserve(beam_db_index.size());
+  for (const auto& pair : beam_db_index) Chunks.push_back(Chunk{pair.second.first, pair.second.second, pair.first});
+  std::sort(Chunks.begin(), Chunks.end(), [](const Chunk &a, const Chunk &b){
+    return (a.StartMs != b.StartMs)? a.StartMs < b.StartMs : a.Entry < b.Entry; });
+  MaxEndMs.reserve(Chunks.size());
+  for (size_t i = 0; i < Chunks.size(); i++){
+    MaxEndMs.push_back((i == 0)? Chunks[i].EndMs : std::max(MaxEndMs[i-1], Chunks[i].EndMs));
+  }
+}
+
+bool BeamDBIndex::IsUnique(size_t i, uint64_t ms) const {
+  //No neighbouring chunk reaches ms, so chunk i is the only one that holds it
+  bool next_clear = (i+1 == Chunks.size()) || Chunks[i+1].StartMs > ms;
+  bool previous_clear = (i == 0) || MaxEndMs[i-1] < ms;
+  return next_clear && previous_clear;
+}
+
+int BeamDBIndex::Find(uint64_t ms_since_epoch){
+
+  if (Chunks.empty()) return -1;
+
+  //Fast path: the timestamp lies in the same chunk as the previous one, or in the next
+  if (Contains(Cursor, ms_since_epoch) && IsUnique(Cursor, ms_since_epoch)) return Chunks[Cursor].Entry;
+  if (Cursor+1 < Chunks.size() && Contains(Cursor+1, ms_since_epoch) && IsUnique(Cursor+1, ms_since_epoch)){
+    Cursor++;
+    return Chunks[Cursor].Entry;
+  }
+
+  //Last chunk starting at or before the timestamp
+  std::vector<Chunk>::const_iterator it = std::upper_bound(Chunks.begin(), Chunks.end(), ms_since_epoch,
+    [](uint64_t ms, const Chunk &chunk){ return ms < chunk.StartMs; });
+  if (it == Chunks.begin()) return -1;
+
+  //Walk back over earlier chunks that may still reach the timestamp; for
+  //non-overlapping chunks this stops after the first one
+  int found = -1;
+  for (size_t i = (it - Chunks.begin()); i-- > 0 && MaxEndMs[i] >= ms_since_epoch; ){
+    if (Contains(i, ms_since_epoch) && (found < 0 || Chunks[i].Entry < found)){
+      found = Chunks[i].Entry;
+      Cursor = i;
+    }
+  }
+  return found;
+}
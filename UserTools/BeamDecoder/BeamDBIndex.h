@@ -0,0 +1,53 @@
+#ifndef BeamDBIndex_H
+#define BeamDBIndex_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <vector>
+#include <map>
+#include <utility>
+
+/**
+* \class BeamDBIndex
+*
+* Interval index over the BeamDBIndex header entry written by the BeamFetcher
+* (beam database entry number -> first and last ms since epoch held by that entry).
+*
+* The chunks are kept sorted by their start time, so finding the chunk of a
+* timestamp is a binary search.  Trigger timestamps arrive roughly in time order,
+* so the chunk of the previous lookup is checked first and most lookups finish
+* without a search.  If chunks overlap, the lowest entry number containing the
+* timestamp is returned, as the former linear scan over the header map did.
+*/
+
+class BeamDBIndex {
+
+ public:
+
+  BeamDBIndex();
+
+  void Build(const std::map<int, std::pair<uint64_t, uint64_t>> &beam_db_index);
+
+  /// Beam database entry holding ms_since_epoch, or -1 if there is none
+  int Find(uint64_t ms_since_epoch);
+
+  size_t size() const { return Chunks.size(); }
+
+ private:
+
+  struct Chunk {
+    uint64_t StartMs;
+    uint64_t EndMs;
+    int Entry;
+  };
+
+  bool Contains(size_t i, uint64_t ms) const { return ms >= Chunks[i].StartMs && ms <= Chunks[i].EndMs; }
+  bool IsUnique(size_t i, uint64_t ms) const;
+
+  std::vector<Chunk> Chunks;       // sorted by StartMs
+  std::vector<uint64_t> MaxEndMs;  // largest EndMs of Chunks[0..i]
+  size_t Cursor;                   // chunk found by the previous lookup
+
+};
+
+#endif
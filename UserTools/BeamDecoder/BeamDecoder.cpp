@@ -38,6 +38,12 @@ bool BeamDecoder::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("SecondToroid", second_toroid);
   m_variables.Get("HornCurrentDevice", horn_current_device);
 
+  // Number of decoded beam database entries kept in memory. Each entry holds
+  // a few hours of beam data, so a small number suffices for time-ordered triggers
+  beam_db_cache_size_ = 2;
+  m_variables.Get("BeamDBCacheSize", beam_db_cache_size_);
+  if (beam_db_cache_size_ < 1) beam_db_cache_size_ = 1;
+
   BeamStatusMap = new std::map<uint64_t,BeamStatus>;
 
   first_entry = true;
@@ -96,6 +102,9 @@ bool BeamDecoder::Execute(){
 
 bool BeamDecoder::Finalise(){
 
+  beam_db_cache_.clear();
+  beam_db_lru_.clear();
+
   return true;
 }
 
@@ -138,6 +147,7 @@ bool BeamDecoder::initialise_beam_db(){
       verbosity_);
     return false;
   }
+  beam_db_intervals_.Build(beam_db_index_);
 
   bool got_start = beam_db_store_.Header->Get("StartMillisecondsSinceEpoch",
     start_ms_since_epoch_);
@@ -190,17 +200,6 @@ BeamStatus BeamDecoder::get_beam_status(uint64_t ns_since_epoch,
       BeamCondition::NonBeamMinibuffer);
   }
 
-  static std::map<std::string, std::map<uint64_t, BeamDataPoint> >
-    beam_data;
-  static int current_beam_db_entry = 0;
-  static bool got_first_beam_entry = false;
-
-  if ( !got_first_beam_entry ) {
-    beam_db_store_.GetEntry(current_beam_db_entry);
-    beam_db_store_.Get("BeamDB", beam_data);
-    got_first_beam_entry = true;
-  }
-
   // The beam database uses timestamps with ms precision
   uint64_t ms_since_epoch = ns_since_epoch / MILLION;
 
@@ -209,41 +208,19 @@ BeamStatus BeamDecoder::get_beam_status(uint64_t ns_since_epoch,
 
   // Find the beam database entry that contains POT information for the
   // moment of interest
-  
-  auto iter = std::find_if(beam_db_index_.cbegin(),
-    beam_db_index_.cend(),
-    [ms_since_epoch](const std::pair<int, std::pair<uint64_t,
-      uint64_t> >& pair) -> bool {
-      uint64_t start_ms = pair.second.first;
-      uint64_t end_ms = pair.second.second;
-      return ms_since_epoch >= start_ms && ms_since_epoch <= end_ms;
-    }
-  );
+  int entry_number = beam_db_intervals_.Find(ms_since_epoch);
 
   // If a suitable entry could not be found, then complain and return
   // a BeamStatus object that indicates that the data were missing
- 
-  bool found_pot_entry = ( iter != beam_db_index_.cend() );
 
-  if ( !found_pot_entry ) {
+  if ( entry_number < 0 ) {
     Log("BeamDecoder tool: WARNING: unable to find a suitable entry for "
       + make_time_string(ms_since_epoch) + " (" + std::to_string(ms_since_epoch)
       + " ms since the Unix epoch) in the beam database file", 0, verbosity_);
     return BeamStatus( TimeClass(ns_since_epoch), 0., BeamCondition::Missing );
   }
 
-  // If we need to load a new entry from the beam database, do so.
-  // Avoid loading a new entry if you don't have to (the maps stored in
-  // each entry are fairly large)   
-
-  int new_entry_number = iter->first;
-  if ( new_entry_number != current_beam_db_entry ) {
-
-    beam_db_store_.GetEntry(new_entry_number);
-    beam_db_store_.Get("BeamDB", beam_data);
-
-    current_beam_db_entry = new_entry_number;
-  }
+  const BeamDB& beam_data = get_beam_db_entry(entry_number);
 
   // Temporary storage for this function's return value
   BeamStatus beam_status;
@@ -412,3 +389,32 @@ BeamStatus BeamDecoder::get_beam_status(uint64_t ns_since_epoch,
 
   return beam_status;
 }
+
+
+const BeamDecoder::BeamDB& BeamDecoder::get_beam_db_entry(int entry_number){
+
+  // Avoid loading an entry from the beam database if you don't have to (the
+  // maps stored in each entry are fairly large)
+  std::map<int, BeamDB>::iterator it = beam_db_cache_.find(entry_number);
+  if ( it != beam_db_cache_.end() ) {
+    if ( beam_db_lru_.front() != entry_number ) {
+      beam_db_lru_.remove(entry_number);
+      beam_db_lru_.push_front(entry_number);
+    }
+    return it->second;
+  }
+
+  if ( (int) beam_db_cache_.size() >= beam_db_cache_size_ ) {
+    beam_db_cache_.erase(beam_db_lru_.back());
+    beam_db_lru_.pop_back();
+  }
+
+  Log("BeamDecoder tool: Loading beam database entry " + std::to_string(entry_number),
+    3, verbosity_);
+  BeamDB& beam_data = beam_db_cache_[entry_number];
+  beam_db_store_.GetEntry(entry_number);
+  beam_db_store_.Get("BeamDB", beam_data);
+  beam_db_lru_.push_front(entry_number);
+
+  return beam_data;
+}
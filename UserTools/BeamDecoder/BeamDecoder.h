@@ -7,6 +7,7 @@
 #include <ctime>
 #include <fstream>
 #include <sstream>
+#include <list>
 
 #include "Tool.h"
 #include "BeamStatus.h"
@@ -14,6 +15,7 @@
 #include "ANNIEconstants.h"
 #include "BeamDataPoint.h"
 #include "TimeClass.h"
+#include "BeamDBIndex.h"
 
 
 
@@ -38,7 +40,10 @@ class BeamDecoder: public Tool {
 
   bool initialise_beam_db();
   BeamStatus get_beam_status(uint64_t ns_since_epoch, MinibufferLabel mb_label);
-  
+
+  typedef std::map<std::string, std::map<uint64_t, BeamDataPoint>> BeamDB;
+  const BeamDB& get_beam_db_entry(int entry_number); ///< Decoded BeamDB entry, loaded through the LRU cache
+
 
  private:
 
@@ -55,6 +60,11 @@ class BeamDecoder: public Tool {
 
   BoostStore beam_db_store_;
   std::map<int, std::pair<uint64_t, uint64_t>> beam_db_index_;
+  BeamDBIndex beam_db_intervals_;			//Sorted interval index over beam_db_index_
+
+  int beam_db_cache_size_;				//Number of decoded BeamDB entries kept in memory
+  std::map<int, BeamDB> beam_db_cache_;
+  std::list<int> beam_db_lru_;				//Cached entry numbers, most recently used first
   uint64_t start_ms_since_epoch_;
   uint64_t end_ms_since_epoch_;
 
@@ -0,0 +1,255 @@
+// standard library includes
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+// POSIX includes
+#include <sys/stat.h>
+
+// ToolAnalysis includes
+#include "BeamDBChunkFetcher.h"
+#include "IFBeamDBInterface.h"
+
+namespace {
+  // Chunks that end less than this long before the present may still be
+  // incomplete in the database, so their responses are not cached
+  constexpr uint64_t CACHE_SAFETY_MS = 3600000ull; // one hour
+
+  // Several chunks may be downloaded ahead of the one Next() waits for, but
+  // not without bound, since each parsed chunk is fairly large
+  constexpr size_t CHUNKS_AHEAD_PER_THREAD = 2;
+}
+
+BeamDBChunkFetcher::BeamDBChunkFetcher(int num_threads, int max_retries,
+  int retry_delay_ms, const std::string& cache_dir,
+  const std::string& url_start) : fNumThreads(num_threads),
+  fMaxRetries(max_retries), fRetryDelayMs(retry_delay_ms),
+  fCacheDir(cache_dir), fURLStart(url_start)
+{
+  // Make sure libcurl has been initialised (by the singleton) before any
+  // handle is created on a worker thread
+  IFBeamDBInterface::Instance();
+
+  if (!fCacheDir.empty()) {
+    if (fCacheDir.back() == '/') fCacheDir.pop_back();
+    mkdir(fCacheDir.c_str(), 0755);
+  }
+}
+
+BeamDBChunkFetcher::~BeamDBChunkFetcher()
+{
+  Stop();
+  if (fCurl) curl_easy_cleanup(fCurl);
+}
+
+void BeamDBChunkFetcher::Start(
+  const std::vector<std::pair<uint64_t, uint64_t> >& chunks)
+{
+  Stop();
+  fChunks = chunks;
+  fNextToFetch = 0;
+  fNextToReturn = 0;
+  fResults.clear();
+  fStop = false;
+
+  for (int i = 0; i < fNumThreads; ++i) {
+    fWorkers.push_back(std::thread(&BeamDBChunkFetcher::WorkerThread, this));
+  }
+}
+
+bool BeamDBChunkFetcher::Next(BeamDB& beam_data, std::string& error)
+{
+  if (fNextToReturn >= fChunks.size()) {
+    error = "no chunks left to fetch";
+    return false;
+  }
+
+  ChunkResult result;
+
+  if (fWorkers.empty()) {
+    if (!fCurl) {
+      fCurl = curl_easy_init();
+      if (!fCurl) throw std::runtime_error("BeamDBChunkFetcher failed to"
+        " initialize libcurl");
+    }
+    FetchChunk(fCurl, fNextToReturn, result);
+    ++fNextToReturn;
+  }
+  else {
+    std::unique_lock<std::mutex> lock(fMutex);
+    fCV.wait(lock, [this]{ return fResults.count(fNextToReturn) > 0; });
+    result = std::move(fResults.at(fNextToReturn));
+    fResults.erase(fNextToReturn);
+    ++fNextToReturn;
+    lock.unlock();
+    fCV.notify_all();  // a worker may be waiting to run further ahead
+  }
+
+  beam_data = std::move(result.beam_data);
+  error = result.error;
+  return result.ok;
+}
+
+void BeamDBChunkFetcher::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fStop = true;
+  }
+  fCV.notify_all();
+  for (auto& worker : fWorkers) worker.join();
+  fWorkers.clear();
+}
+
+void BeamDBChunkFetcher::WorkerThread()
+{
+  CURL* curl = curl_easy_init();
+  if (curl) curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+
+  const size_t max_ahead = CHUNKS_AHEAD_PER_THREAD * fNumThreads;
+
+  while (true) {
+
+    size_t index;
+    {
+      std::unique_lock<std::mutex> lock(fMutex);
+      fCV.wait(lock, [this, max_ahead]{ return fStop
+        || fNextToFetch >= fChunks.size()
+        || fNextToFetch < fNextToReturn + max_ahead; });
+      if (fStop || fNextToFetch >= fChunks.size()) break;
+      index = fNextToFetch++;
+    }
+
+    ChunkResult result;
+    if (curl) FetchChunk(curl, index, result);
+    else result.error = "failed to initialize libcurl";
+
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fResults[index] = std::move(result);
+    }
+    fCV.notify_all();
+  }
+
+  if (curl) curl_easy_cleanup(curl);
+}
+
+void BeamDBChunkFetcher::FetchChunk(CURL* curl, size_t index,
+  ChunkResult& result)
+{
+  uint64_t t0 = fChunks.at(index).first;
+  uint64_t t1 = fChunks.at(index).second;
+
+  std::string response;
+  if (ReadCache(t0, t1, response)) {
+    bool complete = false;
+    result.beam_data = IFBeamDBInterface::Instance().ParseDBResponse(response,
+      complete);
+    if (complete) {
+      std::lock_guard<std::mutex> lock(fMutex);
+      ++fNumCacheHits;
+      result.ok = true;
+      return;
+    }
+    // A cached response that does not parse is downloaded again
+  }
+
+  if (!QueryWithRetries(curl, t0, t1, response, result.beam_data,
+    result.error)) return;
+  WriteCache(t0, t1, response);
+  result.ok = true;
+}
+
+bool BeamDBChunkFetcher::QueryWithRetries(CURL* curl, uint64_t t0,
+  uint64_t t1, std::string& response, BeamDB& beam_data, std::string& error)
+{
+  const auto& db = IFBeamDBInterface::Instance();
+
+  for (int attempt = 0; attempt <= fMaxRetries; ++attempt) {
+
+    if (attempt > 0) {
+      {
+        std::lock_guard<std::mutex> lock(fMutex);
+        ++fNumRetries;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(
+        static_cast<long>(fRetryDelayMs) << (attempt - 1)));
+    }
+
+    try {
+      int code = db.QueryBeamDB(t0, t1, response, curl, fURLStart);
+      if (code != CURLE_OK) {
+        error = "libcurl error: " + std::string(curl_easy_strerror(
+          static_cast<CURLcode>(code)));
+        continue;
+      }
+      // A response without even the csv header line, or one that stops in
+      // the middle of a record, is a failed download. A period without beam
+      // gives the header line only.
+      if (response.empty()) {
+        error = "empty response";
+        continue;
+      }
+      bool complete = false;
+      beam_data = db.ParseDBResponse(response, complete);
+      if (complete) return true;
+      error = "malformed csv response";
+    }
+    catch (const std::exception& e) {
+      error = e.what();
+    }
+  }
+
+  // Never hand out the part of a malformed response that could be parsed
+  beam_data.clear();
+  error = "Error accessing IF beam database for [" + std::to_string(t0)
+    + ", " + std::to_string(t1) + "] ms after " + std::to_string(fMaxRetries + 1)
+    + " attempts: " + error;
+  return false;
+}
+
+std::string BeamDBChunkFetcher::CacheFileName(uint64_t t0, uint64_t t1) const
+{
+  std::stringstream ss;
+  ss << fCacheDir << "/beamdb_" << t0 << '_' << t1 << ".csv";
+  return ss.str();
+}
+
+bool BeamDBChunkFetcher::ReadCache(uint64_t t0, uint64_t t1,
+  std::string& response) const
+{
+  if (fCacheDir.empty()) return false;
+
+  std::ifstream in_file(CacheFileName(t0, t1), std::ios::binary);
+  if (!in_file.good()) return false;
+
+  std::stringstream ss;
+  ss << in_file.rdbuf();
+  response = ss.str();
+  return true;
+}
+
+void BeamDBChunkFetcher::WriteCache(uint64_t t0, uint64_t t1,
+  const std::string& response) const
+{
+  if (fCacheDir.empty()) return;
+
+  uint64_t now_ms = static_cast<uint64_t>(std::time(nullptr)) * 1000ull;
+  if (t1 + CACHE_SAFETY_MS > now_ms) return;
+
+  // Write to a temporary file first, so that an interrupted download never
+  // leaves a truncated response in the cache
+  std::string file_name = CacheFileName(t0, t1);
+  std::stringstream tmp_name;
+  tmp_name << file_name << ".tmp" << std::this_thread::get_id();
+
+  std::ofstream out_file(tmp_name.str(), std::ios::binary);
+  out_file << response;
+  out_file.close();
+
+  if (out_file.good()) std::rename(tmp_name.str().c_str(), file_name.c_str());
+  else std::remove(tmp_name.str().c_str());
+}
@@ -0,0 +1,89 @@
+// Helper used by the BeamFetcher tool to download a list of time chunks
+// from the Intensity Frontier beam database, optionally on several threads
+// and through an on-disk cache of raw database responses
+#pragma once
+
+// standard library includes
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// libcurl includes
+#include <curl/curl.h>
+
+// ToolAnalysis includes
+#include "BeamDataPoint.h"
+
+class BeamDBChunkFetcher {
+
+  public:
+
+    typedef std::map<std::string, std::map<uint64_t, BeamDataPoint> > BeamDB;
+
+    /// @param num_threads Number of chunks downloaded at the same time. With 0
+    /// every chunk is downloaded on the calling thread when it is requested.
+    /// @param max_retries Number of times a failed query is repeated
+    /// @param retry_delay_ms Wait before the first retry, doubled for every
+    /// further one
+    /// @param cache_dir Directory holding the cached responses (no caching if
+    /// empty)
+    /// @param url_start Query URL up to the time range (the IF beam database
+    /// if empty)
+    BeamDBChunkFetcher(int num_threads, int max_retries, int retry_delay_ms,
+      const std::string& cache_dir, const std::string& url_start);
+    ~BeamDBChunkFetcher();
+
+    BeamDBChunkFetcher(const BeamDBChunkFetcher&) = delete;
+    BeamDBChunkFetcher& operator=(const BeamDBChunkFetcher&) = delete;
+
+    /// @brief Start downloading the chunks [t0, t1] (ms since the Unix epoch)
+    void Start(const std::vector<std::pair<uint64_t, uint64_t> >& chunks);
+
+    /// @brief Get the parsed data of the next chunk, in the order given to
+    /// Start(). Returns false, with a message in error, if the chunk could not
+    /// be downloaded.
+    bool Next(BeamDB& beam_data, std::string& error);
+
+    int NumCacheHits() const { return fNumCacheHits; }
+    int NumRetries() const { return fNumRetries; }
+
+  protected:
+
+    struct ChunkResult {
+      bool ok = false;
+      BeamDB beam_data;
+      std::string error;
+    };
+
+    void FetchChunk(CURL* curl, size_t index, ChunkResult& result);
+    bool QueryWithRetries(CURL* curl, uint64_t t0, uint64_t t1,
+      std::string& response, BeamDB& beam_data, std::string& error);
+    std::string CacheFileName(uint64_t t0, uint64_t t1) const;
+    bool ReadCache(uint64_t t0, uint64_t t1, std::string& response) const;
+    void WriteCache(uint64_t t0, uint64_t t1, const std::string& response) const;
+    void Stop();
+    void WorkerThread();
+
+    int fNumThreads;
+    int fMaxRetries;
+    int fRetryDelayMs;
+    std::string fCacheDir;
+    std::string fURLStart;
+
+    std::vector<std::pair<uint64_t, uint64_t> > fChunks;
+    size_t fNextToFetch = 0;   ///< next chunk a worker will pick up
+    size_t fNextToReturn = 0;  ///< next chunk handed out by Next()
+    std::map<size_t, ChunkResult> fResults;  ///< downloaded chunks not yet handed out
+    int fNumCacheHits = 0;
+    int fNumRetries = 0;
+
+    CURL* fCurl = nullptr;     ///< handle used when fetching on the calling thread
+    std::vector<std::thread> fWorkers;
+    std::mutex fMutex;
+    std::condition_variable fCV;
+    bool fStop = false;
+};
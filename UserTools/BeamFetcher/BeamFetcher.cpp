@@ -4,7 +4,7 @@
 
 // ToolAnalysis includes
 #include "BeamFetcher.h"
-#include "IFBeamDBInterface.h"
+#include "BeamDBChunkFetcher.h"
 
 namespace {
   constexpr uint64_t TWO_HOURS = 7200000ull; // ms
@@ -26,6 +26,11 @@ bool BeamFetcher::Initialise(std::string config_filename, DataModel& data)
   // Default values
   timestamp_mode = "MSEC";	//Other option: LOCALDATE, DB
   DaylightSavings = false; 
+  fetch_threads_ = 0;
+  fetch_retries_ = 0;
+  fetch_retry_delay_ms_ = 1000;
+  chunk_cache_dir_ = "";
+  beam_db_url_ = "";
 
   m_variables.Get("verbose", verbosity_);
 
@@ -170,6 +175,14 @@ bool BeamFetcher::Execute() {
     return false;
   }
 
+  m_variables.Get("FetchThreads", fetch_threads_);
+  m_variables.Get("FetchRetries", fetch_retries_);
+  m_variables.Get("FetchRetryDelayMs", fetch_retry_delay_ms_);
+  m_variables.Get("ChunkCacheDir", chunk_cache_dir_);
+  m_variables.Get("BeamDBURL", beam_db_url_);
+  if (fetch_threads_ < 0) fetch_threads_ = 0;
+  if (fetch_retries_ < 0) fetch_retries_ = 0;
+
   return fetch_beam_data(start_ms_since_epoch, end_ms_since_epoch,
     chunk_step_ms);
 }
@@ -189,8 +202,32 @@ bool BeamFetcher::fetch_beam_data(uint64_t start_ms_since_epoch,
   // database queries to fail.
   uint64_t current_time = end_ms_since_epoch;
 
-  // Get a const reference to the beam database interface
-  const auto& db = IFBeamDBInterface::Instance();
+  // With a chunk cache, line the chunks up on multiples of the chunk step, so
+  // that any later download of an overlapping period asks for the same
+  // chunks and finds them in the cache
+  if ( !chunk_cache_dir_.empty() && chunk_step_ms > 0 ) {
+    current_time = ( (end_ms_since_epoch + chunk_step_ms - 1) / chunk_step_ms )
+      * chunk_step_ms;
+  }
+
+  // List the chunks first, so that several of them can be downloaded at the
+  // same time. Have a small overlap (THIRTY_SECONDS) between entries so that
+  // we can be sure not to miss any time interval in the desired range
+  std::vector<uint64_t> chunk_times;
+  std::vector<std::pair<uint64_t, uint64_t> > chunks;
+
+  while (current_time >= start_ms_since_epoch) {
+
+    if (!chunk_times.empty()) current_time -= chunk_step_ms;
+
+    chunk_times.push_back(current_time);
+    chunks.emplace_back(current_time - chunk_step_ms,
+      current_time + THIRTY_SECONDS);
+  }
+
+  BeamDBChunkFetcher fetcher(fetch_threads_, fetch_retries_,
+    fetch_retry_delay_ms_, chunk_cache_dir_, beam_db_url_);
+  fetcher.Start(chunks);
 
   // Storage for parsed data from the IF beam database
   std::map<std::string, std::map<uint64_t, BeamDataPoint> > beam_data;
@@ -199,21 +236,21 @@ bool BeamFetcher::fetch_beam_data(uint64_t start_ms_since_epoch,
   // BeamDB entries later
   std::map<int, std::pair<uint64_t, uint64_t> > beam_db_index;
 
-  int current_entry = 0;
-
-  while (current_time >= start_ms_since_epoch) {
-
-    if (current_entry > 0) current_time -= chunk_step_ms;
+  for (int current_entry = 0; current_entry < (int) chunks.size();
+    ++current_entry)
+  {
+    current_time = chunk_times.at(current_entry);
 
     time_t s_since_epoch = current_time / THOUSAND;
     std::string time_string = asctime(gmtime(&s_since_epoch));
 
     Log("Loading new beam data for " + time_string, 2, verbosity_);
 
-    // Have a small overlap (THIRTY_SECONDS) between entries so that we
-    // can be sure not to miss any time interval in the desired range
-    beam_data = db.QueryBeamDB(current_time - chunk_step_ms,
-      current_time + THIRTY_SECONDS);
+    std::string fetch_error;
+    if ( !fetcher.Next(beam_data, fetch_error) ) {
+      Log("Error (BeamFetcher): " + fetch_error, 0, verbosity_);
+      return false;
+    }
 
     // TODO: remove hard-coded device name here
     uint64_t start_ms
@@ -241,8 +278,16 @@ bool BeamFetcher::fetch_beam_data(uint64_t start_ms_since_epoch,
     beam_db_store_.Set("BeamDB", beam_data);
     beam_db_store_.Save(db_filename_);
     beam_db_store_.Delete();
+  }
 
-    ++current_entry;
+  if ( !chunk_cache_dir_.empty() ) {
+    Log("BeamFetcher tool: " + std::to_string(fetcher.NumCacheHits()) + " of "
+      + std::to_string(chunks.size()) + " beam database chunks were found in "
+      + chunk_cache_dir_, 1, verbosity_);
+  }
+  if ( fetcher.NumRetries() > 0 ) {
+    Log("BeamFetcher tool: " + std::to_string(fetcher.NumRetries())
+      + " beam database queries had to be repeated", 1, verbosity_);
   }
 
   beam_db_store_.Header->Set("BeamDBIndex", beam_db_index);
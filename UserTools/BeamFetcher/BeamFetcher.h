@@ -58,5 +58,19 @@ class BeamFetcher: public Tool {
     std::map<int,std::map<std::string,std::string>> RunInfoDB;
     int RunNumber;
 
+    /// @brief Number of beam database chunks downloaded at the same time
+    /// (0: one after the other on the tool's own thread)
+    int fetch_threads_;
+    /// @brief Number of times a failed chunk query is repeated
+    int fetch_retries_;
+    /// @brief Wait before the first retry of a failed query, doubled for
+    /// every further retry
+    int fetch_retry_delay_ms_;
+    /// @brief Directory holding cached beam database responses (no caching
+    /// if empty)
+    std::string chunk_cache_dir_;
+    /// @brief Query URL up to the time range, overriding the IF beam database
+    std::string beam_db_url_;
+
 
 };
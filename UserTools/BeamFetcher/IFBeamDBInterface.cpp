@@ -60,20 +60,28 @@ int IFBeamDBInterface::QueryBeamDB(uint64_t t0,
     return -1;
   }
 
+  return QueryBeamDB(t0, t1, response_string, fCurl, "");
+}
+
+int IFBeamDBInterface::QueryBeamDB(uint64_t t0, uint64_t t1,
+  std::string& response_string, CURL* curl,
+  const std::string& url_start) const
+{
   constexpr char BNB_URL_START[] = "http://ifb-data.fnal.gov:8089/ifbeam/"
     "data/data?e=e%2C1d&b=BNBBPMTOR&f=csv&tz=&action=Show+device&t0=";
 
   std::stringstream url_stream;
 
-  url_stream << BNB_URL_START;
+  if (url_start.empty()) url_stream << BNB_URL_START;
+  else url_stream << url_start;
   url_stream << std::fixed << std::setprecision(3) << (t0 - 1)/1000.;
   url_stream << "&t1=" << (t1 + 1)/1000.;
 
-  curl_easy_setopt(fCurl, CURLOPT_URL, url_stream.str().c_str());
+  curl_easy_setopt(curl, CURLOPT_URL, url_stream.str().c_str());
 
   response_string.clear();
 
-  curl_easy_setopt(fCurl, CURLOPT_WRITEFUNCTION,
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION,
     static_cast<size_t(*)(char*, size_t, size_t, std::string*)>(
       [](char* ptr, size_t size,
         size_t num_members, std::string* data) -> size_t
@@ -83,9 +91,9 @@ int IFBeamDBInterface::QueryBeamDB(uint64_t t0,
       }
     )
   );
-  curl_easy_setopt(fCurl, CURLOPT_WRITEDATA, &response_string);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_string);
 
-  int code = curl_easy_perform(fCurl);
+  int code = curl_easy_perform(curl);
 
   // Check the HTTP response code from the IF beam database server. If
   // it's not 200, then throw an exception (something went wrong).
@@ -93,7 +101,7 @@ int IFBeamDBInterface::QueryBeamDB(uint64_t t0,
   // this Wikipedia article: http://tinyurl.com/8yqvhwf
   long http_response_code;
   constexpr long HTTP_OK = 200;
-  curl_easy_getinfo(fCurl, CURLINFO_RESPONSE_CODE, &http_response_code);
+  curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_response_code);
   if (http_response_code != HTTP_OK) {
     throw std::runtime_error("HTTP error (code "
       + std::to_string(http_response_code) + ") encountered while querying"
@@ -133,6 +141,14 @@ int IFBeamDBInterface::QueryBeamDB(uint64_t t0,
 
 std::map<std::string, std::map<uint64_t, BeamDataPoint> >
   IFBeamDBInterface::ParseDBResponse(const std::string& response) const
+{
+  bool complete;
+  return ParseDBResponse(response, complete);
+}
+
+std::map<std::string, std::map<uint64_t, BeamDataPoint> >
+  IFBeamDBInterface::ParseDBResponse(const std::string& response,
+  bool& complete) const
 {
   // Create an empty map to store the parsed data.
   std::map<std::string, std::map<uint64_t,
@@ -151,6 +167,8 @@ std::map<std::string, std::map<uint64_t, BeamDataPoint> >
   // Skip the first line (which gives textual column headers)
   std::getline(response_stream, unit, '\n');
 
+  bool bad_record = false;
+
   // Parse each line of the response and load the map with the parsed data
   while (response_stream >> time_stamp) {
     response_stream.ignore(1);
@@ -159,12 +177,18 @@ std::map<std::string, std::map<uint64_t, BeamDataPoint> >
     response_stream >> value;
 
     // If there were any input problems, give up
-    if (!response_stream) break;
+    if (!response_stream) {
+      bad_record = true;
+      break;
+    }
 
     // Otherwise, load the new data into the map
     beam_data[data_type][time_stamp] = BeamDataPoint(value, unit);
   }
 
+  // Reading the time stamps only stops at the end of a complete response
+  complete = !bad_record && response_stream.eof();
+
   PostprocessParsedResponse(beam_data);
 
   return beam_data;
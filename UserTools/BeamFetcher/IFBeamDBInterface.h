@@ -67,6 +67,26 @@ class IFBeamDBInterface {
     int QueryBeamDB(uint64_t t0, uint64_t t1,
       std::string& response_string) const;
 
+    /// @brief Same as the query above, but through a caller-owned libcurl
+    /// handle, so that several queries may run on different threads
+    /// @param curl The libcurl easy handle to use for the query
+    /// @param url_start Query URL up to the time range (the IF beam database
+    /// if empty)
+    int QueryBeamDB(uint64_t t0, uint64_t t1,
+      std::string& response_string, CURL* curl,
+      const std::string& url_start) const;
+
+    /// @brief Parse a csv-format response from the IF beam database into
+    /// the nested map returned by QueryBeamDB
+    std::map<std::string, std::map<uint64_t, BeamDataPoint> >
+      ParseDBResponse(const std::string& response) const;
+
+    /// @brief Same as above
+    /// @param[out] complete False if parsing stopped before the end of the
+    /// response, at a line that is not a valid time,device,unit,value record
+    std::map<std::string, std::map<uint64_t, BeamDataPoint> >
+      ParseDBResponse(const std::string& response, bool& complete) const;
+
     /// @brief Get information about the BNB state from the database as close
     /// as possible to a given time
     /// @param time Timestamp (milliseconds since the Unix epoch) to use when
@@ -78,9 +98,6 @@ class IFBeamDBInterface {
     /// @brief Create the singleton IFBeamDBInterface object
     IFBeamDBInterface();
 
-    std::map<std::string, std::map<uint64_t, BeamDataPoint> >
-      ParseDBResponse(const std::string& response) const;
-
     void PostprocessParsedResponse(std::map<std::string,
       std::map<uint64_t, BeamDataPoint> >& parsed_response) const;
 
@@ -1,16 +1,6 @@
 #include "DigitBuilder.h"
 
 
-static DigitBuilder* fgDigitBuilder = 0;
-DigitBuilder* DigitBuilder::Instance()
-{
-  if( !fgDigitBuilder ){
-    fgDigitBuilder = new DigitBuilder();
-  }
-
-  return fgDigitBuilder;
-}
-
 DigitBuilder::DigitBuilder():Tool(){}
 DigitBuilder::~DigitBuilder() {
 }
@@ -26,7 +26,6 @@ class DigitBuilder: public Tool {
   bool Initialise(std::string configfile,DataModel &data);
   bool Execute();
   bool Finalise();
-  static DigitBuilder* Instance();
 
  private:
   /// \brief Build reconstructed object in ANNIEEvent
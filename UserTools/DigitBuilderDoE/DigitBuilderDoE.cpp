@@ -2,16 +2,6 @@
 
 using namespace ROOT::Math;
 
-static DigitBuilderDoE* fgDigitBuilderDoE = 0;
-DigitBuilderDoE* DigitBuilderDoE::Instance()
-{
-  if( !fgDigitBuilderDoE ){
-    fgDigitBuilderDoE = new DigitBuilderDoE();
-  }
-
-  return fgDigitBuilderDoE;
-}
-
 DigitBuilderDoE::DigitBuilderDoE():Tool(){}
 DigitBuilderDoE::~DigitBuilderDoE() {
 }
@@ -37,7 +37,6 @@ class DigitBuilderDoE: public Tool {
   bool Initialise(std::string configfile,DataModel &data);
   bool Execute();
   bool Finalise();
-  static DigitBuilderDoE* Instance();
 
  private:
   /// Reset the digit list and start muon vertex
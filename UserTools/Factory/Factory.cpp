@@ -1,6 +1,7 @@
 #include "Factory.h"
+#include "ProfiledTool.h"
 
-Tool* Factory(std::string tool) {
+static Tool* MakeTool(std::string tool) {
 Tool* ret=0;
 
 // if (tool=="Type") tool=new Type;
@@ -155,5 +156,12 @@ if (tool=="GetLAPPDEvents") ret=new GetLAPPDEvents;
 if (tool=="LAPPDDataDecoder") ret=new LAPPDDataDecoder;
 if (tool=="PythonScript") ret=new PythonScript;
 if (tool=="ChargedLeptonLikelihoodReco") ret=new ChargedLeptonLikelihoodReco;
+if (tool=="SaveIndexedANNIEEvent") ret=new SaveIndexedANNIEEvent;
+if (tool=="VtxFitBackendComparison") ret=new VtxFitBackendComparison;
 return ret;
 }
+
+Tool* Factory(std::string tool) {
+//Every tool goes through a ProfiledTool, which times it when ToolProfiling is on in the ToolChainConfig
+return ProfiledTool::Wrap(tool,MakeTool(tool));
+}
@@ -0,0 +1,62 @@
+#include "ProfiledTool.h"
+
+Tool* ProfiledTool::Wrap(const std::string &name, Tool *tool){
+  if(tool==0) return 0;
+  return new ProfiledTool(name,tool);
+}
+
+ProfiledTool::ProfiledTool(const std::string &name, Tool *tool):Tool(),Name(name),Wrapped(tool),Profiler(0),ProfilerIndex(-1){}
+
+ProfiledTool::~ProfiledTool(){
+  delete Wrapped;
+  Wrapped=0;
+}
+
+bool ProfiledTool::Initialise(std::string configfile, DataModel &data){
+
+  m_data= &data;
+
+  bool profiling=false;
+  m_data->vars.Get("ToolProfiling",profiling);
+  if(!profiling) return Wrapped->Initialise(configfile,data);
+
+  if(m_data->Profiler==0){
+    m_data->Profiler=new ToolProfiler();
+    m_data->Profiler->Configure(m_data->vars);
+  }
+  Profiler=m_data->Profiler;
+  ProfilerIndex=Profiler->AddTool(Name);
+
+  ToolProfiler::CallStart start=Profiler->Start();
+  bool ret=Wrapped->Initialise(configfile,data);
+  Profiler->Stop(ProfilerIndex,ToolProfiler::kInitialise,start,*m_data);
+  return ret;
+}
+
+
+bool ProfiledTool::Execute(){
+
+  if(Profiler==0) return Wrapped->Execute();
+
+  ToolProfiler::CallStart start=Profiler->Start();
+  bool ret=Wrapped->Execute();
+  Profiler->Stop(ProfilerIndex,ToolProfiler::kExecute,start,*m_data);
+  return ret;
+}
+
+
+bool ProfiledTool::Finalise(){
+
+  if(Profiler==0) return Wrapped->Finalise();
+
+  ToolProfiler::CallStart start=Profiler->Start();
+  bool ret=Wrapped->Finalise();
+  Profiler->Stop(ProfilerIndex,ToolProfiler::kFinalise,start,*m_data);
+  if(Profiler->ToolFinalised()){
+    Profiler->Report();
+    if(m_data->Profiler==Profiler) m_data->Profiler=0;
+    delete Profiler;
+  }
+  Profiler=0;
+  return ret;
+}
@@ -0,0 +1,43 @@
+#ifndef PROFILEDTOOL_H
+#define PROFILEDTOOL_H
+
+#include <string>
+
+#include "Tool.h"
+#include "ToolProfiler.h"
+
+/**
+ * \class ProfiledTool
+ *
+ * Wrapper that Factory() puts around every Tool it makes.  It forwards the Initialise,
+ * Execute and Finalise calls to the tool.  If ToolProfiling is on in the ToolChainConfig, it
+ * also hands each call's cost to the DataModel's ToolProfiler; otherwise the only cost is one
+ * extra call and a null pointer test.  The first wrapped tool to be initialised makes the
+ * profiler, and the last one to be finalised prints its report and deletes it.
+ */
+class ProfiledTool: public Tool {
+
+
+ public:
+
+  /// Wrap tool (owned from here on); returns 0 if tool is 0
+  static Tool* Wrap(const std::string &name, Tool *tool);
+
+  ProfiledTool(const std::string &name, Tool *tool);
+  ~ProfiledTool();
+  bool Initialise(std::string configfile,DataModel &data);
+  bool Execute();
+  bool Finalise();
+
+
+ private:
+
+  std::string Name;
+  Tool *Wrapped;
+  ToolProfiler *Profiler;
+  int ProfilerIndex;
+
+};
+
+
+#endif
@@ -1,24 +1,5 @@
 #include "HitCleaner.h"
 
-static HitCleaner* fgHitCleaner = 0;
-
-HitCleaner* HitCleaner::Instance()
-{
-  if( !fgHitCleaner ){
-    fgHitCleaner = new HitCleaner();
-  }
-
-  if( !fgHitCleaner ){
-    assert(fgHitCleaner);
-  }
-
-  if( fgHitCleaner ){
-
-  }
-
-  return fgHitCleaner;
-}
-
 HitCleaner::HitCleaner():Tool(){}
 	
 HitCleaner::~HitCleaner() {
@@ -212,46 +193,6 @@ bool HitCleaner::Finalise(){
   return true;
 }
 
-void HitCleaner::Config(int config)
-{
-  HitCleaner::Instance()->SetConfig(config);
-}
-
-void HitCleaner::PmtMinPulseHeight(double min)
-{
-  HitCleaner::Instance()->SetPmtMinPulseHeight(min);
-}
-  
-void HitCleaner::PmtNeighbourRadius(double radius)
-{
-  HitCleaner::Instance()->SetPmtNeighbourRadius(radius);
-}
-  
-void HitCleaner::PmtNeighbourDigits(int digits)
-{
-  HitCleaner::Instance()->SetPmtNeighbourDigits(digits);
-}
-  
-void HitCleaner::PmtClusterRadius(double radius)
-{
-  HitCleaner::Instance()->SetPmtClusterRadius(radius);
-}
-  
-void HitCleaner::MinClusterDigits(int digits)
-{
-  HitCleaner::Instance()->SetMinClusterDigits(digits);
-}
-  
-void HitCleaner::PmtTimeWindowN(double windowN)
-{
-  HitCleaner::Instance()->SetPmtTimeWindowNeighbours(windowN);
-}
-
-void HitCleaner::PmtTimeWindowC(double windowC)
-{
-  HitCleaner::Instance()->SetPmtTimeWindowClusters(windowC);
-}
-
 void HitCleaner::PrintParameters()
 {
   std::cout << " *** HitCleaner::PrintParameters() *** " << std::endl;
@@ -28,17 +28,6 @@ class HitCleaner: public Tool {
     kPulseHeightAndTruthInfo = 4
   } FilterConfig_t;
 
-  static HitCleaner* Instance();
-
-  static void Config(int config);
-  static void PmtMinPulseHeight(double min);
-  static void PmtNeighbourRadius(double radius);
-  static void PmtNeighbourDigits(int digits);
-  static void PmtClusterRadius(double radius);
-  static void MinClusterDigits(int digits);
-  static void PmtTimeWindowN(double windowN);
-  static void PmtTimeWindowC(double windowC);
-
   void PrintParameters();
 
   void SetConfig(int config)               { fConfig = config; }
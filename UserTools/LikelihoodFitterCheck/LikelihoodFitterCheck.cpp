@@ -25,6 +25,7 @@ bool LikelihoodFitterCheck::Initialise(std::string configfile, DataModel &data){
   m_data= &data; //assigning transient data pointer
   /////////////////////////////////////////////////////////////////
 
+  fRecoContext = new VertexRecoContext();
   return true;
 }
 
@@ -92,10 +93,9 @@ bool LikelihoodFitterCheck::Execute(){
   
   if(verbosity>0) cout<<"True vertex  = ("<<trueVtxX<<", "<<trueVtxY<<", "<<trueVtxZ<<", "<<trueVtxT<<", "<<trueDirX<<", "<<trueDirY<<", "<<trueDirZ<<")"<<endl;
   
-  FoMCalculator * myFoMCalculator = new FoMCalculator();
-  VertexGeometry* myvtxgeo = VertexGeometry::Instance();
-  myvtxgeo->LoadDigits(fDigitList);
-  myFoMCalculator->LoadVertexGeometry(myvtxgeo); //Load vertex geometry
+  fRecoContext->LoadDigits(fDigitList);
+  FoMCalculator * myFoMCalculator = fRecoContext->NewFoMCalculator();
+  VertexGeometry* myvtxgeo = fRecoContext->GetVertexGeometry();
   //parallel direction
   double dl = 1.0; // step size  = 1 cm along the track
   double dx = dl * trueDirX;
@@ -206,6 +206,7 @@ bool LikelihoodFitterCheck::Finalise(){
   gr_transverse->Write();
   fOutput_tfile->Write();
   fOutput_tfile->Close();
+  delete fRecoContext; fRecoContext = 0;
   Log("LikelihoodFitterCheck exitting", v_debug,verbosity);
   return true;
 }
@@ -10,6 +10,7 @@
 
 #include "FoMCalculator.h"
 #include "VertexGeometry.h"
+#include "VertexRecoContext.h"
 #include "Parameters.h"
 #include "TTree.h"
 
@@ -44,6 +45,8 @@ class LikelihoodFitterCheck: public Tool {
   int fShowEvent = 0;
   
  	std::vector<RecoDigit>* fDigitList = 0;
+ 	/// \brief digits and residuals of the fits of this tool
+ 	VertexRecoContext* fRecoContext = 0;
  	RecoVertex* fTrueVertex = 0;
  	
  	/// \brief histograms
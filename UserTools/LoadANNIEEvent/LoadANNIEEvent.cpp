@@ -1,9 +1,11 @@
 // standard library includes
 #include <fstream>
+#include <sstream>
 #include <string>
 
 // ToolAnalysis includes
 #include "LoadANNIEEvent.h"
+#include "IndexedANNIEEvent.h"
 
 LoadANNIEEvent::LoadANNIEEvent():Tool() {}
 
@@ -17,16 +19,36 @@ bool LoadANNIEEvent::Initialise(std::string config_filename, DataModel &data) {
   offset_evnum = 0;
 
   global_evnr = true;
-  FileFormat = "SeparateStores";	//Other option: "CombinedStore"
+  FileFormat = "SeparateStores";	//Other options: "CombinedStore", "Indexed"
   load_orphan_store = false;
+  std::string indexed_keys = "";
 
   m_variables.Get("verbose", verbosity_);
   m_variables.Get("EventOffset", offset_evnum);
   m_variables.Get("FileFormat",FileFormat);
   m_variables.Get("LoadOrphanStore",load_orphan_store);
   m_variables.Get("GlobalEvNr",global_evnr);
+  m_variables.Get("IndexedKeys",indexed_keys);
   global_ev = offset_evnum;
 
+  if (FileFormat != "SeparateStores" && FileFormat != "CombinedStore" && FileFormat != "Indexed"){
+    Log("Error: Unknown FileFormat "+FileFormat+" in the configuration for the"
+      " LoadANNIEEvent tool", 0, verbosity_);
+    return false;
+  }
+
+  std::stringstream ss_keys(indexed_keys);
+  std::string key;
+  while (std::getline(ss_keys, key, ',')){
+    if (key.empty()) continue;
+    if (!IsIndexedANNIEEventKey(key)){
+      Log("LoadANNIEEvent: Warning: IndexedKeys entry "+key+" is not a known ANNIEEvent key"
+        " and will not be loaded", v_warning, verbosity_);
+      continue;
+    }
+    indexed_keys_.push_back(key);
+  }
+
   std::string input_list_filename;
   bool got_input_file_list = m_variables.Get("FileForListOfInputs",
     input_list_filename);
@@ -47,7 +69,7 @@ bool LoadANNIEEvent::Initialise(std::string config_filename, DataModel &data) {
   std::string temp_str;
   while ( list_file >> temp_str ) input_filenames_.push_back( temp_str );
 
-  if (load_orphan_store && FileFormat == "SeparateStores"){
+  if (load_orphan_store && (FileFormat == "SeparateStores" || FileFormat == "Indexed")){
     std::string input_list_filename_orphan;
     bool got_input_file_list_orphan = m_variables.Get("FileForListOfInputsOrphan", input_list_filename_orphan);
     if (!got_input_file_list_orphan){
@@ -165,13 +187,20 @@ bool LoadANNIEEvent::Execute() {
         m_data->Stores.at("OrphanStore")->Header->Get("TotalEntries",
         total_orphans_in_file_);
       }
-    } else if (FileFormat == "SeparateStores"){
-      BoostStore *theANNIEEvent = new BoostStore(false,
-        BOOST_STORE_MULTIEVENT_FORMAT);
-      std::string input_filename = input_filenames_.at(current_file_);
-      theANNIEEvent->Initialise(input_filename);
-      m_data->Stores["ANNIEEvent"] = theANNIEEvent;
-      m_data->Stores.at("ANNIEEvent")->Header->Get("TotalEntries",total_entries_in_file_);
+    } else if (FileFormat == "SeparateStores" || FileFormat == "Indexed"){
+      if (FileFormat == "Indexed"){
+        if (!this->OpenIndexedFile()){
+          m_data->vars.Set("StopLoop",1);
+          return false;
+        }
+      } else {
+        BoostStore *theANNIEEvent = new BoostStore(false,
+          BOOST_STORE_MULTIEVENT_FORMAT);
+        std::string input_filename = input_filenames_.at(current_file_);
+        theANNIEEvent->Initialise(input_filename);
+        m_data->Stores["ANNIEEvent"] = theANNIEEvent;
+        m_data->Stores.at("ANNIEEvent")->Header->Get("TotalEntries",total_entries_in_file_);
+      }
       if (current_file_==0) {
         global_events.push_back(total_entries_in_file_);
         global_events_start.push_back(0);
@@ -190,6 +219,7 @@ bool LoadANNIEEvent::Execute() {
           total_orphans_in_file_);
       }
     }
+    m_data->CStore.Set("ANNIEEventInputFile",input_filenames_.at(current_file_));
   }
 
    bool user_event=false;
@@ -213,7 +243,7 @@ bool LoadANNIEEvent::Execute() {
          current_entry_ = user_evnum-global_events_start.at(current_file_);
          global_ev = user_evnum;
        } else {
-         // XXX note this loop is only suitable for SeparateStores format.
+         // XXX note this loop is only suitable for SeparateStores and Indexed formats.
          while (current_file_ < input_filenames_.size()){
            ++current_file_;
            if ( current_file_ >= input_filenames_.size() ) {
@@ -230,13 +260,21 @@ bool LoadANNIEEvent::Execute() {
              auto* annie_event = m_data->Stores.at("ANNIEEvent");
              if (annie_event) delete annie_event;
            }
-           m_data->Stores["ANNIEEvent"] = new BoostStore(false,
-             BOOST_STORE_MULTIEVENT_FORMAT);
-           std::string input_filename = input_filenames_.at(current_file_);
            std::cout <<"Reading in current file "<<current_file_<<std::endl;
-           m_data->Stores["ANNIEEvent"]->Initialise(input_filename);
-           m_data->Stores["ANNIEEvent"]->Header->Get("TotalEntries",
-             total_entries_in_file_);
+           if (FileFormat == "Indexed"){
+             if (!this->OpenIndexedFile()){
+               m_data->vars.Set("StopLoop",1);
+               return false;
+             }
+           } else {
+             m_data->Stores["ANNIEEvent"] = new BoostStore(false,
+               BOOST_STORE_MULTIEVENT_FORMAT);
+             std::string input_filename = input_filenames_.at(current_file_);
+             m_data->Stores["ANNIEEvent"]->Initialise(input_filename);
+             m_data->Stores["ANNIEEvent"]->Header->Get("TotalEntries",
+               total_entries_in_file_);
+           }
+           m_data->CStore.Set("ANNIEEventInputFile",input_filenames_.at(current_file_));
            global_events.push_back(global_events.at(current_file_-1)+total_entries_in_file_);
            global_events_start.push_back(global_events.at(current_file_-1));
            if (user_evnum >= global_events_start.at(current_file_) && user_evnum < global_events.at(current_file_)){
@@ -269,9 +307,14 @@ bool LoadANNIEEvent::Execute() {
     " ANNIEEvent input file \"" + input_filenames_.at(current_file_)
     + '\"', 1, verbosity_);
  
-  if ((int)current_entry_ != offset_evnum) m_data->Stores["ANNIEEvent"]->Delete();	//ensures that we can access pointers without problems
+  if (FileFormat == "Indexed"){
+    m_data->Stores["ANNIEEvent"]->Delete();
+    this->LoadIndexedEntry(current_entry_);
+  } else {
+    if ((int)current_entry_ != offset_evnum) m_data->Stores["ANNIEEvent"]->Delete();	//ensures that we can access pointers without problems
 
-  m_data->Stores["ANNIEEvent"]->GetEntry(current_entry_);  
+    m_data->Stores["ANNIEEvent"]->GetEntry(current_entry_);  
+  }
   m_data->Stores["ANNIEEvent"]->Set("LocalEventNumber",current_entry_);
   ++current_entry_;
  
@@ -297,5 +340,46 @@ bool LoadANNIEEvent::Execute() {
 
 
 bool LoadANNIEEvent::Finalise() {
+  // the CStore owns the reader and deletes it with the store, so it is only unmapped here
+  if (indexed_file_){
+    indexed_file_->Close();
+    indexed_file_ = nullptr;
+  }
+  return true;
+}
+
+bool LoadANNIEEvent::OpenIndexedFile() {
+
+  std::string input_filename = input_filenames_.at(current_file_);
+  // one reader serves all input files. It is put into the CStore once, and tools can use
+  // it to read keys that were not loaded, for the entry in the ANNIEEvent's LocalEventNumber
+  if (!indexed_file_){
+    indexed_file_ = new IndexedEventFile;
+    m_data->CStore.Set("IndexedANNIEEventFile",indexed_file_,false);
+  }
+  if (!indexed_file_->Open(input_filename)){
+    Log("LoadANNIEEvent Error! Could not open "+input_filename+" as an indexed ANNIEEvent file",
+      v_error, verbosity_);
+    return false;
+  }
+  total_entries_in_file_ = indexed_file_->NumEntries();
+
+  // the entries are set into the store one key at a time, so it has no file of its own
+  BoostStore *theANNIEEvent = new BoostStore(false, BOOST_STORE_MULTIEVENT_FORMAT);
+  theANNIEEvent->Header->Set("TotalEntries",total_entries_in_file_);
+  m_data->Stores["ANNIEEvent"] = theANNIEEvent;
   return true;
 }
+
+void LoadANNIEEvent::LoadIndexedEntry(size_t entry) {
+
+  BoostStore *annie_event = m_data->Stores["ANNIEEvent"];
+  const std::vector<std::string> keys = indexed_keys_.empty() ? indexed_file_->EntryKeys(entry) : indexed_keys_;
+  for (const std::string &key : keys){
+    if (!indexed_file_->Has(entry, key)) continue;   // not every entry has every key
+    if (!ReadANNIEEventKey(*indexed_file_, entry, key, *annie_event)){
+      Log("LoadANNIEEvent: Warning: Could not read key "+key+" of entry "+std::to_string(entry)
+        +" of "+indexed_file_->FileName(), v_warning, verbosity_);
+    }
+  }
+}
@@ -6,6 +6,7 @@
 
 // ToolAnalysis includes
 #include "Tool.h"
+#include "IndexedEventFile.h"
 
 class LoadANNIEEvent: public Tool {
 
@@ -26,6 +27,13 @@ class LoadANNIEEvent: public Tool {
 
   protected:
 
+    /// @brief Open input file current_file_ as an indexed ANNIEEvent file, and make a new
+    /// ANNIEEvent store for its entries
+    bool OpenIndexedFile();
+
+    /// @brief Set the keys to load of an entry of the indexed file in the ANNIEEvent store
+    void LoadIndexedEntry(size_t entry);
+
     /// @brief Integer code that determines the level of logging to show in
     /// the output
     int verbosity_;
@@ -34,9 +42,15 @@ class LoadANNIEEvent: public Tool {
     bool global_evnr = false;
     uint32_t global_ev;
 
-    /// @brief FileFormat of input file (combined ANNIEEvent+OrphanStore or separate stores)
+    /// @brief FileFormat of input file (combined ANNIEEvent+OrphanStore, separate stores or indexed)
     std::string FileFormat;
 
+    /// @brief Reader of the current input file for the Indexed FileFormat, owned by the CStore
+    IndexedEventFile* indexed_file_ = nullptr;
+
+    /// @brief ANNIEEvent keys loaded from indexed files; all keys of the entry if empty
+    std::vector<std::string> indexed_keys_;
+
     /// @brief Boolean whether OrphanStore should be accessed
     bool load_orphan_store;
 
@@ -1,4 +1,6 @@
 #include "LoadRawData.h"
+#include <sys/stat.h>
+#include <stdexcept>
 
 LoadRawData::LoadRawData():Tool(){}
 
@@ -14,6 +16,9 @@ bool LoadRawData::Initialise(std::string configfile, DataModel &data){
   readtrigoverlap = 0;
   storetrigoverlap = 0;
   storerawdata = true;
+  PrefetchDepth = 0;
+  PrefetchMemoryCapMB = 0;
+  EntriesPerExecute = 1;
 
   m_variables.Get("verbosity",verbosity);
   m_variables.Get("BuildType",BuildType);
@@ -23,6 +28,10 @@ bool LoadRawData::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("ReadTrigOverlap",readtrigoverlap);
   m_variables.Get("StoreTrigOverlap",storetrigoverlap);
   m_variables.Get("StoreRawData",storerawdata);
+  m_variables.Get("PrefetchDepth",PrefetchDepth);
+  m_variables.Get("PrefetchMemoryCapMB",PrefetchMemoryCapMB);
+  m_variables.Get("EntriesPerExecute",EntriesPerExecute);
+  if(EntriesPerExecute<1) EntriesPerExecute = 1;
 
   m_data= &data; //assigning transient data pointer
   
@@ -36,18 +45,18 @@ bool LoadRawData::Initialise(std::string configfile, DataModel &data){
     Log("LoadRawData tool: files to load have been organized.",v_message,verbosity);
   }
 
-  //RawDataObjects
-  RawData = new BoostStore(false,0);
-  PMTData = new BoostStore(false,2);
-  MRDData = new BoostStore(false,2);
-  TrigData = new BoostStore(false,2);
-  LAPPDData = new BoostStore(false,2);
+  //RawDataObjects; with prefetching, the prefetch thread makes them for every part
+  UsePrefetch = (Mode=="FileList" && PrefetchDepth>0 && OrganizedFileList.size()>0);
+  if(!UsePrefetch) this->NewRawDataStores();
 
   //RawDataEntryObjects
   Cdata = new std::vector<CardData>;
   Tdata = new TriggerData;
   Mdata = new MRDOut;
   Ldata = new PsecData;
+  CdataBatch = new std::vector<std::vector<CardData>>;
+  TdataBatch = new std::vector<TriggerData>;
+  MdataBatch = new std::vector<MRDOut>;
 
   FileNum = 0;
   TankEntryNum = 0;
@@ -60,6 +69,16 @@ bool LoadRawData::Initialise(std::string configfile, DataModel &data){
   TrigEntriesCompleted = false;
   LAPPDEntriesCompleted = false;
 
+  //Start opening the parts of the file list in the background
+  if(UsePrefetch){
+    Log("LoadRawData tool: Prefetching up to "+std::to_string(PrefetchDepth)+" parts in the background",v_message,verbosity);
+    StopPrefetch = false;
+    PrefetchThread = std::thread(&LoadRawData::PrefetchParts, this);
+  }
+
+  //Decoders downstream check this to know whether to read the single entry or the batch CStore objects
+  m_data->CStore.Set("RawDataEntriesPerExecute",EntriesPerExecute);
+
   m_data->CStore.Set("FileProcessingComplete",false);
   return true;
 }
@@ -73,7 +92,7 @@ bool LoadRawData::Execute(){
   bool ProcessingComplete = false;
   if(FileCompleted) ProcessingComplete = this->InitializeNewFile();
   if(ProcessingComplete) {
-    Log("LoadRawData Tool: All files have been processed.",v_message,verbosity);
+    LOG_LAZY("LoadRawData Tool: All files have been processed.",v_message,verbosity);
     m_data->CStore.Set("FileProcessingComplete",true);
     return true;
   }
@@ -90,7 +109,7 @@ bool LoadRawData::Execute(){
       if(verbosity>v_message) std::cout << "LoadRawData tool: Single file has already been loaded" << std::endl;
       return true;
     } else if (TankEntryNum==0 && MRDEntryNum == 0 && TrigEntryNum == 0){
-      Log("LoadRawData Tool: Loading Raw Data file as BoostStore",v_message,verbosity); 
+      LOG_LAZY("LoadRawData Tool: Loading Raw Data file as BoostStore",v_message,verbosity); 
       RawData->Initialise(InputFile.c_str());
       if(verbosity>4) RawData->Print(false);
       this->LoadRunInformation();
@@ -98,7 +117,7 @@ bool LoadRawData::Execute(){
       this->LoadTriggerData();
       this->LoadLAPPDData();
     } else {
-      Log("LoadRawData Tool: Continuing Raw Data file processing",v_message,verbosity); 
+      LOG_LAZY("LoadRawData Tool: Continuing Raw Data file processing",v_message,verbosity); 
     }
   } 
   
@@ -109,11 +128,19 @@ bool LoadRawData::Execute(){
       return false;
     }
     if(FileCompleted || CurrentFile=="NONE"){
-      Log("LoadRawData tool:   Moving to next file.",v_message,verbosity);
+      LOG_LAZY("LoadRawData tool:   Moving to next file.",v_message,verbosity);
       if(verbosity>v_warning) std::cout << "LoadRawData tool: Next file to load: "+OrganizedFileList.at(FileNum) << std::endl;
       CurrentFile = OrganizedFileList.at(FileNum);
-      Log("LoadRawData Tool: LoadingRaw Data file as BoostStore",v_debug,verbosity); 
-      RawData->Initialise(CurrentFile.c_str());
+      LOG_LAZY("LoadRawData Tool: LoadingRaw Data file as BoostStore",v_debug,verbosity); 
+      if(UsePrefetch){
+        if(!this->GetPrefetchedPart()){
+          Log("LoadRawData tool ERROR: Could not load file "+CurrentFile+"! Stopping toolchain",v_error,verbosity);
+          m_data->vars.Set("StopLoop",1);
+          return false;
+        }
+      } else {
+        RawData->Initialise(CurrentFile.c_str());
+      }
       std::cout <<"Got file"<<std::endl;
       m_data->CStore.Set("NewRawDataFileAccessed",true);
       if(verbosity>4) RawData->Print(false);
@@ -130,7 +157,7 @@ bool LoadRawData::Execute(){
   else if (Mode == "Processing"){
     std::string State;
     m_data->CStore.Get("State",State);
-    Log("LoadRawData tool: checking CStore for status of data stream",v_debug,verbosity);
+    LOG_LAZY("LoadRawData tool: checking CStore for status of data stream",v_debug,verbosity);
     if (State == "PMTSingle" || State == "Wait"){
       //Single event file available for monitoring; not relevant for this tool
       if (verbosity > v_message) std::cout <<"LoadRawData: State is "<<State<< ". No new full data file available" << std::endl;
@@ -152,7 +179,7 @@ bool LoadRawData::Execute(){
   }
 
   else if (Mode == "Monitoring"){
-    Log("LoadRawData tool: Monitoring mode not implemented!",v_warning,verbosity);
+    LOG_LAZY("LoadRawData tool: Monitoring mode not implemented!",v_warning,verbosity);
     return false;
   }
 
@@ -177,7 +204,7 @@ bool LoadRawData::Execute(){
       bool get_ok;
       // PMT:
       
-      std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > >* InProgressTankEvents=nullptr;
+      std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t> > >* InProgressTankEvents=nullptr;
       get_ok = m_data->CStore.Get("InProgressTankEvents",InProgressTankEvents);
       TimeClass tt;
       if (storerawdata){
@@ -225,7 +252,7 @@ bool LoadRawData::Execute(){
 
   // Unpause all other streams when any stream has read all of its events
   if(TankEntryNum == tanktotalentries){
-    Log("LoadRawData Tool: ALL PMT ENTRIES COLLECTED.",v_debug, verbosity);
+    LOG_LAZY("LoadRawData Tool: ALL PMT ENTRIES COLLECTED.",v_debug, verbosity);
     TankEntriesCompleted = true;
     TankPaused = true;
     if(MRDEntryNum < mrdtotalentries) MRDPaused = false;
@@ -233,7 +260,7 @@ bool LoadRawData::Execute(){
     if(LAPPDEntryNum < lappdtotalentries) LAPPDPaused = false;
   }
   if(MRDEntryNum == mrdtotalentries){
-    Log("LoadRawData Tool: ALL MRD ENTRIES COLLECTED.",v_debug, verbosity);
+    LOG_LAZY("LoadRawData Tool: ALL MRD ENTRIES COLLECTED.",v_debug, verbosity);
     MRDEntriesCompleted = true;
     MRDPaused = true;
     if(TankEntryNum < tanktotalentries) TankPaused = false;
@@ -241,7 +268,7 @@ bool LoadRawData::Execute(){
     if(LAPPDEntryNum < lappdtotalentries) LAPPDPaused = false;
   }
   if(TrigEntryNum == trigtotalentries){
-    Log("LoadRawData Tool: ALL TRIG ENTRIES COLLECTED.",v_debug, verbosity);
+    LOG_LAZY("LoadRawData Tool: ALL TRIG ENTRIES COLLECTED.",v_debug, verbosity);
     TrigEntriesCompleted = true;
     CTCPaused = true;
     if(TankEntryNum < tanktotalentries) TankPaused = false;
@@ -249,7 +276,7 @@ bool LoadRawData::Execute(){
     if(LAPPDEntryNum < lappdtotalentries) LAPPDPaused = false;
   }
   if(LAPPDEntryNum == lappdtotalentries){
-    Log("LoadRawData Tool: ALL LAPPD ENTRIES COLLECTED.",v_debug, verbosity);
+    LOG_LAZY("LoadRawData Tool: ALL LAPPD ENTRIES COLLECTED.",v_debug, verbosity);
     LAPPDEntriesCompleted = true;
     LAPPDPaused = true;
     if(TrigEntryNum < trigtotalentries) CTCPaused = false;
@@ -257,7 +284,7 @@ bool LoadRawData::Execute(){
     if(MRDEntryNum < mrdtotalentries) MRDPaused = false;
   }
   if (LAPPDEntryNum == lappdtotalentries){
-    Log("LoadRawData Tool: ALL LAPPD ENTRIES COLLECTED.",v_debug, verbosity);
+    LOG_LAZY("LoadRawData Tool: ALL LAPPD ENTRIES COLLECTED.",v_debug, verbosity);
     LAPPDEntriesCompleted = true;
     LAPPDPaused = true;
     if(TankEntryNum < tanktotalentries) TankPaused = false;
@@ -270,7 +297,8 @@ bool LoadRawData::Execute(){
   m_data->CStore.Set("PauseLAPPDDecoding",LAPPDPaused);
 
   //Get next data entries; are saved to CStore for tools downstream
-  this->GetNextDataEntries();
+  if(EntriesPerExecute>1) this->GetNextDataEntryBatches();
+  else this->GetNextDataEntries();
 
   //Set if the raw data file has been completed
   if (TankEntriesCompleted && BuildType == "Tank") FileCompleted = true;
@@ -287,26 +315,30 @@ bool LoadRawData::Execute(){
 
   m_data->CStore.Set("NewRawDataEntryAccessed",true);
   m_data->CStore.Set("FileCompleted",FileCompleted);
-  Log("LoadRawData tool: execution loop complete.",v_debug,verbosity);
+  LOG_LAZY("LoadRawData tool: execution loop complete.",v_debug,verbosity);
   return true;
 }
 
 
 bool LoadRawData::Finalise(){
-  RawData->Close();
-  RawData->Delete();
-  delete RawData;
-  if (BuildType == "Tank" || BuildType == "TankAndMRD" || BuildType == "TankAndMRDAndCTC" || BuildType == "TankAndCTC" || BuildType == "TankAndMRDAndCTCAndLAPPD"){
+  this->StopPrefetchThread();
+  //with prefetching, the stores are missing when the chain stopped between two parts
+  if(RawData){
+    RawData->Close();
+    RawData->Delete();
+    delete RawData;
+  }
+  if (PMTData && (BuildType == "Tank" || BuildType == "TankAndMRD" || BuildType == "TankAndMRDAndCTC" || BuildType == "TankAndCTC" || BuildType == "TankAndMRDAndCTCAndLAPPD")){
     PMTData->Close();
     PMTData->Delete();
     delete PMTData;
   }
-  if (BuildType == "MRD" || BuildType == "TankAndMRD" || BuildType == "MRDAndCTC" || BuildType == "TankAndMRDAndCTC" || BuildType == "TankAndMRDAndCTCAndLAPPD"){
+  if (MRDData && (BuildType == "MRD" || BuildType == "TankAndMRD" || BuildType == "MRDAndCTC" || BuildType == "TankAndMRDAndCTC" || BuildType == "TankAndMRDAndCTCAndLAPPD")){
     MRDData->Close();
     MRDData->Delete();
     delete MRDData;
   }
-  if (BuildType == "TankAndMRDAndCTCAndLAPPD"){
+  if (LAPPDData && BuildType == "TankAndMRDAndCTCAndLAPPD"){
     LAPPDData->Close();
     LAPPDData->Delete();
     delete LAPPDData;
@@ -349,7 +381,7 @@ void LoadRawData::LoadRunInformation(){
 void LoadRawData::LoadPMTMRDData(){
   if((BuildType == "TankAndMRD") || (BuildType == "Tank") || (BuildType == "TankAndMRDAndCTC") || (BuildType == "TankAndCTC") || (BuildType == "TankAndMRDAndCTCAndLAPPD")){
     Log("LoadRawData Tool: Accessing PMT Data in raw data",v_message,verbosity);
-    RawData->Get("PMTData",*PMTData);
+    if(!SubStoresPrefetched) RawData->Get("PMTData",*PMTData);
     PMTData->Header->Get("TotalEntries",tanktotalentries);
     Log("LoadRawData Tool: PMTData has "+std::to_string(tanktotalentries)+" entries",v_debug,verbosity);
     if(verbosity>3) PMTData->Print(false);
@@ -359,7 +391,7 @@ void LoadRawData::LoadPMTMRDData(){
   }
   if((BuildType == "TankAndMRD") || (BuildType == "MRD") || (BuildType == "TankAndMRDAndCTC") || (BuildType == "MRDAndCTC") || (BuildType == "TankAndMRDAndCTCAndLAPPD")){
     Log("LoadRawData Tool: Accessing MRD Data in raw data",v_message,verbosity);
-    RawData->Get("CCData",*MRDData);
+    if(!SubStoresPrefetched) RawData->Get("CCData",*MRDData);
     MRDData->Header->Get("TotalEntries",mrdtotalentries);
     Log("LoadRawData Tool: MRDData has "+std::to_string(mrdtotalentries)+" entries",v_debug,verbosity);
     if(verbosity>3) MRDData->Print(false);
@@ -369,7 +401,7 @@ void LoadRawData::LoadPMTMRDData(){
 
 void LoadRawData::LoadTriggerData(){
   Log("LoadRawData Tool: Accessing Trigger Data in raw data",v_message,verbosity);
-  RawData->Get("TrigData",*TrigData);
+  if(!SubStoresPrefetched) RawData->Get("TrigData",*TrigData);
   if(verbosity>3) TrigData->Print(false);
   TrigData->Header->Get("TotalEntries",trigtotalentries);
   if (readtrigoverlap) {
@@ -393,7 +425,8 @@ void LoadRawData::LoadLAPPDData(){
   if((BuildType == "TankAndMRDAndCTCAndLAPPD")){
     Log("LoadRawData Tool: Accessing LAPPD Data in raw data",v_message,verbosity);
     try{
-      RawData->Get("LAPPDData",*LAPPDData);
+      if(!SubStoresPrefetched) RawData->Get("LAPPDData",*LAPPDData);
+      else if(!PrefetchedLAPPD) throw std::runtime_error("LAPPDData not found by prefetch thread");
       LAPPDData->Header->Get("TotalEntries",lappdtotalentries);
       if(verbosity>3) LAPPDData->Print(false);
      } catch (...) {
@@ -485,11 +518,13 @@ std::vector<std::string> LoadRawData::OrganizeRunParts(std::string FileList)
 bool LoadRawData::InitializeNewFile(){
   bool EndOfProcessing = false;
   FileNum += 1;
-  RawData->Close(); RawData->Delete(); delete RawData; RawData = new BoostStore(false,0);
-MRDData->Close(); MRDData->Delete(); delete MRDData; MRDData = new BoostStore(false,2);
-TrigData->Close(); TrigData->Delete(); delete TrigData; TrigData = new BoostStore(false,2);
-  PMTData->Close(); PMTData->Delete(); delete PMTData; PMTData = new BoostStore(false,2);
-  LAPPDData->Close(); LAPPDData->Delete(); delete LAPPDData; LAPPDData = new BoostStore(false,2);
+  RawData->Close(); RawData->Delete(); delete RawData; RawData = nullptr;
+MRDData->Close(); MRDData->Delete(); delete MRDData; MRDData = nullptr;
+TrigData->Close(); TrigData->Delete(); delete TrigData; TrigData = nullptr;
+  PMTData->Close(); PMTData->Delete(); delete PMTData; PMTData = nullptr;
+  LAPPDData->Close(); LAPPDData->Delete(); delete LAPPDData; LAPPDData = nullptr;
+  //the next part brings its own stores when it was prefetched
+  if(!UsePrefetch) this->NewRawDataStores();
 
   TankEntryNum = 0;
   MRDEntryNum = 0;
@@ -505,25 +540,26 @@ TrigData->Close(); TrigData->Delete(); delete TrigData; TrigData = new BoostStor
   m_data->CStore.Set("PauseLAPPDDecoding",false);
 
   if(Mode == "SingleFile"){
-    Log("LoadRawData Tool: Single file parsed.  Ending toolchain after this loop.",v_message, verbosity);
+    LOG_LAZY("LoadRawData Tool: Single file parsed.  Ending toolchain after this loop.",v_message, verbosity);
     m_data->vars.Set("StopLoop",1);
     EndOfProcessing = true;
   }
   if(Mode == "FileList" && FileNum == int(OrganizedFileList.size())){
-    Log("LoadRawData Tool: Full file list parsed.  Ending toolchain after this loop.",v_message, verbosity);
+    LOG_LAZY("LoadRawData Tool: Full file list parsed.  Ending toolchain after this loop.",v_message, verbosity);
     m_data->vars.Set("StopLoop",1);
     EndOfProcessing = true;
+    this->StopPrefetchThread();
   }
   //No need to stop the loop in continous mode
   if (Mode == "Continous"){
-    Log("MRDDataDecoder Tool: Full raw file parsed. Waiting until next raw file is available.",v_message,verbosity);
+    LOG_LAZY("MRDDataDecoder Tool: Full raw file parsed. Waiting until next raw file is available.",v_message,verbosity);
   }
 
   return EndOfProcessing;
 }
 
 void LoadRawData::GetNextDataEntries(){
-  std::cout <<"BuildType: "<<BuildType<<std::endl;
+  LOG_LAZY("LoadRawData Tool: BuildType is "+BuildType,v_debug,verbosity);
   //Get next PMTData Entry
   if(BuildType == "Tank" || BuildType == "TankAndMRD" || BuildType == "TankAndMRDAndCTC" || BuildType == "TankAndCTC" || BuildType == "TankAndMRDAndCTCAndLAPPD"){
     if(!TankPaused && !TankEntriesCompleted){
@@ -538,13 +574,13 @@ void LoadRawData::GetNextDataEntries(){
         }
       }
       if (load_data){
-        Log("LoadRawData Tool: Procesing PMTData Entry "+to_string(TankEntryNum)+"/"+to_string(tanktotalentries),v_debug, verbosity);
+        LOG_LAZY("LoadRawData Tool: Procesing PMTData Entry "+to_string(TankEntryNum)+"/"+to_string(tanktotalentries),v_debug, verbosity);
         PMTData->GetEntry(TankEntryNum);
-        Log("LoadRawData Tool: Getting the PMT card data entry",v_debug, verbosity);
+        LOG_LAZY("LoadRawData Tool: Getting the PMT card data entry",v_debug, verbosity);
         PMTData->Get("CardData",*Cdata);
-        Log("LoadRawData Tool: Setting PMT card data entry into CStore",v_debug, verbosity);
+        LOG_LAZY("LoadRawData Tool: Setting PMT card data entry into CStore",v_debug, verbosity);
         m_data->CStore.Set("CardData",Cdata);
-        Log("LoadRawData Tool: Setting Tank Entry Num CStore",v_debug, verbosity);
+        LOG_LAZY("LoadRawData Tool: Setting Tank Entry Num CStore",v_debug, verbosity);
         m_data->CStore.Set("TankEntryNum",TankEntryNum);
         TankEntryNum+=1;
       }
@@ -554,7 +590,7 @@ void LoadRawData::GetNextDataEntries(){
   //Get next MRDData Entry
   if(BuildType == "MRD" || BuildType == "TankAndMRD" || BuildType == "TankAndMRDAndCTC" || BuildType == "MRDAndCTC" || BuildType == "TankAndMRDAndCTCAndLAPPD"){
     if(!MRDPaused && !MRDEntriesCompleted){
-      Log("LoadRawData Tool: Procesing CCData Entry "+to_string(MRDEntryNum)+"/"+to_string(mrdtotalentries),v_debug, verbosity);
+      LOG_LAZY("LoadRawData Tool: Procesing CCData Entry "+to_string(MRDEntryNum)+"/"+to_string(mrdtotalentries),v_debug, verbosity);
       MRDData->GetEntry(MRDEntryNum);
       MRDData->Get("Data",*Mdata);
       m_data->CStore.Set("MRDData",Mdata,true);
@@ -565,7 +601,7 @@ void LoadRawData::GetNextDataEntries(){
   //Get next LAPPDData Entry
   if (BuildType == "TankAndMRDAndCTCAndLAPPD"){
     if (!LAPPDPaused && !LAPPDEntriesCompleted){
-      Log("LoadRawData Tool: Processing LAPPDData Entry "+to_string(LAPPDEntryNum)+"/"+to_string(lappdtotalentries),v_debug,verbosity);
+      LOG_LAZY("LoadRawData Tool: Processing LAPPDData Entry "+to_string(LAPPDEntryNum)+"/"+to_string(lappdtotalentries),v_debug,verbosity);
       LAPPDData->GetEntry(LAPPDEntryNum);
       LAPPDData->Get("LAPPDData",*Ldata);
       m_data->CStore.Set("LAPPDData",Ldata,true);
@@ -575,7 +611,7 @@ void LoadRawData::GetNextDataEntries(){
 
   //Get next TrigData Entry
   if((BuildType == "TankAndMRDAndCTC" || BuildType == "TankAndCTC" || BuildType == "MRDAndCTC" || BuildType == "CTC" || BuildType == "TankAndMRDAndCTCAndLAPPD") && !TrigEntriesCompleted && !CTCPaused){
-    Log("LoadRawData Tool: Procesing TrigData Entry "+to_string(TrigEntryNum)+"/"+to_string(trigtotalentries),v_debug, verbosity);
+    LOG_LAZY("LoadRawData Tool: Procesing TrigData Entry "+to_string(TrigEntryNum)+"/"+to_string(trigtotalentries),v_debug, verbosity);
     if (storetrigoverlap && TrigEntryNum == 0 && extract_part != 0){
       TrigData->GetEntry(TrigEntryNum);
       TrigData->Get("TrigData",*Tdata);
@@ -608,7 +644,7 @@ void LoadRawData::GetNextDataEntries(){
 
   //Get next LAPPDData Entry
   if(BuildType == "LAPPD" || BuildType == "TankAndLAPPD" || BuildType == "MRDAndLAPPD" || BuildType == "TankAndMRDAndLAPPD" || BuildType == "TankAndMRDAndLAPPDAndCTC"){
-        Log("LoadRawData Tool: Processing LAPPDData Entry "+to_string(LAPPDEntryNum)+"/"+to_string(lappdtotalentries),v_debug,verbosity);
+        LOG_LAZY("LoadRawData Tool: Processing LAPPDData Entry "+to_string(LAPPDEntryNum)+"/"+to_string(lappdtotalentries),v_debug,verbosity);
         LAPPDData->GetEntry(LAPPDEntryNum);
         LAPPDData->Get("LAPPDData", *Ldata);
         m_data->CStore.Set("LAPPDData", Ldata);
@@ -657,3 +693,231 @@ int LoadRawData::GetPartFromFilename(){
   return extracted_part;
 
 }
+
+void LoadRawData::PrefetchParts(){
+
+  for(int i_file=0; i_file < (int) OrganizedFileList.size(); i_file++){
+    RawDataPart part;
+    part.FileName = OrganizedFileList.at(i_file);
+    //On-disk size of the part is used as estimate of its memory footprint
+    struct stat filestat;
+    if(stat(part.FileName.c_str(),&filestat)==0) part.Bytes = filestat.st_size;
+
+    //Wait until there is room for another part; always allow one part so a single
+    //part above the memory cap cannot stall the toolchain
+    {
+      std::unique_lock<std::mutex> lock(PrefetchMutex);
+      PrefetchCV.wait(lock,[this,&part]{
+        if(StopPrefetch || PrefetchedParts.empty()) return true;
+        if((int) PrefetchedParts.size() >= PrefetchDepth) return false;
+        if(PrefetchMemoryCapMB > 0 && (PrefetchedBytes+part.Bytes)/1048576. > PrefetchMemoryCapMB) return false;
+        return true;
+      });
+      if(StopPrefetch) return;
+    }
+
+    part.LoadOK = this->ReadRawDataPart(part);
+
+    {
+      std::lock_guard<std::mutex> lock(PrefetchMutex);
+      PrefetchedParts.push_back(part);
+      PrefetchedBytes += part.Bytes;
+    }
+    PrefetchCV.notify_all();
+  }
+}
+
+bool LoadRawData::ReadRawDataPart(RawDataPart &part){
+
+  //Executed on the prefetch thread: no logging, only BoostStores owned by this part are touched
+  part.RawData = new BoostStore(false,0);
+  part.PMTData = new BoostStore(false,2);
+  part.MRDData = new BoostStore(false,2);
+  part.TrigData = new BoostStore(false,2);
+  part.LAPPDData = new BoostStore(false,2);
+
+  try{
+    if(!part.RawData->Initialise(part.FileName.c_str())) return false;
+    if((BuildType == "TankAndMRD") || (BuildType == "Tank") || (BuildType == "TankAndMRDAndCTC") || (BuildType == "TankAndCTC") || (BuildType == "TankAndMRDAndCTCAndLAPPD")){
+      part.RawData->Get("PMTData",*part.PMTData);
+    }
+    if((BuildType == "TankAndMRD") || (BuildType == "MRD") || (BuildType == "TankAndMRDAndCTC") || (BuildType == "MRDAndCTC") || (BuildType == "TankAndMRDAndCTCAndLAPPD")){
+      part.RawData->Get("CCData",*part.MRDData);
+    }
+    part.RawData->Get("TrigData",*part.TrigData);
+    if(BuildType == "TankAndMRDAndCTCAndLAPPD"){
+      try{
+        part.LAPPDLoaded = part.RawData->Get("LAPPDData",*part.LAPPDData);
+      } catch (...) {
+        part.LAPPDLoaded = false;
+      }
+    }
+  } catch (...) {
+    return false;
+  }
+  return true;
+}
+
+bool LoadRawData::GetPrefetchedPart(){
+
+  RawDataPart part;
+  {
+    std::unique_lock<std::mutex> lock(PrefetchMutex);
+    PrefetchCV.wait(lock,[this]{ return !PrefetchedParts.empty(); });
+    part = PrefetchedParts.front();
+    PrefetchedParts.pop_front();
+    PrefetchedBytes -= part.Bytes;
+  }
+  PrefetchCV.notify_all();
+
+  //the chain stops on a part that can't be used, so the parts after it aren't needed
+  if(part.FileName != CurrentFile){
+    Log("LoadRawData tool ERROR: Prefetched part "+part.FileName+" does not match expected file "+CurrentFile,v_error,verbosity);
+    this->DeleteRawDataPart(part);
+    this->StopPrefetchThread();
+    return false;
+  }
+  if(!part.LoadOK){
+    this->DeleteRawDataPart(part);
+    this->StopPrefetchThread();
+    return false;
+  }
+  //the thread is done once it has handed over the last part of the list
+  if(FileNum == int(OrganizedFileList.size())-1) this->StopPrefetchThread();
+
+  //The active stores were released by InitializeNewFile (or never made in Initialise)
+  RawData = part.RawData;
+  PMTData = part.PMTData;
+  MRDData = part.MRDData;
+  TrigData = part.TrigData;
+  LAPPDData = part.LAPPDData;
+  SubStoresPrefetched = true;
+  PrefetchedLAPPD = part.LAPPDLoaded;
+  return true;
+}
+
+void LoadRawData::StopPrefetchThread(){
+  if(!PrefetchThread.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(PrefetchMutex);
+    StopPrefetch = true;
+  }
+  PrefetchCV.notify_all();
+  PrefetchThread.join();
+  for(RawDataPart &part : PrefetchedParts) this->DeleteRawDataPart(part);
+  PrefetchedParts.clear();
+  PrefetchedBytes = 0;
+}
+
+void LoadRawData::NewRawDataStores(){
+  RawData = new BoostStore(false,0);
+  PMTData = new BoostStore(false,2);
+  MRDData = new BoostStore(false,2);
+  TrigData = new BoostStore(false,2);
+  LAPPDData = new BoostStore(false,2);
+}
+
+void LoadRawData::DeleteRawDataPart(RawDataPart &part){
+  if(part.RawData){ part.RawData->Close(); part.RawData->Delete(); delete part.RawData; part.RawData = nullptr; }
+  if(part.PMTData){ part.PMTData->Close(); part.PMTData->Delete(); delete part.PMTData; part.PMTData = nullptr; }
+  if(part.MRDData){ part.MRDData->Close(); part.MRDData->Delete(); delete part.MRDData; part.MRDData = nullptr; }
+  if(part.TrigData){ part.TrigData->Close(); part.TrigData->Delete(); delete part.TrigData; part.TrigData = nullptr; }
+  if(part.LAPPDData){ part.LAPPDData->Close(); part.LAPPDData->Delete(); delete part.LAPPDData; part.LAPPDData = nullptr; }
+}
+
+void LoadRawData::GetNextDataEntryBatches(){
+  //Same stream logic as GetNextDataEntries, but each unpaused stream publishes a
+  //contiguous block of up to EntriesPerExecute entries as one vector.  Pausing is
+  //therefore applied at batch granularity.
+
+  //Get next block of PMTData entries
+  if(BuildType == "Tank" || BuildType == "TankAndMRD" || BuildType == "TankAndMRDAndCTC" || BuildType == "TankAndCTC" || BuildType == "TankAndMRDAndCTCAndLAPPD"){
+    if(!TankPaused && !TankEntriesCompleted){
+      CdataBatch->clear();
+      int FirstTankEntry = TankEntryNum;
+      while((int)CdataBatch->size() < EntriesPerExecute && TankEntryNum < tanktotalentries){
+        if (!storerawdata){
+          //Add one additional Execute loop in case we want to save Hits information during Event Building
+          if (TankEntryNum == tanktotalentries - 2) m_data->CStore.Set("LastEntry",true);
+          else if (TankEntryNum == tanktotalentries -1){
+            //The extra loop only happens once all real entries have been handed over
+            if (CdataBatch->size()==0){
+              TankEntryNum+=1;
+              m_data->CStore.Set("PauseTankDecoding",true);
+            }
+            break;
+          }
+        }
+        PMTData->GetEntry(TankEntryNum);
+        CdataBatch->emplace_back();
+        PMTData->Get("CardData",CdataBatch->back());
+        TankEntryNum+=1;
+      }
+      if(CdataBatch->size()>0){
+        LOG_LAZY("LoadRawData Tool: Procesing PMTData Entries "+to_string(FirstTankEntry)+"-"+to_string(TankEntryNum-1)+"/"+to_string(tanktotalentries),v_debug, verbosity);
+        m_data->CStore.Set("CardDataBatch",CdataBatch);
+        m_data->CStore.Set("TankEntryNum",TankEntryNum-1);
+      }
+    }
+  }
+
+  //Get next block of MRDData entries
+  if(BuildType == "MRD" || BuildType == "TankAndMRD" || BuildType == "TankAndMRDAndCTC" || BuildType == "MRDAndCTC" || BuildType == "TankAndMRDAndCTCAndLAPPD"){
+    if(!MRDPaused && !MRDEntriesCompleted){
+      MdataBatch->clear();
+      LOG_LAZY("LoadRawData Tool: Procesing CCData Entries starting at "+to_string(MRDEntryNum)+"/"+to_string(mrdtotalentries),v_debug, verbosity);
+      while((int)MdataBatch->size() < EntriesPerExecute && MRDEntryNum < mrdtotalentries){
+        MRDData->GetEntry(MRDEntryNum);
+        MdataBatch->emplace_back();
+        MRDData->Get("Data",MdataBatch->back());
+        MRDEntryNum+=1;
+      }
+      m_data->CStore.Set("MRDDataBatch",MdataBatch,true);
+    }
+  }
+
+  //LAPPD entries are not decoded in batches; keep the one entry per Execute behaviour
+  if (BuildType == "TankAndMRDAndCTCAndLAPPD"){
+    if (!LAPPDPaused && !LAPPDEntriesCompleted){
+      LOG_LAZY("LoadRawData Tool: Processing LAPPDData Entry "+to_string(LAPPDEntryNum)+"/"+to_string(lappdtotalentries),v_debug,verbosity);
+      LAPPDData->GetEntry(LAPPDEntryNum);
+      LAPPDData->Get("LAPPDData",*Ldata);
+      m_data->CStore.Set("LAPPDData",Ldata,true);
+      LAPPDEntryNum+=1;
+    }
+  }
+
+  //Get next block of TrigData entries
+  if((BuildType == "TankAndMRDAndCTC" || BuildType == "TankAndCTC" || BuildType == "MRDAndCTC" || BuildType == "CTC" || BuildType == "TankAndMRDAndCTCAndLAPPD") && !TrigEntriesCompleted && !CTCPaused){
+    TdataBatch->clear();
+    LOG_LAZY("LoadRawData Tool: Procesing TrigData Entries starting at "+to_string(TrigEntryNum)+"/"+to_string(trigtotalentries),v_debug, verbosity);
+    while((int)TdataBatch->size() < EntriesPerExecute && TrigEntryNum < trigtotalentries){
+      TdataBatch->emplace_back();
+      TriggerData &aTdata = TdataBatch->back();
+      if (storetrigoverlap && TrigEntryNum == 0 && extract_part != 0){
+        TrigData->GetEntry(TrigEntryNum);
+        TrigData->Get("TrigData",aTdata);
+        BoostStore StoreTrigOverlap;
+        std::stringstream ss_trigoverlap;
+        ss_trigoverlap << "TrigOverlap_R"<<extract_run<<"S"<<extract_subrun<<"p"<<extract_part-1;
+        if(verbosity>v_message) std::cout <<"Trig Overlap file: "<<ss_trigoverlap.str()<<std::endl;
+        StoreTrigOverlap.Initialise(ss_trigoverlap.str().c_str());
+        TriggerData TdataStore = aTdata;
+        StoreTrigOverlap.Set("TrigData",TdataStore);
+        StoreTrigOverlap.Save(ss_trigoverlap.str().c_str());
+      } else if (!readtrigoverlap || TrigEntryNum != trigtotalentries-1){
+        TrigData->GetEntry(TrigEntryNum);
+        TrigData->Get("TrigData",aTdata);
+      } else {
+        BoostStore ReadTrigOverlap;
+        std::stringstream ss_trigoverlap;
+        ss_trigoverlap << "TrigOverlap_R"<<extract_run<<"S"<<extract_subrun<<"p"<<extract_part;
+        ReadTrigOverlap.Initialise(ss_trigoverlap.str().c_str());
+        ReadTrigOverlap.Get("TrigData",aTdata);
+      }
+      TrigEntryNum+=1;
+    }
+    m_data->CStore.Set("TrigDataBatch",TdataBatch);
+  }
+  return;
+}
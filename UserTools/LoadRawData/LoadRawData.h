@@ -3,8 +3,13 @@
 
 #include <string>
 #include <iostream>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "Tool.h"
+#include "LazyLog.h"
 #include "CardData.h"
 #include "TriggerData.h"
 #include "PsecData.h"
@@ -12,6 +17,24 @@
 #include "Store.h"
 #include "PsecData.h"
 
+/**
+ * \struct RawDataPart
+ *
+ * Holds the BoostStores of one raw data part that has been opened and deserialized
+ * by the prefetch thread, ready to be swapped into LoadRawData on file roll-over.
+ */
+struct RawDataPart {
+  std::string FileName;
+  uintmax_t Bytes = 0;
+  BoostStore *RawData = nullptr;
+  BoostStore *PMTData = nullptr;
+  BoostStore *MRDData = nullptr;
+  BoostStore *TrigData = nullptr;
+  BoostStore *LAPPDData = nullptr;
+  bool LAPPDLoaded = false;
+  bool LoadOK = false;
+};
+
 /**
  * \class LoadRawData
  *
@@ -35,10 +58,17 @@ class LoadRawData: public Tool {
   void LoadLAPPDData(); 
   void LoadRunInformation();
   void GetNextDataEntries();
+  void GetNextDataEntryBatches(); ///< Batch mode version of GetNextDataEntries: loads up to EntriesPerExecute entries per stream
   bool InitializeNewFile(); 
   int GetRunFromFilename();
   int GetSubRunFromFilename();
   int GetPartFromFilename();
+  void PrefetchParts(); ///< Prefetch thread loop: opens upcoming parts of the file list in the background
+  bool ReadRawDataPart(RawDataPart &part); ///< Open one raw data part and deserialize the sub-stores needed for BuildType
+  bool GetPrefetchedPart(); ///< Swap the next prefetched part into the active BoostStores
+  void DeleteRawDataPart(RawDataPart &part);
+  void StopPrefetchThread(); ///< Stop and join the prefetch thread, and delete the parts it still holds
+  void NewRawDataStores(); ///< Make empty active BoostStores for a part read on the main thread
 
  private:
 
@@ -52,6 +82,7 @@ class LoadRawData: public Tool {
   bool readtrigoverlap;
   bool storetrigoverlap;
   bool storerawdata;
+  int EntriesPerExecute = 1; //Number of entries per stream published in one Execute; >1 enables the batch CStore entries
 
   int FileNum = 0;
   int tanktotalentries;
@@ -68,6 +99,19 @@ class LoadRawData: public Tool {
   int TrigEntryNum = 0;
   int LAPPDEntryNum = 0;
 
+  //Background prefetching of upcoming parts in FileList mode
+  bool UsePrefetch = false;       //FileList mode with PrefetchDepth>0: the parts are read by the prefetch thread
+  int PrefetchDepth = 0;          //Number of parts to hold ready beyond the current one (0 = disabled)
+  double PrefetchMemoryCapMB = 0; //Upper limit on the on-disk size of all prefetched parts (<=0 = no limit)
+  std::thread PrefetchThread;
+  std::mutex PrefetchMutex;
+  std::condition_variable PrefetchCV;
+  std::deque<RawDataPart> PrefetchedParts;
+  uintmax_t PrefetchedBytes = 0;
+  bool StopPrefetch = false;
+  bool SubStoresPrefetched = false; //Sub-stores of the active part were already read by the prefetch thread
+  bool PrefetchedLAPPD = false;
+
   //Run / Subrun / part info
   int extract_run;
   int extract_subrun;
@@ -91,6 +135,11 @@ class LoadRawData: public Tool {
   MRDOut* Mdata = nullptr;
   PsecData* Ldata = nullptr;
 
+  //Batch mode entry objects (EntriesPerExecute > 1)
+  std::vector<std::vector<CardData>>* CdataBatch = nullptr;
+  std::vector<TriggerData>* TdataBatch = nullptr;
+  std::vector<MRDOut>* MdataBatch = nullptr;
+
   int verbosity;
   int v_error=0;
   int v_warning=1;
@@ -24,8 +24,11 @@ bool MRDDataDecoder::Initialise(std::string configfile, DataModel &data){
 
   if (verbosity > 0) std::cout <<"MRDDataDecoder: TimeZoneShift: "<<TimeZoneShift<<std::endl;
 
-  m_data->CStore.Get("MRDCrateSpaceToChannelNumMap",MRDCrateSpaceToChannelNumMap);
+  std::map<std::vector<int>,int> MRDCrateSpaceMap;
+  m_data->CStore.Get("MRDCrateSpaceToChannelNumMap",MRDCrateSpaceMap);
+  MRDCrateSpaceToChannelNumMap = PackCrateSpaceMap(MRDCrateSpaceMap);
   m_data->CStore.Set("NewMRDDataAvailable",false);
+  m_data->CStore.Get("RawDataEntriesPerExecute",RawDataEntriesPerExecute);
 
   m_data->CStore.Set("PauseMRDDecoding",false);
   Log("MRDDataDecoder Tool: Initialized successfully",v_message,verbosity);
@@ -53,51 +56,17 @@ bool MRDDataDecoder::Execute(){
 
 
   /////////////////// getting MRD Data ////////////////////
-  Log("MRDDataDecoder Tool: Accessing MRDData from CStore",v_message,verbosity); 
-  m_data->CStore.Get("MRDData",mrddata);
-  std::string mrdTriggertype = "No Loopback";
-  std::vector<unsigned long> chankeys;
-  uint64_t timestamp = static_cast<uint64_t>(mrddata->TimeStamp);    //in ms since 1970/1/1
-  // before anything else convert it to UTC ns
-  timestamp = (timestamp+TimeZoneShift)*1E6;
-  std::vector<std::pair<unsigned long, int>> ChankeyTimePairs;
-  MRDEvents.emplace(timestamp,ChankeyTimePairs);
-  
-  bool cosmic_loopback = false;
-  bool beam_loopback = false;
-  int cosmic_tdc = -1;
-  int beam_tdc = -1;
-  std::vector<int> CrateSlotChannel_Beam{7,11,15};
-  std::vector<int> CrateSlotChannel_Cosmic{7,11,14};
-    
-  //For each entry, loop over all crates and get data
-  for (unsigned int i_data = 0; i_data < mrddata->Crate.size(); i_data++){
-    int crate = mrddata->Crate.at(i_data);
-    int slot = mrddata->Slot.at(i_data);
-    int channel = mrddata->Channel.at(i_data);
-    int hittimevalue = mrddata->Value.at(i_data);
-    std::vector<int> CrateSlotChannel{crate,slot,channel};
-    unsigned long chankey = 999;
-    if (MRDCrateSpaceToChannelNumMap.find(CrateSlotChannel) != MRDCrateSpaceToChannelNumMap.end()){
-      chankey = MRDCrateSpaceToChannelNumMap[CrateSlotChannel];
-    }
-    //std::cout <<"crate: "<<crate<<", slot: "<<slot<<", channel: "<<channel<<", chankey: "<<chankey<<std::endl;
-    if (CrateSlotChannel != CrateSlotChannel_Beam && CrateSlotChannel != CrateSlotChannel_Cosmic && chankey != 999){
-      std::pair <unsigned long,int> keytimepair(chankey,hittimevalue);  //chankey will be 0 when looking at loopback channels that don't have an entry in the mapping-->skip
-      MRDEvents[timestamp].push_back(keytimepair);
+  if(RawDataEntriesPerExecute>1){
+    Log("MRDDataDecoder Tool: Accessing MRDData batch from CStore",v_message,verbosity); 
+    m_data->CStore.Get("MRDDataBatch",mrddatabatch);
+    for (unsigned int i_entry = 0; i_entry < mrddatabatch->size(); i_entry++){
+      this->DecodeMRDEntry(&mrddatabatch->at(i_entry));
     }
-    if (crate == 7 && slot == 11 && channel == 14) {cosmic_loopback=true; cosmic_tdc = hittimevalue;}   //FIXME: don't hard-code the trigger channels?
-    if (crate == 7 && slot == 11 && channel == 15) {beam_loopback=true; beam_tdc = hittimevalue;}     //FIXME: don't hard-code the trigger channels?
+  } else {
+    Log("MRDDataDecoder Tool: Accessing MRDData from CStore",v_message,verbosity); 
+    m_data->CStore.Get("MRDData",mrddata);
+    this->DecodeMRDEntry(mrddata);
   }
-  
-  if (beam_loopback) mrdTriggertype = "Beam";
-  if (cosmic_loopback) mrdTriggertype = "Cosmic";      //prefer cosmic loopback over beam loopback (cosmic event will always also have a beam loopback entry)
-
-  CosmicLoopbackMap.emplace(timestamp,cosmic_tdc);
-  BeamLoopbackMap.emplace(timestamp,beam_tdc);
-
-  //Entry processing done.  Label the trigger type and increment index
-  TriggerTypeMap.emplace(timestamp,mrdTriggertype);
 
   //MRD Data file fully processed.   
   //Push the map of TriggerTypeMap and FinishedMRDHits 
@@ -143,3 +112,50 @@ bool MRDDataDecoder::Finalise(){
   Log("MRDDataDecoder tool exitting",v_message,verbosity);
   return true;
 }
+
+void MRDDataDecoder::DecodeMRDEntry(MRDOut* mrdentry){
+  std::string mrdTriggertype = "No Loopback";
+  std::vector<unsigned long> chankeys;
+  uint64_t timestamp = static_cast<uint64_t>(mrdentry->TimeStamp);    //in ms since 1970/1/1
+  // before anything else convert it to UTC ns
+  timestamp = (timestamp+TimeZoneShift)*1E6;
+  std::vector<std::pair<unsigned long, int>> ChankeyTimePairs;
+  MRDEvents.emplace(timestamp,ChankeyTimePairs);
+  
+  bool cosmic_loopback = false;
+  bool beam_loopback = false;
+  int cosmic_tdc = -1;
+  int beam_tdc = -1;
+  const CrateSlotChannelKey CrateSlotChannel_Beam = MakeCrateSlotChannelKey(7,11,15);
+  const CrateSlotChannelKey CrateSlotChannel_Cosmic = MakeCrateSlotChannelKey(7,11,14);
+    
+  //For each entry, loop over all crates and get data
+  for (unsigned int i_data = 0; i_data < mrdentry->Crate.size(); i_data++){
+    int crate = mrdentry->Crate.at(i_data);
+    int slot = mrdentry->Slot.at(i_data);
+    int channel = mrdentry->Channel.at(i_data);
+    int hittimevalue = mrdentry->Value.at(i_data);
+    CrateSlotChannelKey CrateSlotChannel = MakeCrateSlotChannelKey(crate,slot,channel);
+    unsigned long chankey = 999;
+    std::unordered_map<CrateSlotChannelKey,int>::const_iterator it_chankey = MRDCrateSpaceToChannelNumMap.find(CrateSlotChannel);
+    if (it_chankey != MRDCrateSpaceToChannelNumMap.end()){
+      chankey = it_chankey->second;
+    }
+    //std::cout <<"crate: "<<crate<<", slot: "<<slot<<", channel: "<<channel<<", chankey: "<<chankey<<std::endl;
+    if (CrateSlotChannel != CrateSlotChannel_Beam && CrateSlotChannel != CrateSlotChannel_Cosmic && chankey != 999){
+      std::pair <unsigned long,int> keytimepair(chankey,hittimevalue);  //chankey will be 0 when looking at loopback channels that don't have an entry in the mapping-->skip
+      MRDEvents[timestamp].push_back(keytimepair);
+    }
+    if (crate == 7 && slot == 11 && channel == 14) {cosmic_loopback=true; cosmic_tdc = hittimevalue;}   //FIXME: don't hard-code the trigger channels?
+    if (crate == 7 && slot == 11 && channel == 15) {beam_loopback=true; beam_tdc = hittimevalue;}     //FIXME: don't hard-code the trigger channels?
+  }
+  
+  if (beam_loopback) mrdTriggertype = "Beam";
+  if (cosmic_loopback) mrdTriggertype = "Cosmic";      //prefer cosmic loopback over beam loopback (cosmic event will always also have a beam loopback entry)
+
+  CosmicLoopbackMap.emplace(timestamp,cosmic_tdc);
+  BeamLoopbackMap.emplace(timestamp,beam_tdc);
+
+  //Entry processing done.  Label the trigger type and increment index
+  TriggerTypeMap.emplace(timestamp,mrdTriggertype);
+}
@@ -11,6 +11,7 @@
 #include "TriggerData.h"
 #include "BoostStore.h"
 #include "Store.h"
+#include "CardChannelKey.h"
 
 /**
  * \class MRDDataDecoder
@@ -34,12 +35,15 @@ class MRDDataDecoder: public Tool {
   bool Initialise(std::string configfile,DataModel &data); ///< Initialise Function for setting up Tool resources. @param configfile The path and name of the dynamic configuration file to read in. @param data A reference to the transient data class used to pass information between Tools.
   bool Execute(); ///< Execute function used to perform Tool purpose.
   bool Finalise(); ///< Finalise function used to clean up resources.
+  void DecodeMRDEntry(MRDOut* mrdentry); ///< Fill the MRD event and loopback maps from one CCData entry
 
  private:
 
   MRDOut* mrddata=nullptr;
+  std::vector<MRDOut>* mrddatabatch=nullptr;
+  int RawDataEntriesPerExecute = 1;  //Set by LoadRawData; >1 means CCData entries arrive as a batch
   //Map used to relate MRD Crate Space value to channel key
-  std::map<std::vector<int>,int> MRDCrateSpaceToChannelNumMap;
+  std::unordered_map<CrateSlotChannelKey,int> MRDCrateSpaceToChannelNumMap;  //Key: CrateSlotChannelKey(crate,slot,channel), value: MRD channel key
 
   //Maps that store completed waveforms from cards
   std::map<uint64_t, std::vector<std::pair<unsigned long, int> > > MRDEvents;  //Key: {MTCTime}, value: "WaveMap" with key (CardID,ChannelID), value FinishedWaveform
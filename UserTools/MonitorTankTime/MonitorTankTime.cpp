@@ -242,6 +242,12 @@ bool MonitorTankTime::Execute(){
     //-------------------------------------------------------
 
     //get FinishedPMTWaves from DataDecoder tools
+    int TankWaveKeyVersion = 1;
+    m_data->CStore.Get("TankWaveKeyVersion",TankWaveKeyVersion);
+    if (TankWaveKeyVersion != TANK_WAVE_KEY_VERSION){
+      Log("MonitorTankTime ERROR: FinishedPMTWaves key version "+std::to_string(TankWaveKeyVersion)+" does not match expected version "+std::to_string(TANK_WAVE_KEY_VERSION)+". Is an up-to-date PMTDataDecoder running upstream?",v_error,verbosity);
+      return false;
+    }
     m_data->CStore.Get("FinishedPMTWaves",FinishedPMTWaves);
     this->LoopThroughDecodedEvents(FinishedPMTWaves);
 
@@ -951,7 +957,7 @@ void MonitorTankTime::InitializeHists(){
 
 }
 
-void MonitorTankTime::LoopThroughDecodedEvents(std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t>>> finishedPMTWaves){
+void MonitorTankTime::LoopThroughDecodedEvents(std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t>>> &finishedPMTWaves){
 
   Log("MonitorTankTime: LoopThroughDecodedEvents",v_message,verbosity);
 
@@ -972,7 +978,7 @@ void MonitorTankTime::LoopThroughDecodedEvents(std::map<uint64_t, std::map<std::
   int num_samples_first_brf=0;
 
   int i_timestamp = 0;
-  for (std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t>>>::iterator it = finishedPMTWaves.begin(); it != finishedPMTWaves.end(); it++){
+  for (std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t>>>::iterator it = finishedPMTWaves.begin(); it != finishedPMTWaves.end(); it++){
 
     uint64_t timestamp = it->first;
     uint64_t timestamp_temp = timestamp - utc_to_fermi;			//conversion from UTC time to Fermilab US time
@@ -992,12 +998,12 @@ void MonitorTankTime::LoopThroughDecodedEvents(std::map<uint64_t, std::map<std::
     channels_mean.assign(num_active_slots*num_channels_tank,0.);
     channels_sigma.assign(num_active_slots*num_channels_tank,0.);
 
-    std::map<std::vector<int>, std::vector<uint16_t>> afinishedPMTWaves = finishedPMTWaves.at(timestamp);
-    for(std::pair<std::vector<int>, std::vector<uint16_t>> apair : afinishedPMTWaves){
+    const std::map<CardChannelKey, std::vector<uint16_t>> &afinishedPMTWaves = it->second;
+    for(const std::pair<const CardChannelKey, std::vector<uint16_t>> &apair : afinishedPMTWaves){
 
-      int CardID = apair.first.at(0);
-      int ChannelID = apair.first.at(1);
-      std::vector<uint16_t> awaveform = apair.second;
+      int CardID = CardIDFromKey(apair.first);
+      int ChannelID = ChannelIDFromKey(apair.first);
+      const std::vector<uint16_t> &awaveform = apair.second;
       int num_samples = int(awaveform.size()) - 50;
       int CrateNum, SlotNum;
       this->CardIDToElectronicsSpace(CardID, CrateNum, SlotNum);
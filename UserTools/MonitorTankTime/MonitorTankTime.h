@@ -10,6 +10,7 @@
 #include <BoostStore.h>
 #include <CardData.h>
 #include <TriggerData.h>
+#include <CardChannelKey.h>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/date_time/gregorian/gregorian.hpp>
 
@@ -60,7 +61,7 @@ class MonitorTankTime: public Tool {
   //configuration and initialization functions
   void ReadInConfiguration();
   void InitializeHists(); ///< Function to initialize all histograms and canvases
-  void LoopThroughDecodedEvents(std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t>>> finishedPMTWaves);
+  void LoopThroughDecodedEvents(std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t>>> &finishedPMTWaves);
   void WriteToFile();
   void ReadFromFile(ULong64_t timestamp_end, double time_frame);
 
@@ -117,7 +118,7 @@ class MonitorTankTime: public Tool {
 
   
   //CStore variables
-  std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > > FinishedPMTWaves;  //MCT, vector<int,int>{crate,slot}, vector<int>{waveform]
+  std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t> > > FinishedPMTWaves;  //MCT, CardChannelKey(CardID,ChannelID), vector<int>{waveform]
   std::map<std::vector<int>,int>* PMTCrateSpaceToChannelNumMap = nullptr;
 
 
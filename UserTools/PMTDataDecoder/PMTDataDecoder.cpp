@@ -1,5 +1,9 @@
 #include "PMTDataDecoder.h"
 
+//DecoderLog that only builds the message (and takes the log lock) if it will be printed
+#define DECODER_LOG_LAZY(message,level) \
+  do { if((level)<=verbosity) this->DecoderLog((message),(level)); } while(0)
+
 PMTDataDecoder::PMTDataDecoder():Tool(){}
 
 
@@ -18,6 +22,8 @@ bool PMTDataDecoder::Initialise(std::string configfile, DataModel &data){
   Mode = "Offline";
   OffsetVME03 = false;
   OffsetPositive = true;
+  UseLegacyDecoder = false;
+  DecoderThreads = 1;
 
   m_variables.Get("verbosity",verbosity);
   m_variables.Get("Mode",Mode);
@@ -26,6 +32,9 @@ bool PMTDataDecoder::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("OffsetVME03",OffsetVME03);
   m_variables.Get("OffsetVME01",OffsetVME01);
   m_variables.Get("OffsetPositive",OffsetPositive);
+  m_variables.Get("UseLegacyDecoder",UseLegacyDecoder);
+  m_variables.Get("DecoderThreads",DecoderThreads);
+  if (DecoderThreads < 1) DecoderThreads = 1;
 
   if (Mode != "Monitoring" && Mode != "Offline") Mode = "Offline";
   if (Mode == "Monitoring") PMTData = new BoostStore(false,2);
@@ -38,9 +47,19 @@ bool PMTDataDecoder::Initialise(std::string configfile, DataModel &data){
   CurrentSubrunNum = -1;
   // Initialize RawData
 
-  FinishedPMTWaves = new std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > >; 
-  FIFOPMTWaves = new std::map<uint64_t, std::map<std::vector<int>, int > >; 
-  TimestampsFromTheFuture = new std::map<uint64_t,std::map<std::vector<int>,uint64_t>>;
+  FinishedPMTWaves = new std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t> > >; 
+  FIFOPMTWaves = new std::map<uint64_t, std::map<CardChannelKey, int > >; 
+  TimestampsFromTheFuture = new std::map<uint64_t,std::map<CardChannelKey,uint64_t>>;
+  //Wave maps are keyed by CardChannelKey; let downstream tools check they read the same layout
+  m_data->CStore.Set("TankWaveKeyVersion",TANK_WAVE_KEY_VERSION);
+
+  m_data->CStore.Get("RawDataEntriesPerExecute",RawDataEntriesPerExecute);
+
+  //Worker pool for decoding the cards of an entry in parallel
+  StopPool = false;
+  for (int i=0; i<DecoderThreads && DecoderThreads>1; i++){
+    DecoderPool.push_back(std::thread(&PMTDataDecoder::DecoderWorker,this));
+  }
 
   m_data->CStore.Set("PauseTankDecoding",false);
   m_data->CStore.Set("FIFOError1",fifo1);
@@ -52,7 +71,7 @@ bool PMTDataDecoder::Initialise(std::string configfile, DataModel &data){
 
 
 bool PMTDataDecoder::Execute(){
-  Log("PMTDataDecoder Tool: Executing",v_debug, verbosity);
+  LOG_LAZY("PMTDataDecoder Tool: Executing",v_debug, verbosity);
   NewWavesBuilt = false;
   //Set in CStore that there's currently no new tank data available
   m_data->CStore.Set("NewTankPMTDataAvailable",false);
@@ -66,7 +85,7 @@ bool PMTDataDecoder::Execute(){
    
     std::string State;
     m_data->CStore.Get("State",State);
-    Log("PMTDataDecoder tool: checking CStore for status of data stream",v_debug,verbosity);
+    LOG_LAZY("PMTDataDecoder tool: checking CStore for status of data stream",v_debug,verbosity);
     if (State == "Wait" || State == "MRDSingle"){
       if (verbosity > v_message) std::cout <<"PMTDataDecoder: State is "<<State<< ". No new full data file available" << std::endl;
       return true; 
@@ -88,8 +107,7 @@ bool PMTDataDecoder::Execute(){
       fifo1.clear();
       fifo2.clear();
       SequenceMap.clear();
-      TriggerTimeBank.clear();
-      WaveBank.clear();
+      this->ClearWaveBanks();
       
       /*NumPMTDataProcessed = 0;
       int ExecuteEntryNum = 0;
@@ -106,60 +124,56 @@ bool PMTDataDecoder::Execute(){
       }
   
       while((ExecuteEntryNum < EntriesToDo) && (CDEntryNum<totalentries)){
-	      Log("PMTDataDecoder Tool: Procesing PMTData Entry "+to_string(CDEntryNum),v_debug, verbosity);
+	      LOG_LAZY("PMTDataDecoder Tool: Procesing PMTData Entry "+to_string(CDEntryNum),v_debug, verbosity);
     	  PMTData->GetEntry(CDEntryNum);
     	  PMTData->Get("CardData",Cdata_old);*/
 	    
+      //The whole file is collected into decoding tasks first, so that the cards can be
+      //decoded in parallel when DecoderThreads > 1
+      std::vector<CardDecodeTask> CardTasks;
 	     std::map<int,std::vector<CardData>>::iterator it;
         for (it=CardData_Map.begin(); it!= CardData_Map.end(); it++){
             int CDEntryNum = it->first;
-            std::vector<CardData> Cdata_old = it->second;
+            std::vector<CardData> &Cdata_old = it->second;
             //std::cout <<"CDEntryNum: "<<CDEntryNum<<", CData vector size: "<<Cdata_old.size()<<std::endl;
 
-	      Log("PMTDataDecoder Tool: entry has #CardData classes = "+to_string(Cdata_old.size()),v_debug, verbosity);
+	      LOG_LAZY("PMTDataDecoder Tool: entry has #CardData classes = "+to_string(Cdata_old.size()),v_debug, verbosity);
         for (unsigned int CardDataIndex=0; CardDataIndex<Cdata_old.size(); CardDataIndex++){
           if(verbosity>v_debug){
             std::cout<<"PMTDataDecoder Tool: Loading next CardData from entry's index " << CardDataIndex <<std::endl;
             std::cout<<"PMTDataDecoder Tool: CardData's CardID="<<Cdata_old.at(CardDataIndex).CardID<<std::endl;
             std::cout<<"PMTDataDecoder Tool: CardData's data vector size="<<Cdata_old.at(CardDataIndex).Data.size()<<std::endl;
           }
-          CardData aCardData = Cdata_old.at(CardDataIndex);
+          CardData &aCardData = Cdata_old.at(CardDataIndex);
           //Check if card experienced any data loss
           FIFOstate = 0;
           FIFOstate = aCardData.FIFOstate;
           if(FIFOstate == 1){  //FIFO overflow
-            Log("PMTDataDecoder Tool: WARNING FIFO Overflow on card ID"+to_string(aCardData.CardID),v_warning,verbosity);
+            LOG_LAZY("PMTDataDecoder Tool: WARNING FIFO Overflow on card ID"+to_string(aCardData.CardID),v_warning,verbosity);
             fifo1.push_back(aCardData.CardID);
           }
           if(FIFOstate == 2){  //FIFO overflow and error clearing overvlow
-            Log("PMTDataDecoder Tool: WARNING Failure to clear FIFO Overflow on card ID"+to_string(aCardData.CardID),v_warning,verbosity);
+            LOG_LAZY("PMTDataDecoder Tool: WARNING Failure to clear FIFO Overflow on card ID"+to_string(aCardData.CardID),v_warning,verbosity);
             fifo2.push_back(aCardData.CardID);
           }
-          Log("PMTDataDecoder Tool:  CardData has SequenceID... "+to_string(aCardData.SequenceID),v_debug, verbosity);
+          LOG_LAZY("PMTDataDecoder Tool:  CardData has SequenceID... "+to_string(aCardData.SequenceID),v_debug, verbosity);
           bool IsNextInSequence = this->CheckIfCardNextInSequence(aCardData);
           if (!IsNextInSequence) {
-            Log("PMTDataDecoder Tool WARNING: CardData found OUT OF SEQUENCE!!!",v_warning, verbosity);
-            Log("PMTDataDecoder Tool:  OOS CardID... " +
+            LOG_LAZY("PMTDataDecoder Tool WARNING: CardData found OUT OF SEQUENCE!!!",v_warning, verbosity);
+            LOG_LAZY("PMTDataDecoder Tool:  OOS CardID... " +
                     to_string(aCardData.CardID),v_warning, verbosity);
-            Log("PMTDataDecoder Tool:  OOS SequenceID... " + 
+            LOG_LAZY("PMTDataDecoder Tool:  OOS SequenceID... " + 
                     to_string(aCardData.SequenceID),v_warning, verbosity);
           }
 
-          //Decode raw binary data frames
-          std::vector<DecodedFrame> ThisCardDFs;
-          ThisCardDFs = this->DecodeFrames(aCardData.Data);
-          if(ThisCardDFs.size() == 0) Log("PMTDataDecoder Tool:  CardData object has no data. ",v_debug, verbosity);
-          else{
-            // Parse each decoded frame's data stream and frame header 
-            for (unsigned int i=0; i < ThisCardDFs.size(); i++){
-              this->ParseFrame(aCardData.CardID,ThisCardDFs.at(i));
-            }
-          }
+          //Queue raw binary data frames for decoding
+          this->AddCardDecodeTask(aCardData,CardTasks);
 	}
-        Log("PMTDataDecoder Tool: PMTData Entry "+to_string(CDEntryNum)+" processed",v_debug, verbosity);
+        LOG_LAZY("PMTDataDecoder Tool: PMTData Entry "+to_string(CDEntryNum)+" queued",v_debug, verbosity);
         //ExecuteEntryNum += 1; 
         //CDEntryNum+=1; 
       }
+      this->DecodeCardTasks(CardTasks);
         
       CStorePMTWaves = *FinishedPMTWaves;
       m_data->CStore.Set("FinishedPMTWaves",CStorePMTWaves);
@@ -169,7 +183,7 @@ bool PMTDataDecoder::Execute(){
       
       FinishedPMTWaves->clear(); 
 
-      Log("PMTDataDecoder Tool: Current raw data file parsed. Waiting until next file is produced",v_message,verbosity);
+      LOG_LAZY("PMTDataDecoder Tool: Current raw data file parsed. Waiting until next file is produced",v_message,verbosity);
     
       return true;
     } else {
@@ -183,7 +197,7 @@ bool PMTDataDecoder::Execute(){
     bool NewEntryAvailable;
     m_data->CStore.Get("NewRawDataEntryAccessed",NewEntryAvailable);
     if(!NewEntryAvailable){ //Something went wrong processing raw data.  Stop and save what's left
-      Log("PMTDataDecoder Tool: There's no new PMT data.  Things would crash if we continue.  Stopping at next loop to save what data has been built.",v_warning,verbosity); 
+      LOG_LAZY("PMTDataDecoder Tool: There's no new PMT data.  Things would crash if we continue.  Stopping at next loop to save what data has been built.",v_warning,verbosity); 
       m_data->vars.Set("StopLoop",1);
       return true;
     }
@@ -213,21 +227,19 @@ bool PMTDataDecoder::Execute(){
       CurrentSubrunNum = SubRunNumber;
     }
     else if (RunNumber != CurrentRunNum){ //New run has been encountered
-      Log("PMTDataDecoder Tool: New run encountered.  Clearing event building maps",v_message,verbosity); 
+      LOG_LAZY("PMTDataDecoder Tool: New run encountered.  Clearing event building maps",v_message,verbosity); 
       fifo1.clear();
       fifo2.clear();
       SequenceMap.clear();
-      TriggerTimeBank.clear();
-      WaveBank.clear();
+      this->ClearWaveBanks();
       CurrentRunNum = RunNumber;
     }
     else if (SubRunNumber != CurrentSubrunNum){ //New subrun has been encountered
-      Log("PMTDataDecoder Tool: New subrun encountered.",v_message,verbosity); 
+      LOG_LAZY("PMTDataDecoder Tool: New subrun encountered.",v_message,verbosity); 
       fifo1.clear();
       fifo2.clear();
       SequenceMap.clear();
-      TriggerTimeBank.clear();
-      WaveBank.clear();
+      this->ClearWaveBanks();
       CurrentSubrunNum = SubRunNumber;
     }
     bool NewRawDataFile = false;
@@ -238,54 +250,26 @@ bool PMTDataDecoder::Execute(){
       SequenceMap.clear();  //New part file has been encountered
     }
 
-    Log("PMTDataDecoder Tool: Procesing PMTData Entry from CStore",v_debug, verbosity);
-    m_data->CStore.Get("CardData",Cdata);
-    Log("PMTDataDecoder Tool: entry has #CardData classes = "+to_string(Cdata->size()),v_debug, verbosity);
-    
     //Get current state of FIFO overflows
     m_data->CStore.Get("FIFOError1",fifo1);
     m_data->CStore.Get("FIFOError2",fifo2);
 
-    for (unsigned int CardDataIndex=0; CardDataIndex<Cdata->size(); CardDataIndex++){
-      CardData aCardData = Cdata->at(CardDataIndex);
-      if(verbosity>v_debug){
-        std::cout<<"PMTDataDecoder Tool: Loading next CardData from entry's index " << CardDataIndex <<std::endl;
-        std::cout<<"PMTDataDecoder Tool: CardData's CardID="<<aCardData.CardID<<std::endl;
-        std::cout<<"PMTDataDecoder Tool: CardData's data vector size="<<aCardData.Data.size()<<std::endl;
-      }
-      //Check if card experienced any data loss
-      FIFOstate = 0;
-      FIFOstate = aCardData.FIFOstate;
-      if(FIFOstate == 1){  //FIFO overflow
-        Log("PMTDataDecoder Tool: WARNING FIFO Overflow on card ID"+to_string(aCardData.CardID),v_error,verbosity);
-        fifo1.push_back(aCardData.CardID);
-      }
-      if(FIFOstate == 2){  //FIFO overflow and error clearing overvlow
-        Log("PMTDataDecoder Tool: WARNING Failure to clear FIFO Overflow on card ID"+to_string(aCardData.CardID),v_error,verbosity);
-        fifo2.push_back(aCardData.CardID);
-      }
-      Log("PMTDataDecoder Tool:  CardData has SequenceID... "+to_string(aCardData.SequenceID),v_debug, verbosity);
-      bool IsNextInSequence = this->CheckIfCardNextInSequence(aCardData);
-      if (!IsNextInSequence) {
-        Log("PMTDataDecoder Tool WARNING: CardData found OUT OF SEQUENCE!!!",v_warning, verbosity);
-        Log("PMTDataDecoder Tool:  OOO CardID... " +
-                to_string(aCardData.CardID),v_warning, verbosity);
-        Log("PMTDataDecoder Tool:  OOO SequenceID... " + 
-                to_string(aCardData.SequenceID),v_warning, verbosity);
-      }
-      
-      //Decode raw binary frames
-      std::vector<DecodedFrame> ThisCardDFs;
-      ThisCardDFs = this->DecodeFrames(aCardData.Data);
-      if(ThisCardDFs.size() == 0) Log("PMTDataDecoder Tool:  CardData object has no data. ",v_debug, verbosity);
-      else{
-        // Parse each decoded frame's data stream and frame header 
-        for (unsigned int i=0; i < ThisCardDFs.size(); i++){
-          this->ParseFrame(aCardData.CardID,ThisCardDFs.at(i));
-        }
+    if(RawDataEntriesPerExecute>1){
+      LOG_LAZY("PMTDataDecoder Tool: Procesing batch of PMTData Entries from CStore",v_debug, verbosity);
+      m_data->CStore.Get("CardDataBatch",CdataBatch);
+      LOG_LAZY("PMTDataDecoder Tool: batch has #PMTData entries = "+to_string(CdataBatch->size()),v_debug, verbosity);
+      //Decode the whole batch at once to give the DecoderThreads pool more cards per pass
+      std::vector<CardDecodeTask> CardTasks;
+      for (unsigned int EntryIndex=0; EntryIndex<CdataBatch->size(); EntryIndex++){
+        this->AddCardDecodeTasks(CdataBatch->at(EntryIndex),CardTasks);
       }
+      this->DecodeCardTasks(CardTasks);
+    } else {
+      LOG_LAZY("PMTDataDecoder Tool: Procesing PMTData Entry from CStore",v_debug, verbosity);
+      m_data->CStore.Get("CardData",Cdata);
+      this->DecodeCardDataEntry(*Cdata);
     }
-    Log("PMTDataDecoder Tool: PMTData Entry processed",v_debug, verbosity);
+    LOG_LAZY("PMTDataDecoder Tool: PMTData Entry processed",v_debug, verbosity);
     
 
     //PARSING COMPLETE THIS LOOP: PRINT SOME DIAGNOSTICS 
@@ -293,9 +277,9 @@ bool PMTDataDecoder::Execute(){
     //Transfer finished waves from this execute loop to the CStore
 
     if(!NewWavesBuilt){
-      Log("PMTDataDecoder Tool: No new finished PMT waves available.",v_debug, verbosity);
+      LOG_LAZY("PMTDataDecoder Tool: No new finished PMT waves available.",v_debug, verbosity);
     } else {
-      Log("PMTDataDecoder Tool: New finished waves available.",v_debug, verbosity);
+      LOG_LAZY("PMTDataDecoder Tool: New finished waves available.",v_debug, verbosity);
     }
 
     m_data->CStore.Set("InProgressTankEvents",FinishedPMTWaves);
@@ -306,9 +290,9 @@ bool PMTDataDecoder::Execute(){
     m_data->CStore.Set("TimestampsFromTheFuture",TimestampsFromTheFuture);
 
     //Check the size of the WaveBank to see if things are bloating
-    Log("PMTDataDecoder Tool: Size of WaveBank (# waveforms partially built): " + 
-            to_string(WaveBank.size()),v_message, verbosity);
-    Log("PMTDataDecoder Tool: Size of FinishedPMTWaves from this execution (# triggers with at least one wave fully):" + 
+    LOG_LAZY("PMTDataDecoder Tool: Size of WaveBank (# waveforms partially built): " + 
+            to_string(NumWavesInProgress),v_message, verbosity);
+    LOG_LAZY("PMTDataDecoder Tool: Size of FinishedPMTWaves from this execution (# triggers with at least one wave fully):" + 
             to_string(FinishedPMTWaves->size()),v_message, verbosity);
   } 
   return true;
@@ -317,11 +301,195 @@ bool PMTDataDecoder::Execute(){
 
 bool PMTDataDecoder::Finalise(){
 
+  if(DecoderPool.size()>0){
+    {
+      std::lock_guard<std::mutex> lock(PoolMutex);
+      StopPool = true;
+    }
+    PoolCV.notify_all();
+    for (unsigned int i=0; i<DecoderPool.size(); i++) DecoderPool.at(i).join();
+    DecoderPool.clear();
+  }
   Log("PMTDataDecoder tool exitting",v_warning,verbosity);
   return true;
 }
 
-bool PMTDataDecoder::CheckIfCardNextInSequence(CardData aCardData)
+void PMTDataDecoder::ClearWaveBanks()
+{
+  WaveBanks.clear();
+  NumWavesInProgress = 0;
+}
+
+void PMTDataDecoder::DecoderLog(std::string message, int message_level)
+{
+  //Log is not thread safe; decoding functions may run on the DecoderThreads pool
+  std::lock_guard<std::mutex> lock(LogMutex);
+  Log(message,message_level,verbosity);
+}
+
+void PMTDataDecoder::DecodeCardDataEntry(std::vector<CardData> &CardDataEntry)
+{
+  std::vector<CardDecodeTask> CardTasks;
+  this->AddCardDecodeTasks(CardDataEntry,CardTasks);
+  this->DecodeCardTasks(CardTasks);
+  return;
+}
+
+void PMTDataDecoder::AddCardDecodeTasks(std::vector<CardData> &CardDataEntry, std::vector<CardDecodeTask> &CardTasks)
+{
+  LOG_LAZY("PMTDataDecoder Tool: entry has #CardData classes = "+to_string(CardDataEntry.size()),v_debug, verbosity);
+  for (unsigned int CardDataIndex=0; CardDataIndex<CardDataEntry.size(); CardDataIndex++){
+    CardData &aCardData = CardDataEntry.at(CardDataIndex);
+    if(verbosity>v_debug){
+      std::cout<<"PMTDataDecoder Tool: Loading next CardData from entry's index " << CardDataIndex <<std::endl;
+      std::cout<<"PMTDataDecoder Tool: CardData's CardID="<<aCardData.CardID<<std::endl;
+      std::cout<<"PMTDataDecoder Tool: CardData's data vector size="<<aCardData.Data.size()<<std::endl;
+    }
+    //Check if card experienced any data loss
+    FIFOstate = 0;
+    FIFOstate = aCardData.FIFOstate;
+    if(FIFOstate == 1){  //FIFO overflow
+      Log("PMTDataDecoder Tool: WARNING FIFO Overflow on card ID"+to_string(aCardData.CardID),v_error,verbosity);
+      fifo1.push_back(aCardData.CardID);
+    }
+    if(FIFOstate == 2){  //FIFO overflow and error clearing overvlow
+      Log("PMTDataDecoder Tool: WARNING Failure to clear FIFO Overflow on card ID"+to_string(aCardData.CardID),v_error,verbosity);
+      fifo2.push_back(aCardData.CardID);
+    }
+    LOG_LAZY("PMTDataDecoder Tool:  CardData has SequenceID... "+to_string(aCardData.SequenceID),v_debug, verbosity);
+    bool IsNextInSequence = this->CheckIfCardNextInSequence(aCardData);
+    if (!IsNextInSequence) {
+      LOG_LAZY("PMTDataDecoder Tool WARNING: CardData found OUT OF SEQUENCE!!!",v_warning, verbosity);
+      LOG_LAZY("PMTDataDecoder Tool:  OOO CardID... " +
+              to_string(aCardData.CardID),v_warning, verbosity);
+      LOG_LAZY("PMTDataDecoder Tool:  OOO SequenceID... " + 
+              to_string(aCardData.SequenceID),v_warning, verbosity);
+    }
+    this->AddCardDecodeTask(aCardData,CardTasks);
+  }
+  return;
+}
+
+void PMTDataDecoder::AddCardDecodeTask(const CardData &aCardData, std::vector<CardDecodeTask> &CardTasks)
+{
+  CardDecodeTask task;
+  task.Card = &aCardData;
+  task.CardID = aCardData.CardID;
+  task.FIFOstate = aCardData.FIFOstate;
+  task.Bank = &WaveBanks[aCardData.CardID];  //Banks are created here, never by the decoding threads
+  CardTasks.push_back(std::move(task));
+  return;
+}
+
+void PMTDataDecoder::DecodeCardTasks(std::vector<CardDecodeTask> &CardTasks)
+{
+  if(DecoderThreads > 1 && CardTasks.size() > 1){
+    //CardData of the same card have to be decoded in order by one thread
+    std::map<int,unsigned int> CardGroup;
+    {
+      std::lock_guard<std::mutex> lock(PoolMutex);
+      for (unsigned int i=0; i<CardTasks.size(); i++){
+        std::map<int,unsigned int>::iterator it = CardGroup.find(CardTasks.at(i).CardID);
+        if(it == CardGroup.end()){
+          it = CardGroup.emplace(CardTasks.at(i).CardID,PoolGroups.size()).first;
+          PoolGroups.push_back(std::vector<CardDecodeTask*>());
+        }
+        PoolGroups.at(it->second).push_back(&CardTasks.at(i));
+      }
+      PoolNextGroup = 0;
+      PoolGroupsDone = 0;
+    }
+    PoolCV.notify_all();
+    std::unique_lock<std::mutex> lock(PoolMutex);
+    PoolDoneCV.wait(lock,[this]{return PoolGroupsDone == PoolGroups.size();});
+    PoolGroups.clear();
+    PoolNextGroup = 0;
+    PoolGroupsDone = 0;
+    lock.unlock();
+    //A card that failed to decode fails the Execute, as it does without the pool
+    for (unsigned int i=0; i<CardTasks.size(); i++){
+      if(CardTasks.at(i).Error) std::rethrow_exception(CardTasks.at(i).Error);
+    }
+  } else {
+    for (unsigned int i=0; i<CardTasks.size(); i++) this->DecodeCardTask(CardTasks.at(i));
+  }
+  //Merge in CardData order, as the serial decoder would have stored them
+  for (unsigned int i=0; i<CardTasks.size(); i++) this->MergeFinishedWaves(CardTasks.at(i));
+  return;
+}
+
+void PMTDataDecoder::DecoderWorker()
+{
+  std::unique_lock<std::mutex> lock(PoolMutex);
+  while(true){
+    PoolCV.wait(lock,[this]{return StopPool || PoolNextGroup < PoolGroups.size();});
+    if(StopPool) return;
+    std::vector<CardDecodeTask*> &group = PoolGroups.at(PoolNextGroup++);
+    lock.unlock();
+    //An exception can't leave the thread, so it is kept for the Execute thread; the
+    //later CardData of the card are not decoded, as the serial decoder stops there too
+    for (unsigned int i=0; i<group.size(); i++){
+      try{
+        this->DecodeCardTask(*group.at(i));
+      } catch(...){
+        group.at(i)->Error = std::current_exception();
+        break;
+      }
+    }
+    lock.lock();
+    if(++PoolGroupsDone == PoolGroups.size()) PoolDoneCV.notify_one();
+  }
+}
+
+void PMTDataDecoder::DecodeCardTask(CardDecodeTask &task)
+{
+  //Decode raw binary frames
+  const std::vector<uint32_t> &bank = task.Card->Data;
+  if(!UseLegacyDecoder){
+    if(bank.size() < FRAME_WORDS) DECODER_LOG_LAZY("PMTDataDecoder Tool:  CardData object has no data. ",v_debug);
+    this->DecodeCardFrames(task,bank);
+    return;
+  }
+  std::vector<DecodedFrame> ThisCardDFs;
+  ThisCardDFs = this->DecodeFrames(bank);
+  if(ThisCardDFs.size() == 0) DECODER_LOG_LAZY("PMTDataDecoder Tool:  CardData object has no data. ",v_debug);
+  else{
+    // Parse each decoded frame's data stream and frame header 
+    for (unsigned int i=0; i < ThisCardDFs.size(); i++){
+      this->ParseFrame(task,ThisCardDFs.at(i));
+    }
+  }
+  return;
+}
+
+void PMTDataDecoder::MergeFinishedWaves(CardDecodeTask &task)
+{
+  NumWavesInProgress += task.WavesStarted - task.WavesFinished;
+  for (unsigned int i=0; i<task.FinishedWaves.size(); i++){
+    PendingWave &wave = task.FinishedWaves.at(i);
+    uint64_t FinishedWaveTrigTime = wave.TrigTime;
+    if (FinishedWaveTrigTime > 2000000000000000000) {
+      Log("PMTDataDecoder: Error: Encountered timestamp that is very large: FinishedWaveTrigTime = "+std::to_string(FinishedWaveTrigTime)+". Don't include this data in the waves in progress.",v_error,verbosity);
+      (*TimestampsFromTheFuture)[LastGoodTimestamp].emplace(wave.Key,FinishedWaveTrigTime);
+      continue;		//Don't include times that are far off in the future (what is going on there?) [exclude everything beyond 18th of May 2033, ANNIE will probably not run that long...)
+    }
+    LastGoodTimestamp = FinishedWaveTrigTime;
+    LOG_LAZY("PMTDataDecoder Tool: Finished Wave Length"+to_string(wave.Samples.size()),v_debug, verbosity);
+    LOG_LAZY("PMTDataDecoder Tool: Finished Wave Clock time (ns)"+to_string(FinishedWaveTrigTime),v_debug, verbosity);
+
+    if((int)wave.Samples.size()>ADCCountsToBuild){
+      NewWavesBuilt = true;
+      (*FinishedPMTWaves)[FinishedWaveTrigTime].emplace(wave.Key,std::move(wave.Samples));
+      if (task.FIFOstate == 1 || task.FIFOstate == 2) {
+        (*FIFOPMTWaves)[FinishedWaveTrigTime].emplace(wave.Key,task.FIFOstate);
+      }
+    }
+  }
+  task.FinishedWaves.clear();
+  return;
+}
+
+bool PMTDataDecoder::CheckIfCardNextInSequence(const CardData &aCardData)
 {
   bool IsNextInSequence = false;
   //Check if this CardData is next in it's sequence for processing
@@ -333,7 +501,7 @@ bool PMTDataDecoder::CheckIfCardNextInSequence(CardData aCardData)
       it->second+=1;
     }
   } else if ((it == SequenceMap.end())){  //This is the first CardData seen by this CardID
-    if (aCardData.SequenceID!=0) Log("PMTDataDecoder Tool: NOTE First data seen for this card is not SequenceID=0",v_warning,verbosity);
+    if (aCardData.SequenceID!=0) LOG_LAZY("PMTDataDecoder Tool: NOTE First data seen for this card is not SequenceID=0",v_warning,verbosity);
     if(verbosity>v_debug) std::cout << "CARD ID " << aCardData.CardID << "NEXT IN SEQUENCE SHOULD BE " << aCardData.SequenceID+1 << std::endl;
     SequenceMap.emplace(aCardData.CardID, aCardData.SequenceID+1); //Assume this is the first sequenceID even if not zero
     IsNextInSequence = true;
@@ -350,15 +518,15 @@ bool PMTDataDecoder::CheckIfCardNextInSequence(CardData aCardData)
 
 std::vector<DecodedFrame> PMTDataDecoder::DecodeFrames(std::vector<uint32_t> bank)
 {
-  Log("PMTDataDecoder Tool: Decoding frames now ",v_debug, verbosity);
-  Log("PMTDataDecoder Tool: Bank size is "+to_string(bank.size()),v_debug, verbosity);
+  DECODER_LOG_LAZY("PMTDataDecoder Tool: Decoding frames now ",v_debug);
+  DECODER_LOG_LAZY("PMTDataDecoder Tool: Bank size is "+to_string(bank.size()),v_debug);
   uint64_t tempword=0;
   std::vector<DecodedFrame> frames;  //What we will return
   std::vector<uint16_t> samples;
   samples.resize(40); //Well, if there's 480 bits per frame of samples max, this fits it
-  if(verbosity>v_message) std::cout << "DECODING A CARDDATA'S DATA BANK.  SIZE OF BANK: " << bank.size() << std::endl;
-  if(verbosity>v_message) std::cout << "THIS SHOULD HOLD AN INTEGER NUMBER OF FRAMES.  EACH FRAME HAS" << std::endl;
-  if(verbosity>v_message) std::cout << "512 BITs, split into 16 32-bit INTEGERS.  THIS SHOUDL BE DIVISIBLE BY 16" << std::endl;
+  DECODER_LOG_LAZY("DECODING A CARDDATA'S DATA BANK.  SIZE OF BANK: "+to_string(bank.size())+"\n"+
+      "THIS SHOULD HOLD AN INTEGER NUMBER OF FRAMES.  EACH FRAME HAS\n"+
+      "512 BITs, split into 16 32-bit INTEGERS.  THIS SHOUDL BE DIVISIBLE BY 16",v_debug);
   for (unsigned int frame = 0; frame<bank.size()/16; ++frame) {  // if each frame has 16 32-bit ints, nframes = bank_size/16
     struct DecodedFrame thisframe;
     int sampleindex = 0;
@@ -367,17 +535,17 @@ std::vector<DecodedFrame> PMTDataDecoder::DecodeFrames(std::vector<uint32_t> ban
     bool haverecheader_part1 = false;
     while (sampleindex < 40) {  //Parse out this whole frame
       if (bitsleft < 12) {
-        if(verbosity>vv_debug) std::cout << "DATA STREAM STEP AT SAMPLE INDEX" << sampleindex << std::endl;
-        if(verbosity>vv_debug) std::cout <<" BANK[WORDINDEX="<<wordindex<<"]: "<<bank[wordindex]<<std::endl;
+        DECODER_LOG_LAZY("DATA STREAM STEP AT SAMPLE INDEX"+to_string(sampleindex)+"\n"+
+            " BANK[WORDINDEX="+to_string(wordindex)+"]: "+to_string(bank[wordindex]),vv_debug+1);
         tempword += ((uint64_t)be32toh(bank[wordindex]))<<bitsleft;
-        if(verbosity>vv_debug) std::cout << "DATA STREAM SNAPSHOT WITH NEXT 32-bit WORD FROM FRAME " << std::bitset<64>(tempword) << std::endl;
+        DECODER_LOG_LAZY("DATA STREAM SNAPSHOT WITH NEXT 32-bit WORD FROM FRAME "+std::bitset<64>(tempword).to_string(),vv_debug+1);
         bitsleft += 32;
         wordindex += 1;
       }
       //Logic to search for record headers
       if((int)(tempword&0xfff)==RECORD_HEADER_LABELPART1) haverecheader_part1 = true;
       else if (haverecheader_part1 && ((int)(tempword&0xfff)==RECORD_HEADER_LABELPART2)){
-        if(verbosity>vv_debug) std::cout << "FOUND A RECORD HEADER. AT INDEX " << sampleindex << std::endl;
+        DECODER_LOG_LAZY("FOUND A RECORD HEADER. AT INDEX "+to_string(sampleindex),vv_debug+1);
         thisframe.has_recordheader=true;
         thisframe.recordheader_starts.push_back(sampleindex-1);
         haverecheader_part1 = false;
@@ -386,22 +554,22 @@ std::vector<DecodedFrame> PMTDataDecoder::DecodeFrames(std::vector<uint32_t> ban
      
       //Takie the first 12 bits of the tempword at each loop, and shift tempword
       samples[sampleindex] = tempword&0xfff;
-      if(verbosity>vv_debug) std::cout << "FIRST 12 BITS IN THIS SNAPSHOT: " << std::bitset<16>(tempword&0xfff) << dec << std::endl;
+      DECODER_LOG_LAZY("FIRST 12 BITS IN THIS SNAPSHOT: "+std::bitset<16>(tempword&0xfff).to_string(),vv_debug+1);
       tempword = tempword>>12;
       bitsleft -= 12;
       sampleindex += 1;
     } //END parse out this frame
     thisframe.frameheader = be32toh(bank[16*frame+15]);  //Frameid is held in the frame's last 32-bit word
-    if(verbosity>vv_debug) std::cout << "FRAMEHEADER last 8 bits: " << std::bitset<32>(thisframe.frameheader>>24) << std::endl;
+    DECODER_LOG_LAZY("FRAMEHEADER last 8 bits: "+std::bitset<32>(thisframe.frameheader>>24).to_string(),vv_debug+1);
     thisframe.samples = samples;
-    if(verbosity>vv_debug) std::cout << "LENGTH OF SAMPLES AFTER DECODING A FRAME: " << dec << thisframe.samples.size() << std::endl;
+    DECODER_LOG_LAZY("LENGTH OF SAMPLES AFTER DECODING A FRAME: "+to_string(thisframe.samples.size()),vv_debug+1);
     frames.push_back(thisframe);
   }
-  Log("PMTDataDecoder Tool: Decoding frames complete ",v_debug, verbosity);
+  DECODER_LOG_LAZY("PMTDataDecoder Tool: Decoding frames complete ",v_debug);
   return frames;
 }
 
-void PMTDataDecoder::ParseFrame(int CardID, DecodedFrame DF)
+void PMTDataDecoder::ParseFrame(CardDecodeTask &task, DecodedFrame DF)
 { 
   //Decoded frame infomration is moved to the
   //TriggerTimeBank and WaveBank.  
@@ -409,45 +577,47 @@ void PMTDataDecoder::ParseFrame(int CardID, DecodedFrame DF)
   unsigned channel_mask; 
   int ChannelID = DF.frameheader >> 24; //TODO: Use something more intricate?
                                   //Bitrange defined by Jonathan (511 downto 504)
-  if(verbosity>4) std::cout << "Parsing frame with CardID and ChannelID-" << 
-      CardID << "," << ChannelID << std::endl;
+  DECODER_LOG_LAZY("Parsing frame with CardID and ChannelID-"+
+      to_string(task.CardID)+","+to_string(ChannelID),vv_debug+1);
   if(!DF.has_recordheader && (ChannelID != SYNCFRAME_HEADERID)){
     //All samples are waveforms for channel record that already exists in the WaveBank.
-    this->AddSamplesToWaveBank(CardID, ChannelID, DF.samples);
+    this->AddSamplesToWaveBank(task, ChannelID, DF.samples);
   } else if (ChannelID != SYNCFRAME_HEADERID){
     int WaveSecBegin = 0;
     //We need to get the rest of a wave from WaveSecBegin to where the header starts
     //FIXME: this works if there's already a wave being built.  You need to parse 
     //a record header in the wavebank first if it's the first thing in the frame though
     if(verbosity>v_debug) {
+      std::string starts;
       for (unsigned int j = 0; j<DF.recordheader_starts.size(); j++){
-          std::cout << DF.recordheader_starts.at(j) << std::endl;
+          starts += (j ? "\n" : "")+to_string(DF.recordheader_starts.at(j));
       }
+      this->DecoderLog(starts,vv_debug);
     }
     for (unsigned int j = 0; j<DF.recordheader_starts.size(); j++){
       //TODO: More graceful way to handle this?  It's already happened once
       if(WaveSecBegin>DF.recordheader_starts.at(j)){
-        if (verbosity > v_warning) std::cout << "WARNING: Record header label found inside another record header." << 
-            "This is likely due a 000FFF in the counter.  Skipping record header and " <<
-            "continuing" << std::endl;
+        DECODER_LOG_LAZY(std::string("WARNING: Record header label found inside another record header.")+
+            "This is likely due a 000FFF in the counter.  Skipping record header and "+
+            "continuing",v_message);
         continue;
       }
-      if(verbosity>vv_debug)std::cout << "RECORD HEADER INDEX" << DF.recordheader_starts.at(j) << std::endl;
-      if(verbosity>vv_debug)std::cout << "WAVESECBEGIN IS " << WaveSecBegin << std::endl;
+      DECODER_LOG_LAZY("RECORD HEADER INDEX"+to_string(DF.recordheader_starts.at(j))+"\n"+
+          "WAVESECBEGIN IS "+to_string(WaveSecBegin),vv_debug+1);
       std::vector<uint16_t> WaveSlice(DF.samples.begin()+WaveSecBegin, 
               DF.samples.begin()+DF.recordheader_starts.at(j));
-      Log("PMTDataDecoder Tool: Length of waveslice: "+to_string(WaveSlice.size()),vv_debug, verbosity);
+      DECODER_LOG_LAZY("PMTDataDecoder Tool: Length of waveslice: "+to_string(WaveSlice.size()),vv_debug);
       //Add this WaveSlice to the wave bank
-      this->AddSamplesToWaveBank(CardID, ChannelID, WaveSlice);
+      this->AddSamplesToWaveBank(task, ChannelID, WaveSlice);
       //Since we have acquired the wave up to the next record header, the wave is done.
       //Store it in the FinishedWaves map.
-      this->StoreFinishedWaveform(CardID, ChannelID);
+      this->StoreFinishedWaveform(task, ChannelID);
       //Now, we have the header coming next.  Get it and parse it, starting whatever
       //Entries in maps are needed. 
       std::vector<uint16_t> RecordHeader(DF.samples.begin()+
               DF.recordheader_starts.at(j), DF.samples.begin()+
               DF.recordheader_starts.at(j)+SAMPLES_RIGHTOF_000+1);
-      this->ParseRecordHeader(CardID, ChannelID, RecordHeader);
+      this->ParseRecordHeader(task, ChannelID, RecordHeader);
       WaveSecBegin = DF.recordheader_starts.at(j)+SAMPLES_RIGHTOF_000+1;
     }
     // No more record headers from here; just parse the rest of whatever 
@@ -455,82 +625,95 @@ void PMTDataDecoder::ParseFrame(int CardID, DecodedFrame DF)
     int WaveSecEnd = DF.samples.size()-1;
     std::vector<uint16_t> WaveSlice(DF.samples.begin()+WaveSecBegin, 
             DF.samples.end());
-    this->AddSamplesToWaveBank(CardID, ChannelID, WaveSlice);
+    this->AddSamplesToWaveBank(task, ChannelID, WaveSlice);
   }
   else {
-    this->ParseSyncFrame(CardID, DF);
+    this->ParseSyncFrame(task, DF);
   }
   return;
 }
 
-void PMTDataDecoder::ParseSyncFrame(int CardID, DecodedFrame DF)
+void PMTDataDecoder::ParseSyncFrame(CardDecodeTask &task, DecodedFrame DF)
+{
+  this->ParseSyncFrame(task, DF.samples.data());
+}
+
+void PMTDataDecoder::ParseSyncFrame(CardDecodeTask &task, const uint16_t *samples)
 {
-  if(verbosity>vv_debug) std::cout << "PRINTING ALL DATA IN A SYNC FRAME FOR CARD" << CardID << std::endl;
   uint64_t SyncCounter = 0;
+  std::string dump;
   for (int i=0; i < 6; i++){
-    if(verbosity>vv_debug) std::cout << "SYNC FRAME DATA AT INDEX " << i << ": " << DF.samples.at(i) << std::endl;
-    SyncCounter += ((uint64_t)DF.samples.at(i)) << (12*i);
-    if(verbosity>vv_debug) std::cout << "SYNC COUNTER WITH CURRENT SAMPLE PUT AT LEFT: " << SyncCounter << std::endl;
-  }
-  std::map<int, std::vector<uint64_t>>::iterator it = SyncCounters.find(CardID);
-  if(it != SyncCounters.end()) SyncCounters.at(CardID).push_back(SyncCounter);
-  else {
-    std::vector<uint64_t> SyncVec{SyncCounter};
-    SyncCounters.emplace(CardID,SyncVec);
+    SyncCounter += ((uint64_t)samples[i]) << (12*i);
+    if(verbosity>vv_debug) dump += "\nSYNC FRAME DATA AT INDEX "+to_string(i)+": "+to_string(samples[i])+
+        "\nSYNC COUNTER WITH CURRENT SAMPLE PUT AT LEFT: "+to_string(SyncCounter);
   }
+  //One message per frame, so the dumps of cards decoded on different threads don't interleave
+  DECODER_LOG_LAZY("PRINTING ALL DATA IN A SYNC FRAME FOR CARD"+to_string(task.CardID)+dump,vv_debug+1);
+  task.Bank->SyncCounters.push_back(SyncCounter);
   return;
 }
 
-void PMTDataDecoder::ParseRecordHeader(int CardID, int ChannelID, std::vector<uint16_t> RH)
+void PMTDataDecoder::ParseRecordHeader(CardDecodeTask &task, int ChannelID, std::vector<uint16_t> RH)
+{
+  this->ParseRecordHeader(task, ChannelID, RH.data());
+}
+
+void PMTDataDecoder::ParseRecordHeader(CardDecodeTask &task, int ChannelID, const uint16_t *RH)
 {
   //We need to get the MTC count and make a new entry in TriggerTimeBank and WaveBank
   //First 4 samples; Just get the bits from 24 to 37 (is counter (61 downto 48)
   //Last 4 samples; All the first 48 bits of the MTC count.
-  Log("PMTDataDecoder Tool: Parsing an encountered header ",v_debug, verbosity);
+  DECODER_LOG_LAZY("PMTDataDecoder Tool: Parsing an encountered header ",v_debug);
   if(verbosity>vv_debug){
-    std::cout << "BIT WORDS IN RECORD HEADER: " << std::endl;
-    for (unsigned int j=0; j<RH.size(); j++){
-      std::cout << std::bitset<16>(RH.at(j)) << dec << std::endl;
+    std::string dump = "BIT WORDS IN RECORD HEADER: ";
+    for (unsigned int j=0; j<SAMPLES_RIGHTOF_000+1; j++){
+      dump += "\n"+std::bitset<16>(RH[j]).to_string();
     }
+    this->DecoderLog(dump,vv_debug+1);
   }
-  std::vector<uint16_t> CounterEnd(RH.begin()+2, RH.begin()+4);
-  std::vector<uint16_t> CounterBegin(RH.begin()+4, RH.begin()+8);
+  //Samples 4-7 hold the lower 48 bits of the counter, samples 2-3 the upper bits
   uint64_t ClockCount=0;
   int samplewidth=12;  //each uint16 really only holds 12 bits of info. (see DecodeFrame)
-  //std::reverse(CounterBegin.begin(),CounterBegin.end());
-  for (unsigned int j=0; j<CounterBegin.size(); j++){
-    ClockCount += ((uint64_t)CounterBegin.at(j) << j*samplewidth);
+  for (int j=0; j<4; j++){
+    ClockCount += ((uint64_t)RH[4+j] << j*samplewidth);
   }
-  for (unsigned int j=0; j<CounterEnd.size(); j++){
-    ClockCount += ((uint64_t)CounterEnd.at(j) << ((CounterBegin.size() + j)*samplewidth));
+  for (int j=0; j<2; j++){
+    ClockCount += ((uint64_t)RH[2+j] << ((4 + j)*samplewidth));
+  }
+  //Start a new wave in the card's bank, since this channel's Wave data is coming up
+  //next.  A wave that is still in progress keeps its trigger time and samples.
+  DECODER_LOG_LAZY("PMTDataDecoder Tool: Parsed Clock time for header is "+to_string(ClockCount*8),v_debug);
+  CardWaveBank &bank = *task.Bank;
+  if(!bank.InProgress[ChannelID]){
+    bank.InProgress[ChannelID] = true;
+    bank.TriggerTimes[ChannelID] = ClockCount*8;
+    bank.Waves[ChannelID].clear();
+    task.WavesStarted += 1;
   }
-  std::vector<int> wave_key{CardID,ChannelID};
-  std::vector<uint16_t> Waveform;
-  
-  //Update the TriggerTimeBank and WaveBank with new entries, since this channel's
-  //Wave data is coming up next
-  Log("PMTDataDecoder Tool: Parsed Clock counter for header is "+to_string(ClockCount),v_debug, verbosity);
-  Log("PMTDataDecoder Tool: Parsed Clock time for header is "+to_string(ClockCount*8),v_debug, verbosity);
-  TriggerTimeBank.emplace(wave_key,ClockCount*8);
-  Log("PMTDataDecoder Tool: Placing empty waveform in WaveBank ",v_debug, verbosity);
-  WaveBank.emplace(wave_key,Waveform);
   return;
 }
 
 
-void PMTDataDecoder::StoreFinishedWaveform(int CardID, int ChannelID)
+void PMTDataDecoder::StoreFinishedWaveform(CardDecodeTask &task, int ChannelID)
 {
   //Get the full waveform from the Wave Bank
-  std::vector<int> wave_key{CardID,ChannelID};
-  //Check there's a wave in the map
-  if(WaveBank.count(wave_key)==0){
-    Log("PMTDataDecoder::StoreFinishedWaveform: No waveform available for CardID,ChannelID " + 
-            to_string(CardID) + "," + to_string(ChannelID),v_message, verbosity);
-    Log("PMTDataDecoder::StoreFinishedWaveForm: Continuing without saving any waves",v_message, verbosity);
+  CardWaveBank &bank = *task.Bank;
+  int CardID = task.CardID;
+  //Check there's a wave in the bank
+  if(!bank.InProgress[ChannelID]){
+    DECODER_LOG_LAZY("PMTDataDecoder::StoreFinishedWaveform: No waveform available for CardID,ChannelID " + 
+            to_string(CardID) + "," + to_string(ChannelID),v_message);
+    DECODER_LOG_LAZY("PMTDataDecoder::StoreFinishedWaveForm: Continuing without saving any waves",v_message);
     return;
   }
-  std::vector<uint16_t> FinishedWave = WaveBank.at(wave_key);
-  uint64_t FinishedWaveTrigTime = TriggerTimeBank.at(wave_key);  //Conversion from counter ticks to ns
+  //Clear the finished wave from the bank for the new wave to start being put together
+  bank.InProgress[ChannelID] = false;
+  task.WavesFinished += 1;
+  PendingWave FinishedWave;
+  FinishedWave.Key = MakeCardChannelKey(CardID,ChannelID);
+  FinishedWave.Samples = std::move(bank.Waves[ChannelID]);
+  bank.Waves[ChannelID].clear();
+  uint64_t FinishedWaveTrigTime = bank.TriggerTimes[ChannelID];  //Conversion from counter ticks to ns
   if (CardID > 3000 && OffsetVME03) {
     if (OffsetPositive) FinishedWaveTrigTime += 8;
     else FinishedWaveTrigTime -= 8;	//Offset for VME03
@@ -539,69 +722,107 @@ void PMTDataDecoder::StoreFinishedWaveform(int CardID, int ChannelID)
     if (OffsetPositive) FinishedWaveTrigTime += 8; //Offset for VME01
     else FinishedWaveTrigTime -= 8;
   }
-  if (FinishedWaveTrigTime > 2000000000000000000) {
-    Log("PMTDataDecoder: Error: Encountered timestamp that is very large: FinishedWaveTrigTime = "+std::to_string(FinishedWaveTrigTime)+". Don't include this data in the waves in progress.",v_error,verbosity);
-    WaveBank.erase(wave_key);
-    TriggerTimeBank.erase(wave_key);
-    std::map<std::vector<int>,uint64_t> MapFutureTimestamps;
-    MapFutureTimestamps.emplace(wave_key,FinishedWaveTrigTime);
-    if (TimestampsFromTheFuture->count(LastGoodTimestamp)==0){
-      TimestampsFromTheFuture->emplace(LastGoodTimestamp,MapFutureTimestamps);
-    } else {
-      TimestampsFromTheFuture->at(LastGoodTimestamp).emplace(wave_key,FinishedWaveTrigTime);
-    }
-    return;		//Don't include times that are far off in the future (what is going on there?) [exclude everything beyond 18th of May 2033, ANNIE will probably not run that long...)
-  }
-  LastGoodTimestamp = FinishedWaveTrigTime;
-  Log("PMTDataDecoder Tool: Finished Wave Length"+to_string(WaveBank.size()),v_debug, verbosity);
-  Log("PMTDataDecoder Tool: Finished Wave Clock time (ns)"+to_string(FinishedWaveTrigTime),v_debug, verbosity);
-
-  if((int)FinishedWave.size()>ADCCountsToBuild){
-    NewWavesBuilt = true;
-    if(FinishedPMTWaves->count(FinishedWaveTrigTime) == 0) {
-      std::map<std::vector<int>, std::vector<uint16_t> > WaveMap;
-      WaveMap.emplace(wave_key,FinishedWave);
-      FinishedPMTWaves->emplace(FinishedWaveTrigTime,WaveMap);
-      if (FIFOstate == 1 || FIFOstate ==2){
-        std::map<std::vector<int>,int> FIFOInfo;
-        FIFOInfo.emplace(wave_key,FIFOstate);
-        FIFOPMTWaves->emplace(FinishedWaveTrigTime,FIFOInfo);
-      }
-    } else {
-      FinishedPMTWaves->at(FinishedWaveTrigTime).emplace(wave_key,FinishedWave);
-      if (FIFOstate == 1 || FIFOstate == 2) {
-	if (FIFOPMTWaves->count(FinishedWaveTrigTime)==0){
-          std::map<std::vector<int>,int> FIFOInfo;
-          FIFOInfo.emplace(wave_key,FIFOstate);
-          FIFOPMTWaves->emplace(FinishedWaveTrigTime,FIFOInfo);
-        } else {
-          FIFOPMTWaves->at(FinishedWaveTrigTime).emplace(wave_key,FIFOstate);
-        }
-      }
-    }
-  }
-  //Clear the finished wave from WaveBank and TriggerTimeBank for the new wave
-  //to start being put together
-  WaveBank.erase(wave_key);
-  TriggerTimeBank.erase(wave_key);
+  FinishedWave.TrigTime = FinishedWaveTrigTime;
+  //Moved to FinishedPMTWaves by MergeFinishedWaves once the card is decoded
+  task.FinishedWaves.push_back(std::move(FinishedWave));
   return;
 }
   
-void PMTDataDecoder::AddSamplesToWaveBank(int CardID, int ChannelID, 
+void PMTDataDecoder::AddSamplesToWaveBank(CardDecodeTask &task, int ChannelID, 
         std::vector<uint16_t> WaveSlice)
 {
-  Log("PMTDataDecoder Tool: Adding Waveslice to waveform.  Num. Samples: "+to_string(WaveSlice.size()),vv_debug, verbosity);
+  this->AddSamplesToWaveBank(task, ChannelID, WaveSlice.data(), WaveSlice.data()+WaveSlice.size());
+}
+
+void PMTDataDecoder::AddSamplesToWaveBank(CardDecodeTask &task, int ChannelID, 
+        const uint16_t *first, const uint16_t *last)
+{
+  DECODER_LOG_LAZY("PMTDataDecoder Tool: Adding Waveslice to waveform.  Num. Samples: "+to_string(last-first),vv_debug+1);
   //TODO: Make sure the above is always divisible by 4!
   //Add the WaveSlice to the proper vector in the WaveBank.
-  std::vector<int> wave_key{CardID,ChannelID};
-  if(WaveBank.count(wave_key)==0){
-    Log("PMTDataDecoder Tool: HAVE WAVE SLICE BUT NO WAVE BEING BUILT.: ",v_warning, verbosity);
-    Log("PMTDataDecoder Tool: WAVE SLICE WILL NOT BE SAVED, DATA LOST",v_warning, verbosity);
+  CardWaveBank &bank = *task.Bank;
+  if(!bank.InProgress[ChannelID]){
+    DECODER_LOG_LAZY("PMTDataDecoder Tool: HAVE WAVE SLICE BUT NO WAVE BEING BUILT.: ",v_warning);
+    DECODER_LOG_LAZY("PMTDataDecoder Tool: WAVE SLICE WILL NOT BE SAVED, DATA LOST",v_warning);
     return;
-  } else {
-  WaveBank.at(wave_key).insert(WaveBank.at(wave_key).end(),
-                               WaveSlice.begin(),
-                               WaveSlice.end());
+  }
+  std::vector<uint16_t> &wave = bank.Waves[ChannelID];
+  wave.insert(wave.end(), first, last);
+  return;
+}
+
+void PMTDataDecoder::UnpackFrameSamples(const uint32_t *frame, uint16_t *samples)
+{
+  //The 15 data words of a frame form a bit stream (each word big endian, least significant
+  //bits first) of 40 12-bit samples.  Every three words hold exactly eight samples, so the
+  //frame is unpacked in five fixed groups without carrying a bit accumulator.
+  for (int group=0; group < 5; group++){
+    uint32_t w0 = be32toh(frame[3*group]);
+    uint32_t w1 = be32toh(frame[3*group+1]);
+    uint32_t w2 = be32toh(frame[3*group+2]);
+    uint16_t *s = samples + 8*group;
+    s[0] = w0 & 0xfff;
+    s[1] = (w0>>12) & 0xfff;
+    s[2] = ((w0>>24) | (w1<<8)) & 0xfff;
+    s[3] = (w1>>4) & 0xfff;
+    s[4] = (w1>>16) & 0xfff;
+    s[5] = ((w1>>28) | (w2<<4)) & 0xfff;
+    s[6] = (w2>>8) & 0xfff;
+    s[7] = (w2>>20) & 0xfff;
+  }
+}
+
+void PMTDataDecoder::DecodeCardFrames(CardDecodeTask &task, const std::vector<uint32_t> &bank)
+{
+  //Same parsing as DecodeFrames + ParseFrame, done frame by frame on the bank itself
+  uint16_t samples[FRAME_SAMPLES];
+  int recordheader_starts[FRAME_SAMPLES];
+  const int RecordHeaderLength = SAMPLES_RIGHTOF_000+1;
+  const uint32_t *frame = bank.data();
+  const uint32_t *bank_end = frame + (bank.size()/FRAME_WORDS)*FRAME_WORDS;
+  for (; frame != bank_end; frame += FRAME_WORDS){
+    this->UnpackFrameSamples(frame,samples);
+    int ChannelID = be32toh(frame[FRAME_WORDS-1]) >> 24;  //Frameid is held in the frame's last 32-bit word
+    if(ChannelID == SYNCFRAME_HEADERID){
+      this->ParseSyncFrame(task,samples);
+      continue;
+    }
+
+    //Record headers start with a 0x000 sample directly followed by 0xFFF
+    int num_recordheaders = 0;
+    bool haverecheader_part1 = false;
+    for (int sampleindex=0; sampleindex < FRAME_SAMPLES; sampleindex++){
+      if(samples[sampleindex]==RECORD_HEADER_LABELPART1) haverecheader_part1 = true;
+      else if (haverecheader_part1 && samples[sampleindex]==RECORD_HEADER_LABELPART2){
+        recordheader_starts[num_recordheaders++] = sampleindex-1;
+        haverecheader_part1 = false;
+      }
+      else haverecheader_part1 = false;
+    }
+
+    int WaveSecBegin = 0;
+    for (int j=0; j < num_recordheaders; j++){
+      int HeaderStart = recordheader_starts[j];
+      if(WaveSecBegin>HeaderStart){
+        DECODER_LOG_LAZY(std::string("WARNING: Record header label found inside another record header.")+
+            "This is likely due a 000FFF in the counter.  Skipping record header and "+
+            "continuing",v_message);
+        continue;
+      }
+      //The wave being built ends where the record header starts
+      this->AddSamplesToWaveBank(task, ChannelID, samples+WaveSecBegin, samples+HeaderStart);
+      this->StoreFinishedWaveform(task, ChannelID);
+      if(HeaderStart+RecordHeaderLength > FRAME_SAMPLES){
+        DECODER_LOG_LAZY("PMTDataDecoder Tool: WARNING Record header truncated at end of frame on card ID "+to_string(task.CardID)+". Skipping record header",v_warning);
+        WaveSecBegin = FRAME_SAMPLES;
+        break;
+      }
+      this->ParseRecordHeader(task, ChannelID, samples+HeaderStart);
+      WaveSecBegin = HeaderStart+RecordHeaderLength;
+    }
+    // No more record headers from here; just parse the rest of whatever 
+    // waveform is being looked at
+    this->AddSamplesToWaveBank(task, ChannelID, samples+WaveSecBegin, samples+FRAME_SAMPLES);
   }
   return;
 }
@@ -5,12 +5,19 @@
 #include <iostream>
 #include <bitset>
 #include <deque>
+#include <array>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 
 #include "Tool.h"
+#include "LazyLog.h"
 #include "CardData.h"
 #include "TriggerData.h"
 #include "BoostStore.h"
 #include "Store.h"
+#include "CardChannelKey.h"
 
 #include <boost/algorithm/string.hpp>
 
@@ -36,6 +43,40 @@ struct DecodedFrame{
   }
 };
 
+//Waveforms being built for one ADC card.  Indexed directly by the 8-bit channel ID
+//of the frame header, so no per-lookup key has to be built.
+struct CardWaveBank{
+  static const int NUM_CHANNEL_IDS = 256;
+  std::array<std::vector<uint16_t>,NUM_CHANNEL_IDS> Waves;  //Waveform being built for each channel
+  std::array<uint64_t,NUM_CHANNEL_IDS> TriggerTimes;  //Trigger time associated with each wave
+  std::array<bool,NUM_CHANNEL_IDS> InProgress;  //True once a record header started a wave on this channel
+  std::vector<uint64_t> SyncCounters;  //Sync counters filled in the order they arrive
+  CardWaveBank(){
+    TriggerTimes.fill(0);
+    InProgress.fill(false);
+  }
+};
+
+//A waveform completed while decoding a card, waiting to be merged into FinishedPMTWaves
+struct PendingWave{
+  CardChannelKey Key;
+  uint64_t TrigTime;  //ns, VME offsets applied
+  std::vector<uint16_t> Samples;
+};
+
+//Decoding of one CardData.  Tasks of different cards share no state, so they can run on
+//separate threads; their finished waves are merged afterwards in CardData order.
+struct CardDecodeTask{
+  const CardData* Card = nullptr;
+  int CardID = 0;
+  int FIFOstate = 0;
+  CardWaveBank* Bank = nullptr;
+  std::vector<PendingWave> FinishedWaves;
+  int WavesStarted = 0;
+  int WavesFinished = 0;
+  std::exception_ptr Error;  //Set by a pool worker when decoding the card throws
+};
+
 
 
 class PMTDataDecoder: public Tool {
@@ -49,13 +90,32 @@ class PMTDataDecoder: public Tool {
   bool Finalise(); ///< Finalise function used to clean up resources.
   std::vector<DecodedFrame> DecodeFrames(std::vector<uint32_t> bank);
 
-  void ParseFrame(int CardID, DecodedFrame DF);
-  void ParseSyncFrame(int CardID, DecodedFrame DF);
-  void ParseRecordHeader(int CardID, int ChannelID, std::vector<uint16_t> RH);
-  void StoreFinishedWaveform(int CardID, int ChannelID);
-  void AddSamplesToWaveBank(int CardID, int ChannelID, std::vector<uint16_t> WaveSlice);
-  bool CheckIfCardNextInSequence(CardData aCardData);
+  void ParseFrame(CardDecodeTask &task, DecodedFrame DF);
+  void ParseSyncFrame(CardDecodeTask &task, DecodedFrame DF);
+  void ParseRecordHeader(CardDecodeTask &task, int ChannelID, std::vector<uint16_t> RH);
+  void StoreFinishedWaveform(CardDecodeTask &task, int ChannelID);
+  void AddSamplesToWaveBank(CardDecodeTask &task, int ChannelID, std::vector<uint16_t> WaveSlice);
+
+  //Streaming decoder: walks a card's data bank in place, one frame at a time, and feeds
+  //the WaveBank directly from a stack scratch buffer (no DecodedFrame containers)
+  void DecodeCardFrames(CardDecodeTask &task, const std::vector<uint32_t> &bank);
+  void UnpackFrameSamples(const uint32_t *frame, uint16_t *samples);
+  void ParseSyncFrame(CardDecodeTask &task, const uint16_t *samples);
+  void ParseRecordHeader(CardDecodeTask &task, int ChannelID, const uint16_t *RH);
+  void AddSamplesToWaveBank(CardDecodeTask &task, int ChannelID, const uint16_t *first, const uint16_t *last);
+  bool CheckIfCardNextInSequence(const CardData &aCardData);
+  void DecodeCardDataEntry(std::vector<CardData> &CardDataEntry); ///< Decode all CardData of one PMTData entry (Offline mode)
   void BuildReadyEvents();
+  void ClearWaveBanks();
+
+  //Card decoding: serially, or on the DecoderThreads worker pool with a merge barrier
+  void AddCardDecodeTasks(std::vector<CardData> &CardDataEntry, std::vector<CardDecodeTask> &CardTasks); ///< Sequence/FIFO checks (Offline mode), then queue each CardData
+  void AddCardDecodeTask(const CardData &aCardData, std::vector<CardDecodeTask> &CardTasks);
+  void DecodeCardTasks(std::vector<CardDecodeTask> &CardTasks);  ///< Decode all tasks, then merge their finished waves in order
+  void DecodeCardTask(CardDecodeTask &task);
+  void MergeFinishedWaves(CardDecodeTask &task);
+  void DecoderWorker();
+  void DecoderLog(std::string message, int message_level);
 
 
  private:
@@ -70,6 +130,8 @@ class PMTDataDecoder: public Tool {
   bool NewWavesBuilt;
   int ADCCountsToBuild;  //If a finished wave doesn't have this many ADC counts at least, don't add it for building
   int EntriesPerExecute;
+  bool UseLegacyDecoder;  //Decode via DecodeFrames/ParseFrame instead of the streaming decoder (for comparisons)
+  int DecoderThreads;  //Number of threads decoding cards in parallel (1: decode serially)
   int PMTDEntryNum = 0; 
   int FileNum = 0;
   int CurrentRunNum;
@@ -82,6 +144,9 @@ class PMTDataDecoder: public Tool {
   int RECORD_HEADER_LABELPART1 = 0x000;
   int RECORD_HEADER_LABELPART2 = 0xFFF;
   int SYNCFRAME_HEADERID = 10;
+  //Each frame is 16 32-bit words: 15 words of packed 12-bit samples (40 samples) and the frame header
+  static const int FRAME_WORDS = 16;
+  static const int FRAME_SAMPLES = 40;
   //A record header is made of two 48-bit words, each word in little endian order.  The
   //beginning of the first word has the 0x000 of the Record Header.  Given each 12-bit
   //chunk is stored in a 16-bit word, you want to grab the 7 samples right of 0x000 to
@@ -91,6 +156,8 @@ class PMTDataDecoder: public Tool {
   BoostStore* PMTData;
   std::vector<CardData>* Cdata = nullptr;
   std::vector<CardData> Cdata_old;
+  std::vector<std::vector<CardData>>* CdataBatch = nullptr;
+  int RawDataEntriesPerExecute = 1;  //Set by LoadRawData; >1 means PMTData entries arrive as a batch
 
   //Counter used to track the number of entries processed in a PMT file
   int NumPMTDataProcessed = 0;
@@ -104,22 +171,30 @@ class PMTDataDecoder: public Tool {
   int FIFOstate = 0;
 
 
-  //Maps used in decoding frames; specifically, holds record header and record waveform info
-  std::map<std::vector<int>, uint64_t> TriggerTimeBank;  //Key: {cardID, channelID}. Value: trigger time associated with wave in WaveBank 
-  std::map<std::vector<int>, std::vector<uint16_t>> WaveBank;  //Key: {cardID, channelID}. Value: Waveform being built for this Card and ADC Channel. 
-  std::map<int,std::vector<uint64_t>> SyncCounters; //Key: cardID.  Value: vector of sync counters filled in the order they arrive.
+  //Banks used in decoding frames; specifically, holds record header and record waveform info
+  std::map<int, CardWaveBank> WaveBanks;  //Key: cardID. Value: waveforms, trigger times and sync counters being built for each ADC channel of this card
+  int NumWavesInProgress = 0;
+
+  //Worker pool used when DecoderThreads > 1.  PoolGroups holds the tasks of each card, in order.
+  std::vector<std::thread> DecoderPool;
+  std::mutex PoolMutex;
+  std::condition_variable PoolCV;
+  std::condition_variable PoolDoneCV;
+  std::vector<std::vector<CardDecodeTask*>> PoolGroups;
+  size_t PoolNextGroup = 0;
+  size_t PoolGroupsDone = 0;
+  bool StopPool = false;
+  std::mutex LogMutex;
  
   //Extra maps used for FIFO overflow info and TimestampsFromTheFuture
-  std::map<uint64_t, std::map<std::vector<int>, int> >* FIFOPMTWaves = nullptr;
-  std::map<uint64_t,std::map<std::vector<int>,uint64_t>>* TimestampsFromTheFuture = nullptr;
+  std::map<uint64_t, std::map<CardChannelKey, int> >* FIFOPMTWaves = nullptr;
+  std::map<uint64_t,std::map<CardChannelKey,uint64_t>>* TimestampsFromTheFuture = nullptr;
   uint64_t LastGoodTimestamp = 0;
 
   //Maps that store completed waveforms from cards
-  std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > >* FinishedPMTWaves;  //Key: {MTCTime}, value: "WaveMap" with key (CardID,ChannelID), value FinishedWaveform
-  std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > > FinishedPMTWaves_old;  //Key: {MTCTime}, value: "WaveMap" with key (CardID,ChannelID), value FinishedWaveform
-  std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > > CStorePMTWaves;  //Key: {MTCTime}, value: "WaveMap" with key (CardID,ChannelID), value FinishedWaveform
+  std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t> > >* FinishedPMTWaves;  //Key: {MTCTime}, value: "WaveMap" with key CardChannelKey(CardID,ChannelID), value FinishedWaveform
+  std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t> > > CStorePMTWaves;  //Key: {MTCTime}, value: "WaveMap" with key CardChannelKey(CardID,ChannelID), value FinishedWaveform
   bool NewWaveBuilt;
-  std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > > CStoreTankEvents;  //Key: {MTCTime}, value: "WaveMap" with key (CardID,ChannelID), value FinishedWaveform
 
   // Notes whether DAQ is in lock step running
   // Number of PMTs that must be found in a WaveSet to build the event
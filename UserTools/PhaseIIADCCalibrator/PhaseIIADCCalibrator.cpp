@@ -47,7 +47,7 @@ bool PhaseIIADCCalibrator::Initialise(std::string config_filename, DataModel& da
  
   // algorithm selection
   get_ok = m_variables.Get("BaselineEstimationType", BEType);
-  if(BEType != "ze3ra" && BEType != "rootfit" && BEType != "simple" && BEType != "ze3ra_multi"){
+  if(BEType != "ze3ra" && BEType != "rootfit" && BEType != "polyfit" && BEType != "simple" && BEType != "ze3ra_multi"){
     Log("PhaseIIADCCalibrator Tool: Baseline estimation type not recognized!  Default to ze3ra", v_warning, verbosity);
      BEType = "ze3ra";
   }
@@ -56,7 +56,7 @@ bool PhaseIIADCCalibrator::Initialise(std::string config_filename, DataModel& da
   //Set defaults in case config file has no entries
   p_critical = 0.01;
   num_sub_waveforms = 6;
-  num_baseline_samples = (BEType == "rootfit") ? 980 : 5;
+  num_baseline_samples = (BEType == "rootfit" || BEType == "polyfit") ? 980 : 5;
   
   // get baseline variables
   m_variables.Get("NumBaselineSamples", num_baseline_samples);
@@ -64,6 +64,7 @@ bool PhaseIIADCCalibrator::Initialise(std::string config_filename, DataModel& da
   // get ze3ra variables 
   m_variables.Get("PCritical", p_critical);
   m_variables.Get("NumSubWaveforms", num_sub_waveforms);
+  ze3ra_engine.Configure(num_baseline_samples, num_sub_waveforms, p_critical);
 
   // Get the Auxiliary channel types; identifies which channels are SiPM channels
   m_data->CStore.Get("AuxChannelNumToTypeMap",AuxChannelNumToTypeMap);
@@ -78,9 +79,9 @@ bool PhaseIIADCCalibrator::Initialise(std::string config_filename, DataModel& da
   m_variables.Get("MakeCalLEDWaveforms",make_led_waveforms);
   m_variables.Get("WindowIntegrationDB", adc_window_db); 
   
-  // get ROOT fitting variables
-  if(BEType == "rootfit"){
-    m_variables.Get("drawBaselineRootFit",draw_baseline_fit);
+  // get ROOT fitting variables; polyfit fits the same polynomial without ROOT
+  if(BEType == "rootfit" || BEType == "polyfit"){
+    if(BEType == "rootfit") m_variables.Get("drawBaselineRootFit",draw_baseline_fit);
     if(not get_ok) draw_baseline_fit=false;
     m_variables.Get("BaselineFitStartSample",baseline_start_sample);
     if(not get_ok) baseline_start_sample=0;
@@ -116,17 +117,32 @@ bool PhaseIIADCCalibrator::Initialise(std::string config_filename, DataModel& da
   }
 
 
-  if(adc_window_db != "none") channel_window_map = this->load_window_map(adc_window_db);
+  if(adc_window_db != "none" && !window_table.Load(adc_window_db)){
+    Log("PhaseIIADCHitFinder Tool: Input integration window DB file not found. "
+        " no integration will occur. ",
+        1, verbosity);
+  }
 
   m_data->CStore.Set("NumBaselineSamples",num_baseline_samples);
 
 
   m_data->CStore.Set("NewCalibratedData",false);
-  m_data->CStore.Get("TankPMTCrateSpaceToChannelNumMap",TankPMTCrateSpaceToChannelNumMap);
-  m_data->CStore.Get("AuxCrateSpaceToChannelNumMap",AuxCrateSpaceToChannelNumMap);
+  std::map<std::vector<int>,int> CrateSpaceMap;
+  m_data->CStore.Get("TankPMTCrateSpaceToChannelNumMap",CrateSpaceMap);
+  TankPMTCrateSpaceToChannelNumMap = PackCrateSpaceMap(CrateSpaceMap);
+  CrateSpaceMap.clear();
+  m_data->CStore.Get("AuxCrateSpaceToChannelNumMap",CrateSpaceMap);
+  AuxCrateSpaceToChannelNumMap = PackCrateSpaceMap(CrateSpaceMap);
 
   if (eventbuilding_mode){
 
+    int TankWaveKeyVersion = 1;
+    m_data->CStore.Get("TankWaveKeyVersion",TankWaveKeyVersion);
+    if (TankWaveKeyVersion != TANK_WAVE_KEY_VERSION){
+      Log("PhaseIIADCCalibrator ERROR: InProgressTankEvents key version "+std::to_string(TankWaveKeyVersion)+" does not match expected version "+std::to_string(TANK_WAVE_KEY_VERSION)+". Please run an up-to-date PMTDataDecoder upstream of this tool",v_error,verbosity);
+      return false;
+    }
+
     FinishedRawWaveforms = new std::map<uint64_t, std::map<unsigned long,std::vector<Waveform<unsigned short>>>>;
     FinishedRawWaveformsAux = new std::map<uint64_t, std::map<unsigned long,std::vector<Waveform<unsigned short>>>>;
     FinishedCalibratedWaveforms = new std::map<uint64_t, std::map<unsigned long,std::vector<CalibratedADCWaveform<double>>>>;
@@ -153,7 +169,7 @@ bool PhaseIIADCCalibrator::Initialise(std::string config_filename, DataModel& da
 
 bool PhaseIIADCCalibrator::Execute() {
   
-  Log("PhaseIIADCCalibrator Tool: Executing", v_message, verbosity);
+  LOG_LAZY("PhaseIIADCCalibrator Tool: Executing", v_message, verbosity);
 
 
   //ANNIEEvent mode
@@ -168,15 +184,18 @@ bool PhaseIIADCCalibrator::Execute() {
     return false;
   }
 
-  // Load the map containing the ADC raw waveform data
-  std::map<unsigned long, std::vector<Waveform<unsigned short> > >
+  // Load the ADC raw waveform data.  It may have been stored as WaveformBlocks
+  // (ANNIEEventBuilder SaveWaveformBlocks) or as maps; either way it is read through
+  // views of the samples held in raw_block or raw_map
+  WaveformBlock<unsigned short> raw_block, raw_auxblock;
+  std::map<unsigned long, std::vector<Waveform<unsigned short> > > raw_map, raw_auxmap;
+  std::map<unsigned long, std::vector<WaveformView<unsigned short> > >
     raw_waveform_map;
-  // Load the map containing the ADC raw waveform data
-  std::map<unsigned long, std::vector<Waveform<unsigned short> > >
+  std::map<unsigned long, std::vector<WaveformView<unsigned short> > >
     raw_auxwaveform_map;
 
-  bool got_raw_data = annie_event->Get("RawADCData", raw_waveform_map);
-  bool got_rawaux_data = annie_event->Get("RawADCAuxData", raw_auxwaveform_map);
+  bool got_raw_data = GetWaveformViews(*annie_event, "RawADCData", raw_block, raw_map, raw_waveform_map);
+  bool got_rawaux_data = GetWaveformViews(*annie_event, "RawADCAuxData", raw_auxblock, raw_auxmap, raw_auxwaveform_map);
 
   // Check for problems
   if ( !got_raw_data ) {
@@ -212,7 +231,7 @@ bool PhaseIIADCCalibrator::Execute() {
     //Default running: raw_waveforms only has one entry.  If we go to a
     //hefty-mode style of running though, this could have multiple minibuffers
     const auto& raw_waveforms = temp_pair.second;
-    Log("Making calibrated waveforms for ADC channel " +
+    LOG_LAZY("Making calibrated waveforms for ADC channel " +
       std::to_string(channel_key), 3, verbosity);
 
     if(BEType == "ze3ra"){
@@ -221,12 +240,14 @@ bool PhaseIIADCCalibrator::Execute() {
       calibrated_waveform_map[channel_key] = make_calibrated_waveforms_ze3ra_multi(raw_waveforms);
     } else if(BEType == "rootfit"){
       calibrated_waveform_map[channel_key] = make_calibrated_waveforms_rootfit(raw_waveforms);
+    } else if(BEType == "polyfit"){
+      calibrated_waveform_map[channel_key] = make_calibrated_waveforms_polyfit(raw_waveforms);
     } else if (BEType == "simple"){
       calibrated_waveform_map[channel_key] = make_calibrated_waveforms_simple(raw_waveforms);
     }
 
     if(make_led_waveforms){
-      Log("Also making LED window waveforms for ADC channel " +
+      LOG_LAZY("Also making LED window waveforms for ADC channel " +
         std::to_string(channel_key), 3, verbosity);
       std::vector<Waveform<unsigned short>> LEDWaveforms;
       this->make_raw_led_waveforms(channel_key,raw_waveforms,LEDWaveforms);
@@ -237,6 +258,8 @@ bool PhaseIIADCCalibrator::Execute() {
         calibrated_led_waveform_map[channel_key] = make_calibrated_waveforms_ze3ra_multi(LEDWaveforms);
       } else if(BEType == "rootfit"){
         calibrated_led_waveform_map[channel_key] = make_calibrated_waveforms_rootfit(LEDWaveforms);
+      } else if(BEType == "polyfit"){
+        calibrated_led_waveform_map[channel_key] = make_calibrated_waveforms_polyfit(LEDWaveforms);
       } else if(BEType == "simple"){
         calibrated_led_waveform_map[channel_key] = make_calibrated_waveforms_simple(LEDWaveforms);
       }
@@ -246,10 +269,10 @@ bool PhaseIIADCCalibrator::Execute() {
   //Calibrate the SIPM waveforms
   for (const auto& temp_pair : raw_auxwaveform_map) {
     const auto& channel_key = temp_pair.first;
-    Log("Channel key for Aux channel is " +
+    LOG_LAZY("Channel key for Aux channel is " +
       std::to_string(channel_key), 3, verbosity);
     //For now, only calibrate the SiPM waveforms
-    Log("Type for Aux channel is " +
+    LOG_LAZY("Type for Aux channel is " +
       AuxChannelNumToTypeMap->at(channel_key), 3, verbosity);
     if(AuxChannelNumToTypeMap->at(channel_key) != "SiPM1" && 
        AuxChannelNumToTypeMap->at(channel_key) != "SiPM2") continue; 
@@ -257,7 +280,7 @@ bool PhaseIIADCCalibrator::Execute() {
     //hefty-mode style of running though, this could have multiple minibuffers
     const auto& raw_auxwaveforms = temp_pair.second;
 
-    Log("Making calibrated waveforms for Auxiliary channel " +
+    LOG_LAZY("Making calibrated waveforms for Auxiliary channel " +
       std::to_string(channel_key), 3, verbosity);
 
     if(BEType == "ze3ra"){
@@ -266,12 +289,14 @@ bool PhaseIIADCCalibrator::Execute() {
       calibrated_auxwaveform_map[channel_key] = make_calibrated_waveforms_ze3ra_multi(raw_auxwaveforms);
     } else if(BEType == "rootfit"){
       calibrated_auxwaveform_map[channel_key] = make_calibrated_waveforms_rootfit(raw_auxwaveforms);
+    } else if(BEType == "polyfit"){
+      calibrated_auxwaveform_map[channel_key] = make_calibrated_waveforms_polyfit(raw_auxwaveforms);
     } else if (BEType == "simple"){
       calibrated_auxwaveform_map[channel_key] = make_calibrated_waveforms_simple(raw_auxwaveforms);
     }
   }
 
-  Log("PhaseIIADCCalibrator Tool: Setting CalibratedADCData",v_debug,verbosity);
+  LOG_LAZY("PhaseIIADCCalibrator Tool: Setting CalibratedADCData",v_debug,verbosity);
   annie_event->Set("CalibratedADCData", calibrated_waveform_map);
   annie_event->Set("CalibratedADCAuxData", calibrated_auxwaveform_map);
   if(make_led_waveforms){
@@ -303,7 +328,10 @@ bool PhaseIIADCCalibrator::Execute() {
 
     //Loop over FinishedTankEvents, fill FinishedCalibratedWaveforms
     //for(std::pair<uint64_t,std::map<std::vector<int>, std::vector<uint16_t>>> apair : *FinishedTankEvents){
-    for(std::pair<uint64_t,std::map<std::vector<int>, std::vector<uint16_t>>> apair : *InProgressTankEvents){
+    //Each timestamp's waveforms are taken over from InProgressTankEvents (the entry is
+    //erased below) and handed on to the Finished* maps, which the PhaseIIADCHitFinder
+    //empties in turn, so the samples are moved along the chain instead of copied
+    for(std::pair<const uint64_t,std::map<CardChannelKey, std::vector<uint16_t>>> &apair : *InProgressTankEvents){
       uint64_t PMTCounterTime = apair.first;
       //std::cout <<"PMTCounterTime: "<<PMTCounterTime<<", waveform size: "<<apair.second.size()<<std::endl;
 
@@ -311,31 +339,31 @@ bool PhaseIIADCCalibrator::Execute() {
       //if (FinishedRawWaveforms->count(PMTCounterTime) != 0) continue;
       new_data = true;
       RawTimestampsToDelete.push_back(PMTCounterTime);
-      std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = apair.second;
+      std::map<CardChannelKey, std::vector<uint16_t>> &aWaveMap = apair.second;
       std::map<unsigned long, std::vector<Waveform<uint16_t>> > RawADCData;
       std::map<unsigned long, std::vector<Waveform<uint16_t>> > RawADCAuxData;
 //      if (FinishedRawWaveforms->count(PMTCounterTime)>0) RawADCData = FinishedRawWaveforms->at(PMTCounterTime);
 //      if (FinishedRawWaveformsAux->count(PMTCounterTime)>0) RawADCAuxData = FinishedRawWaveformsAux->at(PMTCounterTime);
-      for(std::pair<std::vector<int>, std::vector<uint16_t>> apair : aWaveMap){
-        int CardID = apair.first.at(0);
-        int ChannelID = apair.first.at(1);
+      for(std::pair<const CardChannelKey, std::vector<uint16_t>> &apair : aWaveMap){
+        int CardID = CardIDFromKey(apair.first);
+        int ChannelID = ChannelIDFromKey(apair.first);
         int CrateNum=-1;
         int SlotNum=-1;
         this->CardIDToElectronicsSpace(CardID, CrateNum, SlotNum);
-        std::vector<uint16_t> TheWaveform = apair.second;
-        Waveform<uint16_t> TheWave(PMTCounterTime, TheWaveform);
         //Placing waveform in a vector in case we want a hefty-mode minibuffer storage eventually
-        std::vector<Waveform<uint16_t>> WaveVec{TheWave};
+        std::vector<Waveform<uint16_t>> WaveVec;
+        WaveVec.emplace_back(PMTCounterTime, std::move(apair.second));
   
-        std::vector<int> CrateSpace{CrateNum,SlotNum,ChannelID};
+        CrateSlotChannelKey CrateSpace = MakeCrateSlotChannelKey(CrateNum,SlotNum,ChannelID);
         unsigned long ChannelKey;
-        if(TankPMTCrateSpaceToChannelNumMap.count(CrateSpace)>0){
-          ChannelKey = TankPMTCrateSpaceToChannelNumMap.at(CrateSpace);
-          RawADCData.emplace(ChannelKey,WaveVec);
+        std::unordered_map<CrateSlotChannelKey,int>::const_iterator it_chankey;
+        if((it_chankey = TankPMTCrateSpaceToChannelNumMap.find(CrateSpace)) != TankPMTCrateSpaceToChannelNumMap.end()){
+          ChannelKey = it_chankey->second;
+          RawADCData.emplace(ChannelKey,std::move(WaveVec));
         }
-        else if (AuxCrateSpaceToChannelNumMap.count(CrateSpace)>0){
-          ChannelKey = AuxCrateSpaceToChannelNumMap.at(CrateSpace);
-          RawADCAuxData.emplace(ChannelKey,WaveVec);
+        else if ((it_chankey = AuxCrateSpaceToChannelNumMap.find(CrateSpace)) != AuxCrateSpaceToChannelNumMap.end()){
+          ChannelKey = it_chankey->second;
+          RawADCAuxData.emplace(ChannelKey,std::move(WaveVec));
         } else{
           Log("PhaseIIADCCalibrator:: Cannot find channel key for crate space entry: ",v_error, verbosity);
           Log("PhaseIIADCCalibrator::CrateNum "+to_string(CrateNum),v_error, verbosity);
@@ -388,7 +416,7 @@ bool PhaseIIADCCalibrator::Execute() {
         //hefty-mode style of running though, this could have multiple minibuffers
         const auto& raw_waveforms = temp_pair.second;
         //std::cout <<"Calibrate raw detector waveforms for channel "<<channel_key<<std::endl;
-        Log("Making calibrated waveforms for ADC channel " +  std::to_string(channel_key), 3, verbosity);
+        LOG_LAZY("Making calibrated waveforms for ADC channel " +  std::to_string(channel_key), 3, verbosity);
 
         if(BEType == "ze3ra"){
           calibrated_waveform_map[channel_key] = make_calibrated_waveforms_ze3ra(raw_waveforms);
@@ -396,6 +424,8 @@ bool PhaseIIADCCalibrator::Execute() {
           calibrated_waveform_map[channel_key] = make_calibrated_waveforms_ze3ra_multi(raw_waveforms);
         } else if(BEType == "rootfit"){
           calibrated_waveform_map[channel_key] = make_calibrated_waveforms_rootfit(raw_waveforms);
+        } else if(BEType == "polyfit"){
+          calibrated_waveform_map[channel_key] = make_calibrated_waveforms_polyfit(raw_waveforms);
         } else if (BEType == "simple"){
           calibrated_waveform_map[channel_key] = make_calibrated_waveforms_simple(raw_waveforms);
         }
@@ -416,19 +446,21 @@ bool PhaseIIADCCalibrator::Execute() {
         }*/
 
         if(make_led_waveforms){
-          Log("Also making LED window waveforms for ADC channel " + std::to_string(channel_key), 3, verbosity);
+          LOG_LAZY("Also making LED window waveforms for ADC channel " + std::to_string(channel_key), 3, verbosity);
           std::vector<Waveform<unsigned short>> LEDWaveforms;
           this->make_raw_led_waveforms(channel_key,raw_waveforms,LEDWaveforms);
-          raw_led_waveform_map.emplace(channel_key,LEDWaveforms);
           if(BEType == "ze3ra"){
             calibrated_led_waveform_map[channel_key] = make_calibrated_waveforms_ze3ra(LEDWaveforms);
           } else if(BEType == "ze3ra_multi"){
             calibrated_led_waveform_map[channel_key] = make_calibrated_waveforms_ze3ra_multi(LEDWaveforms);
           } else if(BEType == "rootfit"){
             calibrated_led_waveform_map[channel_key] = make_calibrated_waveforms_rootfit(LEDWaveforms);
+          } else if(BEType == "polyfit"){
+            calibrated_led_waveform_map[channel_key] = make_calibrated_waveforms_polyfit(LEDWaveforms);
           } else if(BEType == "simple"){
             calibrated_led_waveform_map[channel_key] = make_calibrated_waveforms_simple(LEDWaveforms);
           }
+          raw_led_waveform_map.emplace(channel_key,std::move(LEDWaveforms));
 /*
         for (std::pair<unsigned long, std::vector<CalibratedADCWaveform<double>>> apair : temp_calibrated_led_waveform_map){
           unsigned long chkey = apair.first;
@@ -444,15 +476,15 @@ bool PhaseIIADCCalibrator::Execute() {
       //Calibrate the SIPM waveforms
       for (const auto& temp_pair : RawADCAuxData) {
         const auto& channel_key = temp_pair.first;
-        Log("Channel key for Aux channel is " + std::to_string(channel_key), 3, verbosity);
+        LOG_LAZY("Channel key for Aux channel is " + std::to_string(channel_key), 3, verbosity);
         //For now, only calibrate the SiPM waveforms
-        Log("Type for Aux channel is " + AuxChannelNumToTypeMap->at(channel_key), 3, verbosity);
+        LOG_LAZY("Type for Aux channel is " + AuxChannelNumToTypeMap->at(channel_key), 3, verbosity);
         if(AuxChannelNumToTypeMap->at(channel_key) != "SiPM1" && AuxChannelNumToTypeMap->at(channel_key) != "SiPM2") continue; 
         //Default running: raw_waveforms only has one entry.  If we go to a
         //hefty-mode style of running though, this could have multiple minibuffers
         const auto& raw_auxwaveforms = temp_pair.second;
 
-        Log("Making calibrated waveforms for Auxiliary channel " + std::to_string(channel_key), 3, verbosity);
+        LOG_LAZY("Making calibrated waveforms for Auxiliary channel " + std::to_string(channel_key), 3, verbosity);
 
         if(BEType == "ze3ra"){
           calibrated_auxwaveform_map[channel_key] = make_calibrated_waveforms_ze3ra(raw_auxwaveforms);
@@ -460,6 +492,8 @@ bool PhaseIIADCCalibrator::Execute() {
           calibrated_auxwaveform_map[channel_key] = make_calibrated_waveforms_ze3ra_multi(raw_auxwaveforms);
         } else if(BEType == "rootfit"){
           calibrated_auxwaveform_map[channel_key] = make_calibrated_waveforms_rootfit(raw_auxwaveforms);
+        } else if(BEType == "polyfit"){
+          calibrated_auxwaveform_map[channel_key] = make_calibrated_waveforms_polyfit(raw_auxwaveforms);
         } else if (BEType == "simple"){
           calibrated_auxwaveform_map[channel_key] = make_calibrated_waveforms_simple(raw_auxwaveforms);
         }
@@ -474,18 +508,18 @@ bool PhaseIIADCCalibrator::Execute() {
 
       }
 
-      Log("PhaseIIADCCalibrator Tool: Setting CalibratedADCData",v_debug,verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Setting CalibratedADCData",v_debug,verbosity);
       //std::cout <<"RawADCData.size(): "<<RawADCData.size()<<", Calibrated waveforms size: "<<calibrated_waveform_map.size()<<std::endl;
 
-      FinishedRawAcqSize->emplace(PMTCounterTime,waveform_acq_size);
-      FinishedRawWaveforms->emplace(PMTCounterTime,RawADCData);
-      FinishedRawWaveformsAux->emplace(PMTCounterTime,RawADCAuxData);
-      FinishedCalibratedWaveforms->emplace(PMTCounterTime,calibrated_waveform_map);
-      FinishedCalibratedWaveformsAux->emplace(PMTCounterTime,calibrated_auxwaveform_map);
+      FinishedRawAcqSize->emplace(PMTCounterTime,std::move(waveform_acq_size));
+      FinishedRawWaveforms->emplace(PMTCounterTime,std::move(RawADCData));
+      FinishedRawWaveformsAux->emplace(PMTCounterTime,std::move(RawADCAuxData));
+      FinishedCalibratedWaveforms->emplace(PMTCounterTime,std::move(calibrated_waveform_map));
+      FinishedCalibratedWaveformsAux->emplace(PMTCounterTime,std::move(calibrated_auxwaveform_map));
       if(make_led_waveforms){
         std::cout <<"Setting LEDADCData"<<std::endl;
-        FinishedCalibratedLEDADCData->emplace(PMTCounterTime,calibrated_led_waveform_map);
-        FinishedRawLEDADCData->emplace(PMTCounterTime,raw_led_waveform_map);
+        FinishedCalibratedLEDADCData->emplace(PMTCounterTime,std::move(calibrated_led_waveform_map));
+        FinishedRawLEDADCData->emplace(PMTCounterTime,std::move(raw_led_waveform_map));
       }
       //std::cout <<"Set CalibratedADCData"<<std::endl;
     }
@@ -549,124 +583,44 @@ bool PhaseIIADCCalibrator::Finalise() {
   return true;
 }
 
+template <class RawWaveform>
 void PhaseIIADCCalibrator::ze3ra_baseline(
-  const  Waveform<unsigned short> raw_data,
+  const RawWaveform& raw_data,
   double& baseline, double& sigma_baseline, size_t num_baseline_samples,size_t starting_sample)
 {
-
-  // Signal ADC means, variances, and F-distribution probability values
-  // ("P") for the first num_baseline_samples from each minibuffer
-  // (in Hefty mode) or from each sub-minibuffer (in non-Hefty mode)
-  std::vector<double> means;
-  std::vector<double> variances;
-  std::vector<double> Ps;
-
-  // Using the Phase I non-hefty algorithm. Split the early part of the waveform 
-  // into sub-minibuffers and compute the mean and variance of each one.
+  // Using the Phase I non-hefty algorithm. Split the early part of the waveform
+  // into sub-minibuffers, compute the mean and variance of each one, and
+  // combine the ones that pass the F-distribution test (see Ze3raBaseline)
+  ze3ra_engine.Configure(num_baseline_samples, num_sub_waveforms, p_critical);
   const auto& data = raw_data.Samples();
-  for (size_t sub_mb = 0u; sub_mb < num_sub_waveforms; ++sub_mb) {
-    std::vector<unsigned short> sub_mb_data(
-      data.cbegin()+ starting_sample + sub_mb * num_baseline_samples,
-      data.cbegin() + starting_sample + (1u + sub_mb) * num_baseline_samples);
-
-    double mean, var;
-    ComputeMeanAndVariance(sub_mb_data, mean, var, num_baseline_samples);
-
-    means.push_back(mean);
-    variances.push_back(var);
-  }
-
-  // Compute probabilities for the F-distribution test for each waveform chunk
-  for (size_t j = 0; j < variances.size() - 1; ++j) {
-    double sigma2_j = variances.at(j);
-    double sigma2_jp1 = variances.at(j + 1);
-    double F;
-    if (sigma2_j > sigma2_jp1) F = sigma2_j / sigma2_jp1;
-    else F = sigma2_jp1 / sigma2_j;
-
-    double nu = (num_baseline_samples - 1) / 2.;
-    double P = annie_math::Regularized_Beta_Function(1. / (1. + F), nu, nu);
-
-    // Two-tailed hypothesis test (we need to exclude unusually small values
-    // as well as unusually large ones). The tails have equal sizes, so we
-    // may use symmetry and simply multiply our earlier result by 2.
-    P *= 2.;
-
-    // I've never seen this problem (the numerical values for the regularized
-    // beta function that I've checked all fall within [0,1]), but the book
-    // Numerical Recipes includes this check in a similar block of code,
-    // so I'll add it just in case.
-    if (P > 1.) P = 2. - P;
-
-    Ps.push_back(P);
-  }
-
-  // Compute the mean and standard deviation of the baseline signal
-  // for this RawChannel using the mean and standard deviation from
-  // each minibuffer whose F-distribution probability falls below
-  // the critical value.
-  baseline = 0.;
-  sigma_baseline = 0.;
-  double variance_baseline = 0.;
-  size_t num_passing = 0;
-  for (size_t k = 0; k < Ps.size(); ++k) {
-    if (Ps.at(k) > p_critical) {
-      ++num_passing;
-      baseline += means.at(k);
-      variance_baseline += variances.at(k);
-    }
-  }
-
-  if (num_passing > 1) {
-    baseline /= num_passing;
-
-    variance_baseline *= static_cast<double>(num_baseline_samples - 1)
-      / (num_passing*num_baseline_samples - 1);
-    // Now that we've combined the sample variances correctly, take the
-    // square root to get the standard deviation
-    sigma_baseline = std::sqrt( variance_baseline );
-  }
-  else if (num_passing == 1) {
-    // We only have one set of sample statistics, so all we need to
-    // do is take the square root of the variance to get the standard
-    // deviation.
-    sigma_baseline = std::sqrt( variance_baseline );
-  }
-  else {
-    // If none of the minibuffers passed the F-distribution test,
-    // choose the one closest to passing (i.e., the one with the largest
-    // P-value) and adopt its baseline statistics. For a sufficiently large
-    // number of minibuffers (e.g., 40), such a situation should be very rare.
-    // TODO: consider changing this approach
-    auto max_iter = std::max_element(Ps.cbegin(), Ps.cend());
-    int max_index = std::distance(Ps.cbegin(), max_iter);
-
-    baseline = means.at(max_index);
-    sigma_baseline = std::sqrt( variances.at(max_index) );
-  }
+  size_t num_passing = ze3ra_engine.Compute(data.data(), data.size(),
+    starting_sample, baseline, sigma_baseline);
 
   std::string mb_temp_string = "minibuffer";
 
   if (verbosity >= 4) {
-    for ( size_t x = 0; x < Ps.size(); ++x ) {
-      Log("  " + mb_temp_string + " " + std::to_string(x) + ", mean = "
-        + std::to_string(means.at(x)) + ", var = "
-        + std::to_string(variances.at(x)) + ", p-value = "
-        + std::to_string(Ps.at(x)), 4, verbosity);
+    for ( size_t x = 0; x + 1 < ze3ra_engine.NumWindows(); ++x ) {
+      LOG_LAZY("  " + mb_temp_string + " " + std::to_string(x) + ", mean = "
+        + std::to_string(ze3ra_engine.Mean(x)) + ", var = "
+        + std::to_string(ze3ra_engine.Variance(x)) + ", p-value = "
+        + std::to_string(ze3ra_engine.PValue(x)), 4, verbosity);
     }
   }
 
-  Log(std::to_string(num_passing) + " " + mb_temp_string + " pairs passed the"
-    " F-test", 3, verbosity);
-  Log("Baseline estimate: " + std::to_string(baseline) + " ± "
-    + std::to_string(sigma_baseline) + " ADC counts", 3, verbosity);
+  if (verbosity >= 3) {
+    LOG_LAZY(std::to_string(num_passing) + " " + mb_temp_string + " pairs passed the"
+      " F-test", 3, verbosity);
+    LOG_LAZY("Baseline estimate: " + std::to_string(baseline) + " ± "
+      + std::to_string(sigma_baseline) + " ADC counts", 3, verbosity);
+  }
 
 }
 
 // version based on the ze3bra algorithm; assumes a DC offset is sufficient
+template <class RawWaveform>
 std::vector< CalibratedADCWaveform<double> >
 PhaseIIADCCalibrator::make_calibrated_waveforms_simple(
-  const std::vector< Waveform<unsigned short> >& raw_waveforms)
+  const std::vector<RawWaveform>& raw_waveforms)
 {
 
   // Determine the baseline for the set of raw waveforms (assumed to all
@@ -675,22 +629,23 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_simple(
   for (const auto& raw_waveform : raw_waveforms) {
     double baseline, sigma_baseline;
     std::vector<double> cal_data;
-    const std::vector<unsigned short>& raw_data = raw_waveform.Samples();
+    const auto& raw_data = raw_waveform.Samples();
     ComputeMeanAndVariance(raw_data, baseline, sigma_baseline, num_baseline_samples);
     for (const auto& sample : raw_data) {
       cal_data.push_back((static_cast<double>(sample) - baseline)
         * ADC_TO_VOLT);
     }
     calibrated_waveforms.emplace_back(raw_waveform.GetStartTime(),
-      cal_data, baseline, sigma_baseline);
+      std::move(cal_data), baseline, sigma_baseline);
   }
   return calibrated_waveforms;
 }
 
 // version based on the ze3bra algorithm; assumes a DC offset is sufficient
+template <class RawWaveform>
 std::vector< CalibratedADCWaveform<double> >
 PhaseIIADCCalibrator::make_calibrated_waveforms_ze3ra(
-  const std::vector< Waveform<unsigned short> >& raw_waveforms)
+  const std::vector<RawWaveform>& raw_waveforms)
 {
 
   // Determine the baseline for the set of raw waveforms (assumed to all
@@ -701,22 +656,24 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_ze3ra(
     ze3ra_baseline(raw_waveform, baseline, sigma_baseline,
       num_baseline_samples, 0);
     std::vector<double> cal_data;
-    const std::vector<unsigned short>& raw_data = raw_waveform.Samples();
+    const auto& raw_data = raw_waveform.Samples();
+    cal_data.reserve(raw_data.size());
     for (const auto& sample : raw_data) {
       cal_data.push_back((static_cast<double>(sample) - baseline)
         * ADC_TO_VOLT);
     }
   
     calibrated_waveforms.emplace_back(raw_waveform.GetStartTime(),
-      cal_data, baseline, sigma_baseline);
+      std::move(cal_data), baseline, sigma_baseline);
   }
   return calibrated_waveforms;
 }
 
 // version based on the ze3bra algorithm; assumes a DC offset is sufficient
+template <class RawWaveform>
 std::vector< CalibratedADCWaveform<double> >
 PhaseIIADCCalibrator::make_calibrated_waveforms_ze3ra_multi(
-  const std::vector< Waveform<unsigned short> >& raw_waveforms)
+  const std::vector<RawWaveform>& raw_waveforms)
 {
 
   // Determine the baseline for the set of raw waveforms (assumed to all
@@ -748,7 +705,7 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_ze3ra_multi(
       baselines.push_back(first_baseline);
     }
     std::vector<double> cal_data;
-    const std::vector<unsigned short>& raw_data = raw_waveform.Samples();
+    const auto& raw_data = raw_waveform.Samples();
     for (const auto& asample: raw_data){
       for(int j = 0; j<(int)RepresentationRegion.size(); j++){
         if(asample < RepresentationRegion.at(j)){
@@ -765,7 +722,7 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_ze3ra_multi(
     double bl_estimates_mean, bl_estimates_var;
     ComputeMeanAndVariance(baselines, bl_estimates_mean, bl_estimates_var);
     calibrated_waveforms.emplace_back(raw_waveform.GetStartTime(),
-      cal_data, bl_estimates_mean, bl_estimates_var);
+      std::move(cal_data), bl_estimates_mean, bl_estimates_var);
   }
   return calibrated_waveforms;
 }
@@ -773,10 +730,11 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_ze3ra_multi(
 
 
 // version based on a polynomial fit done via ROOT
+template <class RawWaveform>
 std::vector< CalibratedADCWaveform<double> >
 PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
-  const std::vector< Waveform<unsigned short> >& raw_waveforms){
-  Log("PhaseIIADCCalibrator Tool: Doing ROOT based baseline subtraction", v_debug, verbosity);
+  const std::vector<RawWaveform>& raw_waveforms){
+  LOG_LAZY("PhaseIIADCCalibrator Tool: Doing ROOT based baseline subtraction", v_debug, verbosity);
   std::vector< CalibratedADCWaveform<double> > calibrated_waveforms;
   
   // Apparently the input waveforms given to us represent all the minibuffers for one channel,
@@ -787,7 +745,7 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
   if(calibrated_waveform_tgraph==nullptr){
     // we need to know how many points the tgraph will hold
     num_waveform_points = raw_waveforms.front().Samples().size();
-    Log("PhaseIIADCCalibrator Tool: Making TGraph with " + to_string(num_waveform_points)
+    LOG_LAZY("PhaseIIADCCalibrator Tool: Making TGraph with " + to_string(num_waveform_points)
         +" data points", v_debug, verbosity);
     //Log("PhaseIIADCCalibrator Tool: Making new Graph",v_error,verbosity);
     calibrated_waveform_tgraph = new TGraph(num_waveform_points);
@@ -811,7 +769,7 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
     if((num_baseline_samples<=0) || (num_baseline_samples>(num_waveform_points-baseline_start_sample)))
         num_baseline_samples = num_waveform_points;
     if(baseline_start_sample<0) baseline_start_sample = 0;
-    Log("PhaseIIADCCalibrator Tool: Making fit function of type pol"+to_string(baseline_fit_order)
+    LOG_LAZY("PhaseIIADCCalibrator Tool: Making fit function of type pol"+to_string(baseline_fit_order)
          + " to fit waveform samples " + to_string(baseline_start_sample) + " to " 
          + to_string(baseline_start_sample+num_waveform_points), v_debug, verbosity);
     //Log("PhaseIIADCCalibrator Tool: Making new Function",v_error,verbosity);
@@ -824,21 +782,21 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
   }
   
   // Loop over raw waveforms
-  Log("PhaseIIADCCalibrator Tool: Looping over "+to_string(raw_waveforms.size()) + " raw waveforms",
+  LOG_LAZY("PhaseIIADCCalibrator Tool: Looping over "+to_string(raw_waveforms.size()) + " raw waveforms",
       v_debug, verbosity);
   for (const auto& raw_waveform : raw_waveforms){
     
     // retrieve the raw samples
-    const std::vector<unsigned short>& raw_data = raw_waveform.Samples();
+    const auto& raw_data = raw_waveform.Samples();
     
     // update our TGraph's datapoints with the new datapoints
-    Log("PhaseIIADCCalibrator Tool: Setting TGraph datapoints", v_debug, verbosity);
+    LOG_LAZY("PhaseIIADCCalibrator Tool: Setting TGraph datapoints", v_debug, verbosity);
     for(int samplei=0; samplei<(int)raw_data.size(); ++samplei){
       calibrated_waveform_tgraph->SetPoint(samplei,samplei,raw_data.at(samplei));
     }
     
     // fit the graph
-    Log("PhaseIIADCCalibrator Tool: Fitting the baseline", v_debug, verbosity);
+    LOG_LAZY("PhaseIIADCCalibrator Tool: Fitting the baseline", v_debug, verbosity);
     TFitResultPtr fit_result = calibrated_waveform_tgraph->Fit(calibrated_waveform_fit,"RCFSQ"); // F
     // R to use range of TF1
     // F option uses minuit fitter for polN... better?
@@ -851,9 +809,9 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
     std::vector<double> fitpars(baseline_fit_order+1);
     double baseline=0;
     if(not fit_succeeded){
-      Log("PhaseIIADCCalibrator Tool: polynomial fit of baseline failed!",v_warning,verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: polynomial fit of baseline failed!",v_warning,verbosity);
     } else {
-      Log("PhaseIIADCCalibrator Tool: polynomial fit of baseline succeeded, noting parameters",v_debug,verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: polynomial fit of baseline succeeded, noting parameters",v_debug,verbosity);
       // make a note of the current fit parameters, in case we re-do the fit later
       for(int orderi=0; orderi<(baseline_fit_order+1); ++orderi){
         fitpars.at(orderi) = fit_result->Value(orderi);
@@ -863,15 +821,15 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
         logmessage+= to_string(fitpars.at(orderi))+"*x^"+to_string(orderi);
         if(orderi<baseline_fit_order) logmessage+=" + ";
       }
-      Log(logmessage, v_debug, verbosity);
+      LOG_LAZY(logmessage, v_debug, verbosity);
       baseline = fitpars.at(0); // DC offset. FIXME this doesn't fully capture the correction applied
     }
     
     // in either case, draw the data and fit result
     if(draw_baseline_fit){
-      Log("PhaseIIADCCalibrator Tool: Drawing initial baseline fit",v_message,verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Drawing initial baseline fit",v_message,verbosity);
       if(gROOT->FindObject("baselineFitCanvas")==nullptr){
-        Log("PhaseIIADCCalibrator Tool: Constructing canvas for drawing fit", v_debug, verbosity);
+        LOG_LAZY("PhaseIIADCCalibrator Tool: Constructing canvas for drawing fit", v_debug, verbosity);
         //Log("PhaseIIADCCalibrator Tool: Making new Canvas",v_error,verbosity);
         baselineFitCanvas = new TCanvas("baselineFitCanvas");
       } else {
@@ -883,7 +841,7 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
       baselineFitCanvas->Modified();
       baselineFitCanvas->Update();
       gSystem->ProcessEvents();
-      Log("PhaseIIADCCalibrator Tool: Sleeping while waiting for user to close canvas",v_debug,verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Sleeping while waiting for user to close canvas",v_debug,verbosity);
       while(gROOT->FindObject("baselineFitCanvas")!=nullptr){
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
         gSystem->ProcessEvents();
@@ -897,7 +855,7 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
     double cal_data_min=std::numeric_limits<double>::max();
     double cal_data_max=std::numeric_limits<double>::min();
     // loop over samples
-    Log("PhaseIIADCCalibrator Tool: Subtracting baseline and converting to ADC counts", v_debug, verbosity);
+    LOG_LAZY("PhaseIIADCCalibrator Tool: Subtracting baseline and converting to ADC counts", v_debug, verbosity);
     for(uint samplei=0; samplei<raw_data.size(); ++samplei){
       const unsigned short& sample = raw_data.at(samplei);
       if(gROOT->FindObject("calibrated_waveform_fit")==nullptr){
@@ -916,10 +874,10 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
     }
     
     if(draw_baseline_fit){
-      Log("PhaseIIADCCalibrator Tool: Drawing baseline subtracted fit",v_message,verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Drawing baseline subtracted fit",v_message,verbosity);
       
       // update our TGraph's datapoints with the new datapoints
-      Log("PhaseIIADCCalibrator Tool: Setting TGraph datapoints", v_debug, verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Setting TGraph datapoints", v_debug, verbosity);
       for(int samplei=0; samplei<(int)cal_data.size(); ++samplei){
         calibrated_waveform_tgraph->SetPoint(samplei,samplei,cal_data.at(samplei));
       }
@@ -928,7 +886,7 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
       TFitResultPtr fit_result = calibrated_waveform_tgraph->Fit(calibrated_waveform_fit,"RCFSQ"); // F
       
       if(gROOT->FindObject("baselineFitCanvas")==nullptr){
-        Log("PhaseIIADCCalibrator Tool: Constructing canvas for drawing fit", v_debug, verbosity);
+        LOG_LAZY("PhaseIIADCCalibrator Tool: Constructing canvas for drawing fit", v_debug, verbosity);
         //Log("PhaseIIADCCalibrator Tool: Making new Canvas",v_error,verbosity);
         baselineFitCanvas = new TCanvas("baselineFitCanvas");
       } else {
@@ -941,7 +899,7 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
       baselineFitCanvas->Modified();
       baselineFitCanvas->Update();
       gSystem->ProcessEvents();
-      Log("PhaseIIADCCalibrator Tool: Sleeping while waiting for user to close canvas",v_debug,verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Sleeping while waiting for user to close canvas",v_debug,verbosity);
       while(gROOT->FindObject("baselineFitCanvas")!=nullptr){
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
         gSystem->ProcessEvents();
@@ -963,17 +921,17 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
         logmessage+= " which will not invoke outlier removal and refit";
       }
     }
-    Log(logmessage, v_debug, verbosity);
+    LOG_LAZY(logmessage, v_debug, verbosity);
     if((redo_fit_without_outliers) && (cal_data_range>refit_threshold) && (fit_succeeded)){
-      Log("PhaseIIADCCalibrator Tool: Removing outliers", v_debug, verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Removing outliers", v_debug, verbosity);
       
       // find and remove outliers
       std::vector<double> non_outlier_points(cal_data);
       // We'll use interquartile range as a definition of data excluding outliers.
       // First we need to find the interquartile range. Do it the lazy way: with ROOT.
-      Log("PhaseIIADCCalibrator Tool: Getting histogram for quantiles", v_debug, verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Getting histogram for quantiles", v_debug, verbosity);
       if(gROOT->FindObject("raw_datapoint_hist")==nullptr){
-        Log("PhaseIIADCCalibrator Tool: Making histogram for quantile measurement", v_debug, verbosity);
+        LOG_LAZY("PhaseIIADCCalibrator Tool: Making histogram for quantile measurement", v_debug, verbosity);
         //Log("PhaseIIADCCalibrator Tool: Making new Histogram",v_error,verbosity);
         raw_datapoint_hist = new TH1D("raw_datapoint_hist","Raw Data Histogram",200,cal_data_min,cal_data_max);
         if(not raw_datapoint_hist){
@@ -981,7 +939,7 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
           return calibrated_waveforms;
         }
       } else {
-        Log("PhaseIIADCCalibrator Tool: Resetting raw data histogram", v_debug, verbosity);
+        LOG_LAZY("PhaseIIADCCalibrator Tool: Resetting raw data histogram", v_debug, verbosity);
         raw_datapoint_hist->Reset(); raw_datapoint_hist->SetBins(200, cal_data_min, cal_data_max);
       }
       for(double& cal_sample : cal_data){ raw_datapoint_hist->Fill(cal_sample); }
@@ -991,23 +949,23 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
       std::vector<double> threshold_probabilities{0.00,0.95}; // graphs are inverted; only clip top (pulses)
       std::vector<double> threshold_values(threshold_probabilities.size());
       // get the quantile thresholds. Note GetQuantiles asks for it's input arrays backwards...
-      Log("PhaseIIADCCalibrator Tool: Getting Quantiles", v_debug, verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Getting Quantiles", v_debug, verbosity);
       raw_datapoint_hist->GetQuantiles(threshold_probabilities.size(),
           threshold_values.data(),threshold_probabilities.data());
       
-      Log("PhaseIIADCCalibrator Tool: Quantiles were: " + to_string(threshold_values.at(0))
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Quantiles were: " + to_string(threshold_values.at(0))
             +" and "+to_string(threshold_values.at(1)),v_debug,verbosity);
       
       // since we know it: XXX note this is before second baseline subtraction!... not really accurate
-      Log("PhaseIIADCCalibrator Tool: Getting baseline sigma", v_debug, verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Getting baseline sigma", v_debug, verbosity);
       sigma_baseline = raw_datapoint_hist->GetStdDev();
       
       // draw the histogram for check
       if(draw_baseline_fit){
-        Log("PhaseIIADCCalibrator Tool: Drawing histogrammed data for quantile determination",v_message,verbosity);
+        LOG_LAZY("PhaseIIADCCalibrator Tool: Drawing histogrammed data for quantile determination",v_message,verbosity);
         
         if(gROOT->FindObject("baselineFitCanvas")==nullptr){
-          Log("PhaseIIADCCalibrator Tool: Constructing canvas for drawing fit", v_debug, verbosity);
+          LOG_LAZY("PhaseIIADCCalibrator Tool: Constructing canvas for drawing fit", v_debug, verbosity);
           //Log("PhaseIIADCCalibrator Tool: Making new Canvas",v_error,verbosity);
           baselineFitCanvas = new TCanvas("baselineFitCanvas");
         } else {
@@ -1019,7 +977,7 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
         baselineFitCanvas->Modified();
         baselineFitCanvas->Update();
         gSystem->ProcessEvents();
-        Log("PhaseIIADCCalibrator Tool: Sleeping while waiting for user to close canvas",v_debug,verbosity);
+        LOG_LAZY("PhaseIIADCCalibrator Tool: Sleeping while waiting for user to close canvas",v_debug,verbosity);
         while(gROOT->FindObject("baselineFitCanvas")!=nullptr){
           std::this_thread::sleep_for(std::chrono::milliseconds(100));
           gSystem->ProcessEvents();
@@ -1027,7 +985,7 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
       }
       
       // now we can remove any outliers
-      Log("PhaseIIADCCalibrator Tool: Erasing outliers", v_debug, verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Erasing outliers", v_debug, verbosity);
       auto newend = std::remove_if(non_outlier_points.begin(), non_outlier_points.end(),
          [&threshold_values](double& dataval){
            return ( (dataval<threshold_values.front()) || (dataval>threshold_values.back()) );
@@ -1036,7 +994,7 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
       non_outlier_points.erase(newend, non_outlier_points.end());
       
       // update the contents of the TGraph with the outliers removed
-      Log("PhaseIIADCCalibrator Tool: Updating TGraph", v_debug, verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Updating TGraph", v_debug, verbosity);
       for(uint samplei=0; samplei<non_outlier_points.size(); ++samplei){
         calibrated_waveform_tgraph->SetPoint(samplei,samplei,non_outlier_points.at(samplei));
       }
@@ -1047,21 +1005,21 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
       
       // note that this time we have fewer datapoints than before,
       // so we will need to restrict the range of our fit
-      Log("PhaseIIADCCalibrator Tool: Setting TF1 range for outlier removed data", v_debug, verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Setting TF1 range for outlier removed data", v_debug, verbosity);
       calibrated_waveform_fit->SetRange(0, non_outlier_points.size());
       calibrated_waveform_fit->SetMinimum(0);
       calibrated_waveform_fit->SetMaximum(non_outlier_points.size());
       
       // now redo the fit as we did before but with the remaining data
-      Log("PhaseIIADCCalibrator Tool: Redoing fit", v_debug, verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Redoing fit", v_debug, verbosity);
       fit_result = calibrated_waveform_tgraph->Fit(calibrated_waveform_fit,"RCFSQ");
       fit_succeeded = ((static_cast<Int_t>(fit_result))==0);  // successful fit is 0
       
       // Draw the result of the re-fit
       if(draw_baseline_fit){
-        Log("PhaseIIADCCalibrator Tool: Drawing outlier-subtracted baseline fit",v_message,verbosity);
+        LOG_LAZY("PhaseIIADCCalibrator Tool: Drawing outlier-subtracted baseline fit",v_message,verbosity);
         if(gROOT->FindObject("baselineFitCanvas")==nullptr){
-          Log("PhaseIIADCCalibrator Tool: Constructing canvas for drawing fit", v_debug, verbosity);
+          LOG_LAZY("PhaseIIADCCalibrator Tool: Constructing canvas for drawing fit", v_debug, verbosity);
           //Log("PhaseIIADCCalibrator Tool: Making new Canvas",v_error,verbosity);
           baselineFitCanvas = new TCanvas("baselineFitCanvas");
         } else {
@@ -1073,7 +1031,7 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
         baselineFitCanvas->Modified();
         baselineFitCanvas->Update();
         gSystem->ProcessEvents();
-        Log("PhaseIIADCCalibrator Tool: Sleeping while waiting for user to close canvas",v_debug,verbosity);
+        LOG_LAZY("PhaseIIADCCalibrator Tool: Sleeping while waiting for user to close canvas",v_debug,verbosity);
         while(gROOT->FindObject("baselineFitCanvas")!=nullptr){
           std::this_thread::sleep_for(std::chrono::milliseconds(100));
           gSystem->ProcessEvents();
@@ -1081,16 +1039,16 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
       }
       
       if(not fit_succeeded){
-        Log("PhaseIIADCCalibrator Tool: polynomial re-fit of baseline failed!",v_warning,verbosity);
+        LOG_LAZY("PhaseIIADCCalibrator Tool: polynomial re-fit of baseline failed!",v_warning,verbosity);
       } else {
         logmessage="PhaseIIADCCalibrator Tool: Baseline re-fit success: fit function was: ";
         for(int orderi=0; orderi<(baseline_fit_order+1); ++orderi){
           logmessage+= to_string(fit_result->Value(orderi))+"*x^"+to_string(orderi);
           if(orderi<baseline_fit_order) logmessage+=" + ";
         }
-        Log(logmessage, v_debug, verbosity);
+        LOG_LAZY(logmessage, v_debug, verbosity);
         
-        Log("PhaseIIADCCalibrator Tool: Combining with previous fit for final fit parameters", v_debug, verbosity);
+        LOG_LAZY("PhaseIIADCCalibrator Tool: Combining with previous fit for final fit parameters", v_debug, verbosity);
         // get the new fit parameters and add them to the previous ones.
         for(int orderi=0; orderi<(baseline_fit_order+1); ++orderi){
           double new_parameter_val = fit_result->Value(orderi) + fitpars.at(orderi);
@@ -1101,12 +1059,12 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
           logmessage+= to_string(fit_result->Value(orderi))+"*x^"+to_string(orderi);
           if(orderi<baseline_fit_order) logmessage+=" + ";
         }
-        Log(logmessage,v_debug,verbosity);
+        LOG_LAZY(logmessage,v_debug,verbosity);
         
         baseline = calibrated_waveform_fit->GetParameter(0); // DC offset. FIXME doesn't fully capture correction
         
         // update our calibrated values
-        Log("PhaseIIADCCalibrator Tool: Updating calibrated data based on new fit", v_debug, verbosity);
+        LOG_LAZY("PhaseIIADCCalibrator Tool: Updating calibrated data based on new fit", v_debug, verbosity);
         for(uint samplei=0; samplei<raw_data.size(); ++samplei){
           const unsigned short& sample = raw_data.at(samplei);
           double baseline_val = calibrated_waveform_fit->Eval(samplei);
@@ -1116,7 +1074,7 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
       }
       
       // revert our fit range for the next one before we forget
-      Log("PhaseIIADCCalibrator Tool: Resetting TF1 range to default", v_debug, verbosity);
+      LOG_LAZY("PhaseIIADCCalibrator Tool: Resetting TF1 range to default", v_debug, verbosity);
       calibrated_waveform_fit->SetRange(baseline_start_sample,num_baseline_samples);
       calibrated_waveform_fit->SetMinimum(baseline_start_sample);
       calibrated_waveform_fit->SetMaximum(num_baseline_samples);
@@ -1124,20 +1082,20 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
       // Draw the final baseline subtracted data, and a fit, which by defn should be a straight line through 0
       if(draw_baseline_fit){
         // update the contents of the TGraph with the final datapoints
-        Log("PhaseIIADCCalibrator Tool: Updating TGraph", v_debug, verbosity);
+        LOG_LAZY("PhaseIIADCCalibrator Tool: Updating TGraph", v_debug, verbosity);
         calibrated_waveform_tgraph->Set(cal_data.size()); // resize
         for(uint samplei=0; samplei<cal_data.size(); ++samplei){
           calibrated_waveform_tgraph->SetPoint(samplei,samplei,cal_data.at(samplei));
         }
         
         // redo the fit; this time just for check
-        Log("PhaseIIADCCalibrator Tool: Redoing fit once more just to check", v_debug, verbosity);
+        LOG_LAZY("PhaseIIADCCalibrator Tool: Redoing fit once more just to check", v_debug, verbosity);
         fit_result = calibrated_waveform_tgraph->Fit(calibrated_waveform_fit,"RCFSQ");
         fit_succeeded = ((static_cast<Int_t>(fit_result))==0);  // successful fit is 0
         
-        Log("PhaseIIADCCalibrator Tool: Drawing fit to final baseline-subtracted data",v_message,verbosity);
+        LOG_LAZY("PhaseIIADCCalibrator Tool: Drawing fit to final baseline-subtracted data",v_message,verbosity);
         if(gROOT->FindObject("baselineFitCanvas")==nullptr){
-          Log("PhaseIIADCCalibrator Tool: Constructing canvas for drawing fit", v_debug, verbosity);
+          LOG_LAZY("PhaseIIADCCalibrator Tool: Constructing canvas for drawing fit", v_debug, verbosity);
           //Log("PhaseIIADCCalibrator Tool: Making new Canvas",v_error,verbosity);
           baselineFitCanvas = new TCanvas("baselineFitCanvas");
         } else {
@@ -1149,7 +1107,7 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
         baselineFitCanvas->Modified();
         baselineFitCanvas->Update();
         gSystem->ProcessEvents();
-        Log("PhaseIIADCCalibrator Tool: Sleeping while waiting for user to close canvas",v_debug,verbosity);
+        LOG_LAZY("PhaseIIADCCalibrator Tool: Sleeping while waiting for user to close canvas",v_debug,verbosity);
         while(gROOT->FindObject("baselineFitCanvas")!=nullptr){
           std::this_thread::sleep_for(std::chrono::milliseconds(100));
           gSystem->ProcessEvents();
@@ -1158,26 +1116,125 @@ PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit(
     }
     
     // construct the calibrated waveform
-    Log("PhaseIIADCCalibrator Tool: Constructing calibrated waveform", v_debug, verbosity);
-    calibrated_waveforms.emplace_back(raw_waveform.GetStartTime(), cal_data, baseline, sigma_baseline);
+    LOG_LAZY("PhaseIIADCCalibrator Tool: Constructing calibrated waveform", v_debug, verbosity);
+    calibrated_waveforms.emplace_back(raw_waveform.GetStartTime(), std::move(cal_data), baseline, sigma_baseline);
   }
   
   return calibrated_waveforms;
 }
 
+// version fitting the same polynomial as the rootfit version, by closed-form least squares
+template <class RawWaveform>
+std::vector< CalibratedADCWaveform<double> >
+PhaseIIADCCalibrator::make_calibrated_waveforms_polyfit(
+  const std::vector<RawWaveform>& raw_waveforms){
+  std::vector< CalibratedADCWaveform<double> > calibrated_waveforms;
+  if(raw_waveforms.empty()) return calibrated_waveforms;
+
+  // fix the fit range on the first waveforms, exactly as the rootfit version sets up its TF1
+  if(not poly_baseline_configured){
+    num_waveform_points = raw_waveforms.front().Samples().size();
+    if((num_baseline_samples<=0) || (num_baseline_samples>(num_waveform_points-baseline_start_sample)))
+        num_baseline_samples = num_waveform_points;
+    // the TF1 range [start, num_baseline_samples] includes both ends
+    size_t last_sample = std::min(num_baseline_samples, num_waveform_points-1);
+    LOG_LAZY("PhaseIIADCCalibrator Tool: Fitting pol"+to_string(baseline_fit_order)
+         + " to waveform samples " + to_string(baseline_start_sample) + " to "
+         + to_string(last_sample), v_debug, verbosity);
+    poly_baseline.Configure(baseline_fit_order, baseline_start_sample, last_sample);
+    poly_baseline_configured = true;
+  }
+
+  for (const auto& raw_waveform : raw_waveforms){
+    const auto& raw_data = raw_waveform.Samples();
+
+    std::vector<double> fitpars;
+    bool fit_succeeded = poly_baseline.Fit(raw_data, fitpars);
+    double baseline=0;
+    if(not fit_succeeded){
+      LOG_LAZY("PhaseIIADCCalibrator Tool: polynomial fit of baseline failed!",v_warning,verbosity);
+    } else {
+      if(verbosity>=v_debug){
+        logmessage="PhaseIIADCCalibrator Tool: Baseline fit success: fit function was: ";
+        for(int orderi=0; orderi<(baseline_fit_order+1); ++orderi){
+          logmessage+= to_string(fitpars.at(orderi))+"*x^"+to_string(orderi);
+          if(orderi<baseline_fit_order) logmessage+=" + ";
+        }
+        LOG_LAZY(logmessage, v_debug, verbosity);
+      }
+      baseline = fitpars.at(0); // DC offset, as for rootfit
+    }
+
+    // convert samples from ADC count to volts, and subtract the baseline, if fit succeeded
+    std::vector<double> cal_data(raw_data.size());
+    // max starts from the smallest positive double, as in the rootfit version
+    double cal_data_min=std::numeric_limits<double>::max();
+    double cal_data_max=std::numeric_limits<double>::min();
+    for(size_t samplei=0; samplei<raw_data.size(); ++samplei){
+      double baseline_val = (fit_succeeded) ? PolyBaseline::Eval(fitpars, samplei) : 0;
+      double cal_val = (static_cast<double>(raw_data[samplei]) - baseline_val)*ADC_TO_VOLT;
+      cal_data[samplei]=cal_val;
+      if(cal_val<cal_data_min) cal_data_min = cal_val;
+      if(cal_val>cal_data_max) cal_data_max = cal_val;
+    }
+
+    double sigma_baseline = 0;
+
+    // remove outliers and refit, as the rootfit version does: the top 5% of the
+    // baseline-subtracted samples (200 bin histogram quantile) are dropped, the rest is
+    // refitted at x = 0..n-1 and the refit parameters are added to the first fit's
+    double cal_data_range = cal_data_max - cal_data_min;
+    if((redo_fit_without_outliers) && (cal_data_range>refit_threshold) && (fit_succeeded)){
+      std::vector<double> threshold_probabilities{0.00,0.95};
+      std::vector<double> threshold_values;
+      PolyBaseline::HistogramQuantiles(cal_data, 200, cal_data_min, cal_data_max,
+          threshold_probabilities, threshold_values, sigma_baseline);
+
+      std::vector<double> non_outlier_points;
+      non_outlier_points.reserve(cal_data.size());
+      for(double dataval : cal_data){
+        if((dataval>=threshold_values.front()) && (dataval<=threshold_values.back())) non_outlier_points.push_back(dataval);
+      }
+
+      std::vector<double> refitpars;
+      fit_succeeded = (non_outlier_points.size()>0) && PolyBaseline::FitRange(non_outlier_points, 0,
+          non_outlier_points.size()-1, baseline_fit_order, refitpars);
+      if(not fit_succeeded){
+        LOG_LAZY("PhaseIIADCCalibrator Tool: polynomial re-fit of baseline failed!",v_warning,verbosity);
+      } else {
+        for(int orderi=0; orderi<(baseline_fit_order+1); ++orderi) fitpars.at(orderi) += refitpars.at(orderi);
+        baseline = fitpars.at(0);
+        for(size_t samplei=0; samplei<raw_data.size(); ++samplei){
+          double baseline_val = PolyBaseline::Eval(fitpars, samplei);
+          cal_data[samplei] = (static_cast<double>(raw_data[samplei]) - baseline_val)*ADC_TO_VOLT;
+        }
+      }
+    }
+
+    calibrated_waveforms.emplace_back(raw_waveform.GetStartTime(), std::move(cal_data), baseline, sigma_baseline);
+  }
+
+  return calibrated_waveforms;
+}
+
+template <class RawWaveform>
 void PhaseIIADCCalibrator::make_raw_led_waveforms(unsigned long channel_key,
-  const std::vector< Waveform<unsigned short> > raw_waveforms,
+  const std::vector<RawWaveform>& raw_waveforms,
   std::vector< Waveform<unsigned short> >& raw_led_waveforms)
 {
   //Get the windows for this channel key
-  std::vector<std::vector<int>> thispmt_adc_windows;
-  thispmt_adc_windows = this->get_db_windows(channel_key);
+  int window_index = this->get_db_window_index(channel_key);
+  if (window_index < 0) return;
+  const int* window_starts = window_table.WindowStarts(window_index);
+  const int* window_ends = window_table.WindowEnds(window_index);
+  size_t num_windows = window_table.NumWindows(window_index);
+  raw_led_waveforms.reserve(raw_led_waveforms.size() + raw_waveforms.size()*num_windows);
   for(int j=0; j<(int)raw_waveforms.size(); j++){
-    for(int i = 0; i<(int)thispmt_adc_windows.size();i++){
+    const auto& raw_samples = raw_waveforms.at(j).Samples();
+    for(size_t i = 0; i<num_windows;i++){
       // Make a waveform out of this subwindow, plus the number of samples
       // used for background estimation
-      std::vector<int> awindow = thispmt_adc_windows.at(i);
-      int windowmin = awindow.at(0) - ((int)num_baseline_samples);
+      int windowmin = window_starts[i] - ((int)num_baseline_samples);
       if(windowmin<0){
         std::cout << "PhaseIIADCCalibrator Tool WARNING: when making an " <<
             "LED window, there was not enough room prior to the window to " <<
@@ -1185,65 +1242,31 @@ void PhaseIIADCCalibrator::make_raw_led_waveforms(unsigned long channel_key,
            " too close to zero ADC counts." << std::endl;
         windowmin = 0;
       }
-      int windowmax = awindow.at(1);
+      int windowmax = window_ends[i];
+      if(windowmax > (int)raw_samples.size()){
+        throw std::out_of_range("PhaseIIADCCalibrator: LED window ends after the end of the waveform");
+      }
 
-      std::vector<uint16_t> led_waveform;
       //FIXME: want start time of window, not of the full raw waveform
       double start_time = raw_waveforms.at(j).GetStartTime();
-      for (int s = windowmin; s < windowmax; ++s) {
-        led_waveform.push_back(raw_waveforms.at(j).GetSample(s));
-      }
-      Waveform<uint16_t> led_rawwave{start_time,led_waveform};
-      raw_led_waveforms.push_back(led_rawwave);
+      std::vector<uint16_t> led_waveform;
+      if(windowmin < windowmax) led_waveform.assign(raw_samples.begin()+windowmin, raw_samples.begin()+windowmax);
+      raw_led_waveforms.emplace_back(start_time,std::move(led_waveform));
     }
   }
   return;
 }
 
-std::vector<std::vector<int>> PhaseIIADCCalibrator::get_db_windows(unsigned long channelkey){
-    std::vector<std::vector<int>> this_pmt_windows;
-  //Look in the map and check if channelkey exists.
-  if (channel_window_map.find(channelkey) == channel_window_map.end() ) {
+int PhaseIIADCCalibrator::get_db_window_index(unsigned long channelkey){
+  //Look in the table and check if channelkey exists.
+  int window_index = window_table.ChannelIndex(channelkey);
+  if (window_index < 0) {
      if (verbosity>3){
        std::cout << "PhaseIIADCHitFinder Warning: no integration windows found" <<
        "for channel_key" << channelkey <<". Not finding pulses." << std::endl;
        }
-  } else {
-    // gottem
-    this_pmt_windows = channel_window_map.at(channelkey);
-  }
-  return this_pmt_windows;
-}
-
-std::map<unsigned long, std::vector<std::vector<int>>> PhaseIIADCCalibrator::load_window_map(std::string window_db)
-{
-  std::map<unsigned long, std::vector<std::vector<int>>> chanwindowmap;
-  std::string fileline;
-  ifstream myfile(window_db.c_str());
-  if (myfile.is_open()){
-    while(getline(myfile,fileline)){
-      if(fileline.find("#")!=std::string::npos) continue;
-      std::cout << fileline << std::endl; //has our stuff;
-      std::vector<std::string> dataline;
-      boost::split(dataline,fileline, boost::is_any_of(","), boost::token_compress_on);
-      unsigned long chanvalue = std::stoul(dataline.at(0));
-      int windowminvalue = std::stoi(dataline.at(1));
-      int windowmaxvalue = std::stoi(dataline.at(2));
-      std::vector<int> window{windowminvalue,windowmaxvalue};
-      if(chanwindowmap.count(chanvalue)==0){ // Place window range into integral windows
-        std::vector<std::vector<int>> window_vector{window};
-        chanwindowmap.emplace(chanvalue,window_vector);
-      }
-      else { // Add this window to the windows to integrate in
-        chanwindowmap.at(chanvalue).push_back(window);
-      }
-    }
-  } else {
-    Log("PhaseIIADCHitFinder Tool: Input integration window DB file not found. "
-        " no integration will occur. ",
-        1, verbosity);
   }
-  return chanwindowmap;
+  return window_index;
 }
 
 void PhaseIIADCCalibrator::CardIDToElectronicsSpace(int CardID,
@@ -1255,3 +1278,22 @@ void PhaseIIADCCalibrator::CardIDToElectronicsSpace(int CardID,
   CrateNum = CardID / 1000;
   return;
 }
+
+// The raw waveform types the calibration is done for: Waveforms in event building
+// mode, and views of either raw data layout in ANNIEEvent mode
+#define PHASEIIADCCALIBRATOR_INSTANTIATE(RawWaveform) \
+  template std::vector< CalibratedADCWaveform<double> > PhaseIIADCCalibrator::make_calibrated_waveforms_ze3ra( \
+    const std::vector<RawWaveform>& raw_waveforms); \
+  template std::vector< CalibratedADCWaveform<double> > PhaseIIADCCalibrator::make_calibrated_waveforms_ze3ra_multi( \
+    const std::vector<RawWaveform>& raw_waveforms); \
+  template std::vector< CalibratedADCWaveform<double> > PhaseIIADCCalibrator::make_calibrated_waveforms_rootfit( \
+    const std::vector<RawWaveform>& raw_waveforms); \
+  template std::vector< CalibratedADCWaveform<double> > PhaseIIADCCalibrator::make_calibrated_waveforms_polyfit( \
+    const std::vector<RawWaveform>& raw_waveforms); \
+  template std::vector< CalibratedADCWaveform<double> > PhaseIIADCCalibrator::make_calibrated_waveforms_simple( \
+    const std::vector<RawWaveform>& raw_waveforms); \
+  template void PhaseIIADCCalibrator::make_raw_led_waveforms(unsigned long channel_key, \
+    const std::vector<RawWaveform>& raw_waveforms, std::vector< Waveform<unsigned short>>& LEDWaveforms);
+PHASEIIADCCALIBRATOR_INSTANTIATE(Waveform<unsigned short>)
+PHASEIIADCCALIBRATOR_INSTANTIATE(WaveformView<unsigned short>)
+#undef PHASEIIADCCALIBRATOR_INSTANTIATE
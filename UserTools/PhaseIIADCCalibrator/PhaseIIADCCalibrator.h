@@ -10,10 +10,16 @@
 // ToolAnalysis includes
 #include "CalibratedADCWaveform.h"
 #include "Tool.h"
+#include "LazyLog.h"
 #include "Waveform.h"
+#include "WaveformBlock.h"
 #include "annie_math.h"
 #include "ANNIEalgorithms.h"
 #include "ANNIEconstants.h"
+#include "CardChannelKey.h"
+#include "ADCWindowTable.h"
+#include "Ze3raBaseline.h"
+#include "PolyBaseline.h"
 #include <boost/algorithm/string.hpp>
 
 #include <sstream>
@@ -36,40 +42,51 @@ class PhaseIIADCCalibrator : public Tool {
 
   protected:
 
+    // The raw waveforms of a channel are read as Waveforms (event building mode) or as
+    // WaveformViews (ANNIEEvent mode, either data layout); both are instantiated in the .cpp
+
     /// @brief Compute the baseline for a particular RawChannel
     /// object using a technique taken from the ZE3RA code.
     /// @details See section 2.2 of https://arxiv.org/pdf/1106.0808.pdf for a
     /// description of the algorithm.
-    void ze3ra_baseline(const Waveform<unsigned short> raw_data,
+    template <class RawWaveform> void ze3ra_baseline(const RawWaveform& raw_data,
       double& baseline, double& sigma_baseline, size_t num_baseline_samples, size_t starting_sample);
 
+    template <class RawWaveform>
     std::vector< CalibratedADCWaveform<double> > make_calibrated_waveforms_ze3ra(
-      const std::vector< Waveform<unsigned short> >& raw_waveforms);
+      const std::vector<RawWaveform>& raw_waveforms);
     
+    template <class RawWaveform>
     std::vector< CalibratedADCWaveform<double> > make_calibrated_waveforms_ze3ra_multi(
-      const std::vector< Waveform<unsigned short> >& raw_waveforms);
+      const std::vector<RawWaveform>& raw_waveforms);
     
     /// @brief Fit a polynomial to the baseline of each waveform.
+    template <class RawWaveform>
     std::vector< CalibratedADCWaveform<double> > make_calibrated_waveforms_rootfit(
-      const std::vector<Waveform<short unsigned int> >& raw_waveforms);
+      const std::vector<RawWaveform>& raw_waveforms);
+
+    /// @brief Fit the same polynomial as make_calibrated_waveforms_rootfit, by closed-form least squares.
+    template <class RawWaveform>
+    std::vector< CalibratedADCWaveform<double> > make_calibrated_waveforms_polyfit(
+      const std::vector<RawWaveform>& raw_waveforms);
     
     /// @brief Calculate mean and standard deviation using num_baseline_samples at beginning of waveform
+    template <class RawWaveform>
     std::vector< CalibratedADCWaveform<double> > make_calibrated_waveforms_simple(
-      const std::vector<Waveform<short unsigned int> >& raw_waveforms);
+      const std::vector<RawWaveform>& raw_waveforms);
     
     bool use_ze3ra_algorithm;
     bool use_root_algorithm;
  
+    template <class RawWaveform>
     void make_raw_led_waveforms(unsigned long channel_key,
-      const std::vector< Waveform<unsigned short> > raw_waveforms,
+      const std::vector<RawWaveform>& raw_waveforms,
       std::vector< Waveform<unsigned short>>& LEDWaveforms);
-    // Load a PMT's integration windows from the channel_window_map. If none, returns an empty vector.
-    std::vector<std::vector<int>> get_db_windows(unsigned long channelkey);
-   
-    // load the LED pulse window map (CSV file) from the source file given
-    std::map<unsigned long, std::vector<std::vector<int>>> load_window_map(std::string window_db);
+    // Index of a PMT's LED windows in the window_table. If none, returns -1.
+    int get_db_window_index(unsigned long channelkey);
 
-    std::map<unsigned long, std::vector<std::vector<int>>> channel_window_map;
+    // LED pulse windows, loaded once from the window DB (CSV file)
+    ADCWindowTable window_table;
 
     std::string BEType;
 
@@ -85,6 +102,7 @@ class PhaseIIADCCalibrator : public Tool {
     //ze3ra and ze3ra_multi configurables 
     size_t num_baseline_samples;
     size_t num_sub_waveforms;
+    Ze3raBaseline ze3ra_engine;  // window statistics and F-test shared by ze3ra and ze3ra_multi
 
     //ze3ra_multi configurables
     size_t baseline_rep_samples;
@@ -99,11 +117,13 @@ class PhaseIIADCCalibrator : public Tool {
     int baseline_fit_order;
     bool redo_fit_without_outliers;
     double refit_threshold; // V range of the initial baseline subtracted waveform must be > this to trigger refit
+    PolyBaseline poly_baseline;  // pseudo-inverse of the polyfit baseline fit, set up on the first waveforms
+    bool poly_baseline_configured = false;
  
     //Variables specifically intended for Event Building
     bool eventbuilding_mode = false;
     //std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > > *FinishedTankEvents;  //Key: {MTCTime}, value: map of fully-built waveforms from WaveBank
-    std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > > *InProgressTankEvents;  //Key: {MTCTime}, value: map of fully-built waveforms from WaveBank
+    std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t> > > *InProgressTankEvents;  //Key: {MTCTime}, value: map of fully-built waveforms from WaveBank
     std::map<uint64_t, std::map<unsigned long,std::vector<Waveform<unsigned short>>>> *FinishedRawWaveforms;	//Key: {MTCTime}, value: map of raw waveforms
     std::map<uint64_t, std::map<unsigned long,std::vector<Waveform<unsigned short>>>> *FinishedRawWaveformsAux;  //Key: {MTCTime}, value: map of raw waveforms (aux channels)
     std::map<uint64_t, std::map<unsigned long,std::vector<CalibratedADCWaveform<double>>>> *FinishedCalibratedWaveforms;	//Key: {MTCTime}, value: map of calibrated waveforms
@@ -112,8 +132,8 @@ class PhaseIIADCCalibrator : public Tool {
     std::map<uint64_t, std::map<unsigned long,std::vector<Waveform<unsigned short>>>> *FinishedRawLEDADCData;	//Key: {MTCTime}, value: map of raw LED waveforms
     std::map<uint64_t, std::map<unsigned long,std::vector<int>>> *FinishedRawAcqSize;   // Key: {MTCTime}, value: map 
 
-    std::map<std::vector<int>,int> TankPMTCrateSpaceToChannelNumMap;
-    std::map<std::vector<int>,int> AuxCrateSpaceToChannelNumMap;
+    std::unordered_map<CrateSlotChannelKey,int> TankPMTCrateSpaceToChannelNumMap;  //Key: CrateSlotChannelKey(crate,slot,channel), value: channel key
+    std::unordered_map<CrateSlotChannelKey,int> AuxCrateSpaceToChannelNumMap;
 
     int ExecuteCount;
     int ExecutesPerBuild;
@@ -0,0 +1,165 @@
+#include "PolyBaseline.h"
+
+#include <algorithm>
+#include <cmath>
+
+PolyBaseline::PolyBaseline():FitOrder(-1),FirstSample(0),LastSample(0),Valid(false){}
+
+bool PolyBaseline::SolveNormalEquations(size_t first, size_t last, int order,
+    std::vector<double> &inverse, std::vector<double> &to_x, double &centre, double &halfwidth){
+  const int m = order+1;
+  centre = 0.5*(static_cast<double>(first) + static_cast<double>(last));
+  halfwidth = 0.5*(static_cast<double>(last) - static_cast<double>(first));
+  if (halfwidth <= 0.) halfwidth = 1.;
+
+  //V^T V in the rescaled variable: entry (j,k) is the sum of t^(j+k)
+  std::vector<double> powersums(2*m-1,0.);
+  for (size_t i = first; i <= last; i++){
+    double t = (static_cast<double>(i) - centre)/halfwidth;
+    double tk = 1.;
+    for (int k = 0; k < 2*m-1; k++){ powersums[k] += tk; tk *= t; }
+  }
+  std::vector<double> a(m*m);
+  for (int j = 0; j < m; j++){
+    for (int k = 0; k < m; k++) a[j*m+k] = powersums[j+k];
+  }
+
+  //Invert by Gauss-Jordan elimination with partial pivoting
+  inverse.assign(m*m,0.);
+  for (int j = 0; j < m; j++) inverse[j*m+j] = 1.;
+  for (int col = 0; col < m; col++){
+    int pivot = col;
+    for (int row = col+1; row < m; row++){
+      if (fabs(a[row*m+col]) > fabs(a[pivot*m+col])) pivot = row;
+    }
+    if (a[pivot*m+col] == 0.) return false;
+    if (pivot != col){
+      for (int k = 0; k < m; k++){
+        std::swap(a[col*m+k],a[pivot*m+k]);
+        std::swap(inverse[col*m+k],inverse[pivot*m+k]);
+      }
+    }
+    double scale = 1./a[col*m+col];
+    for (int k = 0; k < m; k++){ a[col*m+k] *= scale; inverse[col*m+k] *= scale; }
+    for (int row = 0; row < m; row++){
+      if (row == col || a[row*m+col] == 0.) continue;
+      double factor = a[row*m+col];
+      for (int k = 0; k < m; k++){
+        a[row*m+k] -= factor*a[col*m+k];
+        inverse[row*m+k] -= factor*inverse[col*m+k];
+      }
+    }
+  }
+
+  //t^k = ((x-centre)/halfwidth)^k = sum_j binomial(k,j) x^j (-centre)^(k-j) / halfwidth^k
+  to_x.assign(m*m,0.);
+  for (int k = 0; k < m; k++){
+    double binomial = 1.;
+    for (int j = 0; j <= k; j++){
+      to_x[j*m+k] = binomial*pow(-centre,k-j)/pow(halfwidth,k);
+      binomial = binomial*(k-j)/(j+1);
+    }
+  }
+  return true;
+}
+
+void PolyBaseline::Configure(int order, size_t first_sample, size_t last_sample){
+  if (Valid && order == FitOrder && first_sample == FirstSample && last_sample == LastSample) return;
+  FitOrder = order;
+  FirstSample = first_sample;
+  LastSample = last_sample;
+  Valid = false;
+  PseudoInverse.clear();
+  ToSampleCoeffs.clear();
+  if (order < 0 || last_sample < first_sample || last_sample-first_sample < (size_t)order) return;
+
+  std::vector<double> inverse;
+  double centre, halfwidth;
+  if (!SolveNormalEquations(first_sample,last_sample,order,inverse,ToSampleCoeffs,centre,halfwidth)) return;
+
+  //Row j of the pseudo-inverse: sum_k inverse(j,k) t_i^k for every sample i of the range
+  const int m = order+1;
+  const size_t n = last_sample-first_sample+1;
+  PseudoInverse.assign(m*n,0.);
+  std::vector<double> tpow(m);
+  for (size_t i = 0; i < n; i++){
+    double t = (static_cast<double>(first_sample+i) - centre)/halfwidth;
+    double tk = 1.;
+    for (int k = 0; k < m; k++){ tpow[k] = tk; tk *= t; }
+    for (int j = 0; j < m; j++){
+      double val = 0.;
+      for (int k = 0; k < m; k++) val += inverse[j*m+k]*tpow[k];
+      PseudoInverse[j*n+i] = val;
+    }
+  }
+  Valid = true;
+}
+
+bool PolyBaseline::Fit(const uint16_t *samples, size_t nsamples, std::vector<double> &pars) const {
+  if (!Valid || nsamples <= LastSample){
+    //Waveform shorter than the configured range: fit what there is of it
+    if (nsamples == 0 || nsamples <= FirstSample){
+      pars.assign(FitOrder < 0 ? 0 : FitOrder+1,0.);
+      return false;
+    }
+    return FitRange(samples,nsamples,FirstSample,std::min(LastSample,nsamples-1),FitOrder,pars);
+  }
+  const int m = FitOrder+1;
+  const size_t n = LastSample-FirstSample+1;
+  const uint16_t *y = samples+FirstSample;
+  std::vector<double> coeffs_t(m,0.);
+  for (int j = 0; j < m; j++){
+    const double *row = PseudoInverse.data()+j*n;
+    double val = 0.;
+    for (size_t i = 0; i < n; i++) val += row[i]*y[i];
+    coeffs_t[j] = val;
+  }
+  pars.assign(m,0.);
+  for (int j = 0; j < m; j++){
+    for (int k = 0; k < m; k++) pars[j] += ToSampleCoeffs[j*m+k]*coeffs_t[k];
+  }
+  return true;
+}
+
+void PolyBaseline::HistogramQuantiles(const std::vector<double> &data, int nbins, double xmin, double xmax,
+    const std::vector<double> &probabilities, std::vector<double> &quantiles, double &stddev){
+  quantiles.assign(probabilities.size(),xmin);
+  stddev = 0.;
+  if (nbins <= 0 || !(xmax > xmin)) return;
+
+  //Fill, as TAxis::FindBin bins them: [xmin,xmax) split into nbins equal bins
+  std::vector<double> integral(nbins+1,0.);
+  double sumw = 0., sumwx = 0., sumwx2 = 0.;
+  const double width = (xmax-xmin)/nbins;
+  for (double x : data){
+    if (x < xmin || x >= xmax) continue;
+    int bin = static_cast<int>(nbins*(x-xmin)/(xmax-xmin));
+    if (bin >= nbins) continue;
+    integral[bin+1] += 1.;
+    sumw += 1.; sumwx += x; sumwx2 += x*x;
+  }
+  if (sumw == 0.) return;
+  double mean = sumwx/sumw;
+  stddev = sqrt(fabs(sumwx2/sumw - mean*mean));
+
+  //Normalised cumulative integral, as TH1::ComputeIntegral
+  for (int bin = 1; bin <= nbins; bin++) integral[bin] += integral[bin-1];
+  const double total = integral[nbins];
+  for (double &val : integral) val /= total;
+
+  //Interpolate within the bin holding each probability, as TH1::GetQuantiles
+  for (size_t i = 0; i < probabilities.size(); i++){
+    const double prob = probabilities[i];
+    std::vector<double>::const_iterator it = std::lower_bound(integral.begin(),integral.begin()+nbins,prob);
+    int ibin = (it != integral.begin()+nbins && *it == prob) ? static_cast<int>(it-integral.begin())
+                                                            : static_cast<int>(it-integral.begin())-1;
+    while (ibin < nbins-1 && integral[ibin+1] == prob){
+      if (integral[ibin+2] == prob) ibin++;
+      else break;
+    }
+    if (ibin < 0) ibin = 0;
+    quantiles[i] = xmin + ibin*width;
+    const double dint = integral[ibin+1]-integral[ibin];
+    if (dint > 0) quantiles[i] += width*(prob-integral[ibin])/dint;
+  }
+}
@@ -0,0 +1,113 @@
+#ifndef PolyBaseline_H
+#define PolyBaseline_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+/**
+* \class PolyBaseline
+*
+* Closed-form least-squares polynomial baseline, as used by the PhaseIIADCCalibrator's
+* "polyfit" baseline estimation.  It fits the same model as the "rootfit" method (a polN
+* in the sample number over the samples [first_sample, last_sample], both included) but
+* without going through a TGraph, a TF1 and Minuit.
+*
+* The fit matrix only depends on the order and the sample range, so Configure() solves
+* the normal equations once and keeps the pseudo-inverse (V^T V)^-1 V^T of the
+* Vandermonde matrix V.  A fit is then one (order+1) x n matrix-vector product over the
+* raw samples.  The polynomial is built in the sample number rescaled to [-1,1], so the
+* normal equations stay well conditioned.  The coefficients are handed back as
+* coefficients of powers of the sample number, like the TF1 parameters.  Fits over
+* other ranges (short waveforms, the outlier-removed refit) solve the normal equations
+* on the spot.
+*
+* The object is only written to by Configure(), so one instance can be shared by
+* threads calibrating different waveforms.
+*/
+
+class PolyBaseline {
+
+ public:
+
+  PolyBaseline();
+
+  /// Set the polynomial order and the inclusive sample range of the fit
+  void Configure(int order, size_t first_sample, size_t last_sample);
+
+  int Order() const { return FitOrder; }
+
+  /// Fit the configured sample range of a waveform.  If the waveform ends before the
+  /// range does, only its samples within the range are fitted.  Returns false if there
+  /// are fewer samples than parameters.
+  bool Fit(const uint16_t *samples, size_t nsamples, std::vector<double> &pars) const;
+  /// As above, for the Samples() of a Waveform or a WaveformView
+  template<typename Samples> bool Fit(const Samples &samples, std::vector<double> &pars) const {
+    return Fit(samples.data(), samples.size(), pars);
+  }
+
+  /// Fit y[i] at x = i over the samples [first, last] of the n values of y
+  template<typename T> static bool FitRange(const T *y, size_t n, size_t first, size_t last,
+      int order, std::vector<double> &pars);
+  template<typename T> static bool FitRange(const std::vector<T> &y, size_t first, size_t last,
+      int order, std::vector<double> &pars){
+    return FitRange(y.data(), y.size(), first, last, order, pars);
+  }
+
+  /// Value of the polynomial with coefficients pars at x
+  static double Eval(const std::vector<double> &pars, double x){
+    double val = 0.;
+    for (size_t k = pars.size(); k-- > 0; ) val = val*x + pars[k];
+    return val;
+  }
+
+  /// Quantiles of data as TH1::GetQuantiles finds them in a histogram of nbins bins over
+  /// [xmin,xmax).  Values outside that range are not counted, as they would fall into the
+  /// under/overflow bins; stddev is their unbinned standard deviation (TH1::GetStdDev).
+  static void HistogramQuantiles(const std::vector<double> &data, int nbins, double xmin, double xmax,
+      const std::vector<double> &probabilities, std::vector<double> &quantiles, double &stddev);
+
+ private:
+
+  /// Solve the normal equations for the points x in [first,last], rescaled to t in [-1,1].
+  /// On success, inverse holds (V^T V)^-1 and to_x converts coefficients in t to
+  /// coefficients in x.
+  static bool SolveNormalEquations(size_t first, size_t last, int order,
+      std::vector<double> &inverse, std::vector<double> &to_x, double &centre, double &halfwidth);
+
+  int FitOrder;
+  size_t FirstSample;
+  size_t LastSample;
+  bool Valid;
+  std::vector<double> PseudoInverse;   // (order+1) x n, row major
+  std::vector<double> ToSampleCoeffs;  // (order+1) x (order+1), t coefficients to x coefficients
+
+};
+
+template<typename T> bool PolyBaseline::FitRange(const T *y, size_t n, size_t first, size_t last,
+    int order, std::vector<double> &pars){
+  pars.assign(order+1,0.);
+  if (order < 0 || last >= n || last < first || last-first < (size_t)order) return false;
+  std::vector<double> inverse, to_x;
+  double centre, halfwidth;
+  if (!SolveNormalEquations(first,last,order,inverse,to_x,centre,halfwidth)) return false;
+  const int m = order+1;
+  //V^T y in the rescaled variable
+  std::vector<double> vty(m,0.);
+  for (size_t i = first; i <= last; i++){
+    double t = (static_cast<double>(i) - centre)/halfwidth;
+    double tk = 1.;
+    double yi = static_cast<double>(y[i]);
+    for (int k = 0; k < m; k++){ vty[k] += tk*yi; tk *= t; }
+  }
+  std::vector<double> coeffs_t(m,0.);
+  for (int j = 0; j < m; j++){
+    for (int k = 0; k < m; k++) coeffs_t[j] += inverse[j*m+k]*vty[k];
+  }
+  for (int j = 0; j < m; j++){
+    for (int k = 0; k < m; k++) pars[j] += to_x[j*m+k]*coeffs_t[k];
+  }
+  return true;
+}
+
+#endif
@@ -0,0 +1,168 @@
+#include "Ze3raBaseline.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "annie_math.h"
+
+Ze3raBaseline::Ze3raBaseline():NumBaselineSamples(0),NumSubWaveforms(0),PCritical(0.),FCritical(0.),UseFCritical(false){}
+
+double Ze3raBaseline::FTestPValue(double sigma2_a, double sigma2_b, size_t num_baseline_samples){
+  double F;
+  if (sigma2_a > sigma2_b) F = sigma2_a / sigma2_b;
+  else F = sigma2_b / sigma2_a;
+
+  double nu = (num_baseline_samples - 1) / 2.;
+  double P = annie_math::Regularized_Beta_Function(1. / (1. + F), nu, nu);
+
+  // Two-tailed hypothesis test (we need to exclude unusually small values
+  // as well as unusually large ones). The tails have equal sizes, so we
+  // may use symmetry and simply multiply our earlier result by 2.
+  P *= 2.;
+
+  // Numerical Recipes includes this check in a similar block of code
+  if (P > 1.) P = 2. - P;
+
+  return P;
+}
+
+void Ze3raBaseline::Configure(size_t num_baseline_samples, size_t num_sub_waveforms, double p_critical){
+  if (num_baseline_samples == NumBaselineSamples && num_sub_waveforms == NumSubWaveforms && p_critical == PCritical) return;
+  NumBaselineSamples = num_baseline_samples;
+  NumSubWaveforms = num_sub_waveforms;
+  PCritical = p_critical;
+  Means.reserve(NumSubWaveforms);
+  Variances.reserve(NumSubWaveforms);
+
+  //The p-value of F = sigma2_a/sigma2_b (with F >= 1) falls from 1 at F = 1 towards 0.
+  //Bisect for the largest F that still passes; if F = 1 already fails, or the
+  //p-value misbehaves, every pair is tested with the full p-value instead.
+  UseFCritical = false;
+  if (NumBaselineSamples < 2) return;
+  auto p_of_F = [this](double F){ return FTestPValue(F, 1., NumBaselineSamples); };
+  if (!(p_of_F(1.) > PCritical)) return;
+
+  double lo = 1.;
+  double hi = 2.;
+  while (p_of_F(hi) > PCritical){
+    lo = hi;
+    hi *= 2.;
+    if (std::isinf(hi)) {
+      FCritical = std::numeric_limits<double>::max();
+      UseFCritical = true;
+      return;
+    }
+  }
+  //Invariant: p(lo) > PCritical >= p(hi); stop when they are neighbouring doubles
+  while (std::nextafter(lo, hi) < hi){
+    double mid = lo + 0.5*(hi - lo);
+    if (mid <= lo || mid >= hi) break;
+    if (p_of_F(mid) > PCritical) lo = mid;
+    else hi = mid;
+  }
+  FCritical = lo;
+  UseFCritical = true;
+}
+
+double Ze3raBaseline::PValue(size_t pair) const {
+  return FTestPValue(Variances[pair], Variances[pair+1], NumBaselineSamples);
+}
+
+size_t Ze3raBaseline::Compute(const uint16_t *samples, size_t num_samples, size_t starting_sample,
+    double &baseline, double &sigma_baseline){
+
+  const size_t n = NumBaselineSamples;
+  Means.clear();
+  Variances.clear();
+
+  // Mean and sample variance of each window.  The sums are exact integers, so they
+  // can be accumulated in any order (and vectorised by the compiler).
+  for (size_t sub_mb = 0u; sub_mb < NumSubWaveforms; ++sub_mb) {
+    size_t first = starting_sample + sub_mb * n;
+    if (n == 0 || first + n > num_samples) break;
+    const uint16_t *window = samples + first;
+    uint64_t sum = 0;
+    uint64_t sum2 = 0;
+    for (size_t i = 0; i < n; ++i) {
+      uint32_t x = window[i];
+      sum += x;
+      sum2 += x*x;
+    }
+    double mean = static_cast<double>(sum) / n;
+    double var = 0.;
+    if (n > 1) {
+      // n*sum2 - sum^2 is the exact n*(n-1)*variance; it cannot overflow for 16-bit
+      // samples unless a window holds more than ~60000 samples
+      uint64_t nm2 = n*sum2 - sum*sum;
+      var = static_cast<double>(nm2) / (static_cast<double>(n) * static_cast<double>(n - 1));
+    }
+    Means.push_back(mean);
+    Variances.push_back(var);
+  }
+
+  const size_t num_windows = Means.size();
+  if (num_windows < 2) {
+    // Not enough of the waveform to compare windows
+    baseline = (num_windows == 1)? Means[0] : std::numeric_limits<double>::quiet_NaN();
+    sigma_baseline = (num_windows == 1)? std::sqrt(Variances[0]) : baseline;
+    return 0;
+  }
+
+  // F-test for each pair of neighbouring windows
+  size_t num_passing = 0;
+  baseline = 0.;
+  sigma_baseline = 0.;
+  double variance_baseline = 0.;
+  for (size_t j = 0; j + 1 < num_windows; ++j) {
+    double sigma2_j = Variances[j];
+    double sigma2_jp1 = Variances[j + 1];
+    bool passed;
+    if (UseFCritical && sigma2_j > 0. && sigma2_jp1 > 0.) {
+      double F = (sigma2_j > sigma2_jp1)? sigma2_j / sigma2_jp1 : sigma2_jp1 / sigma2_j;
+      passed = (F <= FCritical);
+    } else {
+      passed = (PValue(j) > PCritical);
+    }
+    if (passed) {
+      ++num_passing;
+      baseline += Means[j];
+      variance_baseline += Variances[j];
+    }
+  }
+
+  if (num_passing > 1) {
+    baseline /= num_passing;
+
+    variance_baseline *= static_cast<double>(n - 1)
+      / (num_passing*n - 1);
+    // Now that we've combined the sample variances correctly, take the
+    // square root to get the standard deviation
+    sigma_baseline = std::sqrt( variance_baseline );
+  }
+  else if (num_passing == 1) {
+    // We only have one set of sample statistics, so all we need to
+    // do is take the square root of the variance to get the standard
+    // deviation.
+    sigma_baseline = std::sqrt( variance_baseline );
+  }
+  else {
+    // If none of the windows passed the F-test, choose the one closest to
+    // passing (i.e., the one with the largest P-value) and adopt its baseline
+    // statistics.
+    double max_P = PValue(0);
+    size_t max_index = 0;
+    for (size_t j = 1; j + 1 < num_windows; ++j) {
+      double P = PValue(j);
+      if (P > max_P) {
+        max_P = P;
+        max_index = j;
+      }
+    }
+
+    baseline = Means[max_index];
+    sigma_baseline = std::sqrt( Variances[max_index] );
+  }
+
+  return num_passing;
+}
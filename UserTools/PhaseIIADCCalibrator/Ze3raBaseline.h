@@ -0,0 +1,70 @@
+#ifndef Ze3raBaseline_H
+#define Ze3raBaseline_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+/**
+* \class Ze3raBaseline
+*
+* Baseline estimate of the ZE3RA code (section 2.2 of https://arxiv.org/pdf/1106.0808.pdf)
+* as used by the PhaseIIADCCalibrator.  The early part of a waveform is split into
+* num_sub_waveforms windows of num_baseline_samples samples each, and the windows whose
+* variance is consistent with the next window's (F-test) are averaged.
+*
+* The window sums and sums of squares are accumulated as integers straight from the
+* waveform samples, without copying them, into scratch buffers that are reused from one
+* waveform to the next.  The F-test p-value only decreases with the variance ratio F, so
+* Configure() solves once for the largest ratio that still passes p_critical, and the
+* test itself becomes a comparison.  p-values are only evaluated (with
+* annie_math::Regularized_Beta_Function) for the rare waveform where no window passes,
+* for degenerate (zero) variances and for debug printout.
+*
+* Compared with the former per-window ComputeMeanAndVariance, means and variances agree
+* to within 1e-12 relative; they are now exact up to the final division.  The F-test
+* decisions only differ where the exact variance ratio sits on the critical value, or
+* where two window pairs have exactly the same ratio when picking the best of the failing
+* pairs.  In those cases the running-sum rounding of the former code decided the outcome.
+* Such exact ties only occur for windows of very quiet integer samples, and the baseline
+* then changes by about the sample spread.  src/BenchmarkZe3raBaseline.cpp keeps the
+* former code and compares the two.
+*/
+
+class Ze3raBaseline {
+
+ public:
+
+  Ze3raBaseline();
+
+  void Configure(size_t num_baseline_samples, size_t num_sub_waveforms, double p_critical);
+
+  /// Estimate the baseline from the windows starting at samples[starting_sample].  Windows
+  /// running past the end of the waveform are not used.  Returns the number of window
+  /// pairs that passed the F-test.
+  size_t Compute(const uint16_t *samples, size_t num_samples, size_t starting_sample,
+      double &baseline, double &sigma_baseline);
+
+  /// Window statistics of the last Compute() call
+  size_t NumWindows() const { return Means.size(); }
+  double Mean(size_t window) const { return Means[window]; }
+  double Variance(size_t window) const { return Variances[window]; }
+  double PValue(size_t pair) const;   ///< F-test p-value of windows pair and pair+1
+
+  /// Two-tailed F-test p-value for equal variances with num_baseline_samples samples each
+  static double FTestPValue(double sigma2_a, double sigma2_b, size_t num_baseline_samples);
+
+ private:
+
+  size_t NumBaselineSamples;
+  size_t NumSubWaveforms;
+  double PCritical;
+  double FCritical;        // largest variance ratio with a p-value above PCritical
+  bool UseFCritical;       // false if the p-value is not monotonic over the range needed
+
+  std::vector<double> Means;
+  std::vector<double> Variances;
+
+};
+
+#endif
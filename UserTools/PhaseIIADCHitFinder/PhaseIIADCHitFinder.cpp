@@ -23,6 +23,7 @@ bool PhaseIIADCHitFinder::Initialise(std::string config_filename, DataModel& dat
   pulse_window_end_shift = 25;
   adc_window_db = "none"; //Used when pulse_finding_approach="fixed_windows"
   eventbuilding_mode = false;
+  hitfinder_threads = 1;
 
   //Load any configurables set in the config file
   m_variables.Get("verbosity",verbosity); 
@@ -36,6 +37,7 @@ bool PhaseIIADCHitFinder::Initialise(std::string config_filename, DataModel& dat
   m_variables.Get("PulseWindowEnd", pulse_window_end_shift);
   m_variables.Get("WindowIntegrationDB", adc_window_db); 
   m_variables.Get("EventBuilding",eventbuilding_mode);
+  m_variables.Get("HitFinderThreads",hitfinder_threads);
 
   if ((pulse_window_start_shift > 0) || (pulse_window_end_shift) < 0){
     Log("PhaseIIADCHitFinder Tool: WARNING... trigger threshold crossing will not be inside pulse window.  Threshold" 
@@ -58,7 +60,11 @@ bool PhaseIIADCHitFinder::Initialise(std::string config_filename, DataModel& dat
 
   //Load window and threshold CSV files if defined
   if(adc_threshold_db != "none") channel_threshold_map = this->load_channel_threshold_map(adc_threshold_db);
-  if(adc_window_db != "none") channel_window_map = this->load_integration_window_map(adc_window_db);
+  if(adc_window_db != "none" && !window_table.Load(adc_window_db)){
+    Log("PhaseIIADCHitFinder Tool ERROR! Input integration window DB file not found! "
+        " no integration will occur. ",
+        v_warning, verbosity);
+  }
 
   if (eventbuilding_mode != false && eventbuilding_mode != true){
     Log("PhaseIIADCCalibrator: Event Building mode not recognized. Default to false",v_warning,verbosity);
@@ -77,6 +83,12 @@ bool PhaseIIADCHitFinder::Initialise(std::string config_filename, DataModel& dat
 
   m_data->CStore.Set("NewHitsData",false);
 
+  //Worker pool for finding the pulses of different channels in parallel
+  StopPool = false;
+  for (int i=0; i<hitfinder_threads && hitfinder_threads>1; i++){
+    HitFinderPool.push_back(std::thread(&PhaseIIADCHitFinder::HitFinderWorker,this));
+  }
+
   if (eventbuilding_mode){
     InProgressHits = new std::map<uint64_t, std::map<unsigned long,std::vector<Hit>>*>;
     InProgressHitsAux = new std::map<uint64_t, std::map<unsigned long,std::vector<Hit>>*>;
@@ -118,14 +130,15 @@ bool PhaseIIADCHitFinder::Execute() {
       return false;
     }
 
-    // Load the maps containing the ADC raw waveform data
+    // Load the ADC raw waveform data, stored as maps or as WaveformBlocks
     bool got_raw_data = false;
     bool got_rawaux_data = false;
     if(use_led_waveforms){
       got_raw_data = annie_event->Get("RawLEDADCData", raw_waveform_map);
+      GetViews(raw_waveform_map, raw_views);
     } else {
-      got_raw_data = annie_event->Get("RawADCData", raw_waveform_map);
-      got_rawaux_data = annie_event->Get("RawADCAuxData", raw_aux_waveform_map);
+      got_raw_data = GetWaveformViews(*annie_event, "RawADCData", raw_block, raw_waveform_map, raw_views);
+      got_rawaux_data = GetWaveformViews(*annie_event, "RawADCAuxData", raw_aux_block, raw_aux_waveform_map, raw_aux_views);
     }
     // Check for problems
     if ( !got_raw_data ) {
@@ -138,22 +151,24 @@ bool PhaseIIADCHitFinder::Execute() {
         verbosity);
       return false;
     }
-    else if ( raw_waveform_map.empty() ) {
+    else if ( raw_views.empty() ) {
       Log("Error: The PhaseIIADCHitFinder tool found an empty RawADCData entry", v_error,
         verbosity);
       return false;
     }
     
-    // Load the maps containing the ADC calibrated waveform data
+    // Load the ADC calibrated waveform data, stored as maps or as WaveformBlocks
     bool got_calibrated_data = false;
     bool got_calibratedaux_data = false;
     if(use_led_waveforms){
       got_calibrated_data = annie_event->Get("CalibratedLEDADCData",
         calibrated_waveform_map);
+      GetViews(calibrated_waveform_map, calibrated_views);
     } else {
-      got_calibrated_data = annie_event->Get("CalibratedADCData",
-        calibrated_waveform_map);
-      got_calibratedaux_data = annie_event->Get("CalibratedADCAuxData", calibrated_aux_waveform_map);
+      got_calibrated_data = GetWaveformViews(*annie_event, "CalibratedADCData",
+        calibrated_block, calibrated_waveform_map, calibrated_views);
+      got_calibratedaux_data = GetWaveformViews(*annie_event, "CalibratedADCAuxData",
+        calibrated_aux_block, calibrated_aux_waveform_map, calibrated_aux_views);
     }
 
     // Check for problems
@@ -167,21 +182,37 @@ bool PhaseIIADCHitFinder::Execute() {
         " entry", v_error, verbosity);
       return false;
     }
-    else if ( calibrated_waveform_map.empty() ) {
+    else if ( calibrated_views.empty() ) {
       Log("Error: The PhaseIIADCHitFinder tool found an empty CalibratedADCData entry",
         v_error, verbosity);
       return false;
     }
 
     //Find pulses in the raw detector data
-    for (const auto& temp_pair : raw_waveform_map) {
+    std::vector<ChannelPulseTask> PulseTasks;
+    for (const auto& temp_pair : raw_views) {
       const auto& achannel_key = temp_pair.first;
       const auto& araw_waveforms = temp_pair.second;
       //Don't make hit objects for any offline channels
       Channel* thischannel = geom->GetChannel(achannel_key);
       if(thischannel->GetStatus() == channelstatus::OFF) continue;
-      std::vector<CalibratedADCWaveform<double> > acalibrated_waveforms = calibrated_waveform_map.at(achannel_key);
-      bool MadeMaps = this->build_pulse_and_hit_map(achannel_key, araw_waveforms, acalibrated_waveforms, pulse_map,*hit_map);
+      const std::vector<WaveformView<double> >& acalibrated_waveforms = calibrated_views.at(achannel_key);
+      this->AddPulseTask(achannel_key, araw_waveforms, acalibrated_waveforms, PulseTasks);
+    }
+    size_t FirstAuxTask = PulseTasks.size();
+    //Find pulses in the raw auxiliary channel data
+    for (const auto& temp_pair : raw_aux_views) {
+      const auto& achannel_key = temp_pair.first;
+      if(AuxChannelNumToTypeMap->at(achannel_key) != "SiPM1" &&
+        AuxChannelNumToTypeMap->at(achannel_key) != "SiPM2") continue; 
+      const auto& araw_waveforms = temp_pair.second;
+      const std::vector<WaveformView<double> >& acalibrated_waveforms = calibrated_aux_views.at(achannel_key);
+      this->AddPulseTask(achannel_key, araw_waveforms, acalibrated_waveforms, PulseTasks);
+    }
+    this->FindPulseTasks(PulseTasks);
+
+    for (size_t i_task = 0; i_task < FirstAuxTask; i_task++){
+      bool MadeMaps = this->MergeChannelPulses(PulseTasks.at(i_task), pulse_map,*hit_map);
       if(!MadeMaps){
         Log("PhaseIIADCHitFinder Error: problem making PMT hit and pulse maps", 0, verbosity);
         return false;
@@ -193,14 +224,8 @@ bool PhaseIIADCHitFinder::Execute() {
     annie_event->Set("Hits", hit_map,true);
 
     Log("PhaseIIADCHitFinder Tool: Finding SiPM pulses in auxiliary channels", v_debug, verbosity);
-    //Find pulses in the raw auxiliary channel data
-    for (const auto& temp_pair : raw_aux_waveform_map) {
-      const auto& achannel_key = temp_pair.first;
-      if(AuxChannelNumToTypeMap->at(achannel_key) != "SiPM1" &&
-        AuxChannelNumToTypeMap->at(achannel_key) != "SiPM2") continue; 
-      const auto& araw_waveforms = temp_pair.second;
-      std::vector<CalibratedADCWaveform<double> > acalibrated_waveforms = calibrated_aux_waveform_map.at(achannel_key);
-      bool MadeAuxMaps = this->build_pulse_and_hit_map(achannel_key, araw_waveforms, acalibrated_waveforms, aux_pulse_map,*aux_hit_map);
+    for (size_t i_task = FirstAuxTask; i_task < PulseTasks.size(); i_task++){
+      bool MadeAuxMaps = this->MergeChannelPulses(PulseTasks.at(i_task), aux_pulse_map,*aux_hit_map);
       if(!MadeAuxMaps){
         Log("PhaseIIADCHitFinder Error: problem making  Aux hit and pulse maps", 0, verbosity);
         return false;
@@ -252,94 +277,106 @@ bool PhaseIIADCHitFinder::Execute() {
 
     std::vector<uint64_t> CalibratedTimestampsToDelete;
 
-    for(std::pair<uint64_t,std::map<unsigned long, std::vector<Waveform<unsigned short>>>> apair : *FinishedRawWaveforms){
-      uint64_t PMTCounterTime = apair.first;
+    //The pulses of all channels of all timestamps are found in one batch (on the worker pool
+    //if HitFinderThreads > 1), then merged into the InProgress maps timestamp by timestamp.
+    //The Finished* maps are only read here and erased below, so the tasks refer to them
+    //rather than copying the waveforms.
+    std::vector<ChannelPulseTask> PulseTasks;
+    std::vector<TimestampPulseTasks> TimestampTasks;
+    try {
+      for(const std::pair<const uint64_t,std::map<unsigned long, std::vector<Waveform<unsigned short>>>> &apair : *FinishedRawWaveforms){
+        uint64_t PMTCounterTime = apair.first;
       
-      //Skip already processed events
-      //if (FinishedHits->count(PMTCounterTime) != 0) continue;
-      CalibratedTimestampsToDelete.push_back(PMTCounterTime);
-
-      new_data = true;
-
-      //std::cout <<"Sizes: "<<std::endl;
-      //std::cout <<"Hits: Timestamp: "<<PMTCounterTime<<", RawWaveform: "<<apair.second.size()<<std::endl;
-      //std::cout <<"RawWaveformAux: "<<FinishedRawWaveformsAux->size();
-      //std::cout <<"FinishedCalibratedWaveforms: "<<FinishedCalibratedWaveforms->size();
-      //std::cout <<"FinishedCalibratedWaveformsAux: "<<FinishedCalibratedWaveformsAux->size();
-      //Get all the maps
-      std::map<unsigned long, std::vector<Waveform<unsigned short>>> aRawWaveformMap = apair.second;
-      std::map<unsigned long, std::vector<Waveform<unsigned short>>> aRawWaveformMapAux;
-      std::map<unsigned long, std::vector<CalibratedADCWaveform<double>>> aCalibratedWaveformMap;
-      std::map<unsigned long, std::vector<CalibratedADCWaveform<double>>> aCalibratedWaveformMapAux;
-      bool get_single_rawaux = false;
-      //std::cout <<"Check if FinishedRawWaveFormsAux have timestamp "<<PMTCounterTime<<std::endl;
-      get_single_rawaux = (FinishedRawWaveformsAux->count(PMTCounterTime) > 0);
-      if (get_single_rawaux) aRawWaveformMapAux = FinishedRawWaveformsAux->at(PMTCounterTime);
-      else {Log("PhaseIIADCHitFinder tool: Did not find raw aux waveform entry for timestamp "+std::to_string(PMTCounterTime),v_error,verbosity); return false;}
-      bool get_single_calib = false;
-      get_single_calib = (FinishedCalibratedWaveforms->count(PMTCounterTime) > 0);
-      if (get_single_calib) aCalibratedWaveformMap = FinishedCalibratedWaveforms->at(PMTCounterTime);
-      else {Log("PhaseIIADCHitFinder tool: Did not find calibrated waveform entry for timestamp "+std::to_string(PMTCounterTime),v_error,verbosity); return false;}
-      bool get_single_calibaux = false;
-      get_single_calibaux = (FinishedCalibratedWaveformsAux->count(PMTCounterTime) > 0);
-      if (get_single_calibaux) aCalibratedWaveformMapAux = FinishedCalibratedWaveformsAux->at(PMTCounterTime);
-      else {Log("PhaseIIADCHitFinder tool: Did not find calibrated aux waveform entry for timestamp "+std::to_string(PMTCounterTime),v_error,verbosity); return false;}
+        //Skip already processed events
+        //if (FinishedHits->count(PMTCounterTime) != 0) continue;
+        CalibratedTimestampsToDelete.push_back(PMTCounterTime);
+
+        new_data = true;
+
+        //Get all the maps
+        const std::map<unsigned long, std::vector<Waveform<unsigned short>>> &aRawWaveformMap = apair.second;
+        auto it_rawaux = FinishedRawWaveformsAux->find(PMTCounterTime);
+        if (it_rawaux == FinishedRawWaveformsAux->end()) {Log("PhaseIIADCHitFinder tool: Did not find raw aux waveform entry for timestamp "+std::to_string(PMTCounterTime),v_error,verbosity); return false;}
+        auto it_calib = FinishedCalibratedWaveforms->find(PMTCounterTime);
+        if (it_calib == FinishedCalibratedWaveforms->end()) {Log("PhaseIIADCHitFinder tool: Did not find calibrated waveform entry for timestamp "+std::to_string(PMTCounterTime),v_error,verbosity); return false;}
+        auto it_calibaux = FinishedCalibratedWaveformsAux->find(PMTCounterTime);
+        if (it_calibaux == FinishedCalibratedWaveformsAux->end()) {Log("PhaseIIADCHitFinder tool: Did not find calibrated aux waveform entry for timestamp "+std::to_string(PMTCounterTime),v_error,verbosity); return false;}
+        const std::map<unsigned long, std::vector<Waveform<unsigned short>>> &aRawWaveformMapAux = it_rawaux->second;
+        const std::map<unsigned long, std::vector<CalibratedADCWaveform<double>>> &aCalibratedWaveformMap = it_calib->second;
+        const std::map<unsigned long, std::vector<CalibratedADCWaveform<double>>> &aCalibratedWaveformMapAux = it_calibaux->second;
+
+        TimestampPulseTasks ts_tasks;
+        ts_tasks.Timestamp = PMTCounterTime;
+        ts_tasks.FirstTask = PulseTasks.size();
+        //Find pulses in the raw detector data
+        for (const auto& temp_pair : aRawWaveformMap) {
+          const auto& achannel_key = temp_pair.first;
+          const auto& araw_waveforms = temp_pair.second;
+          ts_tasks.TankChkeys.push_back(achannel_key);
+          //Don't make hit objects for any offline channels
+          Channel* thischannel = geom->GetChannel(achannel_key);
+          if(thischannel->GetStatus() == channelstatus::OFF) continue;
+          const std::vector<CalibratedADCWaveform<double> >& acalibrated_waveforms = aCalibratedWaveformMap.at(achannel_key);
+          this->AddPulseTask(achannel_key, araw_waveforms, acalibrated_waveforms, PulseTasks);
+        }
+        ts_tasks.FirstAuxTask = PulseTasks.size();
+        //Find pulses in the raw auxiliary channel data
+        for (const auto& temp_pair : aRawWaveformMapAux) {
+          const auto& achannel_key = temp_pair.first;
+          if (AuxChannelNumToTypeMap->at(achannel_key) == "BRF" || AuxChannelNumToTypeMap->at(achannel_key) == "BoosterRWM") ts_tasks.AuxChkeys.push_back(achannel_key);
+          if(AuxChannelNumToTypeMap->at(achannel_key) != "SiPM1" && AuxChannelNumToTypeMap->at(achannel_key) != "SiPM2") continue; 
+          const auto& araw_waveforms = temp_pair.second;
+          const std::vector<CalibratedADCWaveform<double> >& acalibrated_waveforms = aCalibratedWaveformMapAux.at(achannel_key);
+          this->AddPulseTask(achannel_key, araw_waveforms, acalibrated_waveforms, PulseTasks);
+        }
+        ts_tasks.EndTask = PulseTasks.size();
+        TimestampTasks.push_back(std::move(ts_tasks));
+      }
+
+      this->FindPulseTasks(PulseTasks);
+    }
+
+    catch (const std::exception& except) {
+      Log("Error: " + std::string( except.what() ), 0, verbosity);
+      return false;
+    }
+
+    for(TimestampPulseTasks &ts_tasks : TimestampTasks){
+      uint64_t PMTCounterTime = ts_tasks.Timestamp;
 
       this->ClearMaps();
 
       try {
         //Recreate maps that were deleted with ANNIEEvent->Delete() ANNIEEventBuilder tool
-        //hit_map = new std::map<unsigned long,std::vector<Hit>>;
-        //aux_hit_map = new std::map<unsigned long,std::vector<Hit>>;
         if (InProgressHits->count(PMTCounterTime)>0) hit_map = InProgressHits->at(PMTCounterTime);
 	else hit_map = new std::map<unsigned long,std::vector<Hit>>;
         if (InProgressHitsAux->count(PMTCounterTime)>0) aux_hit_map = InProgressHitsAux->at(PMTCounterTime);
 	else aux_hit_map = new std::map<unsigned long,std::vector<Hit>>;
-	if (InProgressRecoADCHits->count(PMTCounterTime)>0) pulse_map = InProgressRecoADCHits->at(PMTCounterTime);
-	if (InProgressRecoADCHitsAux->count(PMTCounterTime)>0) aux_pulse_map = InProgressRecoADCHitsAux->at(PMTCounterTime);
-        if (InProgressChkey->count(PMTCounterTime)>0) chkey_map = InProgressChkey->at(PMTCounterTime);
-
-        //std::cout <<"Looping through aRawWaveformMap"<<std::endl;
-        //Find pulses in the raw detector data
-        for (const auto& temp_pair : aRawWaveformMap) {
-          //std::cout <<"get entry"<<std::endl;
-          const auto& achannel_key = temp_pair.first;
-          const auto& araw_waveforms = temp_pair.second;
-          chkey_map.push_back(achannel_key);
-          //Don't make hit objects for any offline channels
-          Channel* thischannel = geom->GetChannel(achannel_key);
-          if(thischannel->GetStatus() == channelstatus::OFF) continue;
-          //std::cout <<"Get calibrated waveform map entry"<<std::endl;
-          std::vector<CalibratedADCWaveform<double> > acalibrated_waveforms = aCalibratedWaveformMap.at(achannel_key);
-          //std::cout <<"build_pulse_and_hit_map"<<std::endl;
-          bool MadeMaps = this->build_pulse_and_hit_map(achannel_key, araw_waveforms, acalibrated_waveforms, pulse_map,*hit_map);
-          //std::cout <<"chankey: "<<achannel_key<<"hit_map size: "<<hit_map->size()<<std::endl;
+	//The pulse and channel key maps are moved out of the InProgress maps and moved back
+	//in below once this timestamp's pulses have been added
+	if (InProgressRecoADCHits->count(PMTCounterTime)>0) pulse_map = std::move(InProgressRecoADCHits->at(PMTCounterTime));
+	if (InProgressRecoADCHitsAux->count(PMTCounterTime)>0) aux_pulse_map = std::move(InProgressRecoADCHitsAux->at(PMTCounterTime));
+        if (InProgressChkey->count(PMTCounterTime)>0) chkey_map = std::move(InProgressChkey->at(PMTCounterTime));
+
+        chkey_map.insert(chkey_map.end(),ts_tasks.TankChkeys.begin(),ts_tasks.TankChkeys.end());
+        for (size_t i_task = ts_tasks.FirstTask; i_task < ts_tasks.FirstAuxTask; i_task++){
+          bool MadeMaps = this->MergeChannelPulses(PulseTasks.at(i_task), pulse_map,*hit_map);
           if(!MadeMaps){
             Log("PhaseIIADCHitFinder Error: problem making PMT hit and pulse maps", 0, verbosity);
             return false;
           }
         }
 
-	//std::cout <<"chkey_map size: "<<chkey_map.size()<<std::endl;
-	
         Log("PhaseIIADCHitFinder Tool: setting PMT RecoADCHits in InProgress Events", v_debug, verbosity);
-        if (InProgressRecoADCHits->count(PMTCounterTime)==0) InProgressRecoADCHits->emplace(PMTCounterTime,pulse_map);
-	else InProgressRecoADCHits->at(PMTCounterTime)=pulse_map;
+        (*InProgressRecoADCHits)[PMTCounterTime] = std::move(pulse_map);
       
         Log("PhaseIIADCHitFinder Tool: setting PMT Hits in InProgress Events", v_debug, verbosity);
         if (InProgressHits->count(PMTCounterTime)==0) InProgressHits->emplace(PMTCounterTime,hit_map);
 	else InProgressHits->at(PMTCounterTime)=hit_map;
 
-
         Log("PhaseIIADCHitFinder Tool: Finding SiPM pulses in auxiliary channels", v_debug, verbosity);
-        //Find pulses in the raw auxiliary channel data
-        for (const auto& temp_pair : aRawWaveformMapAux) {
-          const auto& achannel_key = temp_pair.first;
-          if (AuxChannelNumToTypeMap->at(achannel_key) == "BRF" || AuxChannelNumToTypeMap->at(achannel_key) == "BoosterRWM") chkey_map.push_back(achannel_key);
-          if(AuxChannelNumToTypeMap->at(achannel_key) != "SiPM1" && AuxChannelNumToTypeMap->at(achannel_key) != "SiPM2") continue; 
-          const auto& araw_waveforms = temp_pair.second;
-          std::vector<CalibratedADCWaveform<double> > acalibrated_waveforms = aCalibratedWaveformMapAux.at(achannel_key);
-          bool MadeAuxMaps = this->build_pulse_and_hit_map(achannel_key, araw_waveforms, acalibrated_waveforms, aux_pulse_map,*aux_hit_map);
+        for (size_t i_task = ts_tasks.FirstAuxTask; i_task < ts_tasks.EndTask; i_task++){
+          bool MadeAuxMaps = this->MergeChannelPulses(PulseTasks.at(i_task), aux_pulse_map,*aux_hit_map);
           if(!MadeAuxMaps){
             Log("PhaseIIADCHitFinder Error: problem making  Aux hit and pulse maps", 0, verbosity);
             return false;
@@ -347,13 +384,11 @@ bool PhaseIIADCHitFinder::Execute() {
         }
 
 	//Include the RWM and BRF waveforms in the InProgressChkey map
-        if (InProgressChkey->count(PMTCounterTime)==0) InProgressChkey->emplace(PMTCounterTime,chkey_map);
-	else InProgressChkey->at(PMTCounterTime)=chkey_map;
-	//std::cout <<"InProgressChkeyMap size after emplacing: "<<InProgressChkey->at(PMTCounterTime).size()<<std::endl;
+        chkey_map.insert(chkey_map.end(),ts_tasks.AuxChkeys.begin(),ts_tasks.AuxChkeys.end());
+        (*InProgressChkey)[PMTCounterTime] = std::move(chkey_map);
 
         Log("PhaseIIADCHitFinder Tool: setting RecoADCAuxHits in InProgress Events", v_debug, verbosity);
-        if (InProgressRecoADCHitsAux->count(PMTCounterTime)==0) InProgressRecoADCHitsAux->emplace(PMTCounterTime,aux_pulse_map);
-	else InProgressRecoADCHitsAux->at(PMTCounterTime)=aux_pulse_map;
+        (*InProgressRecoADCHitsAux)[PMTCounterTime] = std::move(aux_pulse_map);
         
         Log("PhaseIIADCHitFinder Tool: setting AuxHits in InProgress Events", v_debug, verbosity);
         if (InProgressHitsAux->count(PMTCounterTime)==0) InProgressHitsAux->emplace(PMTCounterTime,aux_hit_map);
@@ -405,6 +440,15 @@ bool PhaseIIADCHitFinder::Execute() {
 
 
 bool PhaseIIADCHitFinder::Finalise() {
+  if(HitFinderPool.size()>0){
+    {
+      std::lock_guard<std::mutex> lock(PoolMutex);
+      StopPool = true;
+    }
+    PoolCV.notify_all();
+    for (unsigned int i=0; i<HitFinderPool.size(); i++) HitFinderPool.at(i).join();
+    HitFinderPool.clear();
+  }
   return true;
 }
 
@@ -425,19 +469,16 @@ unsigned short PhaseIIADCHitFinder::get_db_threshold(unsigned long channelkey){
   return this_pmt_threshold;
 }
 
-std::vector<std::vector<int>> PhaseIIADCHitFinder::get_db_windows(unsigned long channelkey){
-    std::vector<std::vector<int>> this_pmt_windows;
-  //Look in the map and check if channelkey exists.
-  if (channel_window_map.find(channelkey) == channel_window_map.end() ) {
+int PhaseIIADCHitFinder::get_db_window_index(unsigned long channelkey){
+  //Look in the table and check if channelkey exists.
+  int window_index = window_table.ChannelIndex(channelkey);
+  if (window_index < 0) {
      if (verbosity>v_debug){
        std::cout << "PhaseIIADCHitFinder Warning: no integration windows found" <<
        "for channel_key" << channelkey <<". Not finding pulses." << std::endl;
        }
-  } else {
-    // gottem
-    this_pmt_windows = channel_window_map.at(channelkey);
   }
-  return this_pmt_windows;
+  return window_index;
 }
 
 std::map<unsigned long, unsigned short> PhaseIIADCHitFinder::load_channel_threshold_map(std::string threshold_db){
@@ -467,134 +508,166 @@ std::map<unsigned long, unsigned short> PhaseIIADCHitFinder::load_channel_thresh
   return chanthreshmap;
 }
 
-std::map<unsigned long, std::vector<std::vector<int>>> PhaseIIADCHitFinder::load_integration_window_map(std::string window_db)
+template <class RawWaveform, class CalibratedWaveform>
+void PhaseIIADCHitFinder::AddPulseTask(
+  unsigned long channel_key,
+  const std::vector<RawWaveform>& raw_waveforms,
+  const std::vector<CalibratedWaveform>& calibrated_waveforms,
+  std::vector<ChannelPulseTask>& tasks)
 {
-  std::map<unsigned long, std::vector<std::vector<int>>> chanwindowmap;
-  std::string fileline;
-  ifstream myfile(window_db.c_str());
-  if (myfile.is_open()){
-    while(getline(myfile,fileline)){
-      if(fileline.find("#")!=std::string::npos) continue;
-      std::cout << fileline << std::endl; //has our stuff;
-      std::vector<std::string> dataline;
-      boost::split(dataline,fileline, boost::is_any_of(","), boost::token_compress_on);
-      unsigned long chanvalue = std::stoul(dataline.at(0));
-      int windowminvalue = std::stoi(dataline.at(1));
-      int windowmaxvalue = std::stoi(dataline.at(2));
-      std::vector<int> window{windowminvalue,windowmaxvalue};
-      if(chanwindowmap.count(chanvalue)==0){ // Place window range into integral windows
-        std::vector<std::vector<int>> window_vector{window};
-        chanwindowmap.emplace(chanvalue,window_vector);
-      }
-      else { // Add this window to the windows to integrate in
-        chanwindowmap.at(chanvalue).push_back(window);
-      }
+  ChannelPulseTask task;
+  task.ChannelKey = channel_key;
+  task.RawWaveforms.assign(raw_waveforms.begin(), raw_waveforms.end());
+  task.CalibratedWaveforms.assign(calibrated_waveforms.begin(), calibrated_waveforms.end());
+  //The DB lookups may print warnings, so they are done here rather than on the workers
+  if (pulse_finding_approach == "fixed_windows") task.WindowIndex = this->get_db_window_index(channel_key);
+  else if (pulse_finding_approach == "threshold") task.Threshold = this->get_db_threshold(channel_key);
+  tasks.push_back(std::move(task));
+}
+
+void PhaseIIADCHitFinder::FindPulseTasks(std::vector<ChannelPulseTask>& tasks)
+{
+  if(HitFinderPool.size() > 0 && tasks.size() > 1){
+    {
+      std::lock_guard<std::mutex> lock(PoolMutex);
+      PoolTasks = &tasks;
+      PoolNextTask = 0;
+      PoolTasksDone = 0;
     }
+    PoolCV.notify_all();
+    std::unique_lock<std::mutex> lock(PoolMutex);
+    PoolDoneCV.wait(lock,[this,&tasks]{return PoolTasksDone == tasks.size();});
+    PoolTasks = nullptr;
+    PoolNextTask = 0;
+    PoolTasksDone = 0;
   } else {
-    Log("PhaseIIADCHitFinder Tool ERROR! Input integration window DB file not found! "
-        " no integration will occur. ",
-        v_warning, verbosity);
+    for (size_t i=0; i<tasks.size(); i++) this->FindChannelPulses(tasks.at(i));
   }
-  return chanwindowmap;
 }
 
-bool PhaseIIADCHitFinder::build_pulse_and_hit_map(
-  unsigned long channel_key,
-  std::vector<Waveform<unsigned short> > raw_waveforms, 
-  std::vector<CalibratedADCWaveform<double> > calibrated_waveforms,
-  std::map<unsigned long, std::vector< std::vector<ADCPulse>> > & pmap,
-  std::map<unsigned long,std::vector<Hit>>& hmap)
+void PhaseIIADCHitFinder::HitFinderWorker()
 {
+  std::unique_lock<std::mutex> lock(PoolMutex);
+  while(true){
+    PoolCV.wait(lock,[this]{return StopPool || (PoolTasks && PoolNextTask < PoolTasks->size());});
+    if(StopPool) return;
+    std::vector<ChannelPulseTask> &tasks = *PoolTasks;
+    ChannelPulseTask &task = tasks.at(PoolNextTask++);
+    lock.unlock();
+    this->FindChannelPulses(task);
+    lock.lock();
+    if(++PoolTasksDone == tasks.size()) PoolDoneCV.notify_one();
+  }
+}
 
+void PhaseIIADCHitFinder::FindChannelPulses(ChannelPulseTask& task)
+{
+  const std::vector<WaveformView<unsigned short> >& raw_waveforms = task.RawWaveforms;
+  const std::vector<WaveformView<double> >& calibrated_waveforms = task.CalibratedWaveforms;
+  unsigned long channel_key = task.ChannelKey;
+  std::vector< std::vector<ADCPulse> > &pulse_vec = task.Pulses;
+  ADCWindowIntegrator integrator;
 
-  //std::cout <<"Check size of raw_waveforms"<<std::endl;
   // Ensure that the number of minibuffers is the same between the
   // sets of raw and calibrated waveforms for the current channel
   if ( raw_waveforms.size() != calibrated_waveforms.size() ) {
-    Log("Error: The PhaseIIPhaseIIADCHitFinder tool found a set of raw waveforms produced"
-      " using a different number of waveforms than the matching calibrated"
-      " waveforms.", v_error, verbosity);
-    return false;
+    task.SizeMismatch = true;
+    return;
   }
 
-  //std::cout <<"Define vectors"<<std::endl;
-  //Initialize objects that final pulse information is loaded into
-  std::vector< std::vector<ADCPulse> > pulse_vec;
-  std::vector<Hit> HitsOnPMT;
-
-  //std::cout <<"Get num minibuffers"<<std::endl;
-  size_t num_minibuffers = raw_waveforms.size();
-  //std::cout <<"Choose pulse finding approach"<<std::endl;
-  if (pulse_finding_approach == "full_window"){
-
-    // Integrate each whole dang minibuffer and background subtract 
-    for (size_t mb = 0; mb < num_minibuffers; ++mb) {
-        Waveform<unsigned short> buffer_wave = raw_waveforms.at(mb);
-        int window_end = buffer_wave.GetSamples()->size()-1;
-        std::vector<int> fullwindow{0,window_end};
-        std::vector<std::vector<int>> onewindowvec{fullwindow};
-        pulse_vec.push_back(this->find_pulses_bywindow(raw_waveforms.at(mb),
-          calibrated_waveforms.at(mb), onewindowvec, channel_key,false));
+  //Exceptions are handed to the merge, which rethrows them on the tool's thread
+  try {
+    size_t num_minibuffers = raw_waveforms.size();
+    if (pulse_finding_approach == "full_window"){
+
+      // Integrate each whole dang minibuffer and background subtract 
+      for (size_t mb = 0; mb < num_minibuffers; ++mb) {
+          int window_start = 0;
+          int window_end = raw_waveforms.at(mb).Samples().size()-1;
+          pulse_vec.push_back(this->find_pulses_bywindow(raw_waveforms.at(mb),
+            calibrated_waveforms.at(mb), &window_start, &window_end, 1, channel_key,false,
+            integrator));
+      }
     }
-  }
 
-  if (pulse_finding_approach == "full_window_maxpeak"){
-    // Integrate each whole dang minibuffer and background subtract 
-    for (size_t mb = 0; mb < num_minibuffers; ++mb) {
-        Waveform<unsigned short> buffer_wave = raw_waveforms.at(mb);
-        int window_end = buffer_wave.GetSamples()->size()-1;
-        std::vector<int> fullwindow{0,window_end};
-        std::vector<std::vector<int>> onewindowvec{fullwindow};
-        pulse_vec.push_back(this->find_pulses_bywindow(raw_waveforms.at(mb),
-          calibrated_waveforms.at(mb), onewindowvec, channel_key,true));
+    if (pulse_finding_approach == "full_window_maxpeak"){
+      // Integrate each whole dang minibuffer and background subtract 
+      for (size_t mb = 0; mb < num_minibuffers; ++mb) {
+          int window_start = 0;
+          int window_end = raw_waveforms.at(mb).Samples().size()-1;
+          pulse_vec.push_back(this->find_pulses_bywindow(raw_waveforms.at(mb),
+            calibrated_waveforms.at(mb), &window_start, &window_end, 1, channel_key,true,
+            integrator));
+      }
     }
-  }
-
-  if (pulse_finding_approach == "fixed_windows"){
-    // Integrate pulse over a fixed windows defined for channel 
-    std::vector<std::vector<int>> thispmt_adc_windows;
-    thispmt_adc_windows = this->get_db_windows(channel_key);
 
-    //For each minibuffer, integrate window to get pulses
-    for (size_t mb = 0; mb < num_minibuffers; ++mb) {
-        pulse_vec.push_back(this->find_pulses_bywindow(raw_waveforms.at(mb),
-          calibrated_waveforms.at(mb), thispmt_adc_windows, channel_key,false));
+    if (pulse_finding_approach == "fixed_windows"){
+      //For each minibuffer, integrate the channel's fixed windows to get pulses
+      const int* window_starts = nullptr;
+      const int* window_ends = nullptr;
+      size_t num_windows = 0;
+      if (task.WindowIndex >= 0) {
+        window_starts = window_table.WindowStarts(task.WindowIndex);
+        window_ends = window_table.WindowEnds(task.WindowIndex);
+        num_windows = window_table.NumWindows(task.WindowIndex);
+      }
+      for (size_t mb = 0; mb < num_minibuffers; ++mb) {
+          pulse_vec.push_back(this->find_pulses_bywindow(raw_waveforms.at(mb),
+            calibrated_waveforms.at(mb), window_starts, window_ends, num_windows,
+            channel_key,false,integrator));
+      }
     }
-  }
 
-  else if (pulse_finding_approach == "threshold"){
-   
-    //std::cout <<"THRESHOLD approach"<<std::endl; 
-   // Determine the ADC threshold to use for the current channel
-    unsigned short thispmt_adc_threshold = BOGUS_INT;
-    //std::cout <<"get db threshold"<<std::endl;
-    thispmt_adc_threshold = this->get_db_threshold(channel_key);
-
-   // std::cout <<"go through minibuffers"<<std::endl;
-    //For each minibuffer, adjust threshold for baseline calibration and find pulses
-    for (size_t mb = 0; mb < num_minibuffers; ++mb) {
-      //std::cout <<mb<<"/"<<num_minibuffers<<std::endl;
-      if (threshold_type == "relative") {
-        thispmt_adc_threshold = thispmt_adc_threshold
-          + std::round( calibrated_waveforms.at(mb).GetBaseline() );
-      }
+    else if (pulse_finding_approach == "threshold"){
+      unsigned short thispmt_adc_threshold = task.Threshold;
 
-      if (mb == 0) Log("PhaseIIADCHitFinder: Waveform will use ADC threshold = "
-        + std::to_string(thispmt_adc_threshold) + " for channel "
-        + std::to_string( channel_key ),
-        2, verbosity);
+      //For each minibuffer, adjust threshold for baseline calibration and find pulses
+      for (size_t mb = 0; mb < num_minibuffers; ++mb) {
+        if (threshold_type == "relative") {
+          thispmt_adc_threshold = thispmt_adc_threshold
+            + std::round( calibrated_waveforms.at(mb).GetBaseline() );
+        }
+        if (mb == 0) task.FirstThreshold = thispmt_adc_threshold;
 
         pulse_vec.push_back(this->find_pulses_bythreshold(raw_waveforms.at(mb),
           calibrated_waveforms.at(mb), thispmt_adc_threshold, channel_key));
-    }
-  } 
-  
-  else if (pulse_finding_approach == "NNLS") {
+      }
+    } 
+
+    //Convert ADCPulses to Hits
+    task.Hits = this->convert_adcpulses_to_hits(channel_key,pulse_vec);
+  }
+
+  catch (const std::exception& except) {
+    task.Error = except.what();
+  }
+}
+
+bool PhaseIIADCHitFinder::MergeChannelPulses(
+  ChannelPulseTask& task,
+  std::map<unsigned long, std::vector< std::vector<ADCPulse>> > & pmap,
+  std::map<unsigned long,std::vector<Hit>>& hmap)
+{
+  unsigned long channel_key = task.ChannelKey;
+  if ( task.SizeMismatch ) {
+    Log("Error: The PhaseIIPhaseIIADCHitFinder tool found a set of raw waveforms produced"
+      " using a different number of waveforms than the matching calibrated"
+      " waveforms.", v_error, verbosity);
+    return false;
+  }
+  if (pulse_finding_approach == "threshold" && task.RawWaveforms.size() > 0){
+    Log("PhaseIIADCHitFinder: Waveform will use ADC threshold = "
+      + std::to_string(task.FirstThreshold) + " for channel "
+      + std::to_string( channel_key ),
+      2, verbosity);
+  }
+  if (!task.Error.empty()) throw std::runtime_error(task.Error);
+  if (pulse_finding_approach == "NNLS") {
     Log("PhaseIIADCHitFinder: NNLS approach is not implemented.  please use threshold.",
         0, verbosity);
   }
 
- // std::cout <<"Fill pulse map"<<std::endl;
+  std::vector< std::vector<ADCPulse> > &pulse_vec = task.Pulses;
   //Fill pulse map with all ADCPulses found
   Log("PhaseIIADCHitFinder: Filling pulse map.",
       v_debug, verbosity);
@@ -604,12 +677,11 @@ bool PhaseIIADCHitFinder::build_pulse_and_hit_map(
     if (pmap.count(channel_key) == 0) pmap.emplace(channel_key,pulse_vec);
     else pmap.at(channel_key).push_back(apulsevec);
   }
-  //Convert ADCPulses to Hits and fill into Hit map
-  HitsOnPMT = this->convert_adcpulses_to_hits(channel_key,pulse_vec);
+  //Fill hit map with the Hits converted from the ADCPulses
   Log("PhaseIIADCHitFinder: Filling hit map.",
       v_debug, verbosity);
-  for(int j=0; j < (int) HitsOnPMT.size(); j++){
-    Hit ahit = HitsOnPMT.at(j);
+  for(int j=0; j < (int) task.Hits.size(); j++){
+    Hit ahit = task.Hits.at(j);
     if(hmap.count(channel_key)==0) hmap.emplace(channel_key, std::vector<Hit>{ahit});
     else hmap.at(channel_key).push_back(ahit);
   }
@@ -617,10 +689,11 @@ bool PhaseIIADCHitFinder::build_pulse_and_hit_map(
 }
 
 std::vector<ADCPulse> PhaseIIADCHitFinder::find_pulses_bywindow(
-  const Waveform<unsigned short>& raw_minibuffer_data,
-  const CalibratedADCWaveform<double>& calibrated_minibuffer_data,
-  std::vector<std::vector<int>> adc_windows, const unsigned long& channel_key,
-  bool MaxHeightPulseOnly) const
+  const WaveformView<unsigned short>& raw_minibuffer_data,
+  const WaveformView<double>& calibrated_minibuffer_data,
+  const int* window_starts, const int* window_ends, size_t num_windows,
+  const unsigned long& channel_key, bool MaxHeightPulseOnly,
+  ADCWindowIntegrator& integrator) const
 {
   //Sanity check that raw/calibrated minibuffers are same size
   if ( raw_minibuffer_data.Samples().size()
@@ -638,21 +711,18 @@ std::vector<ADCPulse> PhaseIIADCHitFinder::find_pulses_bywindow(
   
   std::vector<ADCPulse> pulses;
 
-  for(int i = 0; i<(int)adc_windows.size();i++){
-    // Integrate the pulse to get its area. Use a Riemann sum. Also get
-    // the raw amplitude (maximum ADC value within the pulse) and the
-    // sample at which the peak occurs.
-    std::vector<int> awindow = adc_windows.at(i);
-    size_t wmin = static_cast<size_t>(awindow.at(0));
-    size_t wmax = static_cast<size_t>(awindow.at(1));
-    unsigned short max_ADC = std::numeric_limits<unsigned short>::lowest();
-    size_t peak_sample = BOGUS_INT;
-    for (size_t p = wmin; p <= wmax; ++p) {
-      if (max_ADC < raw_minibuffer_data.GetSample(p)) {
-        max_ADC = raw_minibuffer_data.GetSample(p);
-        peak_sample = p;
-      }
-    }
+  // Integrate all the windows at once to get their areas (Riemann sums), their
+  // raw amplitudes (maximum ADC value within the window) and the samples at
+  // which the peaks occur.
+  std::vector<ADCWindowIntegral> integrals;
+  integrator.Integrate(raw_minibuffer_data.Samples(), calibrated_minibuffer_data.Samples(),
+    window_starts, window_ends, num_windows, integrals);
+
+  for(size_t i = 0; i < num_windows; i++){
+    size_t wmin = static_cast<size_t>(window_starts[i]);
+    size_t wmax = static_cast<size_t>(window_ends[i]);
+    unsigned short max_ADC = integrals[i].MaxADC;
+    size_t peak_sample = integrals[i].PeakSample;
 
     // The amplitude of the pulse (V)
     double calibrated_amplitude
@@ -693,11 +763,9 @@ std::vector<ADCPulse> PhaseIIADCHitFinder::find_pulses_bywindow(
       wmin = pulsewinleft;
       wmax = pulsewinright;
     } else {
-      // Integrate the calibrated pulse (to get a quantity in V * samples)
-      for (size_t p = wmin; p <= wmax; ++p) {
-        raw_area += raw_minibuffer_data.GetSample(p);
-        charge += calibrated_minibuffer_data.GetSample(p);
-      }
+      // The calibrated pulse integral is in V * samples
+      raw_area = integrals[i].RawArea;
+      charge = integrals[i].Charge;
     }
 
     // Convert the pulse integral to nC
@@ -717,8 +785,8 @@ std::vector<ADCPulse> PhaseIIADCHitFinder::find_pulses_bywindow(
 
 
 std::vector<ADCPulse> PhaseIIADCHitFinder::find_pulses_bythreshold(
-  const Waveform<unsigned short>& raw_minibuffer_data,
-  const CalibratedADCWaveform<double>& calibrated_minibuffer_data,
+  const WaveformView<unsigned short>& raw_minibuffer_data,
+  const WaveformView<double>& calibrated_minibuffer_data,
   unsigned short adc_threshold, const unsigned long& channel_key) const
 {
   //Sanity check that raw/calibrated minibuffers are same size
@@ -13,9 +13,13 @@
 #include <cmath>
 #include <limits>
 #include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 // ToolAnalysis includes
 #include "ADCPulse.h"
+#include "ADCWindowTable.h"
 #include "CalibratedADCWaveform.h"
 #include "Hit.h"
 
@@ -23,10 +27,36 @@
 #include "Geometry.h"
 #include "Tool.h"
 #include "Waveform.h"
+#include "WaveformBlock.h"
 #include "Constants.h"
 #include "Channel.h"
 #include <boost/algorithm/string.hpp>
 
+//Pulse finding for the waveforms of one channel.  Tasks share no state, so they can run on
+//separate threads; their pulses and hits are merged afterwards in task order.
+struct ChannelPulseTask{
+  unsigned long ChannelKey = 0;
+  std::vector<WaveformView<unsigned short>> RawWaveforms;       //One per minibuffer, of the waveforms
+  std::vector<WaveformView<double>> CalibratedWaveforms;        //held by the tool's maps or blocks
+  unsigned short Threshold = 0;           //From the threshold DB (threshold approach)
+  int WindowIndex = -1;                   //Channel index in the window table (fixed_windows approach)
+  std::vector<std::vector<ADCPulse>> Pulses;  //One vector of pulses per minibuffer
+  std::vector<Hit> Hits;
+  unsigned short FirstThreshold = 0;  //ADC threshold used for the first minibuffer, for logging
+  bool SizeMismatch = false;
+  std::string Error;  //what() of an exception thrown while finding pulses
+};
+
+//The pulse tasks of one timestamp in event building mode, as ranges in the task vector
+struct TimestampPulseTasks{
+  uint64_t Timestamp = 0;
+  size_t FirstTask = 0;
+  size_t FirstAuxTask = 0;
+  size_t EndTask = 0;
+  std::vector<unsigned long> TankChkeys;
+  std::vector<unsigned long> AuxChkeys;
+};
+
 class PhaseIIADCHitFinder : public Tool {
 
   public:
@@ -57,13 +87,17 @@ class PhaseIIADCHitFinder : public Tool {
     int pulse_window_start_shift;
     int pulse_window_end_shift;
     std::map<unsigned long, unsigned short> channel_threshold_map;
-    std::map<unsigned long, std::vector<std::vector<int>>> channel_window_map;
+    ADCWindowTable window_table;  //Integration windows from the window DB
     bool eventbuilding_mode; 
+    int hitfinder_threads;  //Number of threads finding pulses in parallel (1: serially)
    
    
     std::map<int,std::string>* AuxChannelNumToTypeMap;
 
-     // Load the map containing the ADC calibrated waveform data
+     // The ADC raw and calibrated waveform data of the ANNIEEvent, held either as
+     // WaveformBlocks or as maps (see GetWaveformViews)
+    WaveformBlock<double> calibrated_block, calibrated_aux_block;
+    WaveformBlock<unsigned short> raw_block, raw_aux_block;
     std::map<unsigned long, std::vector<CalibratedADCWaveform<double> > >
       calibrated_waveform_map;
     std::map<unsigned long, std::vector<CalibratedADCWaveform<double> > >
@@ -72,6 +106,9 @@ class PhaseIIADCHitFinder : public Tool {
       raw_waveform_map;
     std::map<unsigned long, std::vector<Waveform<unsigned short> > >
       raw_aux_waveform_map;
+     // and the views the pulse finding reads them through
+    std::map<unsigned long, std::vector<WaveformView<double> > > calibrated_views, calibrated_aux_views;
+    std::map<unsigned long, std::vector<WaveformView<unsigned short> > > raw_views, raw_aux_views;
     
     // Build the map of pulses and Hit Map
     std::map<unsigned long, std::vector< std::vector<ADCPulse>> > pulse_map;
@@ -85,35 +122,46 @@ class PhaseIIADCHitFinder : public Tool {
     // Load a PMT's threshold from the channel_threshold_map. If none, returns default ADC threshold
     unsigned short get_db_threshold(unsigned long channelkey);
 
-    // Load a PMT's integration windows from the channel_window_map. If none, returns an empty vector.
-    std::vector<std::vector<int>> get_db_windows(unsigned long channelkey);
+    // Index of a PMT's integration windows in the window_table. If none, returns -1.
+    int get_db_window_index(unsigned long channelkey);
 
     // load a channel threshold map from the source file given
     std::map<unsigned long, unsigned short> load_channel_threshold_map(std::string threshold_db);
 
-    // load an integration window map (CSV file) from the source file given
-    std::map<unsigned long, std::vector<std::vector<int>>> load_integration_window_map(std::string window_db);
-
     void ClearMaps();
-    bool build_pulse_and_hit_map(unsigned long ckey,
-       std::vector<Waveform<unsigned short> > rawmap, 
-      std::vector<CalibratedADCWaveform<double> > calmap,
+
+    //Pulse finding: each channel is a task, found serially or on the hitfinder_threads
+    //worker pool, then merged into the pulse and hit maps in the order the tasks were added
+    template <class RawWaveform, class CalibratedWaveform>
+    void AddPulseTask(unsigned long ckey,
+      const std::vector<RawWaveform>& rawmap,
+      const std::vector<CalibratedWaveform>& calmap,
+      std::vector<ChannelPulseTask>& tasks);
+    void FindPulseTasks(std::vector<ChannelPulseTask>& tasks);
+    void FindChannelPulses(ChannelPulseTask& task);
+    bool MergeChannelPulses(ChannelPulseTask& task,
       std::map<unsigned long, std::vector< std::vector<ADCPulse>> > & pmap,
       std::map<unsigned long,std::vector<Hit>>& hmap);
+    void HitFinderWorker();
+
     // Create a vector of ADCPulse objects using the raw and calibrated signals
     // from a given minibuffer. Note that the vectors of raw and calibrated
     // samples are assumed to be the same size. This function will throw an
     // exception if this assumption is violated.
     std::vector<ADCPulse> find_pulses_bythreshold(
-      const Waveform<unsigned short>& raw_minibuffer_data,
-      const CalibratedADCWaveform<double>& calibrated_minibuffer_data,
+      const WaveformView<unsigned short>& raw_minibuffer_data,
+      const WaveformView<double>& calibrated_minibuffer_data,
       unsigned short adc_threshold, const unsigned long& channel_key) const;
 
+    // Create one ADCPulse per integration window [window_starts[i], window_ends[i]].
+    // The windows are integrated in one pass by the integrator, which holds the
+    // scratch buffers and is reused for all the minibuffers of a task.
     std::vector<ADCPulse> find_pulses_bywindow(
-      const Waveform<unsigned short>& raw_minibuffer_data,
-      const CalibratedADCWaveform<double>& calibrated_minibuffer_data,
-      std::vector<std::vector<int>> adc_windows, const unsigned long& channel_key,
-      bool MaxHeightPulseOnly) const;
+      const WaveformView<unsigned short>& raw_minibuffer_data,
+      const WaveformView<double>& calibrated_minibuffer_data,
+      const int* window_starts, const int* window_ends, size_t num_windows,
+      const unsigned long& channel_key, bool MaxHeightPulseOnly,
+      ADCWindowIntegrator& integrator) const;
 
     //Takes the ADC pulse vectors (one per minibuffer) and converts them to a vector of hits
     std::vector<Hit> convert_adcpulses_to_hits(unsigned long channel_key,std::vector<std::vector<ADCPulse>> pulses);
@@ -133,6 +181,16 @@ class PhaseIIADCHitFinder : public Tool {
     //std::map<uint64_t, std::map<unsigned long,std::vector<std::vector<ADCPulse>>>> *FinishedRecoADCHits; //Key: {MTCTime}, value: map of found pulses
     //std::map<uint64_t, std::map<unsigned long,std::vector<std::vector<ADCPulse>>>> *FinishedRecoADCHitsAux; //Key: {MTCTime}, value: map of found pulses
 
+    //Worker pool used when hitfinder_threads > 1
+    std::vector<std::thread> HitFinderPool;
+    std::mutex PoolMutex;
+    std::condition_variable PoolCV;
+    std::condition_variable PoolDoneCV;
+    std::vector<ChannelPulseTask>* PoolTasks = nullptr;
+    size_t PoolNextTask = 0;
+    size_t PoolTasksDone = 0;
+    bool StopPool = false;
+
 };
 
 #endif
@@ -0,0 +1,100 @@
+#include "SaveIndexedANNIEEvent.h"
+
+#include <sstream>
+
+#include "IndexedANNIEEvent.h"
+
+SaveIndexedANNIEEvent::SaveIndexedANNIEEvent():Tool(){}
+
+
+bool SaveIndexedANNIEEvent::Initialise(std::string configfile, DataModel &data){
+
+  /////////////////// Useful header ///////////////////////
+  if(configfile!="") m_variables.Initialise(configfile); // loading config file
+  //m_variables.Print();
+
+  m_data= &data; //assigning transient data pointer
+  /////////////////////////////////////////////////////////////////
+
+  verbosity = 1;
+  OutputDirectory = ".";
+  std::string keys = "";
+  m_variables.Get("verbose",verbosity);
+  m_variables.Get("OutputDirectory",OutputDirectory);
+  m_variables.Get("Keys",keys);
+
+  std::stringstream ss_keys(keys);
+  std::string key;
+  while(std::getline(ss_keys,key,',')){
+    if(key.empty()) continue;
+    if(!IsIndexedANNIEEventKey(key)){
+      Log("SaveIndexedANNIEEvent tool: Error! "+key+" is not a known ANNIEEvent key; known keys are listed in DataModel/IndexedANNIEEvent.cpp",v_error,verbosity);
+      return false;
+    }
+    Keys.push_back(key);
+  }
+  if(Keys.empty()) Keys = IndexedANNIEEventKeys();
+
+  return true;
+}
+
+
+bool SaveIndexedANNIEEvent::Execute(){
+
+  std::string input_file;
+  if(!m_data->CStore.Get("ANNIEEventInputFile",input_file)){
+    Log("SaveIndexedANNIEEvent tool: Error! No ANNIEEventInputFile in the CStore. Please run LoadANNIEEvent before this tool",v_error,verbosity);
+    m_data->vars.Set("StopLoop",1);
+    return false;
+  }
+  if(input_file != CurrentInputFile){
+    CloseOutputFile();
+    if(!OpenOutputFile(input_file)){
+      m_data->vars.Set("StopLoop",1);
+      return false;
+    }
+  }
+
+  BoostStore *annie_event = m_data->Stores["ANNIEEvent"];
+  for(const std::string &key : Keys){
+    if(WriteANNIEEventKey(*annie_event,key,Writer)) KeysWritten[key]++;
+  }
+  Writer.WriteEntry();
+
+  return true;
+}
+
+
+bool SaveIndexedANNIEEvent::Finalise(){
+
+  CloseOutputFile();
+  return true;
+}
+
+bool SaveIndexedANNIEEvent::OpenOutputFile(const std::string &input_file){
+
+  std::string basename = input_file.substr(input_file.find_last_of('/')+1);
+  CurrentOutputFile = OutputDirectory+"/"+basename+".idx";
+  if(!Writer.Open(CurrentOutputFile)){
+    Log("SaveIndexedANNIEEvent tool: Error! Could not create output file "+CurrentOutputFile,v_error,verbosity);
+    return false;
+  }
+  CurrentInputFile = input_file;
+  KeysWritten.clear();
+  Log("SaveIndexedANNIEEvent tool: Converting "+input_file+" into "+CurrentOutputFile,v_message,verbosity);
+  return true;
+}
+
+void SaveIndexedANNIEEvent::CloseOutputFile(){
+
+  if(!Writer.IsOpen()) return;
+  size_t entries = Writer.NumEntries();
+  if(!Writer.Close()){
+    Log("SaveIndexedANNIEEvent tool: Error! Writing "+CurrentOutputFile+" failed",v_error,verbosity);
+    return;
+  }
+  Log("SaveIndexedANNIEEvent tool: Wrote "+std::to_string(entries)+" entries to "+CurrentOutputFile,v_message,verbosity);
+  for(const std::pair<const std::string,long> &key : KeysWritten){
+    Log("SaveIndexedANNIEEvent tool:   "+key.first+" in "+std::to_string(key.second)+" entries",v_debug,verbosity);
+  }
+}
@@ -0,0 +1,53 @@
+#ifndef SaveIndexedANNIEEvent_H
+#define SaveIndexedANNIEEvent_H
+
+#include <string>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "Tool.h"
+#include "IndexedEventFile.h"
+
+/**
+ * \class SaveIndexedANNIEEvent
+ *
+ * Writes each ANNIEEvent that passes through into an indexed event file (see
+ * IndexedEventFile.h), one output file per input file of LoadANNIEEvent.  Run after
+ * LoadANNIEEvent, it converts ProcessedData BoostStore files into files that
+ * LoadANNIEEvent reads with FileFormat Indexed.
+*/
+class SaveIndexedANNIEEvent: public Tool {
+
+
+ public:
+
+  SaveIndexedANNIEEvent(); ///< Simple constructor
+  bool Initialise(std::string configfile,DataModel &data); ///< Read the output directory and the keys to write
+  bool Execute(); ///< Write the keys of the current ANNIEEvent entry
+  bool Finalise(); ///< Close the last output file
+
+
+ private:
+
+  bool OpenOutputFile(const std::string &input_file);
+  void CloseOutputFile();
+
+  std::string OutputDirectory;
+  std::vector<std::string> Keys;
+
+  IndexedEventWriter Writer;
+  std::string CurrentInputFile;
+  std::string CurrentOutputFile;
+  std::map<std::string,long> KeysWritten;   // entries holding each key, in the current file
+
+  int verbosity;
+  int v_error=0;
+  int v_warning=1;
+  int v_message=2;
+  int v_debug=3;
+
+};
+
+
+#endif
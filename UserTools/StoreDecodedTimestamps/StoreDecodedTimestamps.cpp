@@ -34,7 +34,7 @@ bool StoreDecodedTimestamps::Initialise(std::string configfile, DataModel &data)
   t_timestamps_ctc->Branch("t_ctc_sec",&t_ctc_sec);
   t_timestamps_ctc->Branch("triggerword_ctc",&triggerword_ctc);
 
-  InProgressTankEvents = new std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > >;
+  InProgressTankEvents = new std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t> > >;
   ExecuteNr=0;
 
   new_pmt_data = false;
@@ -90,11 +90,17 @@ bool StoreDecodedTimestamps::Execute(){
   }
 
    if (new_pmt_data) {
+    int TankWaveKeyVersion = 1;
+    m_data->CStore.Get("TankWaveKeyVersion",TankWaveKeyVersion);
+    if (TankWaveKeyVersion != TANK_WAVE_KEY_VERSION){
+      std::cout <<"StoreDecodedTimestamps ERROR: InProgressTankEvents key version "<<TankWaveKeyVersion<<" does not match expected version "<<TANK_WAVE_KEY_VERSION<<std::endl;
+      return false;
+    }
     m_data->CStore.Get("InProgressTankEvents",InProgressTankEvents);
     std::vector<uint64_t> timestamps_delete;
-    for(std::pair<uint64_t,std::map<std::vector<int>, std::vector<uint16_t>>> apair : *InProgressTankEvents){
+    for(const std::pair<const uint64_t,std::map<CardChannelKey, std::vector<uint16_t>>> &apair : *InProgressTankEvents){
       uint64_t PMTCounterTimeNs = apair.first;
-      std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = apair.second;
+      const std::map<CardChannelKey, std::vector<uint16_t>> &aWaveMap = apair.second;
       if (aWaveMap.size() == (133)){
         if (AlmostCompleteWaveforms.find(PMTCounterTimeNs)!=AlmostCompleteWaveforms.end()) AlmostCompleteWaveforms[PMTCounterTimeNs]++;
         else AlmostCompleteWaveforms.emplace(PMTCounterTimeNs,0);
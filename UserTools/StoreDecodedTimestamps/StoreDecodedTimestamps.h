@@ -42,7 +42,7 @@ class StoreDecodedTimestamps: public Tool {
   bool new_pmt_data;
   bool new_ctc_data;
   std::map<uint64_t, std::vector<std::pair<unsigned long, int> > > MRDEvents;
-  std::map<uint64_t, std::map<std::vector<int>,std::vector<uint16_t> > > *InProgressTankEvents;
+  std::map<uint64_t, std::map<CardChannelKey,std::vector<uint16_t> > > *InProgressTankEvents;
   std::map<uint64_t, std::vector<uint32_t>>* TimeToTriggerWordMap;
   std::map<uint64_t, int> AlmostCompleteWaveforms;
 
@@ -39,6 +39,7 @@ bool TriggerDataDecoder::Initialise(std::string configfile, DataModel &data){
   TimeToTriggerWordMap = new std::map<uint64_t,std::vector<uint32_t>>;
   TimeToTriggerWordMapComplete = new std::map<uint64_t,std::vector<uint32_t>>;
   m_data->CStore.Set("PauseCTCDecoding",false);
+  m_data->CStore.Get("RawDataEntriesPerExecute",RawDataEntriesPerExecute);
 
   if(TriggerMaskFile!="none"){
     TriggerMask = LoadTriggerMask(TriggerMaskFile);
@@ -89,52 +90,25 @@ bool TriggerDataDecoder::Execute(){
       }
     }
 
-    //Get the TriggerData vector pointer from the CStore
-    Log("TriggerDataDecoder Tool: Accessing TrigData vector in CStore",v_debug, verbosity);
-    bool got_tdata = m_data->CStore.Get("TrigData",Tdata);
-    if(!got_tdata){
-      if(verbosity>0) std::cout << "TriggerDataDecoder error: No TriggerData in CStore!" << std::endl;
-      return false;
-    }
-    bool new_ts_available = false;
-    std::vector<uint32_t> aTimeStampData = Tdata->TimeStampData;
-    std::cout <<"aTimeStampData.size(): "<<aTimeStampData.size()<<std::endl;
-    for(int i = 0; i < (int) aTimeStampData.size(); i++){
-      if(verbosity>v_debug) std::cout<<"TriggerDataDecoder Tool: Loading next TrigData from entry's index " << i <<std::endl;
-      new_ts_available = this->AddWord(aTimeStampData.at(i));
-      if(new_ts_available){
-        if(verbosity>4){
-          std::cout << "PARSED TRIGGER TIME: " << processed_ns.back() << std::endl;
-          std::cout << "PARSED TRIGGER WORD: " << processed_sources.back() << std::endl;
-        }
-        if (TimeToTriggerWordMapComplete->find(processed_ns.back()) != TimeToTriggerWordMapComplete->end()) TimeToTriggerWordMapComplete->at(processed_ns.back()).push_back(processed_sources.back());
-        else {
-          std::vector<uint32_t> timestamp_ns{processed_sources.back()};
-          TimeToTriggerWordMapComplete->emplace(processed_ns.back(),timestamp_ns);
-        }
-        if(UseTrigMask){
-          uint32_t recent_trigger_word = processed_sources.back();
-          for(int j = 0; j<(int) TriggerMask.size(); j++){
-            if(TriggerMask.at(j) == (int) recent_trigger_word){
-              m_data->CStore.Set("NewCTCDataAvailable",true);
-              if(verbosity>4) std::cout << "TRIGGER WORD BEING ADDED TO TRIGWORDMAP" << std::endl;
-              if (TimeToTriggerWordMap->find(processed_ns.back()) != TimeToTriggerWordMap->end()) TimeToTriggerWordMap->at(processed_ns.back()).push_back(processed_sources.back());
-              else {
-                std::vector<uint32_t> timestamp_ns{processed_sources.back()};
-                TimeToTriggerWordMap->emplace(processed_ns.back(),timestamp_ns);
-              }
-            }
-          }
-        } else {
-          m_data->CStore.Set("NewCTCDataAvailable",true);
-          if(verbosity>4) std::cout << "TRIGGER WORD BEING ADDED TO TRIGWORDMAP" << std::endl;
-          if (TimeToTriggerWordMap->find(processed_ns.back()) != TimeToTriggerWordMap->end()) TimeToTriggerWordMap->at(processed_ns.back()).push_back(processed_sources.back());
-          else {
-            std::vector<uint32_t> timestamp_ns{processed_sources.back()};
-            TimeToTriggerWordMap->emplace(processed_ns.back(),timestamp_ns);
-          }
-        }
+    //Get the TriggerData pointer (or batch of TriggerData) from the CStore
+    if(RawDataEntriesPerExecute>1){
+      Log("TriggerDataDecoder Tool: Accessing TrigData batch in CStore",v_debug, verbosity);
+      bool got_tdata = m_data->CStore.Get("TrigDataBatch",TdataBatch);
+      if(!got_tdata){
+        if(verbosity>0) std::cout << "TriggerDataDecoder error: No TriggerData batch in CStore!" << std::endl;
+        return false;
+      }
+      for(int i_entry = 0; i_entry < (int) TdataBatch->size(); i_entry++){
+        this->DecodeTimeStampData(TdataBatch->at(i_entry).TimeStampData);
       }
+    } else {
+      Log("TriggerDataDecoder Tool: Accessing TrigData vector in CStore",v_debug, verbosity);
+      bool got_tdata = m_data->CStore.Get("TrigData",Tdata);
+      if(!got_tdata){
+        if(verbosity>0) std::cout << "TriggerDataDecoder error: No TriggerData in CStore!" << std::endl;
+        return false;
+      }
+      this->DecodeTimeStampData(Tdata->TimeStampData);
     }
   } 
   else if (mode == "Monitoring"){
@@ -194,6 +168,48 @@ bool TriggerDataDecoder::Execute(){
 }
 
 
+void TriggerDataDecoder::DecodeTimeStampData(const std::vector<uint32_t> &aTimeStampData){
+  bool new_ts_available = false;
+  std::cout <<"aTimeStampData.size(): "<<aTimeStampData.size()<<std::endl;
+  for(int i = 0; i < (int) aTimeStampData.size(); i++){
+    if(verbosity>v_debug) std::cout<<"TriggerDataDecoder Tool: Loading next TrigData from entry's index " << i <<std::endl;
+    new_ts_available = this->AddWord(aTimeStampData.at(i));
+    if(new_ts_available){
+      if(verbosity>4){
+        std::cout << "PARSED TRIGGER TIME: " << processed_ns.back() << std::endl;
+        std::cout << "PARSED TRIGGER WORD: " << processed_sources.back() << std::endl;
+      }
+      if (TimeToTriggerWordMapComplete->find(processed_ns.back()) != TimeToTriggerWordMapComplete->end()) TimeToTriggerWordMapComplete->at(processed_ns.back()).push_back(processed_sources.back());
+      else {
+        std::vector<uint32_t> timestamp_ns{processed_sources.back()};
+        TimeToTriggerWordMapComplete->emplace(processed_ns.back(),timestamp_ns);
+      }
+      if(UseTrigMask){
+        uint32_t recent_trigger_word = processed_sources.back();
+        for(int j = 0; j<(int) TriggerMask.size(); j++){
+          if(TriggerMask.at(j) == (int) recent_trigger_word){
+            m_data->CStore.Set("NewCTCDataAvailable",true);
+            if(verbosity>4) std::cout << "TRIGGER WORD BEING ADDED TO TRIGWORDMAP" << std::endl;
+            if (TimeToTriggerWordMap->find(processed_ns.back()) != TimeToTriggerWordMap->end()) TimeToTriggerWordMap->at(processed_ns.back()).push_back(processed_sources.back());
+            else {
+              std::vector<uint32_t> timestamp_ns{processed_sources.back()};
+              TimeToTriggerWordMap->emplace(processed_ns.back(),timestamp_ns);
+            }
+          }
+        }
+      } else {
+        m_data->CStore.Set("NewCTCDataAvailable",true);
+        if(verbosity>4) std::cout << "TRIGGER WORD BEING ADDED TO TRIGWORDMAP" << std::endl;
+        if (TimeToTriggerWordMap->find(processed_ns.back()) != TimeToTriggerWordMap->end()) TimeToTriggerWordMap->at(processed_ns.back()).push_back(processed_sources.back());
+        else {
+          std::vector<uint32_t> timestamp_ns{processed_sources.back()};
+          TimeToTriggerWordMap->emplace(processed_ns.back(),timestamp_ns);
+        }
+      }
+    }
+  }
+}
+
 bool TriggerDataDecoder::Finalise(){
   //delete TimeToTriggerWordMap;	//DONT delete TimeToTriggerWordMap since it wil be deleted by the CStore automatically
   std::cout << "TriggerDataDecoder tool exitting" << std::endl;
@@ -31,10 +31,13 @@ class TriggerDataDecoder: public Tool {
   std::vector<int> LoadTriggerMask(std::string triggermask_file);
   std::map<int,std::string> LoadTriggerWords(std::string triggerwords_file);
   void CheckForRunChange();
+  void DecodeTimeStampData(const std::vector<uint32_t> &aTimeStampData); ///< Parse the timestamp words of one TrigData entry (EventBuilding mode)
  private:
 
   //std::vector<TriggerData> *Tdata = nullptr;
   TriggerData *Tdata = nullptr;
+  std::vector<TriggerData> *TdataBatch = nullptr;
+  int RawDataEntriesPerExecute = 1;  //Set by LoadRawData; >1 means TrigData entries arrive as a batch
   std::map<uint64_t,std::vector<uint32_t>>* TimeToTriggerWordMap;
   std::map<uint64_t,std::vector<uint32_t>>* TimeToTriggerWordMapComplete;	//Info about all triggerwords
   bool UseTrigMask = false;
@@ -163,3 +163,5 @@
 #include "LAPPDDataDecoder.h"
 #include "PythonScript.h"
 #include "ChargedLeptonLikelihoodReco.h"
+#include "SaveIndexedANNIEEvent.h"
+#include "VtxFitBackendComparison.h"
@@ -35,6 +35,7 @@ bool VertexGeometryCheck::Initialise(std::string configfile, DataModel &data){
   m_data= &data; //assigning transient data pointer
   /////////////////////////////////////////////////////////////////
 
+  fRecoContext = new VertexRecoContext();
   return true;
 }
 
@@ -109,12 +110,11 @@ bool VertexGeometryCheck::Execute(){
 
   double ConeAngle = Parameters::CherenkovAngle();
 
-  FoMCalculator * myFoMCalculator = new FoMCalculator();
-  VertexGeometry* myvtxgeo = VertexGeometry::Instance();
-  myvtxgeo->LoadDigits(fDigitList);
-  myFoMCalculator->LoadVertexGeometry(myvtxgeo); //Load vertex geometry
+  fRecoContext->LoadDigits(fDigitList);
+  FoMCalculator * myFoMCalculator = fRecoContext->NewFoMCalculator();
+  VertexGeometry* myvtxgeo = fRecoContext->GetVertexGeometry();
   int nhits = myvtxgeo->GetNDigits();
-  myvtxgeo->CalcExtendedResiduals(trueVtxX, trueVtxY, trueVtxZ, trueVtxT, trueDirX, trueDirY, trueDirZ);
+  myvtxgeo->CalcResiduals(trueVtxX, trueVtxY, trueVtxZ, trueVtxT, trueDirX, trueDirY, trueDirZ);
   double meantime = myFoMCalculator->FindSimpleTimeProperties(ConeAngle);
   fmeanres->Fill(meantime);
   double fom = -999.999*100;
@@ -176,6 +176,7 @@ bool VertexGeometryCheck::Finalise(){
   fOutput_tfile->cd();
   fOutput_tfile->Write();
   fOutput_tfile->Close();
+  delete fRecoContext; fRecoContext = 0;
   Log("VertexGeometryCheck exitting", v_debug,verbosity);
   return true;
 }
@@ -6,6 +6,7 @@
 
 #include "FoMCalculator.h"
 #include "VertexGeometry.h"
+#include "VertexRecoContext.h"
 #include "Parameters.h"
 #include "Tool.h"
 #include "TTree.h"
@@ -40,6 +41,8 @@ class VertexGeometryCheck: public Tool {
   
   /// \brief recodigit vector
  	std::vector<RecoDigit>* fDigitList = 0;
+ 	/// \brief digits and residuals of the fits of this tool
+ 	VertexRecoContext* fRecoContext = 0;
  		
  	/// \brief true vertex pointer
  	RecoVertex* fTrueVertex = 0;
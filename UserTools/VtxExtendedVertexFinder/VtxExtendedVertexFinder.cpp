@@ -1,4 +1,8 @@
 #include "VtxExtendedVertexFinder.h"
+#include "TROOT.h"
+
+#include <algorithm>
+#include <thread>
 
 VtxExtendedVertexFinder::VtxExtendedVertexFinder():Tool(){}
 
@@ -16,12 +20,31 @@ bool VtxExtendedVertexFinder::Initialise(std::string configfile, DataModel &data
   fTmax = 10.0;
   fUseTrueVertexAsSeed = false;
   fSeedGridFits = false;
+  fSeedFitThreads = 1;
+  fUseAnalyticGradient = false;
+  fFitBackend = "Minuit";
   /// Get the Tool configuration variables
   m_variables.Get("UseTrueVertexAsSeed",fUseTrueVertexAsSeed);
   m_variables.Get("FitAllOnSeedGrid",fSeedGridFits);
   m_variables.Get("verbosity", verbosity);
   m_variables.Get("FitTimeWindowMin", fTmin);
   m_variables.Get("FitTimeWindowMax", fTmax);
+  m_variables.Get("SeedFitThreads", fSeedFitThreads);
+  m_variables.Get("UseAnalyticGradient", fUseAnalyticGradient);
+  m_variables.Get("FitBackend", fFitBackend);
+  if(!VertexFitBackend::IsBackend(fFitBackend)){
+    Log("VtxExtendedVertexFinder Tool: Error: unknown FitBackend "+fFitBackend+" (Minuit or LBFGS)",v_error,verbosity);
+    return false;
+  }
+  if(fSeedFitThreads<1) fSeedFitThreads = std::max(1u, std::thread::hardware_concurrency());
+
+  fRecoContext = new VertexRecoContext();
+  if(fSeedGridFits && fSeedFitThreads>1){
+    // The optimizers of the threads register their TMinuits with gROOT
+    ROOT::EnableThreadSafety();
+    for(int i=1; i<fSeedFitThreads; i++) fThreadContexts.push_back(new VertexRecoContext());
+    Log("VtxExtendedVertexFinder Tool: Fitting grid seeds on "+to_string(fSeedFitThreads)+" threads",v_message,verbosity);
+  }
   
   /// Create extended vertex
   /// Note that the objects created by "new" must be added to the "RecoEvent" store. 
@@ -72,8 +95,7 @@ bool VtxExtendedVertexFinder::Execute(){
   }
 	
   // Load digits to VertexGeometry
-  myvtxgeo = VertexGeometry::Instance();
-  myvtxgeo->LoadDigits(fDigitList);
+  fRecoContext->LoadDigits(fDigitList);
   // Do extended vertex (muon track) reconstruction using MC truth information
   if( fUseTrueVertexAsSeed ){
   Log("VtxExtendedVertexFinder Tool: Run vertex reconstruction using MC truth information",v_message,verbosity);
@@ -136,18 +158,22 @@ bool VtxExtendedVertexFinder::Execute(){
 bool VtxExtendedVertexFinder::Finalise(){
   // memory has to be freed in the Finalise() function
   delete fExtendedVertex; fExtendedVertex = 0;
+  delete fRecoContext; fRecoContext = 0;
+  for(VertexRecoContext* context : fThreadContexts) delete context;
+  fThreadContexts.clear();
   if(verbosity>0) cout<<"VtxExtendedVertexFinder exitting"<<endl;
   return true;
 }
 
 RecoVertex* VtxExtendedVertexFinder::FitExtendedVertex(RecoVertex* myVertex) {
   //fit with Minuit
-  MinuitOptimizer* myOptimizer = new MinuitOptimizer();
+  MinuitOptimizer* myOptimizer = fRecoContext->NewOptimizer();
   myOptimizer->SetPrintLevel(-1);
   myOptimizer->SetMeanTimeCalculatorType(1); //Type 1: most probable time
-  myOptimizer->LoadVertexGeometry(myvtxgeo); //Load vertex geometry
   myOptimizer->LoadVertex(myVertex); //Load vertex seed
   myOptimizer->SetFitterTimeRange(fTmin, fTmax); //Set time range to fit over 
+  myOptimizer->SetUseAnalyticGradient(fUseAnalyticGradient);
+  myOptimizer->SetFitBackend(fFitBackend);
   myOptimizer->FitExtendedVertexWithMinuit(); //scan the point position in 4D space
   // Fitted vertex must be copied to a new vertex pointer that is created in this class 
   // Once the optimizer is deleted, the fitted vertex is lost. 
@@ -173,29 +199,37 @@ RecoVertex* VtxExtendedVertexFinder::FitGridSeeds(std::vector<RecoVertex>* vSeed
   int vtxRecoStatus = -1;
   unsigned int nlast = vSeedVtxList->size();
   
-  RecoVertex* fSeedPos = 0;
-  RecoVertex* fSimpleVertex = new RecoVertex();
   RecoVertex* bestGridVertex = new RecoVertex(); // FIXME: pointer must be deleted by the invoker
   
+  // Seed a direction at every grid position
+  std::vector<RecoVertex*> vSimpleSeeds;
   for( unsigned int n=0; n<nlast; n++ ){
-    //Find best time with Minuit
-    MinuitOptimizer* myOptimizer = new MinuitOptimizer();
-    myOptimizer->SetPrintLevel(0);
-    myOptimizer->SetMeanTimeCalculatorType(1);
-    myOptimizer->LoadVertexGeometry(myvtxgeo); //Load vertex geometry
-    myOptimizer->SetFitterTimeRange(fTmin, fTmax); //Set time range to fit over 
-    fSeedPos = &(vSeedVtxList->at(n));
-  	fSimpleVertex= this->FindSimpleDirection(fSeedPos);
-    myOptimizer->LoadVertex(fSimpleVertex); //Load vertex seed
-    myOptimizer->FitExtendedVertexWithMinuit(); //scan the point position in 4D space
-    vtxFOM = myOptimizer->GetFittedVertex()->GetFOM();
-    vtxRecoStatus = myOptimizer->GetFittedVertex()->GetStatus();
+    vSimpleSeeds.push_back(this->FindSimpleDirection(&(vSeedVtxList->at(n))));
+  }
+  
+  // Fit every seed.  Each thread takes the next seed that has not been fitted yet,
+  // and fits it in a context of its own.
+  std::vector<RecoVertex> vSeedFits(nlast);
+  std::atomic<unsigned int> nextSeed(0);
+  unsigned int nthreads = std::min((unsigned int)fSeedFitThreads, nlast);
+  std::vector<std::thread> fitThreads;
+  for( unsigned int i=1; i<nthreads; i++ ){
+    fitThreads.push_back(std::thread(&VtxExtendedVertexFinder::FitSeedsWorker, this,
+                                     &vSimpleSeeds, &nextSeed, fThreadContexts.at(i-1), &vSeedFits));
+  }
+  this->FitSeedsWorker(&vSimpleSeeds, &nextSeed, fRecoContext, &vSeedFits);
+  for( std::thread& fitThread : fitThreads ) fitThread.join();
+  
+  // Pick the best fit in seed order, so that of equal FOMs the first seed's fit is kept
+  for( unsigned int n=0; n<nlast; n++ ){
+    vtxFOM = vSeedFits.at(n).GetFOM();
+    vtxRecoStatus = vSeedFits.at(n).GetStatus();
  
     if((vtxFOM>bestFOM) && (vtxRecoStatus==0)){
-      bestGridVertex->CloneVertex(myOptimizer->GetFittedVertex());
+      bestGridVertex->CloneVertex(&(vSeedFits.at(n)));
       bestFOM = vtxFOM;
     }
-    delete myOptimizer; myOptimizer = 0;
+    delete vSimpleSeeds.at(n);
   }
   if (verbosity>4){
     std::cout << "Best fit vertex information: " << std::endl;
@@ -206,6 +240,24 @@ RecoVertex* VtxExtendedVertexFinder::FitGridSeeds(std::vector<RecoVertex>* vSeed
   return bestGridVertex;
 }
 
+void VtxExtendedVertexFinder::FitSeedsWorker(const std::vector<RecoVertex*>* vSimpleSeeds,
+        std::atomic<unsigned int>* nextSeed, VertexRecoContext* context, std::vector<RecoVertex>* vSeedFits) {
+  if( context!=fRecoContext ) context->LoadDigits(fDigitList);
+  for( unsigned int n=(*nextSeed)++; n<vSimpleSeeds->size(); n=(*nextSeed)++ ){
+    //Find best time with Minuit
+    MinuitOptimizer* myOptimizer = context->NewOptimizer();
+    myOptimizer->SetPrintLevel(0);
+    myOptimizer->SetMeanTimeCalculatorType(1);
+    myOptimizer->SetFitterTimeRange(fTmin, fTmax); //Set time range to fit over 
+    myOptimizer->SetUseAnalyticGradient(fUseAnalyticGradient);
+    myOptimizer->SetFitBackend(fFitBackend);
+    myOptimizer->LoadVertex(vSimpleSeeds->at(n)); //Load vertex seed
+    myOptimizer->FitExtendedVertexWithMinuit(); //scan the point position in 4D space
+    vSeedFits->at(n).CloneVertex(myOptimizer->GetFittedVertex());
+    delete myOptimizer; myOptimizer = 0;
+  }
+}
+
 RecoVertex* VtxExtendedVertexFinder::FindSimpleDirection(RecoVertex* myVertex) {
 	
   /// get vertex position
@@ -3,11 +3,14 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
+#include <atomic>
 
 #include "Tool.h"
 #include <VertexGeometry.h>
 #include <TMinuit.h>
 #include <MinuitOptimizer.h>
+#include <VertexRecoContext.h>
 
 class VtxExtendedVertexFinder: public Tool {
 
@@ -41,6 +44,10 @@ class VtxExtendedVertexFinder: public Tool {
   
   /// \brief Run ExtendedVertex with every grid seed
   RecoVertex* FitGridSeeds(std::vector<RecoVertex>* vSeedVtxList);
+
+  /// \brief Fit seeds in context, taking the next one from nextSeed, until none are left
+  void FitSeedsWorker(const std::vector<RecoVertex*>* vSimpleSeeds, std::atomic<unsigned int>* nextSeed,
+                      VertexRecoContext* context, std::vector<RecoVertex>* vSeedFits);
   
   /// \brief Find a simple direction using weighted sum of digit charges 
   RecoVertex* FindSimpleDirection(RecoVertex* myvertex);
@@ -53,6 +60,10 @@ class VtxExtendedVertexFinder: public Tool {
   
   bool fUseTrueVertexAsSeed;
   bool fSeedGridFits;
+  bool fUseAnalyticGradient;
+  
+  /// \brief VertexFitBackend minimising the fits ("Minuit" or "LBFGS")
+  std::string fFitBackend;
   
   RecoVertex* fTrueVertex = 0;
   std::vector<RecoDigit>* fDigitList = 0;
@@ -60,8 +71,14 @@ class VtxExtendedVertexFinder: public Tool {
   /// \brief extended vertex
   RecoVertex* fExtendedVertex = 0;
   
-  /// Vertex Geometry shared by Fitter tools
-  VertexGeometry* myvtxgeo;
+  /// \brief digits, residuals and optimizers of the fits of this tool
+  VertexRecoContext* fRecoContext = 0;
+
+  /// \brief number of threads fitting the grid seeds of an event
+  int fSeedFitThreads;
+
+  /// \brief context of each seed fitting thread besides the tool's own
+  std::vector<VertexRecoContext*> fThreadContexts;
   
   /// verbosity levels: if 'verbosity' < this level, the message type will be logged.
   int verbosity=-1;
@@ -0,0 +1,300 @@
+#include "VtxFitBackendComparison.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+VtxFitBackendComparison::VtxFitBackendComparison():Tool(){}
+
+// q-quantile of values (sorted in place); 0 if there are none
+static double Quantile(std::vector<double>& values, double q){
+  if(values.empty()) return 0.0;
+  std::sort(values.begin(), values.end());
+  return values.at(std::min(values.size()-1, (size_t)(q*values.size())));
+}
+
+bool VtxFitBackendComparison::Initialise(std::string configfile, DataModel &data){
+
+  /////////////////// Usefull header ///////////////////////
+  if(configfile!="")  m_variables.Initialise(configfile); //loading config file
+  //m_variables.Print();
+
+  m_data= &data; //assigning transient data pointer
+  /////////////////////////////////////////////////////////////////
+
+  std::string backends = "Minuit,Minuit+Gradient,LBFGS,LBFGS+Gradient";
+  int randomSeed = 4357;
+  fSeedsPerEvent = 5;
+  fSeedPositionSmear = 30.0;
+  fSeedAngleSmear = 20.0;
+  fSeedTimeSmear = 2.0;
+  fTmin = -10.0;
+  fTmax = 10.0;
+  fMaxEvents = -1;
+  fEventsFitted = 0;
+  fReportFile = "";
+  /// Get the Tool configuration variables
+  m_variables.Get("verbosity", verbosity);
+  m_variables.Get("Backends", backends);
+  m_variables.Get("SeedsPerEvent", fSeedsPerEvent);
+  m_variables.Get("SeedPositionSmear", fSeedPositionSmear);
+  m_variables.Get("SeedAngleSmear", fSeedAngleSmear);
+  m_variables.Get("SeedTimeSmear", fSeedTimeSmear);
+  m_variables.Get("RandomSeed", randomSeed);
+  m_variables.Get("FitTimeWindowMin", fTmin);
+  m_variables.Get("FitTimeWindowMax", fTmax);
+  m_variables.Get("MaxEvents", fMaxEvents);
+  m_variables.Get("ReportFile", fReportFile);
+  fRandom.SetSeed(randomSeed);
+
+  // "Name" or "Name+Gradient", comma separated
+  fRecoContext = new VertexRecoContext();
+  std::stringstream backendlist(backends);
+  std::string label;
+  while(std::getline(backendlist, label, ',')){
+    if(label.empty()) continue;
+    BackendSetup setup;
+    setup.fLabel = label;
+    setup.fBackend = label;
+    setup.fUseAnalyticGradient = false;
+    size_t plus = label.find('+');
+    if(plus!=std::string::npos){
+      setup.fBackend = label.substr(0, plus);
+      if(label.substr(plus+1)!="Gradient"){
+        Log("VtxFitBackendComparison Tool: Error: unknown backend option in "+label+" (only +Gradient)",v_error,verbosity);
+        return false;
+      }
+      setup.fUseAnalyticGradient = true;
+    }
+    MinuitOptimizer* myOptimizer = fRecoContext->NewOptimizer();
+    if(!myOptimizer->SetFitBackend(setup.fBackend)){
+      Log("VtxFitBackendComparison Tool: Error: unknown backend "+setup.fBackend+" (Minuit or LBFGS)",v_error,verbosity);
+      delete myOptimizer;
+      return false;
+    }
+    myOptimizer->SetPrintLevel(-1);
+    myOptimizer->SetMeanTimeCalculatorType(1); //Type 1: most probable time
+    myOptimizer->SetFitterTimeRange(fTmin, fTmax);
+    myOptimizer->SetUseAnalyticGradient(setup.fUseAnalyticGradient);
+    fSetups.push_back(setup);
+    fOptimizers.push_back(myOptimizer);
+  }
+  if(fSetups.empty()){
+    Log("VtxFitBackendComparison Tool: Error: no Backends to compare",v_error,verbosity);
+    return false;
+  }
+  fResults.resize(fSetups.size());
+  fEventBest.resize(fSetups.size());
+
+  if(fReportFile!=""){
+    fReport.open(fReportFile.c_str());
+    if(!fReport.is_open()){
+      Log("VtxFitBackendComparison Tool: Error: can't write "+fReportFile,v_error,verbosity);
+      return false;
+    }
+    fReport << "backend,event,seed,status,converged,calls,gradient_calls,iterations,fom,distance_cm,angle_deg,time_us" << std::endl;
+  }
+
+  return true;
+}
+
+bool VtxFitBackendComparison::Execute(){
+  Log("===========================================================================================",v_debug,verbosity);
+  Log("VtxFitBackendComparison Tool: Executing",v_debug,verbosity);
+
+  if(fMaxEvents>=0 && fEventsFitted>=fMaxEvents){
+    m_data->vars.Set("StopLoop",1);
+    return true;
+  }
+
+  // check if event passes the cut
+  bool EventCutstatus = false;
+  auto get_evtstatus = m_data->Stores.at("RecoEvent")->Get("EventCutStatus",EventCutstatus);
+  if(!get_evtstatus) {
+    Log("Error: The VtxFitBackendComparison tool could not find the Event selection status", v_error, verbosity);
+    return false;
+  }
+  if(!EventCutstatus) {
+    Log("Message: This event doesn't pass the event selection. ", v_message, verbosity);
+    return true;
+  }
+
+  // ANNIE Event number
+  m_data->Stores.at("ANNIEEvent")->Get("EventNumber",fEventNumber);
+
+  // Retrive digits and the true vertex from RecoEvent
+  get_ok = m_data->Stores.at("RecoEvent")->Get("RecoDigit",fDigitList);
+  if(not get_ok){
+    Log("VtxFitBackendComparison Tool: Error retrieving RecoDigits,no digit from the RecoEvent!",v_error,verbosity);
+    return false;
+  }
+  get_ok = m_data->Stores.at("RecoEvent")->Get("TrueVertex", fTrueVertex);
+  if(not get_ok){
+    Log("VtxFitBackendComparison Tool: Error retrieving TrueVertex from RecoEvent!",v_error,verbosity);
+    return false;
+  }
+  fRecoContext->LoadDigits(fDigitList);
+
+  std::vector<RecoVertex> seeds;
+  this->MakeSeeds(fTrueVertex, seeds);
+
+  double trueX = fTrueVertex->GetPosition().X();
+  double trueY = fTrueVertex->GetPosition().Y();
+  double trueZ = fTrueVertex->GetPosition().Z();
+  double trueDirX = fTrueVertex->GetDirection().X();
+  double trueDirY = fTrueVertex->GetDirection().Y();
+  double trueDirZ = fTrueVertex->GetDirection().Z();
+
+  for(unsigned int isetup=0; isetup<fSetups.size(); isetup++){
+    MinuitOptimizer* myOptimizer = fOptimizers.at(isetup);
+    FitResult best;
+    bool foundBest = false;
+    for(unsigned int n=0; n<seeds.size(); n++){
+      myOptimizer->LoadVertex(&(seeds.at(n)));
+      auto start = std::chrono::steady_clock::now();
+      myOptimizer->FitExtendedVertexWithMinuit();
+      auto end = std::chrono::steady_clock::now();
+
+      RecoVertex* fitted = myOptimizer->GetFittedVertex();
+      double dx = fitted->GetPosition().X()-trueX;
+      double dy = fitted->GetPosition().Y()-trueY;
+      double dz = fitted->GetPosition().Z()-trueZ;
+      double cosangle = fitted->GetDirection().X()*trueDirX + fitted->GetDirection().Y()*trueDirY
+                      + fitted->GetDirection().Z()*trueDirZ;
+      FitResult result;
+      result.fEvent = fEventNumber;
+      result.fSeed = n;
+      result.fDistance = sqrt(dx*dx+dy*dy+dz*dz);
+      result.fAngle = acos(std::max(-1.0, std::min(1.0, cosangle)))*180.0/M_PI;
+      result.fFOM = fitted->GetFOM();
+      result.fStatus = fitted->GetStatus();
+      result.fStats = myOptimizer->GetFitStatistics();
+      result.fMicroseconds = std::chrono::duration<double, std::micro>(end-start).count();
+      fResults.at(isetup).push_back(result);
+
+      if(fReport.is_open()){
+        fReport << fSetups.at(isetup).fLabel << "," << result.fEvent << "," << result.fSeed << ","
+                << result.fStatus << "," << result.fStats.fConverged << "," << result.fStats.fCalls << ","
+                << result.fStats.fGradientCalls << "," << result.fStats.fIterations << ","
+                << result.fFOM << "," << result.fDistance << "," << result.fAngle << ","
+                << result.fMicroseconds << std::endl;
+      }
+      // the fit the reconstruction would keep: the highest FOM of the good fits
+      if(result.fStatus==0 && (!foundBest || result.fFOM>best.fFOM)){
+        best = result;
+        foundBest = true;
+      }
+    }
+    if(foundBest) fEventBest.at(isetup).push_back(best);
+  }
+  fEventsFitted++;
+  return true;
+}
+
+void VtxFitBackendComparison::MakeSeeds(RecoVertex* trueVertex, std::vector<RecoVertex>& seeds){
+  // The first seed is the true vertex itself.  The others are moved by a Gaussian
+  // distance in each coordinate and in time, and the direction is tilted by a Gaussian
+  // angle towards a random perpendicular.
+  double vtxX = trueVertex->GetPosition().X();
+  double vtxY = trueVertex->GetPosition().Y();
+  double vtxZ = trueVertex->GetPosition().Z();
+  double vtxTime = trueVertex->GetTime();
+  double dirX = trueVertex->GetDirection().X();
+  double dirY = trueVertex->GetDirection().Y();
+  double dirZ = trueVertex->GetDirection().Z();
+
+  for(int n=0; n<fSeedsPerEvent; n++){
+    RecoVertex seed;
+    if(n==0){
+      seed.SetVertex(vtxX, vtxY, vtxZ, vtxTime);
+      seed.SetDirection(dirX, dirY, dirZ);
+      seeds.push_back(seed);
+      continue;
+    }
+    seed.SetVertex(vtxX+fRandom.Gaus(0.0,fSeedPositionSmear), vtxY+fRandom.Gaus(0.0,fSeedPositionSmear),
+                   vtxZ+fRandom.Gaus(0.0,fSeedPositionSmear), vtxTime+fRandom.Gaus(0.0,fSeedTimeSmear));
+    double ex = fRandom.Gaus(), ey = fRandom.Gaus(), ez = fRandom.Gaus();
+    double along = ex*dirX+ey*dirY+ez*dirZ;
+    ex -= along*dirX; ey -= along*dirY; ez -= along*dirZ;
+    double norm = sqrt(ex*ex+ey*ey+ez*ez);
+    double tilt = fRandom.Gaus(0.0,fSeedAngleSmear)*M_PI/180.0;
+    if(norm>0.0){
+      seed.SetDirection(cos(tilt)*dirX+sin(tilt)*ex/norm, cos(tilt)*dirY+sin(tilt)*ey/norm,
+                        cos(tilt)*dirZ+sin(tilt)*ez/norm);
+    }
+    else seed.SetDirection(dirX, dirY, dirZ);
+    seeds.push_back(seed);
+  }
+}
+
+void VtxFitBackendComparison::ReportBackend(const BackendSetup& setup, const std::vector<FitResult>& results,
+                                            const std::vector<FitResult>& eventBest){
+  int nfits = results.size();
+  int nconverged = 0, ngood = 0;
+  double calls = 0.0, gradientCalls = 0.0, iterations = 0.0, microseconds = 0.0, fom = 0.0;
+  bool countsIterations = true;
+  std::vector<double> distances, angles, bestDistances, bestAngles;
+  for(const FitResult& result : results){
+    if(result.fStats.fConverged) nconverged++;
+    if(result.fStatus==0) ngood++;
+    calls += result.fStats.fCalls;
+    gradientCalls += result.fStats.fGradientCalls;
+    if(result.fStats.fIterations<0) countsIterations = false;
+    iterations += result.fStats.fIterations;
+    microseconds += result.fMicroseconds;
+    fom += result.fFOM;
+    distances.push_back(result.fDistance);
+    angles.push_back(result.fAngle);
+  }
+  for(const FitResult& result : eventBest){
+    bestDistances.push_back(result.fDistance);
+    bestAngles.push_back(result.fAngle);
+  }
+  double perfit = ( nfits>0 ) ? 1.0/nfits : 0.0;
+
+  std::cout << std::fixed << std::setprecision(1)
+            << std::setw(18) << std::left << setup.fLabel << std::right
+            << std::setw(7) << nfits
+            << std::setw(8) << 100.0*nconverged*perfit
+            << std::setw(8) << 100.0*ngood*perfit
+            << std::setw(9) << calls*perfit
+            << std::setw(9) << gradientCalls*perfit;
+  if(countsIterations) std::cout << std::setw(8) << iterations*perfit;
+  else std::cout << std::setw(8) << "-";
+  std::cout << std::setw(11) << microseconds*perfit
+            << std::setw(9) << fom*perfit
+            << std::setw(9) << Quantile(distances, 0.5)
+            << std::setw(9) << Quantile(distances, 0.68)
+            << std::setw(9) << Quantile(angles, 0.5)
+            << std::setw(8) << eventBest.size()
+            << std::setw(9) << Quantile(bestDistances, 0.5)
+            << std::setw(9) << Quantile(bestAngles, 0.5)
+            << std::endl;
+}
+
+bool VtxFitBackendComparison::Finalise(){
+  std::cout << std::endl << "VtxFitBackendComparison: extended vertex fits of " << fEventsFitted
+            << " events, " << fSeedsPerEvent << " seeds per event" << std::endl;
+  std::cout << std::setw(18) << std::left << "backend" << std::right
+            << std::setw(7) << "fits" << std::setw(8) << "conv%" << std::setw(8) << "good%"
+            << std::setw(9) << "calls" << std::setw(9) << "grads" << std::setw(8) << "iters"
+            << std::setw(11) << "us/fit" << std::setw(9) << "FOM"
+            << std::setw(9) << "dr50" << std::setw(9) << "dr68" << std::setw(9) << "angle50"
+            << std::setw(8) << "events" << std::setw(9) << "best dr" << std::setw(9) << "best ang"
+            << std::endl;
+  for(unsigned int isetup=0; isetup<fSetups.size(); isetup++){
+    this->ReportBackend(fSetups.at(isetup), fResults.at(isetup), fEventBest.at(isetup));
+  }
+  std::cout << "  conv%: fits the backend reports converged; good%: fits with RecoVertex status 0" << std::endl
+            << "  calls, grads, iters: FoM evaluations, of them with gradient, and iterations per fit" << std::endl
+            << "  dr50/dr68 [cm], angle50 [deg]: quantiles of the distance and angle to the true vertex" << std::endl
+            << "  best: the highest-FOM good fit of each event, as the reconstruction would keep" << std::endl;
+
+  if(fReport.is_open()) fReport.close();
+  for(MinuitOptimizer* myOptimizer : fOptimizers) delete myOptimizer;
+  fOptimizers.clear();
+  delete fRecoContext; fRecoContext = 0;
+  return true;
+}
@@ -0,0 +1,99 @@
+#ifndef VtxFitBackendComparison_H
+#define VtxFitBackendComparison_H
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+#include "Tool.h"
+#include "TRandom3.h"
+#include "MinuitOptimizer.h"
+#include "VertexFitBackend.h"
+#include "VertexRecoContext.h"
+
+/**
+* \class VtxFitBackendComparison
+*
+* Runs the extended vertex fit of every event with each VertexFitBackend in turn, from
+* the same seeds: the MC true vertex smeared by fixed random amounts.  Finalise reports
+* fit quality (distance and angle to the true vertex, FOM) and speed (FoM evaluations,
+* iterations and time per fit) for each backend.
+*/
+
+class VtxFitBackendComparison: public Tool {
+
+
+ public:
+
+  VtxFitBackendComparison();
+  bool Initialise(std::string configfile,DataModel &data);
+  bool Execute();
+  bool Finalise();
+
+
+ private:
+
+  /// \brief A backend to compare, with or without the analytic gradient
+  struct BackendSetup {
+    std::string fLabel;
+    std::string fBackend;
+    bool fUseAnalyticGradient;
+  };
+
+  /// \brief One fit of one seed with one backend
+  struct FitResult {
+    int fEvent;
+    int fSeed;
+    double fDistance;   ///< to the true vertex [cm]
+    double fAngle;      ///< to the true direction [deg]
+    double fFOM;
+    int fStatus;        ///< RecoVertex status of the fit
+    FitStatistics fStats;
+    double fMicroseconds;
+  };
+
+  /// \brief Seeds of an event: the true vertex, smeared
+  void MakeSeeds(RecoVertex* trueVertex, std::vector<RecoVertex>& seeds);
+
+  /// \brief Summary of the fits of one backend
+  void ReportBackend(const BackendSetup& setup, const std::vector<FitResult>& results,
+                     const std::vector<FitResult>& eventBest);
+
+  /// \brief ANNIE event number
+  uint32_t fEventNumber;
+
+  std::vector<BackendSetup> fSetups;
+  std::vector<MinuitOptimizer*> fOptimizers;     ///< one per setup
+  std::vector<std::vector<FitResult> > fResults;    ///< every fit, per setup
+  std::vector<std::vector<FitResult> > fEventBest;  ///< highest-FOM good fit of each event, per setup
+
+  VertexRecoContext* fRecoContext = 0;
+  std::vector<RecoDigit>* fDigitList = 0;
+  RecoVertex* fTrueVertex = 0;
+  TRandom3 fRandom;
+
+  int fSeedsPerEvent;
+  double fSeedPositionSmear;   ///< cm, per coordinate
+  double fSeedAngleSmear;      ///< degrees
+  double fSeedTimeSmear;       ///< ns
+  double fTmin;
+  double fTmax;
+  int fMaxEvents;
+  int fEventsFitted;
+  std::string fReportFile;
+  std::ofstream fReport;
+
+  /// verbosity levels: if 'verbosity' < this level, the message type will be logged.
+  int verbosity=-1;
+  int v_error=0;
+  int v_warning=1;
+  int v_message=2;
+  int v_debug=3;
+  std::string logmessage;
+  int get_ok;
+
+};
+
+
+#endif
@@ -13,15 +13,22 @@ bool VtxPointDirectionFinder::Initialise(std::string configfile, DataModel &data
   /////////////////////////////////////////////////////////////////
   
   fUseTrueVertexAsSeed = false;
+  fFitBackend = "Minuit";
   
   /// Get the Tool configuration variables
 	m_variables.Get("UseTrueVertexAsSeed",fUseTrueVertexAsSeed);
 	m_variables.Get("verbosity", verbosity);
+	m_variables.Get("FitBackend", fFitBackend);
+	if(!VertexFitBackend::IsBackend(fFitBackend)){
+	  Log("VtxPointDirectionFinder Tool: Error: unknown FitBackend "+fFitBackend+" (Minuit or LBFGS)",v_error,verbosity);
+	  return false;
+	}
 	
 	/// The pointer has to be deleted after usage
 	fSimpleDirection = new RecoVertex();
 	fPointDirection = new RecoVertex();
 
+  fRecoContext = new VertexRecoContext();
   return true;
 }
 
@@ -61,8 +68,7 @@ bool VtxPointDirectionFinder::Execute(){
   }
 	
 	// Load digits to VertexGeometry
-  VertexGeometry* myvtxgeo = VertexGeometry::Instance();
-  myvtxgeo->LoadDigits(fDigitList);
+  fRecoContext->LoadDigits(fDigitList);
 	// Do extended vertex (muon track) reconstruction using MC truth information
 	if( fUseTrueVertexAsSeed ){
     Log("VtxPointDirectionFinder Tool: Run direction reconstruction using MC truth information",v_message,verbosity);
@@ -104,6 +110,7 @@ bool VtxPointDirectionFinder::Finalise(){
 	/// for example the SaveRecoEvent tool
 	delete fSimpleDirection; fSimpleDirection = 0;
 	delete fPointDirection; fPointDirection = 0;
+	delete fRecoContext; fRecoContext = 0;
 	if(verbosity>0) cout<<"VtxPointDirectionFinder exitting"<<endl;
   return true;
 }
@@ -195,11 +202,10 @@ RecoVertex* VtxPointDirectionFinder::FindSimpleDirection(RecoVertex* myVertex) {
 
 RecoVertex* VtxPointDirectionFinder::FitPointDirection(RecoVertex* myVertex) {
   //fit with Minuit
-  MinuitOptimizer* myOptimizer = new MinuitOptimizer();
+  MinuitOptimizer* myOptimizer = fRecoContext->NewOptimizer();
   myOptimizer->SetPrintLevel(0);
+  myOptimizer->SetFitBackend(fFitBackend);
   myOptimizer->SetMeanTimeCalculatorType(1); //Type 1: most probable time
-  VertexGeometry* myvtxgeo = VertexGeometry::Instance();
-  myOptimizer->LoadVertexGeometry(myvtxgeo); //Load vertex geometry
   myOptimizer->LoadVertex(myVertex); //Load vertex seed
   myOptimizer->FitPointDirectionWithMinuit(); //scan the point position in 4D space
   // Fitted vertex must be copied to a new vertex pointer that is created in this class 
@@ -7,6 +7,7 @@
 #include "Tool.h"
 #include "VertexGeometry.h"
 #include "MinuitOptimizer.h"
+#include "VertexRecoContext.h"
 
 class VtxPointDirectionFinder: public Tool {
 
@@ -45,9 +46,13 @@ class VtxPointDirectionFinder: public Tool {
  	void PushPointDirection(RecoVertex* vtx, bool savetodisk);
  	
  	bool fUseTrueVertexAsSeed;
+ 	std::string fFitBackend; ///< VertexFitBackend minimising the fits ("Minuit" or "LBFGS")
  	RecoVertex* fTrueVertex = 0;
  	std::vector<RecoDigit>* fDigitList = 0;
  	
+ 	/// \brief digits, residuals and optimizers of the fits of this tool
+ 	VertexRecoContext* fRecoContext = 0;
+ 	
  	/// \brief simple direction
  	RecoVertex* fSimpleDirection = 0;
  	/// \brief point direction
@@ -14,11 +14,17 @@ bool VtxPointPositionFinder::Initialise(std::string configfile, DataModel &data)
   
   fUseTrueVertexAsSeed = false;
   fUseMinuit = true;
+  fFitBackend = "Minuit";
   
   /// Get the Tool configuration variables
 	m_variables.Get("UseTrueVertexAsSeed",fUseTrueVertexAsSeed);
 	m_variables.Get("UseMinuitForPos",fUseMinuit);
 	m_variables.Get("verbosity", verbosity);
+	m_variables.Get("FitBackend", fFitBackend);
+	if(!VertexFitBackend::IsBackend(fFitBackend)){
+	  Log("VtxPointPositionFinder Tool: Error: unknown FitBackend "+fFitBackend+" (Minuit or LBFGS)",v_error,verbosity);
+	  return false;
+	}
 	
 	/// Create Simple position and point position
 	/// Note that the objects created by "new" must be added to the "RecoEvent" store. 
@@ -30,6 +36,7 @@ bool VtxPointPositionFinder::Initialise(std::string configfile, DataModel &data)
 
         // Now Create the list of Seed FOMs
         vSeedFOMList = new std::vector<double>;
+  fRecoContext = new VertexRecoContext();
   return true;
 }
 
@@ -71,9 +78,7 @@ bool VtxPointPositionFinder::Execute(){
   }
   
   // Load digits to VertexGeometry
-  VertexGeometry* myvtxgeo = VertexGeometry::Instance();
-  //myvtxgeo->Clear();
-  myvtxgeo->LoadDigits(fDigitList);
+  fRecoContext->LoadDigits(fDigitList);
   
   // Do point position reconstruction using MC truth information
   if( fUseTrueVertexAsSeed ){
@@ -131,6 +136,7 @@ bool VtxPointPositionFinder::Finalise(){
 	delete fSimplePosition; fSimplePosition = 0;
 	delete fPointPosition; fPointPosition = 0;
 	delete vSeedFOMList; vSeedFOMList = 0;
+	delete fRecoContext; fRecoContext = 0;
 	if(verbosity>0) cout<<"VtxPointPositionFinder exitting"<<endl;
   return true;
 }
@@ -146,11 +152,10 @@ bool VtxPointPositionFinder::Finalise(){
 /// we'll come back to fix this later.  (Jingbo Wang, Aug 24, 2018)
 RecoVertex* VtxPointPositionFinder::FitPointPosition(RecoVertex* myVertex) {
   //fit with Minuit
-  MinuitOptimizer* myOptimizer = new MinuitOptimizer();
+  MinuitOptimizer* myOptimizer = fRecoContext->NewOptimizer();
   myOptimizer->SetPrintLevel(0);
+  myOptimizer->SetFitBackend(fFitBackend);
   myOptimizer->SetMeanTimeCalculatorType(1); //
-  VertexGeometry* myvtxgeo = VertexGeometry::Instance();
-  myOptimizer->LoadVertexGeometry(myvtxgeo); //Load vertex geometry
   myOptimizer->LoadVertex(myVertex); //Load vertex seed
   myOptimizer->FitPointPositionWithMinuit(); //scan the point position in 4D space
   // Fitted vertex must be copied to a new vertex pointer that is created in this class 
@@ -179,11 +184,10 @@ RecoVertex* VtxPointPositionFinder::FindSimplePosition(std::vector<RecoVertex>*
   unsigned int nlast = vSeedVtxList->size();
   
   //Find best time with Minuit
-  MinuitOptimizer* myOptimizer = new MinuitOptimizer();
+  MinuitOptimizer* myOptimizer = fRecoContext->NewOptimizer();
   myOptimizer->SetPrintLevel(0);
+  myOptimizer->SetFitBackend(fFitBackend);
   myOptimizer->SetMeanTimeCalculatorType(1);
-  VertexGeometry* myvtxgeo = VertexGeometry::Instance();
-  myOptimizer->LoadVertexGeometry(myvtxgeo); //Load vertex geometry
   RecoVertex* vSeed = 0;
   RecoVertex* newVertex = new RecoVertex(); // Note: pointer must be deleted by the invoker
   
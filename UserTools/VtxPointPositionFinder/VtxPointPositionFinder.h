@@ -7,6 +7,7 @@
 #include "Tool.h"
 #include "VertexGeometry.h"
 #include "MinuitOptimizer.h"
+#include "VertexRecoContext.h"
 #include <TRandom3.h>
 
 class VtxPointPositionFinder: public Tool {
@@ -55,10 +56,14 @@ class VtxPointPositionFinder: public Tool {
  	void PushVertexSeedFOMList(bool savetodisk);
  	
  	bool fUseTrueVertexAsSeed;
+ 	std::string fFitBackend; ///< VertexFitBackend minimising the fits ("Minuit" or "LBFGS")
  	bool fUseMinuit; //If True, give the best GridSeed to the Minuit Optimizer
 
  	RecoVertex* fTrueVertex = 0;
  	std::vector<RecoDigit>* fDigitList = 0;
+ 	
+ 	/// \brief digits, residuals and optimizers of the fits of this tool
+ 	VertexRecoContext* fRecoContext = 0;
 
 	// Create an object to store the Grid Seed FOMs 
         std::vector<double>* vSeedFOMList;
@@ -12,14 +12,21 @@ bool VtxPointVertexFinder::Initialise(std::string configfile, DataModel &data){
   m_data= &data; //assigning transient data pointer
   /////////////////////////////////////////////////////////////////
 	fUseTrueVertexAsSeed = false;
+	fFitBackend = "Minuit";
   
   /// Get the Tool configuration variables
 	m_variables.Get("UseTrueVertexAsSeed",fUseTrueVertexAsSeed);
 	m_variables.Get("verbosity", verbosity);
+	m_variables.Get("FitBackend", fFitBackend);
+	if(!VertexFitBackend::IsBackend(fFitBackend)){
+	  Log("VtxPointVertexFinder Tool: Error: unknown FitBackend "+fFitBackend+" (Minuit or LBFGS)",v_error,verbosity);
+	  return false;
+	}
 	
 	/// The pointer has to be deleted after usage
 	fPointVertex = new RecoVertex();
 	
+  fRecoContext = new VertexRecoContext();
   return true;
 }
 
@@ -59,8 +66,7 @@ bool VtxPointVertexFinder::Execute(){
   }
 	
 	// Load digits to VertexGeometry
-  VertexGeometry* myvtxgeo = VertexGeometry::Instance();
-  myvtxgeo->LoadDigits(fDigitList);
+  fRecoContext->LoadDigits(fDigitList);
 	// Do extended vertex (muon track) reconstruction using MC truth information
 	if( fUseTrueVertexAsSeed ){
     Log("VtxPointVertexFinder Tool: Run direction reconstruction using MC truth information",v_message,verbosity);
@@ -99,17 +105,17 @@ bool VtxPointVertexFinder::Finalise(){
 	/// If the pointer is not delected here, it can be delected in the last tool in the tool chain,
 	/// for example the SaveRecoEvent tool
 	delete fPointVertex; fPointVertex = 0;
+	delete fRecoContext; fRecoContext = 0;
 	if(verbosity>0) cout<<"VtxPointVertexFinder exitting"<<endl;
   return true;
 }
 
 RecoVertex* VtxPointVertexFinder::FitPointVertex(RecoVertex* myVertex) {
   //fit with Minuit
-  MinuitOptimizer* myOptimizer = new MinuitOptimizer();
+  MinuitOptimizer* myOptimizer = fRecoContext->NewOptimizer();
   myOptimizer->SetPrintLevel(0);
+  myOptimizer->SetFitBackend(fFitBackend);
   myOptimizer->SetMeanTimeCalculatorType(1); //Type 1: most probable time
-  VertexGeometry* myvtxgeo = VertexGeometry::Instance();
-  myOptimizer->LoadVertexGeometry(myvtxgeo); //Load vertex geometry
   myOptimizer->LoadVertex(myVertex); //Load vertex seed
   myOptimizer->FitPointVertexWithMinuit(); //scan the point position in 4D space
   // Fitted vertex must be copied to a new vertex pointer that is created in this class 
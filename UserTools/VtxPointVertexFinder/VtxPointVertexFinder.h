@@ -7,6 +7,7 @@
 #include "Tool.h"
 #include "VertexGeometry.h"
 #include "MinuitOptimizer.h"
+#include "VertexRecoContext.h"
 
 class VtxPointVertexFinder: public Tool {
 
@@ -39,9 +40,13 @@ class VtxPointVertexFinder: public Tool {
  	void PushPointVertex(RecoVertex* vtx, bool savetodisk);
  	
  	bool fUseTrueVertexAsSeed;
+ 	std::string fFitBackend; ///< VertexFitBackend minimising the fits ("Minuit" or "LBFGS")
  	RecoVertex* fTrueVertex = 0;
  	std::vector<RecoDigit>* fDigitList = 0;
  	
+ 	/// \brief digits, residuals and optimizers of the fits of this tool
+ 	VertexRecoContext* fRecoContext = 0;
+ 	
  	/// \brief point vertex
  	RecoVertex* fPointVertex = 0;
  	
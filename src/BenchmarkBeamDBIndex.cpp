@@ -0,0 +1,121 @@
+//Microbenchmark of the beam database entry lookup of BeamDecoder: BeamDBIndex::Find against the
+//linear std::find_if scan over the BeamDBIndex header map that it replaced.
+//
+//Usage: ./BenchmarkBeamDBIndex [Key=Value ...]
+//
+//  Chunks        beam database entries in the index (default 2000)
+//  ChunkSeconds  time range held by each entry (default 3600)
+//  Overlap       fraction of the entries that overlap the next one by a tenth of their range
+//                (default 0.1)
+//  Lookups       timestamps looked up per pattern (default 200000)
+//  Seed          random seed of the index and the timestamps (default 4357)
+//
+//Two patterns are timed: timestamps in time order (spread evenly over the index with jitter, as
+//the CTC triggers of a run arrive), and timestamps in random order.  Both lookups are run on the
+//same timestamps; the benchmark fails if they return a different entry for any of them.
+
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Store.h"
+#include "BeamDBIndex.h"
+
+static double WallSeconds(){
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//The lookup of get_beam_status before BeamDBIndex: first entry (lowest entry number) holding the time
+static int LinearFind(const std::map<int, std::pair<uint64_t, uint64_t>> &beam_db_index, uint64_t ms_since_epoch){
+  auto iter = std::find_if(beam_db_index.cbegin(), beam_db_index.cend(),
+    [ms_since_epoch](const std::pair<int, std::pair<uint64_t, uint64_t> >& pair) -> bool {
+      return ms_since_epoch >= pair.second.first && ms_since_epoch <= pair.second.second;
+    });
+  return (iter != beam_db_index.cend()) ? iter->first : -1;
+}
+
+int main(int argc, char* argv[]){
+
+  Store config;
+  for (int i = 1; i < argc; i++){
+    std::string arg = argv[i];
+    size_t pos = arg.find('=');
+    if (pos == std::string::npos){
+      std::cout << "BenchmarkBeamDBIndex ERROR: argument " << arg << " is not of the form Key=Value" << std::endl;
+      return 1;
+    }
+    config.Set(arg.substr(0,pos),arg.substr(pos+1));
+  }
+  int nchunks = 2000;
+  double chunk_seconds = 3600.;
+  double overlap = 0.1;
+  long nlookups = 200000;
+  int seed = 4357;
+  config.Get("Chunks",nchunks);
+  config.Get("ChunkSeconds",chunk_seconds);
+  config.Get("Overlap",overlap);
+  config.Get("Lookups",nlookups);
+  config.Get("Seed",seed);
+  if (nchunks < 1 || chunk_seconds <= 0. || nlookups < 1){
+    std::cout << "BenchmarkBeamDBIndex ERROR: Chunks, ChunkSeconds and Lookups must be positive" << std::endl;
+    return 1;
+  }
+
+  //Consecutive entries as the BeamFetcher writes them, some reaching into the next one
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uniform(0.,1.);
+  const uint64_t start_ms = 1600000000000ULL;
+  const uint64_t chunk_ms = static_cast<uint64_t>(1000.*chunk_seconds);
+  std::map<int, std::pair<uint64_t, uint64_t>> beam_db_index;
+  for (int entry = 0; entry < nchunks; entry++){
+    uint64_t first = start_ms + entry*chunk_ms;
+    uint64_t last = first + chunk_ms - 1;
+    if (uniform(rng) < overlap) last += chunk_ms/10;
+    beam_db_index[entry] = std::make_pair(first,last);
+  }
+  const uint64_t end_ms = start_ms + nchunks*chunk_ms;
+
+  double build_start = WallSeconds();
+  BeamDBIndex index;
+  index.Build(beam_db_index);
+  double build_seconds = WallSeconds()-build_start;
+
+  std::cout << "BenchmarkBeamDBIndex: " << nchunks << " entries of " << chunk_seconds << " s, " << nlookups
+            << " lookups per pattern; index built in " << std::fixed << std::setprecision(3) << 1e3*build_seconds << " ms" << std::endl;
+
+  long mismatches = 0;
+  const char *patterns[2] = {"time ordered","random"};
+  for (int pattern = 0; pattern < 2; pattern++){
+    std::vector<uint64_t> times(nlookups);
+    double step = double(end_ms-start_ms)/nlookups;
+    for (long i = 0; i < nlookups; i++){
+      if (pattern == 0) times[i] = start_ms + static_cast<uint64_t>(step*(i+uniform(rng)));
+      else times[i] = start_ms + static_cast<uint64_t>((end_ms-start_ms)*uniform(rng));
+    }
+
+    std::vector<int> linear(nlookups), indexed(nlookups);
+    double start = WallSeconds();
+    for (long i = 0; i < nlookups; i++) linear[i] = LinearFind(beam_db_index,times[i]);
+    double linear_seconds = WallSeconds()-start;
+    index.Build(beam_db_index);  //start from the first entry again
+    start = WallSeconds();
+    for (long i = 0; i < nlookups; i++) indexed[i] = index.Find(times[i]);
+    double indexed_seconds = WallSeconds()-start;
+    for (long i = 0; i < nlookups; i++) mismatches += (linear[i] != indexed[i]);
+
+    std::cout << "  " << std::left << std::setw(13) << patterns[pattern] << std::right << std::setprecision(1)
+              << "std::find_if " << std::setw(10) << 1e-6*nlookups/linear_seconds << " Mlookups/s"
+              << "   BeamDBIndex::Find " << std::setw(10) << 1e-6*nlookups/indexed_seconds << " Mlookups/s"
+              << "   speedup " << std::setw(8) << linear_seconds/indexed_seconds << std::endl;
+  }
+  std::cout << "  " << mismatches << " lookups returned a different entry" << std::endl;
+
+  return (mismatches == 0) ? 0 : 1;
+}
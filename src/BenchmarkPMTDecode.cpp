@@ -0,0 +1,221 @@
+//Microbenchmark of the PMT raw data decoding of PMTDataDecoder: the streaming decoder
+//(DecodeCardFrames) against the frame-container decoder it replaced (DecodeFrames followed by
+//ParseFrame, still selected with UseLegacyDecoder 1).
+//
+//Usage: ./BenchmarkPMTDecode [Key=Value ...]
+//
+//  Entries      PMTData entries to decode (default 50)
+//  Cards        ADC cards per entry (default 32)
+//  Channels     channels per card (default 4)
+//  Triggers     record header + waveform records per channel and entry (default 10)
+//  Samples      samples per waveform (default 2000)
+//  Seed         random seed of the waveforms (default 4357)
+//
+//Every entry is generated in memory (one data bank per card, with a sync frame and the records
+//of each channel packed into 16-word frames as the cards write them) and decoded card by card on
+//one thread, once by a decoder of each kind.  The time per entry, frames/s and MB/s of raw data
+//are printed for both.  The waveforms the two decoders finish (channel, trigger time, samples)
+//are compared, and the benchmark fails if they differ.
+
+#include <stdint.h>
+#include <endian.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Store.h"
+#include "DataModel.h"
+#include "CardData.h"
+#include "PMTDataDecoder.h"
+
+static double WallSeconds(){
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const int FRAME_SAMPLES = 40;
+static const int RECORD_HEADER_SAMPLES = 8;
+static const int SYNC_CHANNEL = 10;
+
+//PMTDataDecoder configured without a config file
+class DecoderUnderTest: public PMTDataDecoder {
+
+ public:
+
+  DecoderUnderTest(bool legacy) : PMTDataDecoder() {
+    m_variables.Set("verbosity",0);
+    m_variables.Set("UseLegacyDecoder",legacy ? 1 : 0);
+    m_variables.Set("DecoderThreads",1);
+  }
+
+};
+
+//Inverse of PMTDataDecoder::UnpackFrameSamples: 40 12-bit samples in 15 big endian words,
+//then the channel in the top byte of the last word
+static void PackFrames(const std::vector<uint16_t> &stream, int ChannelID, std::vector<uint32_t> &data){
+  size_t nframes = (stream.size()+FRAME_SAMPLES-1)/FRAME_SAMPLES;
+  uint16_t s[FRAME_SAMPLES];
+  for (size_t frame = 0; frame < nframes; frame++){
+    for (int i = 0; i < FRAME_SAMPLES; i++){
+      size_t index = frame*FRAME_SAMPLES + i;
+      s[i] = index < stream.size() ? stream[index] : stream.back();
+    }
+    for (int group = 0; group < 5; group++){
+      const uint16_t *g = s + 8*group;
+      uint32_t w0 = g[0] | (uint32_t(g[1])<<12) | (uint32_t(g[2]&0xff)<<24);
+      uint32_t w1 = (g[2]>>8) | (uint32_t(g[3])<<4) | (uint32_t(g[4])<<16) | (uint32_t(g[5]&0xf)<<28);
+      uint32_t w2 = (g[5]>>4) | (uint32_t(g[6])<<8) | (uint32_t(g[7])<<20);
+      data.push_back(htobe32(w0));
+      data.push_back(htobe32(w1));
+      data.push_back(htobe32(w2));
+    }
+    data.push_back(htobe32(uint32_t(ChannelID)<<24));
+  }
+}
+
+//0x000, 0xFFF, counter bits 48-71, counter bits 0-47, in 12-bit samples; counters whose
+//samples would hold a second 0x000,0xFFF pair are skipped
+static void MakeRecordHeader(uint64_t ClockCount, std::vector<uint16_t> &stream){
+  uint16_t header[RECORD_HEADER_SAMPLES];
+  while (true){
+    header[0] = 0x000;
+    header[1] = 0xFFF;
+    for (int j = 0; j < 2; j++) header[2+j] = (ClockCount >> ((4+j)*12)) & 0xfff;
+    for (int j = 0; j < 4; j++) header[4+j] = (ClockCount >> (j*12)) & 0xfff;
+    bool fake_label = false;
+    for (int j = 1; j < RECORD_HEADER_SAMPLES-1; j++) fake_label |= (header[j]==0x000 && header[j+1]==0xFFF);
+    if (!fake_label) break;
+    ClockCount++;
+  }
+  stream.insert(stream.end(),header,header+RECORD_HEADER_SAMPLES);
+}
+
+//One CardData per card: a sync frame, then the records of each channel.  Records are a multiple
+//of 8 samples long, so the record headers start anywhere in a frame but are never split.
+static void MakeEntry(int entry, int ncards, int nchannels, int ntriggers, int nsamples,
+                      std::mt19937 &rng, std::vector<CardData> &cards){
+  std::normal_distribution<double> noise(0.,2.);
+  std::uniform_real_distribution<double> baseline(310.,350.);
+  cards.resize(ncards);
+  std::vector<uint16_t> stream;
+  for (int icard = 0; icard < ncards; icard++){
+    CardData &aCardData = cards.at(icard);
+    aCardData.CardID = 1000*(1+icard/16) + icard%16;
+    aCardData.SequenceID = entry;
+    aCardData.FirmwareVersion = 0;
+    aCardData.FIFOstate = 0;
+    aCardData.Data.clear();
+    uint64_t SyncCounter = 1000000 + entry;
+    stream.assign(FRAME_SAMPLES,0);
+    for (int i = 0; i < 6; i++) stream[i] = (SyncCounter >> (12*i)) & 0xfff;
+    PackFrames(stream,SYNC_CHANNEL,aCardData.Data);
+    for (int ichannel = 0; ichannel < nchannels; ichannel++){
+      int ChannelID = (ichannel < SYNC_CHANNEL) ? ichannel : ichannel+1;
+      stream.clear();
+      for (int trigger = 0; trigger < ntriggers; trigger++){
+        MakeRecordHeader(200000000000000000ULL + uint64_t(entry*ntriggers+trigger)*125000,stream);
+        double level = baseline(rng);
+        for (int sample = 0; sample < nsamples; sample++){
+          stream.push_back(static_cast<uint16_t>(std::min(4095.,std::max(1.,std::round(level+noise(rng))))));
+        }
+      }
+      PackFrames(stream,ChannelID,aCardData.Data);
+    }
+  }
+}
+
+int main(int argc, char* argv[]){
+
+  Store config;
+  for (int i = 1; i < argc; i++){
+    std::string arg = argv[i];
+    size_t pos = arg.find('=');
+    if (pos == std::string::npos){
+      std::cout << "BenchmarkPMTDecode ERROR: argument " << arg << " is not of the form Key=Value" << std::endl;
+      return 1;
+    }
+    config.Set(arg.substr(0,pos),arg.substr(pos+1));
+  }
+  int nentries = 50;
+  int ncards = 32;
+  int nchannels = 4;
+  int ntriggers = 10;
+  int nsamples = 2000;
+  int seed = 4357;
+  config.Get("Entries",nentries);
+  config.Get("Cards",ncards);
+  config.Get("Channels",nchannels);
+  config.Get("Triggers",ntriggers);
+  config.Get("Samples",nsamples);
+  config.Get("Seed",seed);
+  if (nentries < 1 || ncards < 1 || nchannels < 1 || ntriggers < 1 || nsamples < 1){
+    std::cout << "BenchmarkPMTDecode ERROR: Entries, Cards, Channels, Triggers and Samples must be positive" << std::endl;
+    return 1;
+  }
+  nsamples = ((RECORD_HEADER_SAMPLES+nsamples+7)/8)*8 - RECORD_HEADER_SAMPLES;
+
+  DataModel legacy_data, streaming_data;
+  DecoderUnderTest legacy(true), streaming(false);
+  legacy.Initialise("",legacy_data);
+  streaming.Initialise("",streaming_data);
+
+  std::mt19937 rng(seed);
+  std::vector<CardData> cards;
+  double legacy_seconds = 0., streaming_seconds = 0.;
+  double frames = 0.;
+  long waves = 0, mismatches = 0;
+  for (int entry = 0; entry < nentries; entry++){
+    MakeEntry(entry,ncards,nchannels,ntriggers,nsamples,rng,cards);
+    for (const CardData &aCardData : cards) frames += aCardData.Data.size()/16;
+
+    std::vector<CardDecodeTask> legacy_tasks, streaming_tasks;
+    for (const CardData &aCardData : cards){
+      legacy.AddCardDecodeTask(aCardData,legacy_tasks);
+      streaming.AddCardDecodeTask(aCardData,streaming_tasks);
+    }
+    //alternate which decoder goes first, so neither always finds the data in the cache
+    for (int pass = 0; pass < 2; pass++){
+      bool legacy_pass = ((entry+pass)%2 == 0);
+      DecoderUnderTest &decoder = legacy_pass ? legacy : streaming;
+      std::vector<CardDecodeTask> &tasks = legacy_pass ? legacy_tasks : streaming_tasks;
+      double start = WallSeconds();
+      for (CardDecodeTask &task : tasks) decoder.DecodeCardTask(task);
+      (legacy_pass ? legacy_seconds : streaming_seconds) += WallSeconds()-start;
+    }
+
+    for (int icard = 0; icard < ncards; icard++){
+      const std::vector<PendingWave> &a = legacy_tasks.at(icard).FinishedWaves;
+      const std::vector<PendingWave> &b = streaming_tasks.at(icard).FinishedWaves;
+      waves += b.size();
+      if (a.size() != b.size()){
+        mismatches += std::max(a.size(),b.size());
+        continue;
+      }
+      for (size_t i = 0; i < a.size(); i++){
+        if (a[i].Key != b[i].Key || a[i].TrigTime != b[i].TrigTime || a[i].Samples != b[i].Samples) mismatches++;
+      }
+    }
+  }
+  legacy.Finalise();
+  streaming.Finalise();
+
+  double megabytes = 64.*frames/1048576.;
+  std::cout << "BenchmarkPMTDecode: " << nentries << " entries of " << ncards << " cards, " << nchannels << " channels, "
+            << ntriggers << " records of " << nsamples << " samples" << std::endl;
+  std::cout << "  " << std::fixed << std::setprecision(0) << frames << " frames, " << std::setprecision(1) << megabytes
+            << " MB, " << waves << " waveforms finished, " << mismatches << " differing between the decoders" << std::endl;
+  const char *names[2] = {"DecodeFrames + ParseFrame (legacy)","DecodeCardFrames (streaming)"};
+  const double seconds[2] = {legacy_seconds,streaming_seconds};
+  for (int i = 0; i < 2; i++){
+    std::cout << "  " << std::left << std::setw(36) << names[i] << std::right << std::setprecision(3)
+              << std::setw(10) << 1e3*seconds[i]/nentries << " ms/entry" << std::setprecision(1)
+              << std::setw(10) << 1e-6*frames/seconds[i] << " Mframes/s" << std::setw(10) << megabytes/seconds[i] << " MB/s" << std::endl;
+  }
+  std::cout << "  speedup " << std::setprecision(2) << legacy_seconds/streaming_seconds << std::endl;
+
+  return (mismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+//Benchmark of the polynomial baseline fits of PhaseIIADCCalibrator: BaselineEstimationType
+//polyfit (make_calibrated_waveforms_polyfit, PolyBaseline) against rootfit
+//(make_calibrated_waveforms_rootfit, a TF1 fitted to a TGraph), on generated PMT waveforms.
+//
+//Usage: ./BenchmarkPolyBaseline [Key=Value ...]
+//
+//  Waveforms                waveforms to calibrate (default 10000)
+//  Samples                  samples per waveform (default 2000)
+//  NumBaselineSamples       last sample of the baseline fit (default 980, the tool's default)
+//  BaselineFitStartSample   first sample of the baseline fit (default 0)
+//  BaselineFitOrder         order of the baseline polynomial (default 1)
+//  RedoFitWithoutOutliers   1 to drop the top 5% of the samples and refit (default 0)
+//  RefitThresholdAdcCounts  waveform range above which the refit is done (default 5)
+//  PulseFraction            fraction of the waveforms with a pulse at a random time (default 0.3)
+//  Tolerance                largest baseline difference allowed, in ADC counts (default 0.01)
+//  Seed                     random seed of the waveforms (default 4357)
+//
+//Both calibrators are set up from the same variables, and each waveform is calibrated by both,
+//one waveform per call as in event building mode.  The time per waveform of each, and the largest
+//differences between them of the baseline (the constant term of the fit) and of the baseline
+//subtracted from any sample, in ADC counts, are printed.  The benchmark fails if either
+//difference exceeds Tolerance.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Store.h"
+#include "DataModel.h"
+#include "PhaseIIADCCalibrator.h"
+
+static double WallSeconds(){
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//PhaseIIADCCalibrator configured without a config file, with its baseline fits made callable
+class CalibratorUnderTest: public PhaseIIADCCalibrator {
+
+ public:
+
+  CalibratorUnderTest(const std::string &method, Store &config) : PhaseIIADCCalibrator() {
+    m_variables.Set("verbosity",0);
+    m_variables.Set("BaselineEstimationType",method);
+    //every fit variable is set, as the tool's defaults are not applied to all of them
+    const char *keys[] = {"NumBaselineSamples","BaselineFitStartSample","BaselineFitOrder",
+                          "RedoFitWithoutOutliers","RefitThresholdAdcCounts"};
+    const char *defaults[] = {"980","0","1","0","5"};
+    for (int i = 0; i < 5; i++){
+      std::string value = defaults[i];
+      config.Get(keys[i],value);
+      m_variables.Set(keys[i],value);
+    }
+  }
+
+  std::vector< CalibratedADCWaveform<double> > Calibrate(const std::vector< Waveform<unsigned short> > &raw_waveforms){
+    return (BEType == "rootfit") ? make_calibrated_waveforms_rootfit(raw_waveforms)
+                                 : make_calibrated_waveforms_polyfit(raw_waveforms);
+  }
+
+};
+
+//A baseline with a slow drift and integer noise, and sometimes a pulse
+static Waveform<unsigned short> MakeWaveform(int nsamples, double pulse_fraction, std::mt19937 &rng){
+  std::uniform_real_distribution<double> uniform(0.,1.);
+  std::normal_distribution<double> noise(0.,1.5);
+  double level = 310. + 40.*uniform(rng);
+  double slope = (uniform(rng) - 0.5)*4./nsamples;
+  double pulse_time = (uniform(rng) < pulse_fraction) ? nsamples*uniform(rng) : -1e9;
+  double pulse_height = 20. + 300.*uniform(rng);
+  std::vector<unsigned short> samples(nsamples);
+  for (int i = 0; i < nsamples; i++){
+    double dt = (i - pulse_time)/4.;
+    double value = level + slope*i + noise(rng) + pulse_height*std::exp(-0.5*dt*dt);
+    samples[i] = static_cast<unsigned short>(std::min(4095.,std::max(0.,std::round(value))));
+  }
+  return Waveform<unsigned short>(0., std::move(samples));
+}
+
+int main(int argc, char* argv[]){
+
+  Store config;
+  for (int i = 1; i < argc; i++){
+    std::string arg = argv[i];
+    size_t pos = arg.find('=');
+    if (pos == std::string::npos){
+      std::cout << "BenchmarkPolyBaseline ERROR: argument " << arg << " is not of the form Key=Value" << std::endl;
+      return 1;
+    }
+    config.Set(arg.substr(0,pos),arg.substr(pos+1));
+  }
+  int nwaveforms = 10000;
+  int nsamples = 2000;
+  int fit_order = 1;
+  double pulse_fraction = 0.3;
+  double tolerance = 0.01;
+  int seed = 4357;
+  config.Get("Waveforms",nwaveforms);
+  config.Get("Samples",nsamples);
+  config.Get("BaselineFitOrder",fit_order);
+  config.Get("PulseFraction",pulse_fraction);
+  config.Get("Tolerance",tolerance);
+  config.Get("Seed",seed);
+  if (nwaveforms < 1 || nsamples < 2 || fit_order < 0){
+    std::cout << "BenchmarkPolyBaseline ERROR: Waveforms must be positive, Samples at least 2 and BaselineFitOrder not negative" << std::endl;
+    return 1;
+  }
+
+  DataModel rootfit_data, polyfit_data;
+  CalibratorUnderTest rootfit("rootfit",config), polyfit("polyfit",config);
+  if (!rootfit.Initialise("",rootfit_data) || !polyfit.Initialise("",polyfit_data)){
+    std::cout << "BenchmarkPolyBaseline ERROR: the calibrators could not be initialised" << std::endl;
+    return 1;
+  }
+
+  std::mt19937 rng(seed);
+  double rootfit_seconds = 0., polyfit_seconds = 0.;
+  double max_baseline_diff = 0., max_sample_diff = 0.;
+  long failed = 0;
+  for (int iwaveform = 0; iwaveform < nwaveforms; iwaveform++){
+    std::vector< Waveform<unsigned short> > raw_waveforms{MakeWaveform(nsamples, pulse_fraction, rng)};
+
+    double start = WallSeconds();
+    std::vector< CalibratedADCWaveform<double> > rootfit_waveforms = rootfit.Calibrate(raw_waveforms);
+    rootfit_seconds += WallSeconds()-start;
+    start = WallSeconds();
+    std::vector< CalibratedADCWaveform<double> > polyfit_waveforms = polyfit.Calibrate(raw_waveforms);
+    polyfit_seconds += WallSeconds()-start;
+
+    if (rootfit_waveforms.size() != 1 || polyfit_waveforms.size() != 1){
+      failed++;
+      continue;
+    }
+    const std::vector<double> &a = rootfit_waveforms.front().Samples();
+    const std::vector<double> &b = polyfit_waveforms.front().Samples();
+    max_baseline_diff = std::max(max_baseline_diff,
+      std::fabs(rootfit_waveforms.front().GetBaseline() - polyfit_waveforms.front().GetBaseline()));
+    for (size_t i = 0; i < a.size() && i < b.size(); i++){
+      max_sample_diff = std::max(max_sample_diff, std::fabs(a[i]-b[i])/ADC_TO_VOLT);
+    }
+  }
+  rootfit.Finalise();
+  polyfit.Finalise();
+
+  std::cout << "BenchmarkPolyBaseline: " << nwaveforms << " waveforms of " << nsamples << " samples, pol"
+            << fit_order << " baseline" << std::endl;
+  const char *names[2] = {"rootfit (TGraph + TF1)","polyfit (PolyBaseline)"};
+  const double seconds[2] = {rootfit_seconds,polyfit_seconds};
+  for (int i = 0; i < 2; i++){
+    std::cout << "  " << std::left << std::setw(24) << names[i] << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << 1e6*seconds[i]/nwaveforms << " us/waveform" << std::endl;
+  }
+  std::cout << "  speedup " << std::setprecision(1) << rootfit_seconds/polyfit_seconds << std::endl;
+  std::cout << "  largest difference: baseline " << std::scientific << std::setprecision(2) << max_baseline_diff
+            << " ADC counts, subtracted baseline at any sample " << max_sample_diff << " ADC counts" << std::endl;
+  if (failed) std::cout << "  " << failed << " waveforms were not calibrated by both" << std::endl;
+
+  return (failed == 0 && max_baseline_diff <= tolerance && max_sample_diff <= tolerance) ? 0 : 1;
+}
@@ -0,0 +1,588 @@
+//Throughput benchmark of the tank PMT chain
+//(LoadRawData -> PMTDataDecoder -> ANNIEEventBuilder -> PhaseIIADCCalibrator -> PhaseIIADCHitFinder).
+//
+//Usage: ./BenchmarkTankChain [configfile] [Key=Value ...]
+//
+//The tools listed in the benchmark's Tools_File are run in order, as the ToolChain would run
+//them, each wrapped in a BenchmarkStage that times its Execute() calls and records the peak
+//resident memory seen during them.  The raw data either come from a recorded raw part file
+//(InputSource File, read by LoadRawData) or are synthesised in memory (InputSource Synthetic,
+//the LoadRawData stage is replaced by the SyntheticRawData source below).  Stages can be
+//switched on or off (Stages / SkipStages) to bisect a regression to one tool.  Key=Value
+//arguments override entries of the config file.  See configfiles/BenchmarkTankChain/README.md.
+
+#include <stdint.h>
+#include <endian.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ToolChain.h"
+#include "Factory.h"
+#include "CardData.h"
+#include "CardChannelKey.h"
+
+static double WallSeconds(){
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double CPUSeconds(){
+  timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID,&ts);
+  return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+//Value in kB of a field ("VmHWM", "VmRSS") of /proc/self/status, or -1
+static long ReadProcStatusKB(const std::string &field){
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status,line)){
+    if (line.compare(0,field.size()+1,field+":") != 0) continue;
+    std::stringstream linestream(line.substr(field.size()+1));
+    long value = -1;
+    linestream >> value;
+    return value;
+  }
+  return -1;
+}
+
+//Reset the kernel's peak RSS (VmHWM) of the process to its current RSS, so the peak read
+//after a stage belongs to that stage.  Returns false where /proc/self/clear_refs can't be written.
+static bool ResetPeakRSS(){
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  if (!clear_refs.is_open()) return false;
+  clear_refs << "5";
+  clear_refs.close();
+  return !clear_refs.fail();
+}
+
+static std::vector<std::string> SplitList(const std::string &list){
+  std::vector<std::string> items;
+  std::string item;
+  std::stringstream liststream(list);
+  while (std::getline(liststream,item,',')){
+    std::stringstream itemstream(item);
+    std::string word;
+    while (itemstream >> word) items.push_back(word);
+  }
+  return items;
+}
+
+//Waveforms waiting in the InProgressTankEvents map of the CStore (0 if there is none)
+static size_t InProgressWaveforms(DataModel &data){
+  std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t>>> *InProgressTankEvents = nullptr;
+  if (!data.CStore.Get("InProgressTankEvents",InProgressTankEvents) || InProgressTankEvents == nullptr) return 0;
+  size_t count = 0;
+  for (const auto &apair : *InProgressTankEvents) count += apair.second.size();
+  return count;
+}
+
+struct StageStats {
+  std::string Name;
+  std::string ToolClass;
+  long Executes = 0;
+  long FailedExecutes = 0;
+  double InitialiseWall = 0.;
+  double Wall = 0.;
+  double CPU = 0.;
+  long PeakRSSKB = 0;
+};
+
+/**
+* \class BenchmarkStage
+*
+* Wraps a Tool of the benchmarked chain: forwards Initialise/Execute/Finalise to it and adds
+* the wall time, the process CPU time (all threads, so worker pools count) and the peak RSS of
+* every Execute() to the stage's StageStats.  Optional hooks run after each Execute() to update
+* the chain-wide counters from the CStore.
+*/
+
+class BenchmarkStage: public Tool {
+
+ public:
+
+  BenchmarkStage(Tool *tool, StageStats *stats, bool reset_peak_rss, std::function<void(DataModel&)> after_execute=nullptr) :
+    Tool(), Wrapped(tool), Stats(stats), ResetPeak(reset_peak_rss), AfterExecute(after_execute) {}
+  ~BenchmarkStage(){ delete Wrapped; }
+
+  bool Initialise(std::string configfile, DataModel &data){
+    m_data = &data;
+    double start = WallSeconds();
+    bool ok = Wrapped->Initialise(configfile,data);
+    Stats->InitialiseWall = WallSeconds()-start;
+    return ok;
+  }
+
+  bool Execute(){
+    if (ResetPeak) ResetPeakRSS();
+    double cpu_start = CPUSeconds();
+    double start = WallSeconds();
+    bool ok = Wrapped->Execute();
+    Stats->Wall += WallSeconds()-start;
+    Stats->CPU += CPUSeconds()-cpu_start;
+    long rss = ReadProcStatusKB(ResetPeak ? "VmHWM" : "VmRSS");
+    if (rss > Stats->PeakRSSKB) Stats->PeakRSSKB = rss;
+    Stats->Executes++;
+    if (!ok) Stats->FailedExecutes++;
+    if (AfterExecute) AfterExecute(*m_data);
+    return ok;
+  }
+
+  bool Finalise(){ return Wrapped->Finalise(); }
+
+ private:
+
+  Tool *Wrapped;
+  StageStats *Stats;
+  bool ResetPeak;
+  std::function<void(DataModel&)> AfterExecute;
+
+};
+
+/**
+* \class SyntheticRawData
+*
+* Stand-in for LoadRawData (BuildType Tank, EntriesPerExecute 1) that makes Phase II PMT raw
+* data in memory.  Each entry holds one CardData per ADC card of the tank and auxiliary
+* channels published by LoadGeometry, with TriggersPerEntry record-header + waveform records
+* per channel packed into 16-word frames as the cards write them.  Waveforms are a flat
+* baseline drawn per waveform from [BaselineMin,BaselineMax] with Gaussian noise, plus a
+* Poisson number of Landau-shaped pulses (Moyal approximation), like the PulseSimulation tool's.
+* The CStore entries LoadRawData sets for the decoders and the event builder are set the
+* same way, and the loop is stopped after the last entry.
+*/
+
+class SyntheticRawData: public Tool {
+
+ public:
+
+  SyntheticRawData() : Tool() {}
+
+  bool Initialise(std::string configfile, DataModel &data){
+    if (configfile!="") m_variables.Initialise(configfile);
+    m_data = &data;
+
+    verbosity = 0;
+    NumEntries = 100;
+    TriggersPerEntry = 10;
+    WaveformSamples = 2000;
+    PulsesPerWaveform = 1.;
+    PulseAmplitude = 60.;
+    PulseWidth = 2.;
+    BaselineMin = 310.;
+    BaselineMax = 350.;
+    NoiseSigma = 2.;
+    TriggerSpacingNs = 1000000;
+    StartTimeNs = 1600000000000000000;
+    RunNumber = 0;
+    SubRunNumber = 0;
+    int seed = 4357;
+    m_variables.Get("verbosity",verbosity);
+    m_variables.Get("Entries",NumEntries);
+    m_variables.Get("TriggersPerEntry",TriggersPerEntry);
+    m_variables.Get("WaveformSamples",WaveformSamples);
+    m_variables.Get("PulsesPerWaveform",PulsesPerWaveform);
+    m_variables.Get("PulseAmplitude",PulseAmplitude);
+    m_variables.Get("PulseWidth",PulseWidth);
+    m_variables.Get("BaselineMin",BaselineMin);
+    m_variables.Get("BaselineMax",BaselineMax);
+    m_variables.Get("NoiseSigma",NoiseSigma);
+    m_variables.Get("TriggerSpacingNs",TriggerSpacingNs);
+    m_variables.Get("StartTimeNs",StartTimeNs);
+    m_variables.Get("RunNumber",RunNumber);
+    m_variables.Get("SubRunNumber",SubRunNumber);
+    m_variables.Get("Seed",seed);
+    Generator.seed(seed);
+
+    //Record header and waveform fill whole frames, so no record header is split between two
+    //frames (the decoder drops those)
+    if (WaveformSamples < 1) WaveformSamples = 1;
+    int record_samples = RECORD_HEADER_SAMPLES + WaveformSamples;
+    record_samples = ((record_samples+FRAME_SAMPLES-1)/FRAME_SAMPLES)*FRAME_SAMPLES;
+    WaveformSamples = record_samples - RECORD_HEADER_SAMPLES;
+
+    //One card per crate and slot of the tank PMT and auxiliary channels
+    std::map<std::vector<int>,int> CrateSpaceMap;
+    for (const char *mapname : {"TankPMTCrateSpaceToChannelNumMap","AuxCrateSpaceToChannelNumMap"}){
+      CrateSpaceMap.clear();
+      m_data->CStore.Get(mapname,CrateSpaceMap);
+      for (const std::pair<const std::vector<int>,int> &apair : CrateSpaceMap){
+        int CardID = apair.first.at(0)*1000 + apair.first.at(1);
+        std::vector<int> &channels = CardChannels[CardID];
+        if (std::find(channels.begin(),channels.end(),apair.first.at(2)) == channels.end()) channels.push_back(apair.first.at(2));
+      }
+    }
+    if (CardChannels.empty()){
+      std::cout << "SyntheticRawData ERROR: no tank PMT or auxiliary channels in the CStore; run LoadGeometry first" << std::endl;
+      return false;
+    }
+    size_t num_channels = 0;
+    for (const std::pair<const int,std::vector<int>> &apair : CardChannels) num_channels += apair.second.size();
+    if (verbosity > 0) std::cout << "SyntheticRawData: " << CardChannels.size() << " cards, " << num_channels << " channels, "
+        << NumEntries << " entries of " << TriggersPerEntry << " triggers, " << WaveformSamples << " samples per waveform" << std::endl;
+
+    EntryNum = 0;
+    TriggerNum = 0;
+    Cdata = new std::vector<CardData>;
+    m_data->CStore.Set("RawDataEntriesPerExecute",1);
+    m_data->CStore.Set("FileProcessingComplete",false);
+    return true;
+  }
+
+  bool Execute(){
+    m_data->CStore.Set("NewRawDataEntryAccessed",false);
+    m_data->CStore.Set("NewRawDataFileAccessed",EntryNum==0);
+    if (EntryNum >= NumEntries){
+      m_data->CStore.Set("FileProcessingComplete",true);
+      m_data->vars.Set("StopLoop",1);
+      return true;
+    }
+    m_data->CStore.Set("PauseTankDecoding",false);
+    m_data->CStore.Set("PauseMRDDecoding",true);
+    m_data->CStore.Set("PauseCTCDecoding",true);
+    m_data->CStore.Set("PauseLAPPDDecoding",true);
+
+    Store RunInfoPostgress;
+    RunInfoPostgress.Set("RunNumber",RunNumber);
+    RunInfoPostgress.Set("SubRunNumber",SubRunNumber);
+    RunInfoPostgress.Set("PartNumber",0);
+    RunInfoPostgress.Set("RunType",-1);
+    RunInfoPostgress.Set("StarTime",StartTimeNs);
+    m_data->CStore.Set("RunInfoPostgress",RunInfoPostgress);
+
+    this->MakeEntry();
+    m_data->CStore.Set("CardData",Cdata);
+    m_data->CStore.Set("TankEntryNum",EntryNum);
+    EntryNum++;
+    bool last_entry = (EntryNum == NumEntries);
+    m_data->CStore.Set("LastEntry",last_entry);
+    m_data->CStore.Set("FileCompleted",last_entry);
+    m_data->CStore.Set("TrigEntriesCompleted",true);
+    m_data->CStore.Set("LAPPDEntriesCompleted",true);
+    m_data->CStore.Set("NewRawDataEntryAccessed",true);
+    if (last_entry) m_data->vars.Set("StopLoop",1);
+    return true;
+  }
+
+  bool Finalise(){
+    //Cdata went to the CStore, which keeps pointing at it (as with LoadRawData's CardData)
+    Cdata = nullptr;
+    return true;
+  }
+
+ private:
+
+  static const int FRAME_WORDS = 16;
+  static const int FRAME_SAMPLES = 40;
+  static const int RECORD_HEADER_SAMPLES = 8;
+
+  void MakeEntry(){
+    Cdata->resize(CardChannels.size());
+    std::vector<uint16_t> stream;
+    std::vector<uint16_t> header(RECORD_HEADER_SAMPLES);
+    size_t icard = 0;
+    for (const std::pair<const int,std::vector<int>> &apair : CardChannels){
+      CardData &aCardData = Cdata->at(icard++);
+      aCardData.CardID = apair.first;
+      aCardData.SequenceID = EntryNum;
+      aCardData.FirmwareVersion = 0;
+      aCardData.FIFOstate = 0;
+      aCardData.Data.clear();
+      for (int ChannelID : apair.second){
+        stream.clear();
+        for (int trigger = 0; trigger < TriggersPerEntry; trigger++){
+          this->MakeRecordHeader(TriggerNum+trigger,header);
+          stream.insert(stream.end(),header.begin(),header.end());
+          this->AddWaveform(stream);
+        }
+        this->PackFrames(stream,ChannelID,aCardData.Data);
+      }
+    }
+    TriggerNum += TriggersPerEntry;
+  }
+
+  //0x000, 0xFFF, counter bits 48-71, counter bits 0-47, in 12-bit samples
+  void MakeRecordHeader(long trigger, std::vector<uint16_t> &header){
+    uint64_t ClockCount = (StartTimeNs + trigger*TriggerSpacingNs)/8;
+    while (true){
+      header[0] = 0x000;
+      header[1] = 0xFFF;
+      for (int j = 0; j < 2; j++) header[2+j] = (ClockCount >> ((4+j)*12)) & 0xfff;
+      for (int j = 0; j < 4; j++) header[4+j] = (ClockCount >> (j*12)) & 0xfff;
+      //A 0x000,0xFFF pair inside the counter would read as a second record header
+      bool fake_label = false;
+      for (int j = 1; j < RECORD_HEADER_SAMPLES-1; j++) fake_label |= (header[j]==0x000 && header[j+1]==0xFFF);
+      if (!fake_label) break;
+      ClockCount++;
+    }
+  }
+
+  void AddWaveform(std::vector<uint16_t> &stream){
+    std::uniform_real_distribution<double> baseline(BaselineMin,BaselineMax);
+    std::normal_distribution<double> noise(0.,NoiseSigma);
+    std::poisson_distribution<int> npulses(PulsesPerWaveform);
+    std::exponential_distribution<double> amplitude(1./PulseAmplitude);
+    std::uniform_real_distribution<double> peaktime(0.,WaveformSamples);
+
+    Pulses.clear();
+    int n = PulsesPerWaveform > 0. ? npulses(Generator) : 0;
+    for (int i = 0; i < n; i++) Pulses.emplace_back(peaktime(Generator),amplitude(Generator));
+    double level = baseline(Generator);
+    for (int sample = 0; sample < WaveformSamples; sample++){
+      double value = level + noise(Generator);
+      for (const std::pair<double,double> &pulse : Pulses){
+        double lambda = (sample-pulse.first)/PulseWidth;
+        if (lambda < -5. || lambda > 30.) continue;
+        value += pulse.second*exp(-0.5*(lambda+exp(-lambda))+0.5);
+      }
+      stream.push_back(static_cast<uint16_t>(std::min(4095.,std::max(1.,std::round(value)))));
+    }
+  }
+
+  //Inverse of PMTDataDecoder::UnpackFrameSamples: 40 12-bit samples in 15 big endian words,
+  //then the channel in the top byte of the last word
+  void PackFrames(const std::vector<uint16_t> &stream, int ChannelID, std::vector<uint32_t> &data){
+    size_t nframes = (stream.size()+FRAME_SAMPLES-1)/FRAME_SAMPLES;
+    uint16_t s[FRAME_SAMPLES];
+    for (size_t frame = 0; frame < nframes; frame++){
+      for (int i = 0; i < FRAME_SAMPLES; i++){
+        size_t index = frame*FRAME_SAMPLES + i;
+        s[i] = index < stream.size() ? stream[index] : stream.back();
+      }
+      for (int group = 0; group < 5; group++){
+        const uint16_t *g = s + 8*group;
+        uint32_t w0 = g[0] | (uint32_t(g[1])<<12) | (uint32_t(g[2]&0xff)<<24);
+        uint32_t w1 = (g[2]>>8) | (uint32_t(g[3])<<4) | (uint32_t(g[4])<<16) | (uint32_t(g[5]&0xf)<<28);
+        uint32_t w2 = (g[5]>>4) | (uint32_t(g[6])<<8) | (uint32_t(g[7])<<20);
+        data.push_back(htobe32(w0));
+        data.push_back(htobe32(w1));
+        data.push_back(htobe32(w2));
+      }
+      data.push_back(htobe32(uint32_t(ChannelID)<<24));
+    }
+  }
+
+  int verbosity;
+  int NumEntries;
+  int TriggersPerEntry;
+  int WaveformSamples;
+  double PulsesPerWaveform;
+  double PulseAmplitude;
+  double PulseWidth;
+  double BaselineMin;
+  double BaselineMax;
+  double NoiseSigma;
+  long TriggerSpacingNs;
+  uint64_t StartTimeNs;
+  int RunNumber;
+  int SubRunNumber;
+
+  std::map<int,std::vector<int>> CardChannels;  //Key: CardID, value: channels with a PMT or aux signal
+  int EntryNum;
+  long TriggerNum;
+  std::vector<CardData> *Cdata = nullptr;
+  std::vector<std::pair<double,double>> Pulses;  //peak sample, amplitude
+  std::mt19937 Generator;
+
+};
+
+int main(int argc, char* argv[]){
+
+  std::string conffile = "configfiles/BenchmarkTankChain/BenchmarkConfig";
+  int firstoverride = 1;
+  if (argc > 1 && std::string(argv[1]).find('=') == std::string::npos){
+    conffile = argv[1];
+    firstoverride = 2;
+  }
+
+  Store config;
+  config.Initialise(conffile);
+  for (int i = firstoverride; i < argc; i++){
+    std::string arg = argv[i];
+    size_t pos = arg.find('=');
+    if (pos == std::string::npos){
+      std::cout << "BenchmarkTankChain ERROR: argument " << arg << " is not of the form Key=Value" << std::endl;
+      return 1;
+    }
+    config.Set(arg.substr(0,pos),arg.substr(pos+1));
+  }
+
+  int verbose = 0;
+  std::string tools_file = "configfiles/BenchmarkTankChain/ToolsConfig";
+  std::string input_source = "File";
+  std::string synthetic_config = "configfiles/BenchmarkTankChain/SyntheticRawDataConfig";
+  std::string stages_list = "";
+  std::string skip_list = "";
+  long max_loops = -1;
+  std::string report_file = "";
+  config.Get("verbose",verbose);
+  config.Get("Tools_File",tools_file);
+  config.Get("InputSource",input_source);
+  config.Get("SyntheticRawDataConfig",synthetic_config);
+  config.Get("Stages",stages_list);
+  config.Get("SkipStages",skip_list);
+  config.Get("MaxLoops",max_loops);
+  config.Get("ReportFile",report_file);
+  if (input_source != "File" && input_source != "Synthetic"){
+    std::cout << "BenchmarkTankChain ERROR: InputSource must be File or Synthetic, not " << input_source << std::endl;
+    return 1;
+  }
+  std::vector<std::string> stages = SplitList(stages_list);
+  std::vector<std::string> skipped = SplitList(skip_list);
+  std::set<std::string> enabled_stages(stages.begin(),stages.end());
+  std::set<std::string> disabled_stages(skipped.begin(),skipped.end());
+
+  //Tools file lines: instance name, tool class, config file
+  struct StageSpec { std::string Name, ToolClass, Config; };
+  std::vector<StageSpec> specs;
+  std::ifstream toolsfile(tools_file.c_str());
+  if (!toolsfile.is_open()){
+    std::cout << "BenchmarkTankChain ERROR: could not open Tools_File " << tools_file << std::endl;
+    return 1;
+  }
+  std::string line;
+  while (std::getline(toolsfile,line)){
+    if (line.find('#') != std::string::npos) line = line.substr(0,line.find('#'));
+    std::stringstream linestream(line);
+    StageSpec spec;
+    if (!(linestream >> spec.Name >> spec.ToolClass)) continue;
+    linestream >> spec.Config;
+    bool is_source = (spec.ToolClass == "LoadRawData");
+    bool on = enabled_stages.empty() || enabled_stages.count(spec.Name) || enabled_stages.count(spec.ToolClass);
+    if (disabled_stages.count(spec.Name) || disabled_stages.count(spec.ToolClass)) on = false;
+    if (!on){
+      std::cout << "BenchmarkTankChain: stage " << spec.Name << " (" << spec.ToolClass << ") switched off" << std::endl;
+      continue;
+    }
+    if (is_source && input_source == "Synthetic"){
+      spec.ToolClass = "SyntheticRawData";
+      spec.Config = synthetic_config;
+    }
+    specs.push_back(spec);
+  }
+
+  //Chain-wide counters, filled by the stage hooks from the CStore
+  double total_bytes = 0.;
+  double total_waveforms = 0.;
+  int total_events = 0;
+  int last_entry_num = -1;
+  size_t last_waveform_count = 0;
+
+  ToolChain tools(verbose, 0, "BenchmarkTankChain", "Interactive", "./log", "LogStore", 0, -1, -1);
+  bool reset_peak_rss = ResetPeakRSS();
+  if (!reset_peak_rss) std::cout << "BenchmarkTankChain: can't reset the peak RSS, reporting the RSS after each Execute instead" << std::endl;
+
+  std::vector<StageStats> stats(specs.size());
+  for (size_t i = 0; i < specs.size(); i++){
+    stats[i].Name = specs[i].Name;
+    stats[i].ToolClass = specs[i].ToolClass;
+    Tool *tool = (specs[i].ToolClass == "SyntheticRawData") ? new SyntheticRawData : Factory(specs[i].ToolClass);
+    if (tool == 0){
+      std::cout << "BenchmarkTankChain ERROR: unknown tool class " << specs[i].ToolClass << std::endl;
+      return 1;
+    }
+    std::function<void(DataModel&)> hook = nullptr;
+    if (specs[i].ToolClass == "LoadRawData" || specs[i].ToolClass == "SyntheticRawData"){
+      //Bytes of PMT raw data handed to the decoder: count each PMTData entry once
+      hook = [&](DataModel &data){
+        bool new_entry = false;
+        int entry_num = -1;
+        std::vector<CardData> *Cdata = nullptr;
+        data.CStore.Get("NewRawDataEntryAccessed",new_entry);
+        data.CStore.Get("TankEntryNum",entry_num);
+        if (!new_entry || entry_num == last_entry_num || !data.CStore.Get("CardData",Cdata) || Cdata == nullptr) return;
+        last_entry_num = entry_num;
+        for (const CardData &aCardData : *Cdata) total_bytes += 4.*aCardData.Data.size();
+      };
+    }
+    else if (specs[i].ToolClass == "PMTDataDecoder"){
+      //Waveforms finished by the decoder: growth of the InProgressTankEvents map since the
+      //end of the stage that ran last (the hooks of all other stages re-baseline the count)
+      hook = [&](DataModel &data){
+        size_t count = InProgressWaveforms(data);
+        if (count > last_waveform_count) total_waveforms += count-last_waveform_count;
+        last_waveform_count = count;
+      };
+    }
+    else if (specs[i].ToolClass == "ANNIEEventBuilder"){
+      hook = [&](DataModel &data){ data.CStore.Get("NumANNIEEventsBuilt",total_events); };
+    }
+    //Any stage but the decoder may take waveforms out of InProgressTankEvents (the
+    //calibrator, or the ANNIEEventBuilder when the chain has no calibrator), so the
+    //count is re-baselined after each of them
+    if (specs[i].ToolClass != "PMTDataDecoder"){
+      std::function<void(DataModel&)> stage_hook = hook;
+      hook = [&,stage_hook](DataModel &data){
+        if (stage_hook) stage_hook(data);
+        last_waveform_count = InProgressWaveforms(data);
+      };
+    }
+    tools.Add(specs[i].Name, new BenchmarkStage(tool,&stats[i],reset_peak_rss,hook), specs[i].Config);
+  }
+
+  double start = WallSeconds();
+  tools.Initialise();
+  double init_wall = WallSeconds()-start;
+  tools.m_data.vars.Set("StopLoop",0);
+  long loops = 0;
+  start = WallSeconds();
+  while (max_loops < 0 || loops < max_loops){
+    tools.Execute();
+    loops++;
+    int stop = 0;
+    tools.m_data.vars.Get("StopLoop",stop);
+    if (stop) break;
+  }
+  double loop_wall = WallSeconds()-start;
+  start = WallSeconds();
+  tools.Finalise();
+  double final_wall = WallSeconds()-start;
+  //Events still written out by Finalise
+  tools.m_data.CStore.Get("NumANNIEEventsBuilt",total_events);
+
+  //Each stage's rates are the chain totals over that stage's own Execute time
+  std::stringstream report;
+  report << std::fixed;
+  report << "BenchmarkTankChain: " << loops << " loops in " << std::setprecision(3) << loop_wall << " s (Initialise "
+         << init_wall << " s, Finalise " << final_wall << " s), input " << input_source << std::endl;
+  report << "Totals: " << total_events << " events, " << std::setprecision(0) << total_waveforms << " waveforms, "
+         << std::setprecision(3) << total_bytes/1.e6 << " MB of PMT raw data" << std::endl;
+  report << std::left << std::setw(24) << "Stage" << std::right << std::setw(10) << "Executes" << std::setw(11) << "Wall[s]"
+         << std::setw(11) << "CPU[s]" << std::setw(12) << "events/s" << std::setw(14) << "waveforms/s"
+         << std::setw(11) << "MB/s" << std::setw(13) << "PeakRSS[MB]" << std::endl;
+  std::ofstream csv;
+  if (report_file != ""){
+    csv.open(report_file.c_str());
+    csv << "stage,tool,executes,failed_executes,initialise_s,wall_s,cpu_s,events_per_s,waveforms_per_s,bytes_per_s,peak_rss_kb" << std::endl;
+  }
+  for (const StageStats &stage : stats){
+    double events_rate = stage.Wall > 0. ? total_events/stage.Wall : 0.;
+    double waveforms_rate = stage.Wall > 0. ? total_waveforms/stage.Wall : 0.;
+    double bytes_rate = stage.Wall > 0. ? total_bytes/stage.Wall : 0.;
+    report << std::left << std::setw(24) << stage.Name << std::right << std::setw(10) << stage.Executes
+           << std::setprecision(3) << std::setw(11) << stage.Wall << std::setw(11) << stage.CPU
+           << std::setprecision(1) << std::setw(12) << events_rate << std::setw(14) << waveforms_rate
+           << std::setprecision(2) << std::setw(11) << bytes_rate/1.e6 << std::setw(13) << stage.PeakRSSKB/1024. << std::endl;
+    if (stage.FailedExecutes > 0) report << "  (" << stage.FailedExecutes << " Execute calls of " << stage.Name << " returned false)" << std::endl;
+    if (csv.is_open()){
+      csv << stage.Name << "," << stage.ToolClass << "," << stage.Executes << "," << stage.FailedExecutes << ","
+          << stage.InitialiseWall << "," << stage.Wall << "," << stage.CPU << "," << events_rate << ","
+          << waveforms_rate << "," << bytes_rate << "," << stage.PeakRSSKB << std::endl;
+    }
+  }
+  std::cout << report.str();
+
+  return 0;
+
+}
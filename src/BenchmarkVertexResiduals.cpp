@@ -0,0 +1,217 @@
+//Microbenchmark of the residual kernels of VertexGeometry and the figures of merit built on them,
+//for a generated event of a typical size (150 PMT digits by default).
+//
+//Usage: ./BenchmarkVertexResiduals [Key=Value ...]
+//
+//  Digits       number of digits of the event (default 150)
+//  Vertices     number of trial vertices around the true one (default 64)
+//  Iterations   passes over the trial vertices per kernel (default 2000)
+//  Seed         random seed of the event and the trial vertices (default 4357)
+//
+//Each kernel is called Iterations*Vertices times; the time per call and per digit is printed.
+//Before timing, the fit kernels (CalcPointResiduals, CalcExtendedResiduals) and the fused
+//FoMCalculator::ExtendedVertexChi2 are checked against CalcResiduals followed by separate
+//TimePropertiesLnL and ConePropertiesFoM passes: the largest differences of the residuals,
+//zenith angles and extended vertex figures of merit over the trial vertices are printed, and the
+//benchmark fails if a figure of merit differs by more than 1e-9.  The analytic gradient of
+//ExtendedVertexChi2 is compared with central differences.
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Store.h"
+#include "Parameters.h"
+#include "RecoDigit.h"
+#include "VertexGeometry.h"
+#include "FoMCalculator.h"
+
+static double WallSeconds(){
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct TrialVertex { double X, Y, Z, DirX, DirY, DirZ; };
+
+//Digits on the wall of a cylinder around a muon-like track; the hit times are the extended
+//(track then Cherenkov photon) times from the vertex, smeared by the time resolution
+static std::vector<RecoDigit> MakeEvent(int ndigits, std::mt19937 &rng){
+  const double radius = 152.4;       // cm
+  const double halfheight = 198.;    // cm
+  const double vtxX = 20., vtxY = -10., vtxZ = -80.;
+  const double norm = sqrt(0.1*0.1+0.05*0.05+1.);
+  const double dirX = 0.1/norm, dirY = -0.05/norm, dirZ = 1./norm;
+  const double c = Parameters::SpeedOfLight();
+  const double n = Parameters::Index0();
+  const double theta = Parameters::CherenkovAngle()*M_PI/180.;
+
+  std::uniform_real_distribution<double> uniform(0.,1.);
+  std::normal_distribution<double> smear(0.,1.);
+  std::vector<RecoDigit> digits;
+  for (int idigit=0; idigit<ndigits; idigit++){
+    double phi = 2.*M_PI*uniform(rng);
+    double x = radius*cos(phi);
+    double y = radius*sin(phi);
+    double z = -halfheight + 2.*halfheight*uniform(rng);
+    double dx = x-vtxX, dy = y-vtxY, dz = z-vtxZ;
+    double ds = sqrt(dx*dx+dy*dy+dz*dz);
+    double angle = acos((dx*dirX+dy*dirY+dz*dirZ)/ds);
+    double ltrack = (angle<theta) ? ds*sin(theta-angle)/sin(theta) : 0.;
+    double lphoton = (angle<theta) ? ds*sin(angle)/sin(theta) : ds;
+    double t = ltrack/c + lphoton*n/c + Parameters::TimeResolution(RecoDigit::PMT8inch)*smear(rng);
+    double q = 1. + 9.*uniform(rng);
+    digits.emplace_back(0, Position(x,y,z), t, q, RecoDigit::PMT8inch, idigit);
+  }
+  return digits;
+}
+
+int main(int argc, char* argv[]){
+
+  Store config;
+  for (int i = 1; i < argc; i++){
+    std::string arg = argv[i];
+    size_t pos = arg.find('=');
+    if (pos == std::string::npos){
+      std::cout << "BenchmarkVertexResiduals ERROR: argument " << arg << " is not of the form Key=Value" << std::endl;
+      return 1;
+    }
+    config.Set(arg.substr(0,pos),arg.substr(pos+1));
+  }
+  int ndigits = 150;
+  int nvertices = 64;
+  long iterations = 2000;
+  int seed = 4357;
+  config.Get("Digits",ndigits);
+  config.Get("Vertices",nvertices);
+  config.Get("Iterations",iterations);
+  config.Get("Seed",seed);
+  if (ndigits < 1 || nvertices < 1 || iterations < 1){
+    std::cout << "BenchmarkVertexResiduals ERROR: Digits, Vertices and Iterations must be positive" << std::endl;
+    return 1;
+  }
+
+  std::mt19937 rng(seed);
+  std::vector<RecoDigit> digits = MakeEvent(ndigits,rng);
+
+  //trial vertices: smeared positions and directions, as the seeds and Minuit steps of a fit
+  std::vector<TrialVertex> vertices;
+  std::normal_distribution<double> smear(0.,1.);
+  for (int ivtx=0; ivtx<nvertices; ivtx++){
+    TrialVertex vtx;
+    vtx.X = 20. + 30.*smear(rng);
+    vtx.Y = -10. + 30.*smear(rng);
+    vtx.Z = -80. + 30.*smear(rng);
+    vtx.DirX = 0.1 + 0.3*smear(rng);
+    vtx.DirY = -0.05 + 0.3*smear(rng);
+    vtx.DirZ = 1. + 0.3*smear(rng);
+    double norm = sqrt(vtx.DirX*vtx.DirX+vtx.DirY*vtx.DirY+vtx.DirZ*vtx.DirZ);
+    vtx.DirX /= norm; vtx.DirY /= norm; vtx.DirZ /= norm;
+    vertices.push_back(vtx);
+  }
+
+  VertexGeometry vtxgeo;
+  vtxgeo.LoadDigits(&digits);
+  FoMCalculator fom;
+  fom.LoadVertexGeometry(&vtxgeo);
+  const double coneangle = Parameters::CherenkovAngle();
+
+  //check the fit kernels against CalcResiduals
+  double maxpoint = 0., maxextended = 0., maxzenith = 0., maxfom = 0., maxfused = 0., maxgradient = 0.;
+  std::vector<double> pointres(ndigits), extendedres(ndigits), zenith(ndigits);
+  for (const TrialVertex &vtx : vertices){
+    vtxgeo.CalcResiduals(vtx.X,vtx.Y,vtx.Z,0.,vtx.DirX,vtx.DirY,vtx.DirZ);
+    for (int idigit=0; idigit<ndigits; idigit++){
+      pointres[idigit] = vtxgeo.GetPointResidual(idigit);
+      extendedres[idigit] = vtxgeo.GetExtendedResidual(idigit);
+      zenith[idigit] = vtxgeo.GetZenith(idigit);
+    }
+    double timefom = 0., conefom = 0.;
+    double meantime = fom.FindSimpleTimeProperties(coneangle);
+    fom.TimePropertiesLnL(meantime,timefom);
+    fom.ConePropertiesFoM(coneangle,conefom);
+    double reference = 0.5*timefom + 0.5*conefom;
+
+    vtxgeo.CalcPointResiduals(vtx.X,vtx.Y,vtx.Z,0.,vtx.DirX,vtx.DirY,vtx.DirZ);
+    for (int idigit=0; idigit<ndigits; idigit++){
+      maxpoint = std::max(maxpoint,fabs(vtxgeo.GetDelta(idigit)-pointres[idigit]));
+      maxzenith = std::max(maxzenith,fabs(vtxgeo.GetZenith(idigit)-zenith[idigit]));
+    }
+    vtxgeo.CalcExtendedResiduals(vtx.X,vtx.Y,vtx.Z,0.,vtx.DirX,vtx.DirY,vtx.DirZ);
+    for (int idigit=0; idigit<ndigits; idigit++){
+      maxextended = std::max(maxextended,fabs(vtxgeo.GetDelta(idigit)-extendedres[idigit]));
+      maxzenith = std::max(maxzenith,fabs(vtxgeo.GetZenith(idigit)-zenith[idigit]));
+    }
+    fom.TimePropertiesLnL(fom.FindSimpleTimeProperties(coneangle),timefom);
+    fom.ConePropertiesFoM(coneangle,conefom);
+    maxfom = std::max(maxfom,fabs(0.5*timefom + 0.5*conefom - reference));
+
+    double fused = 0.;
+    double gradient[7];
+    fom.ExtendedVertexChi2(vtx.X,vtx.Y,vtx.Z,vtx.DirX,vtx.DirY,vtx.DirZ,coneangle,meantime,fused,gradient);
+    maxfused = std::max(maxfused,fabs(fused - reference));
+    //relative to the scale of the derivative, or 1 where it is small
+    const double steps[7] = {1e-4,1e-4,1e-4,1e-6,1e-6,1e-6,1e-4};
+    for (int k=0; k<7; k++){
+      double parplus[7] = {vtx.X,vtx.Y,vtx.Z,vtx.DirX,vtx.DirY,vtx.DirZ,meantime};
+      double parminus[7] = {vtx.X,vtx.Y,vtx.Z,vtx.DirX,vtx.DirY,vtx.DirZ,meantime};
+      parplus[k] += steps[k];
+      parminus[k] -= steps[k];
+      double fomplus = 0., fomminus = 0.;
+      fom.ExtendedVertexChi2(parplus[0],parplus[1],parplus[2],parplus[3],parplus[4],parplus[5],coneangle,parplus[6],fomplus);
+      fom.ExtendedVertexChi2(parminus[0],parminus[1],parminus[2],parminus[3],parminus[4],parminus[5],coneangle,parminus[6],fomminus);
+      double numerical = (fomplus-fomminus)/(2.*steps[k]);
+      maxgradient = std::max(maxgradient,fabs(gradient[k]-numerical)/std::max(1.,fabs(numerical)));
+    }
+  }
+  std::cout << "BenchmarkVertexResiduals: " << ndigits << " digits, " << nvertices << " vertices, "
+            << iterations << " iterations" << std::endl;
+  std::cout << std::scientific << std::setprecision(2)
+            << "  max |difference| to CalcResiduals: point residual " << maxpoint << " ns, extended residual "
+            << maxextended << " ns, zenith " << maxzenith << " deg, extended FoM " << maxfom << std::endl;
+  std::cout << "  max |difference| of the fused ExtendedVertexChi2: FoM " << maxfused
+            << ", gradient to central differences (relative) " << maxgradient << std::endl;
+
+  //time the kernels; the checksum keeps the calls from being optimised away
+  struct Kernel { std::string Name; int Type; };
+  const Kernel kernels[] = { {"CalcResiduals",0}, {"CalcPointResiduals",1}, {"CalcExtendedResiduals",2},
+                             {"FoMCalculator::PointPositionChi2",3}, {"extended FoM in separate passes",5},
+                             {"FoMCalculator::ExtendedVertexChi2",4}, {"ExtendedVertexChi2 with gradient",6} };
+  double checksum = 0.;
+  std::cout << std::fixed;
+  for (const Kernel &kernel : kernels){
+    double start = WallSeconds();
+    for (long iter=0; iter<iterations; iter++){
+      for (const TrialVertex &vtx : vertices){
+        double value = 0.;
+        double gradient[7];
+        double timefom = 0., conefom = 0.;
+        switch (kernel.Type){
+        case 0: vtxgeo.CalcResiduals(vtx.X,vtx.Y,vtx.Z,0.,vtx.DirX,vtx.DirY,vtx.DirZ); value = vtxgeo.GetDelta(0); break;
+        case 1: vtxgeo.CalcPointResiduals(vtx.X,vtx.Y,vtx.Z,0.,0.,0.,0.); value = vtxgeo.GetDelta(0); break;
+        case 2: vtxgeo.CalcExtendedResiduals(vtx.X,vtx.Y,vtx.Z,0.,vtx.DirX,vtx.DirY,vtx.DirZ); value = vtxgeo.GetDelta(0); break;
+        case 3: fom.PointPositionChi2(vtx.X,vtx.Y,vtx.Z,0.,value); break;
+        case 4: fom.ExtendedVertexChi2(vtx.X,vtx.Y,vtx.Z,vtx.DirX,vtx.DirY,vtx.DirZ,coneangle,0.,value); break;
+        case 5:
+          vtxgeo.CalcExtendedResiduals(vtx.X,vtx.Y,vtx.Z,0.,vtx.DirX,vtx.DirY,vtx.DirZ);
+          fom.ConePropertiesFoM(coneangle,conefom);
+          fom.TimePropertiesLnL(0.,timefom);
+          value = 0.5*timefom + 0.5*conefom;
+          break;
+        case 6: fom.ExtendedVertexChi2(vtx.X,vtx.Y,vtx.Z,vtx.DirX,vtx.DirY,vtx.DirZ,coneangle,0.,value,gradient); break;
+        }
+        checksum += value;
+      }
+    }
+    double seconds = WallSeconds()-start;
+    double calls = double(iterations)*nvertices;
+    std::cout << "  " << std::left << std::setw(36) << kernel.Name << std::right << std::setprecision(1)
+              << std::setw(10) << 1e9*seconds/calls << " ns/call" << std::setprecision(2)
+              << std::setw(10) << 1e9*seconds/calls/ndigits << " ns/digit" << std::endl;
+  }
+  std::cout << std::scientific << std::setprecision(6) << "  checksum " << checksum << std::endl;
+
+  return (maxfom <= 1e-9 && maxfused <= 1e-9) ? 0 : 1;
+}
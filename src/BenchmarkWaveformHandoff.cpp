@@ -0,0 +1,343 @@
+//Benchmark of the waveform hand-off from the ANNIEEventBuilder through the PhaseIIADCCalibrator
+//to the PhaseIIADCHitFinder in event building mode: the samples moved along the chain, as the
+//tools do now, against the copies the tools made before (reproduced below).
+//
+//Usage: ./BenchmarkWaveformHandoff [Key=Value ...]
+//
+//  Events            events handed through the chain (default 2000)
+//  EventsPerExecute  timestamps waiting in InProgressTankEvents at each Execute (default 4)
+//  Channels          tank PMT channels per event (default 140)
+//  Samples           samples per waveform (default 2000)
+//  Seed              random seed of the waveforms (default 4357)
+//
+//Both hand-offs use the containers of the tools (InProgressTankEvents, the Finished raw and
+//calibrated waveform maps) and do the same per-waveform work: a baseline from the first samples,
+//the calibrated samples, and a threshold scan standing in for the pulse finding.  Each hand-off
+//runs in its own child process, so the peak resident memory (VmHWM) of one is not inherited by
+//the other.  The wall time per event and the peak RSS above the RSS before the first event are
+//printed for both; the benchmark fails if the two find different pulses.
+
+#include <stdint.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Store.h"
+#include "CardChannelKey.h"
+#include "Waveform.h"
+#include "CalibratedADCWaveform.h"
+
+static double WallSeconds(){
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//Value in kB of a field ("VmHWM", "VmRSS") of /proc/self/status, or -1
+static long ReadProcStatusKB(const std::string &field){
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status,line)){
+    if (line.compare(0,field.size()+1,field+":") != 0) continue;
+    std::stringstream linestream(line.substr(field.size()+1));
+    long value = -1;
+    linestream >> value;
+    return value;
+  }
+  return -1;
+}
+
+typedef std::map<uint64_t, std::map<CardChannelKey, std::vector<uint16_t>>> TankEventMap;
+typedef std::map<uint64_t, std::map<unsigned long, std::vector<Waveform<uint16_t>>>> RawWaveformMap;
+typedef std::map<uint64_t, std::map<unsigned long, std::vector<CalibratedADCWaveform<double>>>> CalibratedWaveformMap;
+
+static const double ADC_TO_VOLT = 2.415 / std::pow(2., 12);
+static const size_t NUM_BASELINE_SAMPLES = 15;
+static const double PULSE_THRESHOLD = 0.005;  // V
+
+struct HandoffResult {
+  double Seconds = 0.;
+  long StartRSSKB = 0;
+  long PeakRSSKB = 0;
+  long Pulses = 0;
+};
+
+//Per-waveform work of the calibrator and hit finder, the same for both hand-offs
+static double Baseline(const std::vector<uint16_t> &samples){
+  double sum = 0.;
+  for (size_t i = 0; i < NUM_BASELINE_SAMPLES && i < samples.size(); i++) sum += samples[i];
+  return sum/NUM_BASELINE_SAMPLES;
+}
+
+static std::vector<double> Calibrate(const std::vector<uint16_t> &samples, double baseline){
+  std::vector<double> cal_data;
+  cal_data.reserve(samples.size());
+  for (uint16_t sample : samples) cal_data.push_back((sample - baseline)*ADC_TO_VOLT);
+  return cal_data;
+}
+
+static long CountPulses(const std::vector<double> &cal_data){
+  long pulses = 0;
+  bool in_pulse = false;
+  for (double value : cal_data){
+    if (!in_pulse && value > PULSE_THRESHOLD) pulses++;
+    in_pulse = (value > PULSE_THRESHOLD);
+  }
+  return pulses;
+}
+
+//The Waveform and CalibratedADCWaveform constructors before the change: the samples argument was
+//taken by value and copied again into the member
+static Waveform<uint16_t> OldWaveform(double start_time, std::vector<uint16_t> samples){
+  std::vector<uint16_t> member(samples);
+  return Waveform<uint16_t>(start_time, std::move(member));
+}
+
+static CalibratedADCWaveform<double> OldCalibratedWaveform(double start_time, std::vector<double> samples,
+                                                           double baseline, double sigma_baseline){
+  std::vector<double> member(samples);
+  return CalibratedADCWaveform<double>(start_time, std::move(member), baseline, sigma_baseline);
+}
+
+//PhaseIIADCHitFinder::build_pulse_and_hit_map before the change took both vectors by value and
+//copied each raw waveform once more
+static long OldBuildPulses(std::vector<Waveform<uint16_t>> raw_waveforms,
+                           std::vector<CalibratedADCWaveform<double>> calibrated_waveforms){
+  long pulses = 0;
+  for (size_t mb = 0; mb < raw_waveforms.size(); mb++){
+    Waveform<uint16_t> buffer_wave = raw_waveforms.at(mb);
+    if (buffer_wave.GetSamples()->empty()) continue;
+    pulses += CountPulses(calibrated_waveforms.at(mb).Samples());
+  }
+  return pulses;
+}
+
+static long BuildPulses(const std::vector<Waveform<uint16_t>> &raw_waveforms,
+                        const std::vector<CalibratedADCWaveform<double>> &calibrated_waveforms){
+  long pulses = 0;
+  for (size_t mb = 0; mb < raw_waveforms.size(); mb++){
+    if (raw_waveforms.at(mb).Samples().empty()) continue;
+    pulses += CountPulses(calibrated_waveforms.at(mb).Samples());
+  }
+  return pulses;
+}
+
+//PhaseIIADCCalibrator::Execute before the change: copies of each timestamp's map, of each
+//waveform, and of the per-timestamp maps put into the Finished maps
+static void OldCalibrate(TankEventMap &InProgressTankEvents, RawWaveformMap &FinishedRawWaveforms,
+                         CalibratedWaveformMap &FinishedCalibratedWaveforms){
+  std::vector<uint64_t> RawTimestampsToDelete;
+  for (std::pair<uint64_t,std::map<CardChannelKey, std::vector<uint16_t>>> apair : InProgressTankEvents){
+    uint64_t PMTCounterTime = apair.first;
+    RawTimestampsToDelete.push_back(PMTCounterTime);
+    std::map<CardChannelKey, std::vector<uint16_t>> aWaveMap = apair.second;
+    std::map<unsigned long, std::vector<Waveform<uint16_t>>> RawADCData;
+    for (std::pair<CardChannelKey, std::vector<uint16_t>> wpair : aWaveMap){
+      std::vector<uint16_t> TheWaveform = wpair.second;
+      Waveform<uint16_t> TheWave = OldWaveform(PMTCounterTime, TheWaveform);
+      std::vector<Waveform<uint16_t>> WaveVec{TheWave};
+      RawADCData.emplace(wpair.first, WaveVec);
+    }
+    std::map<unsigned long, std::vector<CalibratedADCWaveform<double>>> calibrated_waveform_map;
+    for (const auto &temp_pair : RawADCData){
+      std::vector<CalibratedADCWaveform<double>> calibrated_waveforms;
+      for (const auto &raw_waveform : temp_pair.second){
+        double baseline = Baseline(raw_waveform.Samples());
+        std::vector<double> cal_data = Calibrate(raw_waveform.Samples(), baseline);
+        calibrated_waveforms.push_back(OldCalibratedWaveform(raw_waveform.GetStartTime(), cal_data, baseline, 0.));
+      }
+      calibrated_waveform_map[temp_pair.first] = calibrated_waveforms;
+    }
+    FinishedRawWaveforms.emplace(PMTCounterTime, RawADCData);
+    FinishedCalibratedWaveforms.emplace(PMTCounterTime, calibrated_waveform_map);
+  }
+  for (uint64_t timestamp : RawTimestampsToDelete) InProgressTankEvents.erase(timestamp);
+}
+
+//PhaseIIADCCalibrator::Execute now
+static void MoveCalibrate(TankEventMap &InProgressTankEvents, RawWaveformMap &FinishedRawWaveforms,
+                          CalibratedWaveformMap &FinishedCalibratedWaveforms){
+  std::vector<uint64_t> RawTimestampsToDelete;
+  for (std::pair<const uint64_t,std::map<CardChannelKey, std::vector<uint16_t>>> &apair : InProgressTankEvents){
+    uint64_t PMTCounterTime = apair.first;
+    RawTimestampsToDelete.push_back(PMTCounterTime);
+    std::map<CardChannelKey, std::vector<uint16_t>> &aWaveMap = apair.second;
+    std::map<unsigned long, std::vector<Waveform<uint16_t>>> RawADCData;
+    for (std::pair<const CardChannelKey, std::vector<uint16_t>> &wpair : aWaveMap){
+      std::vector<Waveform<uint16_t>> WaveVec;
+      WaveVec.emplace_back(PMTCounterTime, std::move(wpair.second));
+      RawADCData.emplace(wpair.first, std::move(WaveVec));
+    }
+    std::map<unsigned long, std::vector<CalibratedADCWaveform<double>>> calibrated_waveform_map;
+    for (const auto &temp_pair : RawADCData){
+      std::vector<CalibratedADCWaveform<double>> calibrated_waveforms;
+      for (const auto &raw_waveform : temp_pair.second){
+        double baseline = Baseline(raw_waveform.Samples());
+        std::vector<double> cal_data = Calibrate(raw_waveform.Samples(), baseline);
+        calibrated_waveforms.emplace_back(raw_waveform.GetStartTime(), std::move(cal_data), baseline, 0.);
+      }
+      calibrated_waveform_map[temp_pair.first] = std::move(calibrated_waveforms);
+    }
+    FinishedRawWaveforms.emplace(PMTCounterTime, std::move(RawADCData));
+    FinishedCalibratedWaveforms.emplace(PMTCounterTime, std::move(calibrated_waveform_map));
+  }
+  for (uint64_t timestamp : RawTimestampsToDelete) InProgressTankEvents.erase(timestamp);
+}
+
+//PhaseIIADCHitFinder::Execute before the change: copies of the Finished maps of each timestamp
+//and of each channel's calibrated waveforms
+static long OldFindHits(RawWaveformMap &FinishedRawWaveforms, CalibratedWaveformMap &FinishedCalibratedWaveforms){
+  long pulses = 0;
+  for (std::pair<uint64_t,std::map<unsigned long, std::vector<Waveform<unsigned short>>>> apair : FinishedRawWaveforms){
+    std::map<unsigned long, std::vector<Waveform<unsigned short>>> aRawWaveformMap = apair.second;
+    std::map<unsigned long, std::vector<CalibratedADCWaveform<double>>> aCalibratedWaveformMap = FinishedCalibratedWaveforms.at(apair.first);
+    for (const auto &temp_pair : aRawWaveformMap){
+      std::vector<CalibratedADCWaveform<double> > acalibrated_waveforms = aCalibratedWaveformMap.at(temp_pair.first);
+      pulses += OldBuildPulses(temp_pair.second, acalibrated_waveforms);
+    }
+  }
+  FinishedRawWaveforms.clear();
+  FinishedCalibratedWaveforms.clear();
+  return pulses;
+}
+
+//PhaseIIADCHitFinder::Execute now
+static long MoveFindHits(RawWaveformMap &FinishedRawWaveforms, CalibratedWaveformMap &FinishedCalibratedWaveforms){
+  long pulses = 0;
+  for (const std::pair<const uint64_t,std::map<unsigned long, std::vector<Waveform<unsigned short>>>> &apair : FinishedRawWaveforms){
+    const std::map<unsigned long, std::vector<Waveform<unsigned short>>> &aRawWaveformMap = apair.second;
+    const std::map<unsigned long, std::vector<CalibratedADCWaveform<double>>> &aCalibratedWaveformMap = FinishedCalibratedWaveforms.at(apair.first);
+    for (const auto &temp_pair : aRawWaveformMap){
+      const std::vector<CalibratedADCWaveform<double> > &acalibrated_waveforms = aCalibratedWaveformMap.at(temp_pair.first);
+      pulses += BuildPulses(temp_pair.second, acalibrated_waveforms);
+    }
+  }
+  FinishedRawWaveforms.clear();
+  FinishedCalibratedWaveforms.clear();
+  return pulses;
+}
+
+//Runs one hand-off over all events.  The ANNIEEventBuilder's filling of InProgressTankEvents is
+//not timed.
+static HandoffResult RunHandoff(bool move, int nevents, int events_per_execute, int nchannels, int nsamples, int seed){
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> noise(0.,1.5);
+  std::uniform_real_distribution<double> uniform(0.,1.);
+  //a pool of waveforms the events are made of, so generating them doesn't dominate
+  const int pool_size = 64;
+  std::vector<std::vector<uint16_t>> pool(pool_size, std::vector<uint16_t>(nsamples));
+  for (auto &samples : pool){
+    double pulse_time = nsamples*uniform(rng);
+    for (int i = 0; i < nsamples; i++){
+      double dt = (i - pulse_time)/4.;
+      samples[i] = static_cast<uint16_t>(std::round(330. + noise(rng) + 100.*std::exp(-0.5*dt*dt)));
+    }
+  }
+
+  HandoffResult result;
+  result.StartRSSKB = ReadProcStatusKB("VmRSS");
+  TankEventMap InProgressTankEvents;
+  RawWaveformMap FinishedRawWaveforms;
+  CalibratedWaveformMap FinishedCalibratedWaveforms;
+  for (int first = 0; first < nevents; first += events_per_execute){
+    for (int event = first; event < std::min(nevents, first+events_per_execute); event++){
+      uint64_t PMTCounterTime = 1600000000000000000ULL + uint64_t(event)*100000;
+      std::map<CardChannelKey, std::vector<uint16_t>> &WaveMap = InProgressTankEvents[PMTCounterTime];
+      for (int channel = 0; channel < nchannels; channel++){
+        WaveMap.emplace(MakeCardChannelKey(1000+channel/4, channel%4), pool[(event*nchannels+channel)%pool_size]);
+      }
+    }
+    double start = WallSeconds();
+    if (move){
+      MoveCalibrate(InProgressTankEvents, FinishedRawWaveforms, FinishedCalibratedWaveforms);
+      result.Pulses += MoveFindHits(FinishedRawWaveforms, FinishedCalibratedWaveforms);
+    }
+    else {
+      OldCalibrate(InProgressTankEvents, FinishedRawWaveforms, FinishedCalibratedWaveforms);
+      result.Pulses += OldFindHits(FinishedRawWaveforms, FinishedCalibratedWaveforms);
+    }
+    result.Seconds += WallSeconds()-start;
+  }
+  result.PeakRSSKB = ReadProcStatusKB("VmHWM");
+  return result;
+}
+
+//RunHandoff in a child process, with the result passed back through a pipe
+static bool RunHandoffInChild(bool move, int nevents, int events_per_execute, int nchannels, int nsamples, int seed,
+                              HandoffResult &result){
+  int fds[2];
+  if (pipe(fds) != 0) return false;
+  pid_t pid = fork();
+  if (pid < 0) return false;
+  if (pid == 0){
+    close(fds[0]);
+    HandoffResult child_result = RunHandoff(move, nevents, events_per_execute, nchannels, nsamples, seed);
+    ssize_t written = write(fds[1], &child_result, sizeof(child_result));
+    close(fds[1]);
+    _exit(written == sizeof(child_result) ? 0 : 1);
+  }
+  close(fds[1]);
+  ssize_t nread = read(fds[0], &result, sizeof(result));
+  close(fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return nread == sizeof(result) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char* argv[]){
+
+  Store config;
+  for (int i = 1; i < argc; i++){
+    std::string arg = argv[i];
+    size_t pos = arg.find('=');
+    if (pos == std::string::npos){
+      std::cout << "BenchmarkWaveformHandoff ERROR: argument " << arg << " is not of the form Key=Value" << std::endl;
+      return 1;
+    }
+    config.Set(arg.substr(0,pos),arg.substr(pos+1));
+  }
+  int nevents = 2000;
+  int events_per_execute = 4;
+  int nchannels = 140;
+  int nsamples = 2000;
+  int seed = 4357;
+  config.Get("Events",nevents);
+  config.Get("EventsPerExecute",events_per_execute);
+  config.Get("Channels",nchannels);
+  config.Get("Samples",nsamples);
+  config.Get("Seed",seed);
+  if (nevents < 1 || events_per_execute < 1 || nchannels < 1 || nsamples < int(NUM_BASELINE_SAMPLES)){
+    std::cout << "BenchmarkWaveformHandoff ERROR: Events, EventsPerExecute and Channels must be positive, and Samples at least "
+              << NUM_BASELINE_SAMPLES << std::endl;
+    return 1;
+  }
+
+  HandoffResult results[2];
+  const char *names[2] = {"copy (before)","move (now)"};
+  for (int i = 0; i < 2; i++){
+    if (!RunHandoffInChild(i == 1, nevents, events_per_execute, nchannels, nsamples, seed, results[i])){
+      std::cout << "BenchmarkWaveformHandoff ERROR: the " << names[i] << " hand-off did not finish" << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "BenchmarkWaveformHandoff: " << nevents << " events of " << nchannels << " waveforms of " << nsamples
+            << " samples, " << events_per_execute << " per Execute" << std::endl;
+  for (int i = 0; i < 2; i++){
+    std::cout << "  " << std::left << std::setw(16) << names[i] << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << 1e3*results[i].Seconds/nevents << " ms/event" << std::setprecision(1)
+              << std::setw(10) << (results[i].PeakRSSKB-results[i].StartRSSKB)/1024. << " MB peak RSS above start"
+              << std::setw(10) << results[i].Pulses << " pulses" << std::endl;
+  }
+  std::cout << "  speedup " << std::setprecision(2) << results[0].Seconds/results[1].Seconds << std::endl;
+
+  return (results[0].Pulses == results[1].Pulses) ? 0 : 1;
+}
@@ -0,0 +1,237 @@
+//Benchmark of the ze3ra baseline estimate of PhaseIIADCCalibrator: Ze3raBaseline::Compute
+//against the per-window ComputeMeanAndVariance and per-pair F-test p-value code it replaced
+//(reproduced below as LegacyZe3raBaseline), on generated tank PMT waveforms.
+//
+//Usage: ./BenchmarkZe3raBaseline [Key=Value ...]
+//
+//  Events                      events to generate (default 1000)
+//  Channels                    PMT waveforms per event (default 132)
+//  Samples                     samples per waveform (default 2000)
+//  NumBaselineSamples          samples per sub-waveform (default 15, as configfiles/DataDecoder)
+//  NumSubWaveforms             sub-waveforms per estimate (default 10, as configfiles/DataDecoder)
+//  PCritical                   F-test critical p-value (default 0.01)
+//  SamplesPerBaselineEstimate  spacing of the estimates along the waveform, as ze3ra_multi
+//                              (default 1000)
+//  PulseFraction               fraction of the waveforms with a pulse at a random time
+//                              (default 0.3)
+//  Tolerance                   largest baseline difference allowed, in ADC counts (default 1e-9)
+//  Seed                        random seed of the waveforms (default 4357)
+//
+//Every waveform gets the estimates of BaselineEstimationType ze3ra_multi (one per
+//SamplesPerBaselineEstimate samples; the first is the ze3ra estimate), leaving out those whose
+//sub-waveforms run past the end of the waveform, which the old code read out of bounds.  The time
+//per waveform of each implementation, the largest differences of the baseline and its sigma, and
+//the number of estimates differing by more than Tolerance are printed; the benchmark fails if
+//there are any.
+
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Store.h"
+#include "ANNIEalgorithms.h"
+#include "annie_math.h"
+#include "Ze3raBaseline.h"
+
+static double WallSeconds(){
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//PhaseIIADCCalibrator::ze3ra_baseline before Ze3raBaseline, without the debug printout.  Returns
+//the number of sub-waveform pairs that passed the F-test.
+static size_t LegacyZe3raBaseline(const std::vector<unsigned short> &data, double &baseline, double &sigma_baseline,
+                                  size_t num_baseline_samples, size_t num_sub_waveforms, double p_critical,
+                                  size_t starting_sample){
+
+  std::vector<double> means;
+  std::vector<double> variances;
+  std::vector<double> Ps;
+
+  for (size_t sub_mb = 0u; sub_mb < num_sub_waveforms; ++sub_mb) {
+    std::vector<unsigned short> sub_mb_data(
+      data.cbegin()+ starting_sample + sub_mb * num_baseline_samples,
+      data.cbegin() + starting_sample + (1u + sub_mb) * num_baseline_samples);
+
+    double mean, var;
+    ComputeMeanAndVariance(sub_mb_data, mean, var, num_baseline_samples);
+
+    means.push_back(mean);
+    variances.push_back(var);
+  }
+
+  for (size_t j = 0; j < variances.size() - 1; ++j) {
+    double sigma2_j = variances.at(j);
+    double sigma2_jp1 = variances.at(j + 1);
+    double F;
+    if (sigma2_j > sigma2_jp1) F = sigma2_j / sigma2_jp1;
+    else F = sigma2_jp1 / sigma2_j;
+
+    double nu = (num_baseline_samples - 1) / 2.;
+    double P = annie_math::Regularized_Beta_Function(1. / (1. + F), nu, nu);
+    P *= 2.;
+    if (P > 1.) P = 2. - P;
+
+    Ps.push_back(P);
+  }
+
+  baseline = 0.;
+  sigma_baseline = 0.;
+  double variance_baseline = 0.;
+  size_t num_passing = 0;
+  for (size_t k = 0; k < Ps.size(); ++k) {
+    if (Ps.at(k) > p_critical) {
+      ++num_passing;
+      baseline += means.at(k);
+      variance_baseline += variances.at(k);
+    }
+  }
+
+  if (num_passing > 1) {
+    baseline /= num_passing;
+    variance_baseline *= static_cast<double>(num_baseline_samples - 1)
+      / (num_passing*num_baseline_samples - 1);
+    sigma_baseline = std::sqrt( variance_baseline );
+  }
+  else if (num_passing == 1) {
+    sigma_baseline = std::sqrt( variance_baseline );
+  }
+  else {
+    auto max_iter = std::max_element(Ps.cbegin(), Ps.cend());
+    int max_index = std::distance(Ps.cbegin(), max_iter);
+    baseline = means.at(max_index);
+    sigma_baseline = std::sqrt( variances.at(max_index) );
+  }
+
+  return num_passing;
+}
+
+//A flat baseline with integer noise, as the V1742 digitizers record it, and sometimes a pulse
+static void MakeWaveform(int nsamples, double pulse_fraction, std::mt19937 &rng, std::vector<unsigned short> &samples){
+  std::uniform_real_distribution<double> uniform(0.,1.);
+  std::normal_distribution<double> noise(0.,1.5);
+  double level = 310. + 40.*uniform(rng);
+  double pulse_time = (uniform(rng) < pulse_fraction) ? nsamples*uniform(rng) : -1e9;
+  double pulse_height = 20. + 300.*uniform(rng);
+  samples.resize(nsamples);
+  for (int i = 0; i < nsamples; i++){
+    double dt = (i - pulse_time)/4.;
+    double value = level + noise(rng) + pulse_height*std::exp(-0.5*dt*dt);
+    samples[i] = static_cast<unsigned short>(std::min(4095.,std::max(0.,std::round(value))));
+  }
+}
+
+int main(int argc, char* argv[]){
+
+  Store config;
+  for (int i = 1; i < argc; i++){
+    std::string arg = argv[i];
+    size_t pos = arg.find('=');
+    if (pos == std::string::npos){
+      std::cout << "BenchmarkZe3raBaseline ERROR: argument " << arg << " is not of the form Key=Value" << std::endl;
+      return 1;
+    }
+    config.Set(arg.substr(0,pos),arg.substr(pos+1));
+  }
+  int nevents = 1000;
+  int nchannels = 132;
+  int nsamples = 2000;
+  int num_baseline_samples = 15;
+  int num_sub_waveforms = 10;
+  double p_critical = 0.01;
+  int baseline_rep_samples = 1000;
+  double pulse_fraction = 0.3;
+  double tolerance = 1e-9;
+  int seed = 4357;
+  config.Get("Events",nevents);
+  config.Get("Channels",nchannels);
+  config.Get("Samples",nsamples);
+  config.Get("NumBaselineSamples",num_baseline_samples);
+  config.Get("NumSubWaveforms",num_sub_waveforms);
+  config.Get("PCritical",p_critical);
+  config.Get("SamplesPerBaselineEstimate",baseline_rep_samples);
+  config.Get("PulseFraction",pulse_fraction);
+  config.Get("Tolerance",tolerance);
+  config.Get("Seed",seed);
+  if (nevents < 1 || nchannels < 1 || num_baseline_samples < 2 || num_sub_waveforms < 2 || baseline_rep_samples < 1
+      || nsamples < num_baseline_samples*num_sub_waveforms){
+    std::cout << "BenchmarkZe3raBaseline ERROR: Events, Channels and SamplesPerBaselineEstimate must be positive,"
+              << " NumBaselineSamples and NumSubWaveforms at least 2, and Samples at least their product" << std::endl;
+    return 1;
+  }
+
+  //the estimates of one waveform, as make_calibrated_waveforms_ze3ra_multi makes them
+  std::vector<size_t> starting_samples;
+  for (int start = 0; start + num_baseline_samples*num_sub_waveforms <= nsamples; start += baseline_rep_samples){
+    starting_samples.push_back(start);
+  }
+  const size_t nestimates = starting_samples.size();
+
+  Ze3raBaseline engine;
+  engine.Configure(num_baseline_samples, num_sub_waveforms, p_critical);
+
+  std::mt19937 rng(seed);
+  std::vector<std::vector<unsigned short>> waveforms(nchannels);
+  std::vector<double> legacy_baselines(nchannels*nestimates), legacy_sigmas(nchannels*nestimates);
+  std::vector<double> baselines(nchannels*nestimates), sigmas(nchannels*nestimates);
+  double legacy_seconds = 0., engine_seconds = 0.;
+  double max_baseline_diff = 0., max_sigma_diff = 0.;
+  long differing = 0, legacy_passing = 0, engine_passing = 0;
+  for (int event = 0; event < nevents; event++){
+    for (auto &waveform : waveforms) MakeWaveform(nsamples, pulse_fraction, rng, waveform);
+
+    //alternate which implementation goes first, so neither always finds the samples in the cache
+    for (int pass = 0; pass < 2; pass++){
+      bool legacy_pass = ((event+pass)%2 == 0);
+      long num_passing = 0;
+      double start = WallSeconds();
+      for (int channel = 0; channel < nchannels; channel++){
+        const std::vector<unsigned short> &data = waveforms[channel];
+        for (size_t i = 0; i < nestimates; i++){
+          size_t index = channel*nestimates + i;
+          if (legacy_pass){
+            num_passing += LegacyZe3raBaseline(data, legacy_baselines[index], legacy_sigmas[index],
+              num_baseline_samples, num_sub_waveforms, p_critical, starting_samples[i]);
+          }
+          else {
+            num_passing += engine.Compute(data.data(), data.size(), starting_samples[i], baselines[index], sigmas[index]);
+          }
+        }
+      }
+      (legacy_pass ? legacy_seconds : engine_seconds) += WallSeconds()-start;
+      (legacy_pass ? legacy_passing : engine_passing) += num_passing;
+    }
+
+    for (size_t index = 0; index < baselines.size(); index++){
+      double baseline_diff = std::fabs(baselines[index]-legacy_baselines[index]);
+      double sigma_diff = std::fabs(sigmas[index]-legacy_sigmas[index]);
+      max_baseline_diff = std::max(max_baseline_diff, baseline_diff);
+      max_sigma_diff = std::max(max_sigma_diff, sigma_diff);
+      if (baseline_diff > tolerance) differing++;
+    }
+  }
+
+  double nwaveforms = double(nevents)*nchannels;
+  std::cout << "BenchmarkZe3raBaseline: " << nevents << " events of " << nchannels << " waveforms of " << nsamples
+            << " samples, " << nestimates << " estimates per waveform of " << num_sub_waveforms << " x "
+            << num_baseline_samples << " samples" << std::endl;
+  const char *names[2] = {"ComputeMeanAndVariance + p-values (old)","Ze3raBaseline::Compute"};
+  const double seconds[2] = {legacy_seconds,engine_seconds};
+  for (int i = 0; i < 2; i++){
+    std::cout << "  " << std::left << std::setw(40) << names[i] << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << 1e6*seconds[i]/nwaveforms << " us/waveform" << std::setw(10) << seconds[i] << " s total" << std::endl;
+  }
+  std::cout << "  speedup " << std::setprecision(1) << legacy_seconds/engine_seconds << std::endl;
+  std::cout << "  largest difference: baseline " << std::scientific << std::setprecision(2) << max_baseline_diff
+            << " ADC counts, sigma " << max_sigma_diff << " ADC counts" << std::endl;
+  std::cout << "  " << differing << " of " << std::fixed << std::setprecision(0) << nwaveforms*nestimates
+            << " estimates differ by more than " << std::scientific << tolerance << " ADC counts; "
+            << legacy_passing << " window pairs passed the F-test before, " << engine_passing << " now" << std::endl;
+
+  return (differing == 0) ? 0 : 1;
+}
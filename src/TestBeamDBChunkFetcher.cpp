@@ -0,0 +1,411 @@
+//Test of the chunked beam database download of BeamFetcher (BeamDBChunkFetcher) against a
+//stand-in for the IF beam database: an HTTP server on a local port, run on a thread of this
+//program, serving canned csv responses.
+//
+//Usage: ./TestBeamDBChunkFetcher [Key=Value ...]
+//
+//  Chunks     time chunks fetched in each test (default 8)
+//  CacheDir   directory for the response cache test, emptied first (default
+//             /tmp/TestBeamDBChunkFetcher_<pid>)
+//
+//Every test is run with the chunks downloaded on the calling thread, and on 1 and 3 worker
+//threads.  The tests check that the chunks come back in the order given, holding the data from
+//their first to their last millisecond; that failed queries (HTTP errors, empty responses and
+//csv responses that stop in the middle of a record or are not csv at all) are retried, and that
+//the chunk fails once the retries run out; that a response of only the csv header line is an
+//empty chunk, not an error; and that only good responses are cached.  The program returns the
+//number of failed checks.
+
+#include <stdint.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Store.h"
+#include "BeamDBChunkFetcher.h"
+
+typedef std::vector<std::pair<uint64_t, uint64_t>> ChunkList;
+
+static const uint64_t CHUNK_MS = 3600000;        //as BeamFetcher with the default chunk size
+static const uint64_t OVERLAP_MS = 30000;        //THIRTY_SECONDS of BeamFetcher
+static const uint64_t POINT_STEP_MS = 66667;     //spacing of the canned data points
+
+static const std::string CSV_HEADER = "time,name,units,value\n";
+
+struct CannedResponse {
+  int status = 200;
+  std::string body;
+};
+
+//Response for the chunk [t0,t1] (ms, as requested) on the given attempt (0 for the first)
+typedef std::function<CannedResponse(uint64_t t0, uint64_t t1, int attempt)> Scenario;
+
+//Minimal HTTP/1.1 server: one connection at a time, "Connection: close" after every response.
+//The time range of every request is logged.
+class BeamDBStandIn {
+
+ public:
+
+  BeamDBStandIn(){
+    fSocket = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t length = sizeof(address);
+    if (fSocket < 0 || bind(fSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || listen(fSocket, 16) != 0 || getsockname(fSocket, reinterpret_cast<sockaddr*>(&address), &length) != 0){
+      std::cout << "TestBeamDBChunkFetcher ERROR: could not open a local server socket" << std::endl;
+      exit(1);
+    }
+    fPort = ntohs(address.sin_port);
+    fThread = std::thread(&BeamDBStandIn::Serve, this);
+  }
+
+  ~BeamDBStandIn(){
+    fStop = true;
+    fThread.join();
+    close(fSocket);
+  }
+
+  //Query URL up to the time range, as the IF beam database one
+  std::string URLStart() const {
+    return "http://127.0.0.1:" + std::to_string(fPort) + "/ifbeam/data/data?e=e%2C1d&b=BNBBPMTOR&f=csv&tz=&action=Show+device&t0=";
+  }
+
+  void SetScenario(const Scenario &scenario){
+    std::lock_guard<std::mutex> lock(fMutex);
+    fScenario = scenario;
+    fAttempts.clear();
+    fRequests.clear();
+  }
+
+  ChunkList Requests(){
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fRequests;
+  }
+
+ private:
+
+  void Serve(){
+    while (!fStop){
+      pollfd pfd = {fSocket, POLLIN, 0};
+      if (poll(&pfd, 1, 20) <= 0) continue;
+      int connection = accept(fSocket, nullptr, nullptr);
+      if (connection < 0) continue;
+      HandleConnection(connection);
+      close(connection);
+    }
+  }
+
+  void HandleConnection(int connection){
+    std::string request;
+    char buffer[4096];
+    while (request.find("\r\n\r\n") == std::string::npos){
+      ssize_t n = recv(connection, buffer, sizeof(buffer), 0);
+      if (n <= 0) return;
+      request.append(buffer, n);
+    }
+
+    //GET /...&t0=<s>&t1=<s> HTTP/1.1, times in seconds with three decimals
+    std::string line = request.substr(0, request.find("\r\n"));
+    size_t pos0 = line.find("&t0=");
+    size_t pos1 = line.find("&t1=");
+    CannedResponse response;
+    if (pos0 == std::string::npos || pos1 == std::string::npos){
+      response.status = 400;
+    }
+    else {
+      uint64_t t0 = std::llround(1000.*std::strtod(line.c_str()+pos0+4, nullptr));
+      uint64_t t1 = std::llround(1000.*std::strtod(line.c_str()+pos1+4, nullptr));
+      std::lock_guard<std::mutex> lock(fMutex);
+      fRequests.push_back(std::make_pair(t0, t1));
+      response = fScenario(t0, t1, fAttempts[std::make_pair(t0, t1)]++);
+    }
+
+    std::stringstream reply;
+    reply << "HTTP/1.1 " << response.status << (response.status == 200 ? " OK" : " Error") << "\r\n"
+          << "Content-Type: text/csv\r\n"
+          << "Content-Length: " << response.body.size() << "\r\n"
+          << "Connection: close\r\n\r\n" << response.body;
+    std::string text = reply.str();
+    size_t sent = 0;
+    while (sent < text.size()){
+      ssize_t n = send(connection, text.data()+sent, text.size()-sent, MSG_NOSIGNAL);
+      if (n <= 0) return;
+      sent += n;
+    }
+  }
+
+  int fSocket = -1;
+  int fPort = 0;
+  std::atomic<bool> fStop{false};
+  std::thread fThread;
+  std::mutex fMutex;
+  Scenario fScenario;
+  std::map<std::pair<uint64_t, uint64_t>, int> fAttempts;
+  ChunkList fRequests;
+
+};
+
+//What the database holds for a requested range [t0,t1]: toroid readings from t0+1 to t1-1, the
+//range of the chunk itself, in time order as the database returns them
+static std::string GoodCSV(uint64_t t0, uint64_t t1){
+  std::vector<uint64_t> times;
+  for (uint64_t t = t0+1; t < t1-1; t += POINT_STEP_MS) times.push_back(t);
+  times.push_back(t1-1);
+  std::stringstream csv;
+  csv << CSV_HEADER;
+  for (uint64_t t : times) csv << t << ",E:TOR860,E12,4.5\n" << t << ",E:TOR875,E12,4.25\n";
+  return csv.str();
+}
+
+//The first half of the above, cut off after the first letters of a device name
+static std::string TruncatedCSV(uint64_t t0, uint64_t t1){
+  std::string csv = GoodCSV(t0, t1);
+  csv.resize(csv.size()/2);
+  csv.resize(csv.rfind(",E:TOR")+5);
+  return csv;
+}
+
+static CannedResponse Good(uint64_t t0, uint64_t t1, int){
+  CannedResponse response;
+  response.body = GoodCSV(t0, t1);
+  return response;
+}
+
+static CannedResponse HeaderOnly(uint64_t, uint64_t, int){
+  CannedResponse response;
+  response.body = CSV_HEADER;
+  return response;
+}
+
+//Responses that are not a complete csv table: an empty one, an html page, and one cut off in
+//the middle of a record
+static CannedResponse Empty(uint64_t, uint64_t, int){
+  return CannedResponse();
+}
+
+static CannedResponse Html(uint64_t, uint64_t, int){
+  CannedResponse response;
+  response.body = "<html>\n<body>Service Temporarily Unavailable</body>\n</html>\n";
+  return response;
+}
+
+static CannedResponse Truncated(uint64_t t0, uint64_t t1, int){
+  CannedResponse response;
+  response.body = TruncatedCSV(t0, t1);
+  return response;
+}
+
+static CannedResponse ServerError(uint64_t, uint64_t, int){
+  CannedResponse response;
+  response.status = 503;
+  return response;
+}
+
+//The given scenario for the first attempts at every chunk, then a good response
+static Scenario FailFirst(int attempts, const Scenario &failure){
+  return [attempts, failure](uint64_t t0, uint64_t t1, int attempt){
+    return (attempt < attempts) ? failure(t0, t1, attempt) : Good(t0, t1, attempt);
+  };
+}
+
+//Consecutive chunks going back in time from a day in 2020, each reaching 30 s into the next
+//(later) one, in the order BeamFetcher::fetch_beam_data downloads them
+static ChunkList MakeChunks(int nchunks){
+  ChunkList chunks;
+  uint64_t current_time = 1600000000000ULL + nchunks*CHUNK_MS;
+  for (int i = 0; i < nchunks; i++){
+    chunks.push_back(std::make_pair(current_time-CHUNK_MS, current_time+OVERLAP_MS));
+    current_time -= CHUNK_MS;
+  }
+  return chunks;
+}
+
+static int failures = 0;
+
+static void Check(bool passed, const std::string &name, const std::string &detail = ""){
+  if (!passed) failures++;
+  std::cout << (passed ? "  ok     " : "  FAILED ") << name;
+  if (!passed && !detail.empty()) std::cout << ": " << detail;
+  std::cout << std::endl;
+}
+
+struct FetchResult {
+  std::vector<bool> ok;
+  std::vector<BeamDBChunkFetcher::BeamDB> beam_data;
+  std::vector<std::string> errors;
+  int retries = 0;
+  int cache_hits = 0;
+};
+
+static FetchResult Fetch(const ChunkList &chunks, int threads, int max_retries, const std::string &cache_dir,
+                         const BeamDBStandIn &server){
+  BeamDBChunkFetcher fetcher(threads, max_retries, 1, cache_dir, server.URLStart());
+  fetcher.Start(chunks);
+  FetchResult result;
+  for (size_t i = 0; i < chunks.size(); i++){
+    BeamDBChunkFetcher::BeamDB beam_data;
+    std::string error;
+    result.ok.push_back(fetcher.Next(beam_data, error));
+    result.beam_data.push_back(std::move(beam_data));
+    result.errors.push_back(error);
+  }
+  result.retries = fetcher.NumRetries();
+  result.cache_hits = fetcher.NumCacheHits();
+  return result;
+}
+
+//Chunk i holds the canned data of exactly [t0,t1], and the request asked for [t0-1,t1+1]
+static bool ChunkMatches(const FetchResult &result, const ChunkList &chunks, size_t i, std::string &detail){
+  std::stringstream ss;
+  if (!result.ok.at(i)){
+    ss << "chunk " << i << " failed: " << result.errors.at(i);
+  }
+  else if (result.beam_data.at(i).size() != 2 || result.beam_data.at(i).count("E:TOR875") == 0){
+    ss << "chunk " << i << " holds " << result.beam_data.at(i).size() << " devices";
+  }
+  else {
+    const std::map<uint64_t, BeamDataPoint> &points = result.beam_data.at(i).at("E:TOR875");
+    if (points.begin()->first != chunks.at(i).first || points.rbegin()->first != chunks.at(i).second){
+      ss << "chunk " << i << " is [" << chunks.at(i).first << ", " << chunks.at(i).second << "] but holds ["
+         << points.begin()->first << ", " << points.rbegin()->first << "]";
+    }
+    else if (std::fabs(points.begin()->second.value - 4.25e12) > 1. || points.begin()->second.unit != "POT"){
+      ss << "chunk " << i << " holds " << points.begin()->second.value << " " << points.begin()->second.unit;
+    }
+  }
+  detail = ss.str();
+  return detail.empty();
+}
+
+static bool AllMatch(const FetchResult &result, const ChunkList &chunks, std::string &detail){
+  for (size_t i = 0; i < chunks.size(); i++) if (!ChunkMatches(result, chunks, i, detail)) return false;
+  return true;
+}
+
+//One request per chunk for [t0-1,t1+1], each asked for max_retries+1 times at most
+static bool RequestsMatch(BeamDBStandIn &server, const ChunkList &chunks, int attempts, std::string &detail){
+  std::map<std::pair<uint64_t, uint64_t>, int> expected, requested;
+  for (const auto &chunk : chunks) expected[std::make_pair(chunk.first-1, chunk.second+1)] = attempts;
+  for (const auto &request : server.Requests()) requested[request]++;
+  if (requested == expected) return true;
+  std::stringstream ss;
+  ss << server.Requests().size() << " requests, expected " << attempts << " for each of the "
+     << chunks.size() << " chunks";
+  detail = ss.str();
+  return false;
+}
+
+static bool FileExists(const std::string &name){
+  std::ifstream file(name);
+  return file.good();
+}
+
+int main(int argc, char* argv[]){
+
+  Store config;
+  for (int i = 1; i < argc; i++){
+    std::string arg = argv[i];
+    size_t pos = arg.find('=');
+    if (pos == std::string::npos){
+      std::cout << "TestBeamDBChunkFetcher ERROR: argument " << arg << " is not of the form Key=Value" << std::endl;
+      return 1;
+    }
+    config.Set(arg.substr(0,pos),arg.substr(pos+1));
+  }
+  int nchunks = 8;
+  std::string cache_dir = "/tmp/TestBeamDBChunkFetcher_" + std::to_string(getpid());
+  config.Get("Chunks",nchunks);
+  config.Get("CacheDir",cache_dir);
+  if (nchunks < 2){
+    std::cout << "TestBeamDBChunkFetcher ERROR: Chunks must be at least 2" << std::endl;
+    return 1;
+  }
+
+  BeamDBStandIn server;
+  const ChunkList chunks = MakeChunks(nchunks);
+  std::string detail;
+
+  for (int threads : {0, 1, 3}){
+    std::cout << "TestBeamDBChunkFetcher: " << nchunks << " chunks on " << threads << " worker threads" << std::endl;
+    std::string tag = " (" + std::to_string(threads) + " threads)";
+
+    server.SetScenario(Good);
+    FetchResult result = Fetch(chunks, threads, 3, "", server);
+    Check(AllMatch(result, chunks, detail), "chunks in order with their boundaries" + tag, detail);
+    Check(RequestsMatch(server, chunks, 1, detail) && result.retries == 0, "one request per chunk" + tag, detail);
+
+    server.SetScenario(HeaderOnly);
+    result = Fetch(chunks, threads, 3, "", server);
+    bool empty = true;
+    for (size_t i = 0; i < chunks.size(); i++) empty &= result.ok[i] && result.beam_data[i].empty();
+    Check(empty && result.retries == 0, "header only response is an empty chunk" + tag);
+
+    const std::pair<const char*, Scenario> bad_responses[] = {
+      {"HTTP 503", ServerError}, {"empty response", Empty}, {"html response", Html}, {"truncated csv", Truncated}};
+    for (const auto &failure : bad_responses){
+      server.SetScenario(FailFirst(2, failure.second));
+      result = Fetch(chunks, threads, 3, "", server);
+      Check(AllMatch(result, chunks, detail) && RequestsMatch(server, chunks, 3, detail)
+            && result.retries == 2*nchunks, std::string(failure.first) + " retried" + tag, detail);
+
+      server.SetScenario(failure.second);
+      result = Fetch(chunks, threads, 2, "", server);
+      bool all_failed = RequestsMatch(server, chunks, 3, detail);
+      for (size_t i = 0; i < chunks.size(); i++){
+        all_failed &= !result.ok[i] && result.beam_data[i].empty()
+          && result.errors[i].find("after 3 attempts") != std::string::npos;
+      }
+      Check(all_failed, std::string(failure.first) + " fails the chunk after the last retry" + tag,
+            detail.empty() ? result.errors[0] : detail);
+      detail.clear();
+    }
+  }
+
+  //Every chunk but the second is downloaded once and then read from the cache; the second one
+  //always gets a truncated response, and is never cached
+  std::cout << "TestBeamDBChunkFetcher: response cache in " << cache_dir << std::endl;
+  std::system(("rm -rf " + cache_dir).c_str());
+  const std::pair<uint64_t, uint64_t> bad_chunk = chunks.at(1);
+  auto cache_file = [&cache_dir](const std::pair<uint64_t, uint64_t> &chunk){
+    return cache_dir + "/beamdb_" + std::to_string(chunk.first) + "_" + std::to_string(chunk.second) + ".csv";
+  };
+  server.SetScenario([bad_chunk](uint64_t t0, uint64_t t1, int attempt){
+    return (t0 == bad_chunk.first-1) ? Truncated(t0, t1, attempt) : Good(t0, t1, attempt);
+  });
+  FetchResult first = Fetch(chunks, 3, 1, cache_dir, server);
+  Check(!first.ok[1] && first.cache_hits == 0 && !FileExists(cache_file(bad_chunk)) && FileExists(cache_file(chunks[0])),
+        "first download fills the cache with the good responses only");
+
+  std::ofstream corrupted(cache_file(chunks.back()), std::ios::trunc);
+  corrupted << TruncatedCSV(chunks.back().first-1, chunks.back().second+1);
+  corrupted.close();
+
+  server.SetScenario(Good);
+  FetchResult second = Fetch(chunks, 3, 1, cache_dir, server);
+  ChunkList expected_requests = {bad_chunk, chunks.back()};
+  Check(AllMatch(second, chunks, detail) && second.cache_hits == nchunks-2 && RequestsMatch(server, expected_requests, 1, detail),
+        "second download reads the cache, and downloads the missing and corrupted chunks again", detail);
+  std::system(("rm -rf " + cache_dir).c_str());
+
+  std::cout << "TestBeamDBChunkFetcher: " << failures << " failed checks" << std::endl;
+  return failures;
+}
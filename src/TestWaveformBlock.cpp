@@ -0,0 +1,259 @@
+//Test of the columnar WaveformBlock storage (DataModel/WaveformBlock.h): raw and calibrated
+//waveform maps are converted to blocks with FromMap, serialised and read back with the boost
+//binary archives the stores use, and converted back with ToMap.
+//
+//Usage: ./TestWaveformBlock [Key=Value ...]
+//
+//  Channels   channels in the generated maps (default 20)
+//  Seed       random seed of the waveforms (default 4357)
+//
+//The maps hold channels with one and with several minibuffers, of different lengths, and an
+//empty waveform.  The tests check that the round trip gives back the maps unchanged (start
+//times, samples and baselines); that the views of a read-back block, found by channel and
+//minibuffer, hold the same waveforms; and that GetWaveformViews reads a store holding either
+//the block or the map the same way.  The program returns the number of failed checks.
+
+#include <stdint.h>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/map.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include "Store.h"
+#include "WaveformBlock.h"
+
+static int failures = 0;
+
+static void Check(bool passed, const std::string &name, const std::string &detail = ""){
+  if (!passed) failures++;
+  std::cout << (passed ? "  ok     " : "  FAILED ") << name;
+  if (!passed && !detail.empty()) std::cout << ": " << detail;
+  std::cout << std::endl;
+}
+
+//Serialise an object into a string and read it back into another, as a BoostStore entry is
+template <class T> void RoundTrip(const T &in, T &out){
+  std::stringstream stream;
+  {
+    boost::archive::binary_oarchive oa(stream);
+    oa << in;
+  }
+  boost::archive::binary_iarchive ia(stream);
+  ia >> out;
+}
+
+//Stand-in for the ANNIEEvent store: entries are kept serialised, and Get reads them back
+class SerialisingStore {
+ public:
+  template <class T> void Set(const std::string &name, const T &in){
+    std::stringstream stream;
+    boost::archive::binary_oarchive oa(stream);
+    oa << in;
+    Entries[name] = stream.str();
+  }
+  template <class T> bool Get(const std::string &name, T &out){
+    std::map<std::string, std::string>::const_iterator it = Entries.find(name);
+    if (it == Entries.end()) return false;
+    std::stringstream stream(it->second);
+    boost::archive::binary_iarchive ia(stream);
+    ia >> out;
+    return true;
+  }
+ private:
+  std::map<std::string, std::string> Entries;
+};
+
+template <class T> static double GetBaseline(const Waveform<T> &){ return 0.; }
+template <class T> static double GetBaseline(const CalibratedADCWaveform<T> &wave){ return wave.GetBaseline(); }
+template <class T> static double GetSigmaBaseline(const Waveform<T> &){ return 0.; }
+template <class T> static double GetSigmaBaseline(const CalibratedADCWaveform<T> &wave){ return wave.GetSigmaBaseline(); }
+template <class T> static WaveformView<T> ViewOf(const Waveform<T> &wave){ return WaveformView<T>(wave); }
+template <class T> static WaveformView<T> ViewOf(const CalibratedADCWaveform<T> &wave){ return WaveformView<T>(wave); }
+
+//Whether a view holds the same waveform as wave
+template <class W, class T> static bool SameWaveform(const W &wave, const WaveformView<T> &view){
+  const std::vector<T> &samples = wave.Samples();
+  if (view.GetStartTime() != wave.GetStartTime() || view.Samples().size() != samples.size()) return false;
+  if (view.GetBaseline() != GetBaseline(wave) || view.GetSigmaBaseline() != GetSigmaBaseline(wave)) return false;
+  for (size_t i = 0; i < samples.size(); i++){
+    if (view.Samples()[i] != samples[i]) return false;
+  }
+  return true;
+}
+
+//Whether two maps hold the same waveforms, with a description of the first difference
+template <class W> static bool SameMaps(const std::map<unsigned long, std::vector<W>> &expected,
+                                        const std::map<unsigned long, std::vector<W>> &found, std::string &detail){
+  if (expected.size() != found.size()){
+    detail = std::to_string(found.size()) + " channels instead of " + std::to_string(expected.size());
+    return false;
+  }
+  for (const auto &apair : expected){
+    typename std::map<unsigned long, std::vector<W>>::const_iterator it = found.find(apair.first);
+    if (it == found.end() || it->second.size() != apair.second.size()){
+      detail = "channel " + std::to_string(apair.first) + " is missing or has a different number of minibuffers";
+      return false;
+    }
+    for (size_t mb = 0; mb < apair.second.size(); mb++){
+      if (!SameWaveform(apair.second[mb], ViewOf(it->second[mb]))){
+        detail = "channel " + std::to_string(apair.first) + " minibuffer " + std::to_string(mb) + " differs";
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+//Whether a map of views holds the waveforms of a map
+template <class W, class T> static bool SameViews(const std::map<unsigned long, std::vector<W>> &expected,
+                                                  const std::map<unsigned long, std::vector<WaveformView<T>>> &views, std::string &detail){
+  if (expected.size() != views.size()){
+    detail = std::to_string(views.size()) + " channels of views instead of " + std::to_string(expected.size());
+    return false;
+  }
+  for (const auto &apair : expected){
+    typename std::map<unsigned long, std::vector<WaveformView<T>>>::const_iterator it = views.find(apair.first);
+    if (it == views.end() || it->second.size() != apair.second.size()){
+      detail = "channel " + std::to_string(apair.first) + " is missing or has a different number of views";
+      return false;
+    }
+    for (size_t mb = 0; mb < apair.second.size(); mb++){
+      if (!SameWaveform(apair.second[mb], it->second[mb])){
+        detail = "view of channel " + std::to_string(apair.first) + " minibuffer " + std::to_string(mb) + " differs";
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+//Whether Get(channel, minibuffer) finds every waveform of the map, and throws past the last minibuffer
+template <class W, class T> static bool SameLookups(const std::map<unsigned long, std::vector<W>> &expected,
+                                                    const WaveformBlock<T> &block, std::string &detail){
+  for (const auto &apair : expected){
+    if (block.NumMinibuffers(apair.first) != apair.second.size()){
+      detail = "channel " + std::to_string(apair.first) + " has " + std::to_string(block.NumMinibuffers(apair.first)) + " minibuffers";
+      return false;
+    }
+    for (size_t mb = 0; mb < apair.second.size(); mb++){
+      if (!SameWaveform(apair.second[mb], block.Get(apair.first, mb))){
+        detail = "Get(" + std::to_string(apair.first) + "," + std::to_string(mb) + ") differs";
+        return false;
+      }
+    }
+    try {
+      block.Get(apair.first, apair.second.size());
+      detail = "Get past the last minibuffer of channel " + std::to_string(apair.first) + " did not throw";
+      return false;
+    }
+    catch (const std::out_of_range &){}
+  }
+  return true;
+}
+
+int main(int argc, char* argv[]){
+
+  Store config;
+  for (int i = 1; i < argc; i++){
+    std::string arg = argv[i];
+    size_t pos = arg.find('=');
+    if (pos == std::string::npos){
+      std::cout << "TestWaveformBlock ERROR: argument " << arg << " is not of the form Key=Value" << std::endl;
+      return 1;
+    }
+    config.Set(arg.substr(0,pos),arg.substr(pos+1));
+  }
+  int nchannels = 20;
+  int seed = 4357;
+  config.Get("Channels",nchannels);
+  config.Get("Seed",seed);
+  if (nchannels < 2){
+    std::cout << "TestWaveformBlock ERROR: Channels must be at least 2" << std::endl;
+    return 1;
+  }
+
+  //Channel keys out of order and spread out, every third channel with several minibuffers,
+  //and one empty waveform
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> adc(250, 4095);
+  std::normal_distribution<double> noise(0., 1e-3);
+  std::map<unsigned long, std::vector<Waveform<uint16_t>>> raw_map;
+  std::map<unsigned long, std::vector<CalibratedADCWaveform<double>>> calibrated_map;
+  for (int channel = 0; channel < nchannels; channel++){
+    unsigned long key = 1000 + 37*((channel*7) % nchannels);
+    int nminibuffers = (channel % 3 == 0) ? 1 + channel % 4 : 1;
+    for (int mb = 0; mb < nminibuffers; mb++){
+      size_t nsamples = (channel == 1 && mb == 0) ? 0 : 40 + 13*mb + channel;
+      std::vector<uint16_t> raw(nsamples);
+      std::vector<double> calibrated(nsamples);
+      for (size_t i = 0; i < nsamples; i++){
+        raw[i] = static_cast<uint16_t>(adc(rng));
+        calibrated[i] = noise(rng);
+      }
+      double start_time = 1.6e15 + 8.*mb + channel;
+      raw_map[key].emplace_back(start_time, raw);
+      calibrated_map[key].emplace_back(start_time, calibrated, 300. + channel + 0.25*mb, 1.5 + 0.01*mb);
+    }
+  }
+  std::string detail;
+
+  std::cout << "TestWaveformBlock: " << raw_map.size() << " channels" << std::endl;
+
+  WaveformBlock<uint16_t> raw_block, raw_block_read;
+  raw_block.FromMap(raw_map);
+  RoundTrip(raw_block, raw_block_read);
+  std::map<unsigned long, std::vector<Waveform<uint16_t>>> raw_map_read;
+  raw_block_read.ToMap(raw_map_read);
+  Check(raw_block_read.NumWaveforms() == raw_block.NumWaveforms() && raw_block_read.NumSamples() == raw_block.NumSamples(),
+        "raw block reads back with the same numbers of waveforms and samples");
+  Check(SameMaps(raw_map, raw_map_read, detail), "raw map -> FromMap -> serialise -> ToMap gives the map back", detail);
+  Check(SameLookups(raw_map, raw_block_read, detail), "raw block Get finds every channel and minibuffer", detail);
+
+  WaveformBlock<double> calibrated_block, calibrated_block_read;
+  calibrated_block.FromMap(calibrated_map);
+  RoundTrip(calibrated_block, calibrated_block_read);
+  std::map<unsigned long, std::vector<CalibratedADCWaveform<double>>> calibrated_map_read;
+  calibrated_block_read.ToMap(calibrated_map_read);
+  Check(SameMaps(calibrated_map, calibrated_map_read, detail),
+        "calibrated map -> FromMap -> serialise -> ToMap gives the map back, with its baselines", detail);
+  Check(SameLookups(calibrated_map, calibrated_block_read, detail), "calibrated block Get finds every channel and minibuffer", detail);
+
+  //A store written with SaveWaveformBlocks, and one written before blocks existed
+  SerialisingStore block_store, map_store;
+  block_store.Set("RawADCDataBlock", raw_block);
+  block_store.Set("CalibratedADCDataBlock", calibrated_block);
+  map_store.Set("RawADCData", raw_map);
+  map_store.Set("CalibratedADCData", calibrated_map);
+  for (int layout = 0; layout < 2; layout++){
+    SerialisingStore &store = (layout == 0) ? block_store : map_store;
+    std::string tag = (layout == 0) ? " (block)" : " (map)";
+    WaveformBlock<uint16_t> raw_storage;
+    std::map<unsigned long, std::vector<Waveform<uint16_t>>> raw_map_storage;
+    std::map<unsigned long, std::vector<WaveformView<uint16_t>>> raw_views;
+    bool got_raw = GetWaveformViews(store, "RawADCData", raw_storage, raw_map_storage, raw_views);
+    Check(got_raw && SameViews(raw_map, raw_views, detail), "GetWaveformViews reads the raw data" + tag, detail);
+    Check(raw_storage.NumWaveforms() == ((layout == 0) ? raw_block.NumWaveforms() : 0) && raw_map_storage.empty() == (layout == 0),
+          "GetWaveformViews reads only the layout the store holds" + tag);
+
+    WaveformBlock<double> calibrated_storage;
+    std::map<unsigned long, std::vector<CalibratedADCWaveform<double>>> calibrated_map_storage;
+    std::map<unsigned long, std::vector<WaveformView<double>>> calibrated_views;
+    bool got_calibrated = GetWaveformViews(store, "CalibratedADCData", calibrated_storage, calibrated_map_storage, calibrated_views);
+    Check(got_calibrated && SameViews(calibrated_map, calibrated_views, detail), "GetWaveformViews reads the calibrated data" + tag, detail);
+
+    std::map<unsigned long, std::vector<WaveformView<uint16_t>>> missing_views;
+    Check(!GetWaveformViews(store, "RawADCAuxData", raw_storage, raw_map_storage, missing_views) && missing_views.empty(),
+          "GetWaveformViews returns false for a missing entry" + tag);
+  }
+
+  std::cout << "TestWaveformBlock: " << failures << " failed checks" << std::endl;
+  return failures;
+}